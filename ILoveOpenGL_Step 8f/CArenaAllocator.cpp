@@ -0,0 +1,170 @@
+#include "CArenaAllocator.h"
+
+CArenaAllocator::CArenaAllocator()
+{
+	this->m_capacity = 0;
+	this->m_sizeInUse = 0;
+	return;
+}
+
+void CArenaAllocator::Reset( unsigned int capacity )
+{
+	this->m_capacity = capacity;
+	this->m_sizeInUse = 0;
+	this->m_mapFreeBlocks.clear();
+	if ( capacity != 0 )
+	{
+		this->m_mapFreeBlocks[0] = capacity;
+	}
+	return;
+}
+
+void CArenaAllocator::Grow( unsigned int newCapacity )
+{
+	if ( newCapacity <= this->m_capacity )
+	{
+		return;
+	}
+	const unsigned int oldCapacity = this->m_capacity;
+	this->m_capacity = newCapacity;
+	this->m_AddFreeBlock( oldCapacity, newCapacity - oldCapacity );
+	return;
+}
+
+bool CArenaAllocator::Shrink( unsigned int newCapacity )
+{
+	if ( newCapacity >= this->m_capacity )
+	{
+		return ( newCapacity == this->m_capacity );
+	}
+	// The last free block has to go from newCapacity (or before) to the end
+	if ( this->m_mapFreeBlocks.empty() )
+	{
+		return false;
+	}
+	std::map< unsigned int, unsigned int >::iterator itLast = this->m_mapFreeBlocks.end();
+	itLast--;
+	if ( ( itLast->first + itLast->second != this->m_capacity ) || ( itLast->first > newCapacity ) )
+	{
+		return false;
+	}
+	if ( itLast->first == newCapacity )
+	{
+		this->m_mapFreeBlocks.erase( itLast );
+	}
+	else
+	{
+		itLast->second = newCapacity - itLast->first;
+	}
+	this->m_capacity = newCapacity;
+	return true;
+}
+
+bool CArenaAllocator::Allocate( unsigned int size, unsigned int &offset )
+{
+	if ( size == 0 )
+	{
+		offset = 0;
+		return true;
+	}
+	for ( std::map< unsigned int, unsigned int >::iterator itBlock = this->m_mapFreeBlocks.begin();
+		  itBlock != this->m_mapFreeBlocks.end(); itBlock++ )
+	{
+		if ( itBlock->second < size )
+		{
+			continue;
+		}
+		offset = itBlock->first;
+		const unsigned int sizeLeft = itBlock->second - size;
+		this->m_mapFreeBlocks.erase( itBlock );
+		if ( sizeLeft != 0 )
+		{
+			this->m_mapFreeBlocks[offset + size] = sizeLeft;
+		}
+		this->m_sizeInUse += size;
+		return true;
+	}
+	return false;
+}
+
+void CArenaAllocator::Free( unsigned int offset, unsigned int size )
+{
+	if ( size == 0 )
+	{
+		return;
+	}
+	this->m_sizeInUse -= size;
+	this->m_AddFreeBlock( offset, size );
+	return;
+}
+
+void CArenaAllocator::m_AddFreeBlock( unsigned int offset, unsigned int size )
+{
+	// Join it up with the free block after it...
+	std::map< unsigned int, unsigned int >::iterator itNext = this->m_mapFreeBlocks.find( offset + size );
+	if ( itNext != this->m_mapFreeBlocks.end() )
+	{
+		size += itNext->second;
+		this->m_mapFreeBlocks.erase( itNext );
+	}
+	// ...and the one before it
+	std::map< unsigned int, unsigned int >::iterator itAfter = this->m_mapFreeBlocks.lower_bound( offset );
+	if ( itAfter != this->m_mapFreeBlocks.begin() )
+	{
+		std::map< unsigned int, unsigned int >::iterator itBefore = itAfter;
+		itBefore--;
+		if ( itBefore->first + itBefore->second == offset )
+		{
+			itBefore->second += size;
+			return;
+		}
+	}
+	this->m_mapFreeBlocks[offset] = size;
+	return;
+}
+
+unsigned int CArenaAllocator::GetCapacity(void) const
+{
+	return this->m_capacity;
+}
+
+unsigned int CArenaAllocator::GetSizeInUse(void) const
+{
+	return this->m_sizeInUse;
+}
+
+unsigned int CArenaAllocator::GetLargestFreeBlock(void) const
+{
+	unsigned int largest = 0;
+	for ( std::map< unsigned int, unsigned int >::const_iterator itBlock = this->m_mapFreeBlocks.begin();
+		  itBlock != this->m_mapFreeBlocks.end(); itBlock++ )
+	{
+		if ( itBlock->second > largest )
+		{
+			largest = itBlock->second;
+		}
+	}
+	return largest;
+}
+
+unsigned int CArenaAllocator::GetNumberOfFreeBlocks(void) const
+{
+	return static_cast<unsigned int>( this->m_mapFreeBlocks.size() );
+}
+
+void CArenaAllocator::Pack( const std::vector<unsigned int> &vecOffsets, const std::vector<unsigned int> &vecSizes,
+                            std::vector<unsigned int> &vecNewOffsets )
+{
+	vecNewOffsets.resize( vecOffsets.size() );
+	unsigned int nextOffset = 0;
+	for ( unsigned int index = 0; index != static_cast<unsigned int>( vecOffsets.size() ); index++ )
+	{
+		vecNewOffsets[index] = nextOffset;
+		nextOffset += vecSizes[index];
+	}
+
+	this->Reset( this->m_capacity );
+	unsigned int offset = 0;
+	this->Allocate( nextOffset, offset );
+	return;
+}
@@ -0,0 +1,56 @@
+#ifndef _CArenaAllocator_HG_
+#define _CArenaAllocator_HG_
+
+// Hands out pieces ("blocks") of one big buffer, and takes them back again.
+// It doesn't touch any memory itself: it only keeps track of which offsets are free,
+//	so the "units" can be anything (vertices, indices, bytes, etc.).
+// cMeshManager uses it to put all the meshes into one vertex buffer and one index buffer
+//	(see cMeshManager::sMeshArena).
+//
+// The free blocks are kept in offset order, and a block that's freed is joined up with
+//	any free blocks right before or after it. Allocate() takes the first (lowest) block
+//	that's big enough, so things tend to stay packed at the start of the buffer.
+
+#include <map>
+#include <vector>
+
+class CArenaAllocator
+{
+public:
+	CArenaAllocator();
+
+	// Everything is free again (nothing is allocated)
+	void Reset( unsigned int capacity );
+	// Adds to the end (the new part is free)
+	void Grow( unsigned int newCapacity );
+	// Added: Takes the end off. Returns false (and doesn't change anything) if any of that part 
+	//	is in use (so Pack() it first)
+	bool Shrink( unsigned int newCapacity );
+
+	// Returns false if there isn't a free block that big (call Grow(), or compact it)
+	bool Allocate( unsigned int size, unsigned int &offset );
+	// size is what was passed to Allocate()
+	void Free( unsigned int offset, unsigned int size );
+
+	unsigned int GetCapacity(void) const;
+	unsigned int GetSizeInUse(void) const;
+	unsigned int GetLargestFreeBlock(void) const;
+	// 1 (or 0, if it's full) means it's not fragmented at all
+	unsigned int GetNumberOfFreeBlocks(void) const;
+
+	// For compacting: the blocks being kept, in the order they are in now. Returns the
+	//	offset each one moves to if they're packed together from 0, and resets the
+	//	allocator so only those are in use.
+	// vecOffsets and vecSizes are the blocks (same order); vecNewOffsets is the same size.
+	void Pack( const std::vector<unsigned int> &vecOffsets, const std::vector<unsigned int> &vecSizes,
+	           std::vector<unsigned int> &vecNewOffsets );
+
+private:
+	unsigned int m_capacity;
+	unsigned int m_sizeInUse;
+	std::map< unsigned int /*offset*/, unsigned int /*size*/ > m_mapFreeBlocks;
+	// Joins it up with the free blocks on either side (if they're right next to it)
+	void m_AddFreeBlock( unsigned int offset, unsigned int size );
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "CAssetCache.h"
+#include "CFileView.h"
+
+#include <string.h>		// for memcpy()
+
+#ifdef _WIN32
+	#include <windows.h>	// CreateDirectory()
+#else
+	#include <sys/stat.h>	// mkdir()
+	#include <errno.h>
+#endif
+
+//static
+const std::string CAssetCache::DEFAULTCACHEFOLDER = "assets/cooked";
+
+CAssetCache::CAssetCache()
+{
+	return;
+}
+
+void CAssetCache::SetCacheFolder( std::string cacheFolder )
+{
+	this->m_cacheFolder = cacheFolder;
+	return;
+}
+
+std::string CAssetCache::GetCacheFolder(void)
+{
+	return this->m_cacheFolder;
+}
+
+bool CAssetCache::IsEnabled(void)
+{
+	return ( !this->m_cacheFolder.empty() );
+}
+
+bool CAssetCache::CreateCacheFolder(void)
+{
+	if ( !this->IsEnabled() )
+	{
+		return false;
+	}
+#ifdef _WIN32
+	if ( !CreateDirectoryA( this->m_cacheFolder.c_str(), NULL ) && ( GetLastError() != ERROR_ALREADY_EXISTS ) )
+	{
+		return false;
+	}
+#else
+	if ( ( mkdir( this->m_cacheFolder.c_str(), 0755 ) != 0 ) && ( errno != EEXIST ) )
+	{
+		return false;
+	}
+#endif
+	return true;
+}
+
+std::string CAssetCache::GetCookedFileName( std::string sourceFileName, std::string cookedExtension )
+{
+	// Flatten the path, so everything is in the one folder
+	std::string flatName = sourceFileName;
+	for ( std::string::size_type index = 0; index != flatName.size(); index++ )
+	{
+		if ( ( flatName[index] == '/' ) || ( flatName[index] == '\\' ) || ( flatName[index] == ':' ) )
+		{
+			flatName[index] = '_';
+		}
+	}
+	return this->m_cacheFolder + "/" + flatName + cookedExtension;
+}
+
+//static
+bool CAssetCache::CalculateCookKey( std::string sourceFileName, std::string cookSettings, unsigned long long &cookKey )
+{
+	CFileView sourceFile;
+	std::string error;
+	if ( !sourceFile.Open( sourceFileName, error ) )
+	{
+		return false;
+	}
+
+	unsigned int cookVersion = CAssetCache::COOKVERSION;
+	cookKey = CAssetCache::HashBytes( reinterpret_cast<const char*>( &cookVersion ), sizeof(cookVersion), CAssetCache::HASHSTARTVALUE );
+	cookKey = CAssetCache::HashBytes( cookSettings.c_str(), static_cast<unsigned int>( cookSettings.size() ), cookKey );
+	cookKey = CAssetCache::HashBytes( sourceFile.GetData(), sourceFile.GetSize(), cookKey );
+	return true;
+}
+
+//static
+unsigned long long CAssetCache::HashBytes( const char* pData, unsigned int numberOfBytes, unsigned long long hash )
+{
+	const unsigned long long FNVPRIME = 1099511628211ULL;
+
+	// 8 bytes at a time (FNV-1a one byte at a time is about 8x slower)
+	unsigned int numberOfWords = numberOfBytes / sizeof(unsigned long long);
+	for ( unsigned int index = 0; index != numberOfWords; index++ )
+	{
+		unsigned long long word = 0;
+		memcpy( &word, pData + index * sizeof(unsigned long long), sizeof(unsigned long long) );	// (might not be aligned)
+		hash ^= word;
+		hash *= FNVPRIME;
+		hash ^= ( hash >> 32 );		// Otherwise the top bytes of each word barely affect the low bits
+	}
+	// The leftover bytes
+	for ( unsigned int index = numberOfWords * sizeof(unsigned long long); index != numberOfBytes; index++ )
+	{
+		hash ^= static_cast<unsigned char>( pData[index] );
+		hash *= FNVPRIME;
+	}
+	// The length, so "abc" + "" and "ab" + "c" are different
+	hash ^= numberOfBytes;
+	hash *= FNVPRIME;
+	return hash;
+}
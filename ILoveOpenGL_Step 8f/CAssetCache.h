@@ -0,0 +1,44 @@
+#ifndef _CAssetCache_HG_
+#define _CAssetCache_HG_
+
+// Where the "cooked" (already converted) versions of the models and textures go
+// Each cooked file is stamped with a "cook key": a hash of the source file's bytes
+//	plus a string describing how it was processed (normals, texture coords, etc.).
+// If the source file or the processing changes, so does the key, and the cooked
+//	file is out of date. Checking it means reading the source file, but not parsing it.
+//
+// Used by cMeshManager::LoadPlyIntoVBO(), CTextureManager::Create2DTextureFromBMPFile(),
+//	and the "-cook" command line tool (CAssetCooker)
+
+#include <string>
+
+class CAssetCache
+{
+public:
+	CAssetCache();
+
+	static const std::string DEFAULTCACHEFOLDER;	// "assets/cooked"
+	// Bump this if the cooked file formats change (invalidates everything)
+	static const unsigned int COOKVERSION = 1;
+
+	// Empty string (the default) turns the cache off
+	void SetCacheFolder( std::string cacheFolder );
+	std::string GetCacheFolder(void);
+	bool IsEnabled(void);
+	// Makes the folder if it's not there. Returns false if it can't
+	bool CreateCacheFolder(void);
+
+	// e.g. "assets/models/BlueWhale.ply" and ".gdp" --> "assets/cooked/assets_models_BlueWhale.ply.gdp"
+	std::string GetCookedFileName( std::string sourceFileName, std::string cookedExtension );
+
+	// Returns false if the source file can't be read
+	static bool CalculateCookKey( std::string sourceFileName, std::string cookSettings, unsigned long long &cookKey );
+	// 64 bit FNV-1a, but 8 bytes at a time
+	static unsigned long long HashBytes( const char* pData, unsigned int numberOfBytes, unsigned long long hash );
+	static const unsigned long long HASHSTARTVALUE = 14695981039346656037ULL;	// FNV offset basis
+
+private:
+	std::string m_cacheFolder;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "CAssetCooker.h"
+#include "cMeshManager.h"
+#include "GLTexture/CTextureManager.h"
+#include "Ply/CStringHelper.h"
+#include "Ply/CPlyFile5nt.h"		// For PlyWeldInfo
+#include "CHRTimer.h"
+#include "CFileView.h"
+
+#include <iomanip>
+#include <algorithm>
+
+//static
+bool CAssetCooker::CookFolders( std::string modelFolder, std::string textureFolder, 
+                                CAssetCache &cache, std::ostream &output )
+{
+	CHRTimer timer;
+	timer.Reset();
+	timer.Start();
+
+	unsigned int numberCooked = 0;
+	unsigned int numberUpToDate = 0;
+	unsigned int numberFailed = 0;
+
+	output << "Cooking into " << cache.GetCacheFolder() << std::endl;
+
+	// Models
+	std::vector<std::string> vecFileNames;
+	CFileView::FindFiles( modelFolder, "*.ply", vecFileNames );
+	for ( std::vector<std::string>::iterator itFile = vecFileNames.begin(); itFile != vecFileNames.end(); itFile++ )
+	{
+		std::string fullFileName = modelFolder + "/" + *itFile;
+		bool bWasAlreadyUpToDate = false;
+		std::wstring error;
+		PlyWeldInfo weldInfo;
+		output << std::left << std::setw(50) << fullFileName << " ";
+		if ( !cMeshManager::CookPlyFile( fullFileName, cache, bWasAlreadyUpToDate, error, &weldInfo ) )
+		{
+			output << "FAILED: " << CStringHelper::UnicodeToASCII_QnD( error ) << std::endl;
+			numberFailed++;
+		}
+		else if ( bWasAlreadyUpToDate )
+		{
+			output << "up to date" << std::endl;
+			numberUpToDate++;
+		}
+		else
+		{
+			output << "cooked (vertices: " << weldInfo.verticesBefore << " -> " << weldInfo.verticesAfter 
+				   << ", triangles: " << weldInfo.trianglesBefore << " -> " << weldInfo.trianglesAfter << ")" << std::endl;
+			numberCooked++;
+		}
+	}// for ( std::vector<std::string>::iterator itFile
+
+	// Textures
+	vecFileNames.clear();
+	CFileView::FindFiles( textureFolder, "*.bmp", vecFileNames );
+	for ( std::vector<std::string>::iterator itFile = vecFileNames.begin(); itFile != vecFileNames.end(); itFile++ )
+	{
+		std::string fullFileName = textureFolder + "/" + *itFile;
+		bool bWasAlreadyUpToDate = false;
+		std::string error;
+		output << std::left << std::setw(50) << fullFileName << " ";
+		if ( !CTextureManager::CookBMPFile( fullFileName, cache, bWasAlreadyUpToDate, error ) )
+		{
+			output << "FAILED: " << error << std::endl;
+			numberFailed++;
+		}
+		else if ( bWasAlreadyUpToDate )
+		{
+			output << "up to date" << std::endl;
+			numberUpToDate++;
+		}
+		else
+		{
+			output << "cooked" << std::endl;
+			numberCooked++;
+		}
+	}// for ( std::vector<std::string>::iterator itFile
+
+	output << numberCooked << " cooked, " << numberUpToDate << " up to date, " 
+		   << numberFailed << " failed (" << std::fixed << std::setprecision(2) 
+		   << timer.GetElapsedSeconds() << " seconds)" << std::endl;
+
+	return ( numberFailed == 0 );
+}
@@ -0,0 +1,23 @@
+#ifndef _CAssetCooker_HG_
+#define _CAssetCooker_HG_
+
+// The "-cook" command line tool
+// Converts every .ply model and .bmp texture into its cooked (ready to go to the GPU) 
+//	form, and puts them in the cache (see CAssetCache). Anything that's already cooked 
+//	and up to date is skipped, so running it again only redoes what changed.
+// Run the program with "-cook" to use it (no window, no OpenGL).
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "CAssetCache.h"
+
+class CAssetCooker
+{
+public:
+	// Returns false if anything didn't cook
+	static bool CookFolders( std::string modelFolder, std::string textureFolder, 
+	                         CAssetCache &cache, std::ostream &output );
+};
+
+#endif
@@ -0,0 +1,255 @@
+#include "CFileView.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	// So it still builds on Linux, etc.
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <dirent.h>
+	#include <fnmatch.h>
+#endif
+
+CFileView::CFileView()
+{
+	this->m_pData = 0;
+	this->m_size = 0;
+	this->m_bIsMapped = false;
+	this->m_hMapping = 0;
+	this->m_pBuffer = 0;
+	return;
+}
+
+CFileView::~CFileView()
+{
+	this->Close();
+	return;
+}
+
+bool CFileView::Open( std::wstring fileName, std::wstring &error )
+{
+	this->Close();
+
+	std::string errorASCII;
+#ifdef _WIN32
+	// The "sequential scan" flag tells Windows to read ahead (and not bother caching what's behind)
+	HANDLE hFile = CreateFileW( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+	                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if ( !this->m_MapOrReadFile( hFile, errorASCII ) )
+#else
+	std::string fileNameASCII( fileName.begin(), fileName.end() );
+	if ( !this->m_MapOrReadFile( fileNameASCII, errorASCII ) )
+#endif
+	{
+		error = std::wstring( errorASCII.begin(), errorASCII.end() );
+		return false;
+	}
+	return true;
+}
+
+bool CFileView::Open( std::string fileName, std::string &error )
+{
+	this->Close();
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+	                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	return this->m_MapOrReadFile( hFile, error );
+#else
+	return this->m_MapOrReadFile( fileName, error );
+#endif
+}
+
+#ifdef _WIN32
+bool CFileView::m_MapOrReadFile( void* hFile, std::string &error )
+{
+	if ( hFile == INVALID_HANDLE_VALUE )
+	{
+		error = "Can't open the file.";
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if ( !GetFileSizeEx( hFile, &fileSize ) || ( fileSize.QuadPart > 0xFFFFFFFF ) )
+	{
+		error = "Can't get the size of the file (or it's over 4 GB).";
+		CloseHandle( hFile );
+		return false;
+	}
+	this->m_size = static_cast<unsigned int>( fileSize.QuadPart );
+
+	// Can't map an empty file, so those always get read (which is nothing)
+	if ( this->m_size > 0 )
+	{
+		this->m_hMapping = CreateFileMappingA( hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+		if ( this->m_hMapping != NULL )
+		{
+			this->m_pData = static_cast<char*>( MapViewOfFile( this->m_hMapping, FILE_MAP_COPY, 0, 0, 0 ) );
+			if ( this->m_pData != NULL )
+			{
+				this->m_bIsMapped = true;
+			}
+			else
+			{
+				CloseHandle( this->m_hMapping );
+				this->m_hMapping = 0;
+			}
+		}
+	}
+
+	if ( !this->m_bIsMapped )
+	{	// Plan "B": read the whole thing
+		this->m_pBuffer = new char[ this->m_size + 1 ];
+		DWORD bytesRead = 0;
+		if ( ( this->m_size > 0 ) &&
+			 ( !ReadFile( hFile, this->m_pBuffer, this->m_size, &bytesRead, NULL ) || ( bytesRead != this->m_size ) ) )
+		{
+			error = "Can't read the file.";
+			CloseHandle( hFile );
+			this->Close();
+			return false;
+		}
+		this->m_pBuffer[this->m_size] = 0;
+		this->m_pData = this->m_pBuffer;
+	}
+
+	// The mapping keeps its own reference to the file
+	CloseHandle( hFile );
+	return true;
+}
+#else
+bool CFileView::m_MapOrReadFile( std::string fileName, std::string &error )
+{
+	int fileDescriptor = open( fileName.c_str(), O_RDONLY );
+	if ( fileDescriptor < 0 )
+	{
+		error = "Can't open the file.";
+		return false;
+	}
+
+	struct stat fileInfo;
+	if ( ( fstat( fileDescriptor, &fileInfo ) != 0 ) || ( static_cast<unsigned long long>( fileInfo.st_size ) > 0xFFFFFFFFULL ) )
+	{
+		error = "Can't get the size of the file (or it's over 4 GB).";
+		close( fileDescriptor );
+		return false;
+	}
+	this->m_size = static_cast<unsigned int>( fileInfo.st_size );
+
+	if ( this->m_size > 0 )
+	{
+		void* pMapped = mmap( 0, this->m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileDescriptor, 0 );
+		if ( pMapped != MAP_FAILED )
+		{
+			madvise( pMapped, this->m_size, MADV_SEQUENTIAL );
+			madvise( pMapped, this->m_size, MADV_WILLNEED );
+			this->m_pData = static_cast<char*>( pMapped );
+			this->m_bIsMapped = true;
+		}
+	}
+
+	if ( !this->m_bIsMapped )
+	{	// Plan "B": read the whole thing
+		this->m_pBuffer = new char[ this->m_size + 1 ];
+		unsigned int totalRead = 0;
+		while ( totalRead < this->m_size )
+		{
+			ssize_t bytesRead = read( fileDescriptor, this->m_pBuffer + totalRead, this->m_size - totalRead );
+			if ( bytesRead <= 0 )
+			{
+				error = "Can't read the file.";
+				close( fileDescriptor );
+				this->Close();
+				return false;
+			}
+			totalRead += static_cast<unsigned int>( bytesRead );
+		}
+		this->m_pBuffer[this->m_size] = 0;
+		this->m_pData = this->m_pBuffer;
+	}
+
+	close( fileDescriptor );
+	return true;
+}
+#endif
+
+void CFileView::Close(void)
+{
+	if ( this->m_bIsMapped )
+	{
+#ifdef _WIN32
+		UnmapViewOfFile( this->m_pData );
+		CloseHandle( this->m_hMapping );
+#else
+		munmap( this->m_pData, this->m_size );
+#endif
+	}
+	delete [] this->m_pBuffer;
+
+	this->m_pData = 0;
+	this->m_size = 0;
+	this->m_bIsMapped = false;
+	this->m_hMapping = 0;
+	this->m_pBuffer = 0;
+	return;
+}
+
+bool CFileView::IsOpen(void)
+{
+	return ( this->m_pData != 0 );
+}
+
+bool CFileView::IsMapped(void)
+{
+	return this->m_bIsMapped;
+}
+
+char* CFileView::GetData(void)
+{
+	return this->m_pData;
+}
+
+unsigned int CFileView::GetSize(void)
+{
+	return this->m_size;
+}
+
+//static
+bool CFileView::FindFiles( std::string folder, std::string wildcard, std::vector<std::string> &vecFileNames )
+{
+	vecFileNames.clear();
+#ifdef _WIN32
+	WIN32_FIND_DATAA findData;
+	HANDLE hFind = FindFirstFileA( ( folder + "/" + wildcard ).c_str(), &findData );
+	if ( hFind == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+	do
+	{
+		vecFileNames.push_back( findData.cFileName );
+	} while ( FindNextFileA( hFind, &findData ) );
+	FindClose( hFind );
+#else
+	DIR* pFolder = opendir( folder.c_str() );
+	if ( pFolder == 0 )
+	{
+		return false;
+	}
+	while ( dirent* pEntry = readdir( pFolder ) )
+	{
+		if ( fnmatch( wildcard.c_str(), pEntry->d_name, 0 ) == 0 )
+		{
+			vecFileNames.push_back( pEntry->d_name );
+		}
+	}
+	closedir( pFolder );
+#endif
+
+	std::sort( vecFileNames.begin(), vecFileNames.end() );
+	return !vecFileNames.empty();
+}
@@ -0,0 +1,58 @@
+#ifndef _CFileView_HG_
+#define _CFileView_HG_
+
+// Read-only "view" of an entire file, used by the model and texture loaders
+// The file is memory mapped (with a "I'm going to read this from start to end" hint),
+//	so the loaders can parse it in place, without a second, full size copy in memory.
+// If mapping doesn't work, it falls back to reading the whole file into a buffer,
+//	the way the loaders used to. Either way, GetData() and GetSize() work the same.
+//
+// NOTE: The view is "copy on write": if something writes to the data, it gets
+//	its own copy of that page. The file on disk is never changed.
+
+#include <string>
+#include <vector>
+
+class CFileView
+{
+public:
+	CFileView();
+	~CFileView();		// Calls Close()
+
+	// Returns false (and sets error) if the file can't be opened or read
+	bool Open( std::wstring fileName, std::wstring &error );
+	bool Open( std::string fileName, std::string &error );
+	void Close(void);
+
+	bool IsOpen(void);
+	// true if the file is memory mapped, false if it fell back to reading into a buffer
+	bool IsMapped(void);
+
+	char* GetData(void);
+	unsigned int GetSize(void);
+
+	// Added: The names (no path) of the files in the folder that match the wildcard, like "*.ply", 
+	//	sorted (so the tools that go through a whole folder always do it in the same order)
+	// Returns false if there aren't any.
+	static bool FindFiles( std::string folder, std::string wildcard, std::vector<std::string> &vecFileNames );
+
+private:
+	// Can't be copied (it owns the mapping or the buffer)
+	CFileView( const CFileView &rhs );
+	CFileView& operator=( const CFileView &rhs );
+
+	// Maps the file (or reads it if that doesn't work). Closes the file when done.
+#ifdef _WIN32
+	bool m_MapOrReadFile( void* hFile, std::string &error );		// HANDLE from CreateFile()
+#else
+	bool m_MapOrReadFile( std::string fileName, std::string &error );
+#endif
+
+	char* m_pData;
+	unsigned int m_size;
+	bool m_bIsMapped;
+	void* m_hMapping;		// HANDLE from CreateFileMapping() (Windows only)
+	char* m_pBuffer;		// Only used if the mapping didn't work
+};
+
+#endif
@@ -0,0 +1,339 @@
+#include "CGPUUploadRing.h"
+
+#include <GL/freeglut.h>	// For glutGetProcAddress()
+#include <string.h>			// for memcpy()
+#include <vector>
+
+// (the glew that's here is older than ARB_buffer_storage, so these are from glcorearb.h)
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (GLAPIENTRY *PFNBUFFERSTORAGE)( GLenum target, GLsizeiptr size, const void* data, GLbitfield flags );
+
+CGPUUploadRing::CGPUUploadRing()
+{
+	this->m_bufferID = 0;
+	this->m_sizeInBytes = 0;
+	this->m_mode = CGPUUploadRing::MODE_NONE;
+	this->m_pPersistentMapping = 0;
+	this->m_head = 0;
+	this->m_sizeInUse = 0;
+	this->m_sizeThisFrame = 0;
+	this->m_bytesUploadedThisFrame = 0;
+	this->m_totalBytesUploaded = 0;
+	this->m_numberOfWaits = 0;
+	this->m_numberOfFallbacks = 0;
+	return;
+}
+
+CGPUUploadRing::~CGPUUploadRing()
+{
+	// (ShutDown() needs OpenGL, so it's up to whoever called Initialize())
+	return;
+}
+
+bool CGPUUploadRing::Initialize( unsigned int sizeInBytes, std::string &error )
+{
+	this->ShutDown();
+
+	// Is glBufferStorage() there? (4.4, or the extension)
+	GLint majorVersion = 0;
+	GLint minorVersion = 0;
+	glGetIntegerv( GL_MAJOR_VERSION, &majorVersion );
+	glGetIntegerv( GL_MINOR_VERSION, &minorVersion );
+	bool bHasBufferStorage = ( majorVersion > 4 ) || ( ( majorVersion == 4 ) && ( minorVersion >= 4 ) );
+	GLint numberOfExtensions = 0;
+	glGetIntegerv( GL_NUM_EXTENSIONS, &numberOfExtensions );
+	for ( GLint index = 0; ( index < numberOfExtensions ) && !bHasBufferStorage; index++ )
+	{
+		const GLubyte* pExtension = glGetStringi( GL_EXTENSIONS, index );
+		bHasBufferStorage = ( pExtension != 0 ) && ( strcmp( reinterpret_cast<const char*>( pExtension ), "GL_ARB_buffer_storage" ) == 0 );
+	}
+	PFNBUFFERSTORAGE pBufferStorage = 0;
+	if ( bHasBufferStorage )
+	{
+		pBufferStorage = reinterpret_cast<PFNBUFFERSTORAGE>( glutGetProcAddress( "glBufferStorage" ) );
+	}
+
+	glGenBuffers( 1, &(this->m_bufferID) );
+	glBindBuffer( GL_COPY_READ_BUFFER, this->m_bufferID );
+	if ( pBufferStorage != 0 )
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		pBufferStorage( GL_COPY_READ_BUFFER, sizeInBytes, 0, flags );
+		this->m_pPersistentMapping = static_cast<unsigned char*>( glMapBufferRange( GL_COPY_READ_BUFFER, 0, sizeInBytes, flags ) );
+	}
+	if ( this->m_pPersistentMapping != 0 )
+	{
+		this->m_mode = CGPUUploadRing::MODE_PERSISTENT;
+	}
+	else
+	{	// (a buffer made with glBufferStorage() can't be made again with glBufferData(), so start over)
+		glDeleteBuffers( 1, &(this->m_bufferID) );
+		glGenBuffers( 1, &(this->m_bufferID) );
+		glBindBuffer( GL_COPY_READ_BUFFER, this->m_bufferID );
+		glBufferData( GL_COPY_READ_BUFFER, sizeInBytes, 0, GL_STREAM_DRAW );
+		this->m_mode = CGPUUploadRing::MODE_UNSYNCHRONIZED;
+	}
+	glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+
+	if ( glGetError() != GL_NO_ERROR )
+	{
+		error = "Couldn't make the upload ring buffer";
+		this->ShutDown();
+		return false;
+	}
+	this->m_sizeInBytes = sizeInBytes;
+	return true;
+}
+
+void CGPUUploadRing::ShutDown(void)
+{
+	while ( !this->m_queueFencedWrites.empty() )
+	{
+		glDeleteSync( this->m_queueFencedWrites.front().fence );
+		this->m_queueFencedWrites.pop_front();
+	}
+	if ( this->m_bufferID != 0 )
+	{
+		if ( this->m_pPersistentMapping != 0 )
+		{
+			glBindBuffer( GL_COPY_READ_BUFFER, this->m_bufferID );
+			glUnmapBuffer( GL_COPY_READ_BUFFER );
+			glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+		}
+		glDeleteBuffers( 1, &(this->m_bufferID) );
+	}
+	this->m_bufferID = 0;
+	this->m_sizeInBytes = 0;
+	this->m_mode = CGPUUploadRing::MODE_NONE;
+	this->m_pPersistentMapping = 0;
+	this->m_head = 0;
+	this->m_sizeInUse = 0;
+	this->m_sizeThisFrame = 0;
+	return;
+}
+
+CGPUUploadRing::enumMode CGPUUploadRing::GetMode(void) const
+{
+	return this->m_mode;
+}
+
+void CGPUUploadRing::UploadToBuffer( GLuint destinationBuffer, unsigned int destinationOffset, unsigned int sizeInBytes, const void* pData )
+{
+	std::function<void(void*)> writeData = [pData, sizeInBytes]( void* pDestination )
+	{
+		memcpy( pDestination, pData, sizeInBytes );
+	};
+	this->UploadToBuffer( destinationBuffer, destinationOffset, sizeInBytes, writeData );
+	return;
+}
+
+void CGPUUploadRing::UploadToBuffer( GLuint destinationBuffer, unsigned int destinationOffset, unsigned int sizeInBytes,
+                                     std::function<void(void* pDestination)> writeData )
+{
+	if ( sizeInBytes == 0 )
+	{
+		return;
+	}
+	this->m_bytesUploadedThisFrame += sizeInBytes;
+	this->m_totalBytesUploaded += sizeInBytes;
+
+	unsigned int offset = 0;
+	if ( ( this->m_mode != CGPUUploadRing::MODE_NONE ) && this->m_Allocate( sizeInBytes, offset ) &&
+	     this->m_Write( offset, sizeInBytes, writeData ) )
+	{
+		glBindBuffer( GL_COPY_READ_BUFFER, this->m_bufferID );
+		glBindBuffer( GL_COPY_WRITE_BUFFER, destinationBuffer );
+		glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, destinationOffset, sizeInBytes );
+		glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+		glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+		return;
+	}
+
+	if ( this->m_mode != CGPUUploadRing::MODE_NONE )
+	{
+		this->m_numberOfFallbacks++;
+	}
+	std::vector<unsigned char> vecData( sizeInBytes );
+	writeData( &(vecData[0]) );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, destinationBuffer );
+	glBufferSubData( GL_COPY_WRITE_BUFFER, destinationOffset, sizeInBytes, &(vecData[0]) );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+	return;
+}
+
+void CGPUUploadRing::UploadToTexture2D( GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+                                        const void* pPixels, unsigned int sizeInBytes )
+{
+	std::function<void(void*)> writeData = [pPixels, sizeInBytes]( void* pDestination )
+	{
+		memcpy( pDestination, pPixels, sizeInBytes );
+	};
+	if ( !this->m_UploadToTexture2DThroughRing( level, x, y, width, height, format, type, writeData, sizeInBytes ) )
+	{
+		glTexSubImage2D( GL_TEXTURE_2D, level, x, y, width, height, format, type, pPixels );
+	}
+	return;
+}
+
+void CGPUUploadRing::UploadToTexture2D( GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+                                        std::function<void(void* pDestination)> writeData, unsigned int sizeInBytes )
+{
+	if ( !this->m_UploadToTexture2DThroughRing( level, x, y, width, height, format, type, writeData, sizeInBytes ) )
+	{
+		std::vector<unsigned char> vecPixels( sizeInBytes );
+		if ( sizeInBytes != 0 )
+		{
+			writeData( &(vecPixels[0]) );
+		}
+		glTexSubImage2D( GL_TEXTURE_2D, level, x, y, width, height, format, type, vecPixels.empty() ? 0 : &(vecPixels[0]) );
+	}
+	return;
+}
+
+bool CGPUUploadRing::m_UploadToTexture2DThroughRing( GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+                                                     std::function<void(void* pDestination)> &writeData, unsigned int sizeInBytes )
+{
+	this->m_bytesUploadedThisFrame += sizeInBytes;
+	this->m_totalBytesUploaded += sizeInBytes;
+	if ( ( this->m_mode == CGPUUploadRing::MODE_NONE ) || ( sizeInBytes == 0 ) )
+	{
+		return false;
+	}
+
+	unsigned int offset = 0;
+	if ( this->m_Allocate( sizeInBytes, offset ) && this->m_Write( offset, sizeInBytes, writeData ) )
+	{	// (with a buffer bound to GL_PIXEL_UNPACK_BUFFER, the "pointer" is the offset into it)
+		glBindBuffer( GL_PIXEL_UNPACK_BUFFER, this->m_bufferID );
+		glTexSubImage2D( GL_TEXTURE_2D, level, x, y, width, height, format, type, reinterpret_cast<const void*>( static_cast<size_t>( offset ) ) );
+		glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+		return true;
+	}
+	this->m_numberOfFallbacks++;
+	return false;
+}
+
+bool CGPUUploadRing::m_Allocate( unsigned int sizeInBytes, unsigned int &offset )
+{
+	const unsigned int alignedSize = ( sizeInBytes + CGPUUploadRing::ALIGNMENT - 1 ) & ~( CGPUUploadRing::ALIGNMENT - 1 );
+	if ( alignedSize > this->m_sizeInBytes )
+	{
+		return false;
+	}
+	if ( this->m_sizeInUse == 0 )
+	{	// (nothing in use, so start at the beginning; it's less likely to have to wrap)
+		this->m_head = 0;
+	}
+
+	while ( true )
+	{
+		// If it doesn't fit before the end, the rest of the ring is skipped (and counts as used)
+		const unsigned int sizeToEnd = this->m_sizeInBytes - this->m_head;
+		const unsigned int sizeNeeded = ( alignedSize > sizeToEnd ) ? ( alignedSize + sizeToEnd ) : alignedSize;
+		if ( this->m_sizeInUse + sizeNeeded <= this->m_sizeInBytes )
+		{
+			if ( alignedSize > sizeToEnd )
+			{
+				this->m_head = 0;
+			}
+			offset = this->m_head;
+			this->m_head = ( this->m_head + alignedSize ) % this->m_sizeInBytes;
+			this->m_sizeInUse += sizeNeeded;
+			this->m_sizeThisFrame += sizeNeeded;
+			return true;
+		}
+
+		// Full, so wait for the oldest frame (if it's all this frame, fence it first)
+		if ( this->m_queueFencedWrites.empty() )
+		{
+			this->m_FenceThisFrame();
+		}
+		sFencedWrites oldest = this->m_queueFencedWrites.front();
+		this->m_queueFencedWrites.pop_front();
+		GLenum waitResult = glClientWaitSync( oldest.fence, 0, 0 );
+		if ( waitResult == GL_TIMEOUT_EXPIRED )
+		{
+			this->m_numberOfWaits++;
+			const GLuint64 ONESECONDINNANOSECONDS = 1000000000;
+			do
+			{
+				waitResult = glClientWaitSync( oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, ONESECONDINNANOSECONDS );
+			}
+			while ( waitResult == GL_TIMEOUT_EXPIRED );
+		}
+		glDeleteSync( oldest.fence );
+		this->m_sizeInUse -= oldest.sizeInBytes;
+		if ( this->m_sizeInUse == 0 )
+		{
+			this->m_head = 0;
+		}
+	}
+}
+
+bool CGPUUploadRing::m_Write( unsigned int offset, unsigned int sizeInBytes, std::function<void(void* pDestination)> &writeData )
+{
+	if ( this->m_mode == CGPUUploadRing::MODE_PERSISTENT )
+	{	// (coherent, so the copy sees it without a flush)
+		writeData( this->m_pPersistentMapping + offset );
+		return true;
+	}
+
+	// (unsynchronized: the fences already make sure the GPU isn't using this part)
+	glBindBuffer( GL_COPY_READ_BUFFER, this->m_bufferID );
+	void* pMapped = glMapBufferRange( GL_COPY_READ_BUFFER, offset, sizeInBytes,
+	                                  GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT );
+	bool bWritten = false;
+	if ( pMapped != 0 )
+	{
+		writeData( pMapped );
+		// The contents are "undefined" if unmapping didn't work (like if the screen mode changed)
+		bWritten = ( glUnmapBuffer( GL_COPY_READ_BUFFER ) == GL_TRUE );
+	}
+	glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+	return bWritten;
+}
+
+void CGPUUploadRing::m_FenceThisFrame(void)
+{
+	if ( this->m_sizeThisFrame == 0 )
+	{
+		return;
+	}
+	sFencedWrites fencedWrites;
+	fencedWrites.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	fencedWrites.sizeInBytes = this->m_sizeThisFrame;
+	this->m_queueFencedWrites.push_back( fencedWrites );
+	this->m_sizeThisFrame = 0;
+	return;
+}
+
+void CGPUUploadRing::EndFrame(void)
+{
+	this->m_FenceThisFrame();
+	this->m_bytesUploadedThisFrame = 0;
+	return;
+}
+
+unsigned int CGPUUploadRing::GetBytesUploadedThisFrame(void) const
+{
+	return this->m_bytesUploadedThisFrame;
+}
+
+unsigned long long CGPUUploadRing::GetTotalBytesUploaded(void) const
+{
+	return this->m_totalBytesUploaded;
+}
+
+unsigned int CGPUUploadRing::GetNumberOfWaits(void) const
+{
+	return this->m_numberOfWaits;
+}
+
+unsigned int CGPUUploadRing::GetNumberOfFallbacks(void) const
+{
+	return this->m_numberOfFallbacks;
+}
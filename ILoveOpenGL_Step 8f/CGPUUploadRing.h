@@ -0,0 +1,104 @@
+#ifndef _CGPUUploadRing_HG_
+#define _CGPUUploadRing_HG_
+
+// A "staging" buffer that mesh and texture data is written into on the way to the GPU.
+// glBufferSubData() and glTexSubImage2D() from regular memory can make the driver copy
+//	everything right then (on the OpenGL thread). Writing it here, then copying it on the GPU
+//	(glCopyBufferSubData(), or glTexSubImage2D() from a GL_PIXEL_UNPACK_BUFFER), doesn't.
+//
+// It's used as a ring: each write goes after the last one, and wraps around to the start.
+//	EndFrame() puts a fence after each frame's writes; a part of the ring isn't written
+//	over until the GPU is past that frame's fence (it waits, if it has to).
+//
+// If the driver has glBufferStorage() (OpenGL 4.4, or ARB_buffer_storage), the buffer is
+//	mapped once and stays mapped ("persistent"). If not, each write maps just its part of
+//	the buffer (unsynchronized, since the fences already say it's not in use). If that doesn't
+//	work either, or it's bigger than the ring, it's uploaded the "old" way.
+
+#include <GL/glew.h>
+#include <deque>
+#include <functional>
+#include <string>
+
+class CGPUUploadRing
+{
+public:
+	CGPUUploadRing();
+	~CGPUUploadRing();
+
+	// Needs OpenGL. Until this is called (or if it fails), everything is uploaded the "old" way.
+	bool Initialize( unsigned int sizeInBytes, std::string &error );
+	void ShutDown(void);
+
+	enum enumMode
+	{
+		MODE_NONE = 0,			// Not initialized: straight from memory (glBufferSubData(), etc.)
+		MODE_PERSISTENT,		// Mapped the whole time (glBufferStorage())
+		MODE_UNSYNCHRONIZED		// Mapped for each write (glMapBufferRange())
+	};
+	enumMode GetMode(void) const;
+
+	// Copies into destinationBuffer (at destinationOffset). Doesn't change any buffer bindings
+	//	(it uses GL_COPY_READ_BUFFER and GL_COPY_WRITE_BUFFER), so the VAO doesn't matter.
+	void UploadToBuffer( GLuint destinationBuffer, unsigned int destinationOffset, unsigned int sizeInBytes, const void* pData );
+	// Same, but writeData() writes the sizeInBytes bytes itself (so it can go straight from,
+	//	say, a ply's vertex streams, without another copy)
+	void UploadToBuffer( GLuint destinationBuffer, unsigned int destinationOffset, unsigned int sizeInBytes,
+	                     std::function<void(void* pDestination)> writeData );
+	// glTexSubImage2D() on the texture bound to GL_TEXTURE_2D
+	// (sizeInBytes is all of pPixels, with GL_UNPACK_ALIGNMENT the way it is now)
+	void UploadToTexture2D( GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+	                        const void* pPixels, unsigned int sizeInBytes );
+	// Same, but writeData() writes the pixels (like a decoder writing straight into the ring)
+	void UploadToTexture2D( GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+	                        std::function<void(void* pDestination)> writeData, unsigned int sizeInBytes );
+
+	// Call once a frame, after the draws. Fences this frame's writes.
+	void EndFrame(void);
+
+	// How much has been uploaded since the last EndFrame() (any mode)
+	unsigned int GetBytesUploadedThisFrame(void) const;
+	unsigned long long GetTotalBytesUploaded(void) const;
+	// How many times it had to wait for the GPU (the ring was full), and how many uploads
+	//	didn't go through the ring (too big, or the map didn't work)
+	unsigned int GetNumberOfWaits(void) const;
+	unsigned int GetNumberOfFallbacks(void) const;
+
+	static const unsigned int DEFAULTSIZEINBYTES = 16 * 1024 * 1024;
+	// Each write starts on this (enough for any of the vertex, index or pixel types)
+	static const unsigned int ALIGNMENT = 64;
+
+private:
+	GLuint m_bufferID;
+	unsigned int m_sizeInBytes;
+	enumMode m_mode;
+	unsigned char* m_pPersistentMapping;
+
+	// Where the next write goes, and how much is in use (written, but the GPU might not be done with it)
+	unsigned int m_head;
+	unsigned int m_sizeInUse;
+	// This frame's part (it doesn't have a fence yet)
+	unsigned int m_sizeThisFrame;
+	struct sFencedWrites
+	{
+		GLsync fence;
+		unsigned int sizeInBytes;		// (everything up to the fence, including what was skipped to wrap around)
+	};
+	std::deque< sFencedWrites > m_queueFencedWrites;
+	void m_FenceThisFrame(void);
+
+	unsigned int m_bytesUploadedThisFrame;
+	unsigned long long m_totalBytesUploaded;
+	unsigned int m_numberOfWaits;
+	unsigned int m_numberOfFallbacks;
+
+	// Finds room (waits for the GPU if it has to). False if it's bigger than the ring.
+	bool m_Allocate( unsigned int sizeInBytes, unsigned int &offset );
+	// Writes into the ring at offset. False if it couldn't be mapped (so use the fallback).
+	bool m_Write( unsigned int offset, unsigned int sizeInBytes, std::function<void(void* pDestination)> &writeData );
+	// Both UploadToTexture2D()s. False if it has to be done the "old" way.
+	bool m_UploadToTexture2DThroughRing( GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+	                                     std::function<void(void* pDestination)> &writeData, unsigned int sizeInBytes );
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "CThreadPool.h"
+#include <atomic>
+#include <memory>
+
+//static 
+CThreadPool* CThreadPool::m_pTheSharedInstance = 0;
+//static 
+std::mutex CThreadPool::m_sharedInstanceMutex;
+
+CThreadPool::CThreadPool( unsigned int numberOfThreads /*= 0*/ )
+{
+	this->m_bShuttingDown = false;
+
+	if ( numberOfThreads == 0 )
+	{
+		numberOfThreads = std::thread::hardware_concurrency();
+		// Can return zero if it can't figure it out
+		if ( numberOfThreads == 0 )
+		{
+			numberOfThreads = 2;
+		}
+	}
+
+	for ( unsigned int threadCount = 0; threadCount != numberOfThreads; threadCount++ )
+	{
+		this->m_vecThreads.push_back( std::thread( &CThreadPool::m_WorkerThreadLoop, this ) );
+	}
+	return;
+}
+
+CThreadPool::~CThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock( this->m_queueMutex );
+		this->m_bShuttingDown = true;
+	}
+	this->m_queueCondition.notify_all();
+
+	for ( std::vector<std::thread>::iterator itThread = this->m_vecThreads.begin(); itThread != this->m_vecThreads.end(); itThread++ )
+	{
+		itThread->join();
+	}
+	return;
+}
+
+//static 
+CThreadPool* CThreadPool::getSharedInstance(void)
+{
+	std::unique_lock<std::mutex> lock( CThreadPool::m_sharedInstanceMutex );
+	if ( CThreadPool::m_pTheSharedInstance == 0 )
+	{
+		CThreadPool::m_pTheSharedInstance = new CThreadPool();
+	}
+	return CThreadPool::m_pTheSharedInstance;
+}
+
+unsigned int CThreadPool::GetNumberOfThreads(void)
+{
+	return static_cast<unsigned int>( this->m_vecThreads.size() );
+}
+
+std::future<void> CThreadPool::AddJob( std::function<void(void)> job )
+{
+	// packaged_task isn't copyable, but std::function has to be... so wrap it in a shared_ptr
+	std::shared_ptr< std::packaged_task<void(void)> > pTask( new std::packaged_task<void(void)>( job ) );
+	std::future<void> jobFuture = pTask->get_future();
+	{
+		std::unique_lock<std::mutex> lock( this->m_queueMutex );
+		this->m_queueJobs.push_back( [pTask]() { (*pTask)(); } );
+	}
+	this->m_queueCondition.notify_one();
+	return jobFuture;
+}
+
+void CThreadPool::ParallelFor( unsigned int numberOfJobs, std::function<void(unsigned int)> job )
+{
+	if ( numberOfJobs == 0 )
+	{
+		return;
+	}
+
+	// Everyone (the pool threads AND this thread) grabs the next job index until they're gone.
+	// This is shared, since a helper might not even start until after we've returned.
+	struct sSharedState
+	{
+		std::atomic<unsigned int> nextJob;
+		std::atomic<unsigned int> jobsDone;
+		std::mutex doneMutex;
+		std::condition_variable doneCondition;
+		std::function<void(unsigned int)> job;
+		unsigned int numberOfJobs;
+	};
+	std::shared_ptr<sSharedState> pState( new sSharedState() );
+	pState->nextJob = 0;
+	pState->jobsDone = 0;
+	pState->job = job;
+	pState->numberOfJobs = numberOfJobs;
+
+	std::function<void(void)> grabJobs = [pState]()
+	{
+		unsigned int jobIndex = pState->nextJob++;
+		for ( ; jobIndex < pState->numberOfJobs; jobIndex = pState->nextJob++ )
+		{
+			pState->job( jobIndex );
+			if ( ++(pState->jobsDone) == pState->numberOfJobs )
+			{
+				std::unique_lock<std::mutex> lock( pState->doneMutex );
+				pState->doneCondition.notify_all();
+			}
+		}
+	};
+
+	// No point in waking more helpers than there are jobs (this thread is one of the "helpers")
+	unsigned int numberOfHelpers = this->GetNumberOfThreads();
+	if ( numberOfHelpers > ( numberOfJobs - 1 ) )
+	{
+		numberOfHelpers = numberOfJobs - 1;
+	}
+	{
+		std::unique_lock<std::mutex> lock( this->m_queueMutex );
+		for ( unsigned int helperCount = 0; helperCount != numberOfHelpers; helperCount++ )
+		{
+			this->m_queueJobs.push_back( grabJobs );
+		}
+	}
+	this->m_queueCondition.notify_all();
+
+	grabJobs();
+
+	// Wait for any that the helpers are still working on
+	std::unique_lock<std::mutex> lock( pState->doneMutex );
+	while ( pState->jobsDone != pState->numberOfJobs )
+	{
+		pState->doneCondition.wait( lock );
+	}
+	return;
+}
+
+void CThreadPool::m_WorkerThreadLoop(void)
+{
+	while ( true )
+	{
+		std::function<void(void)> job;
+		{
+			std::unique_lock<std::mutex> lock( this->m_queueMutex );
+			while ( !this->m_bShuttingDown && this->m_queueJobs.empty() )
+			{
+				this->m_queueCondition.wait( lock );
+			}
+			if ( this->m_bShuttingDown && this->m_queueJobs.empty() )
+			{
+				return;
+			}
+			job = this->m_queueJobs.front();
+			this->m_queueJobs.pop_front();
+		}
+		job();
+	}
+}
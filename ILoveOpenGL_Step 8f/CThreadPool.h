@@ -0,0 +1,51 @@
+#ifndef _CThreadPool_HG_
+#define _CThreadPool_HG_
+
+// A (very) simple pool of worker threads
+// Jobs are std::function<void(void)> objects that are run, in order, by whichever 
+//	thread is free. Used for the "heavy lifting" on load (ply parsing, etc.)
+//
+// NOTE: ParallelFor() is safe to call from *inside* a job: the calling thread 
+//	does the work as well, so it can't dead-lock waiting for a busy pool.
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class CThreadPool
+{
+public:
+	// Zero threads means "one per core" (std::thread::hardware_concurrency)
+	CThreadPool( unsigned int numberOfThreads = 0 );
+	~CThreadPool();
+
+	// Shared pool (created the first time it's called)
+	static CThreadPool* getSharedInstance(void);
+
+	unsigned int GetNumberOfThreads(void);
+
+	// Adds a job to the queue. The future is "ready" when the job is done.
+	std::future<void> AddJob( std::function<void(void)> job );
+
+	// Calls job(0) to job(numberOfJobs-1) on the pool (and the calling thread), 
+	//	then returns when they are all done. The order they run in isn't defined.
+	void ParallelFor( unsigned int numberOfJobs, std::function<void(unsigned int)> job );
+
+private:
+	std::vector<std::thread> m_vecThreads;
+	std::deque< std::function<void(void)> > m_queueJobs;
+	std::mutex m_queueMutex;
+	std::condition_variable m_queueCondition;
+	bool m_bShuttingDown;
+
+	void m_WorkerThreadLoop(void);
+
+	static CThreadPool* m_pTheSharedInstance;
+	static std::mutex m_sharedInstanceMutex;
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include "CBMPRowDecoder.h"
+
+#include <immintrin.h>	// SSSE3 (tmmintrin.h) and AVX2
+#if defined(_MSC_VER)
+#include <intrin.h>		// __cpuid(), __cpuidex()
+#endif
+
+// (Visual Studio lets any function use any instructions; gcc and clang have to be told which ones)
+#if defined(__GNUC__)
+#define BMPDECODER_TARGET(instructions) __attribute__((target(instructions)))
+#else
+#define BMPDECODER_TARGET(instructions)
+#endif
+
+//static
+unsigned int CBMPRowDecoder::GetFileRowSizeInBytes( unsigned int width )
+{
+	return ( ( 3 * width + 3 ) / 4 ) * 4;
+}
+
+//static
+unsigned int CBMPRowDecoder::GetBytesPerPixel( enumOutputFormat outputFormat )
+{
+	return ( outputFormat == CBMPRowDecoder::OUTPUT_RGBA ) ? 4 : 3;
+}
+
+//static
+void CBMPRowDecoder::DecodeImage( const unsigned char* pFirstRowInFile, unsigned int width, unsigned int height, bool bTopRowFirst,
+                                  enumOutputFormat outputFormat, unsigned char* pDestination )
+{
+	CBMPRowDecoder::DecodeRows( pFirstRowInFile, width, height, bTopRowFirst, outputFormat, pDestination, 0, height );
+	return;
+}
+
+//static
+void CBMPRowDecoder::DecodeRows( const unsigned char* pFirstRowInFile, unsigned int width, unsigned int height, bool bTopRowFirst,
+                                 enumOutputFormat outputFormat, unsigned char* pDestination, unsigned int firstRow, unsigned int lastRow )
+{
+	const size_t fileRowSizeInBytes = CBMPRowDecoder::GetFileRowSizeInBytes( width );
+	const size_t destinationRowSizeInBytes = static_cast<size_t>( width ) * CBMPRowDecoder::GetBytesPerPixel( outputFormat );
+	for ( unsigned int row = firstRow; row < lastRow; row++ )
+	{
+		// (row 0 is the bottom one; if the file starts at the top, it's the last one in the file)
+		const unsigned int rowInFile = bTopRowFirst ? ( height - 1 - row ) : row;
+		CBMPRowDecoder::DecodeRow( pFirstRowInFile + rowInFile * fileRowSizeInBytes, width, outputFormat,
+		                           pDestination + row * destinationRowSizeInBytes );
+	}
+	return;
+}
+
+//static
+CBMPRowDecoder::enumInstructionSet CBMPRowDecoder::GetInstructionSet(void)
+{
+	// (only checked the first time)
+	static const CBMPRowDecoder::enumInstructionSet instructionSet = []()
+	{
+		bool bHasSSSE3 = false;
+		bool bHasAVX2 = false;
+#if defined(_MSC_VER)
+		int cpuInfo[4] = { 0 };
+		__cpuid( cpuInfo, 0 );
+		const int highestFunction = cpuInfo[0];
+		__cpuid( cpuInfo, 1 );
+		bHasSSSE3 = ( cpuInfo[2] & ( 1 << 9 ) ) != 0;
+		// AVX needs the OS to save the registers, too (OSXSAVE, then XCR0 has the SSE and AVX state)
+		const bool bOSHasAVX = ( ( cpuInfo[2] & ( 1 << 27 ) ) != 0 ) && ( ( cpuInfo[2] & ( 1 << 28 ) ) != 0 ) &&
+		                       ( ( _xgetbv( 0 ) & 0x6 ) == 0x6 );
+		if ( bOSHasAVX && ( highestFunction >= 7 ) )
+		{
+			__cpuidex( cpuInfo, 7, 0 );
+			bHasAVX2 = ( cpuInfo[1] & ( 1 << 5 ) ) != 0;
+		}
+#elif defined(__GNUC__)
+		bHasSSSE3 = __builtin_cpu_supports( "ssse3" ) != 0;
+		bHasAVX2 = __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+		if ( bHasAVX2 )		{ return CBMPRowDecoder::INSTRUCTIONS_AVX2; }
+		if ( bHasSSSE3 )	{ return CBMPRowDecoder::INSTRUCTIONS_SSSE3; }
+		return CBMPRowDecoder::INSTRUCTIONS_SCALAR;
+	}();
+	return instructionSet;
+}
+
+//static
+void CBMPRowDecoder::DecodeRow( const unsigned char* pBGR, unsigned int numberOfPixels, enumOutputFormat outputFormat, unsigned char* pDestination )
+{
+	switch ( CBMPRowDecoder::GetInstructionSet() )
+	{
+	case CBMPRowDecoder::INSTRUCTIONS_AVX2:
+		CBMPRowDecoder::m_DecodeRow_AVX2( pBGR, numberOfPixels, outputFormat, pDestination );
+		break;
+	case CBMPRowDecoder::INSTRUCTIONS_SSSE3:
+		CBMPRowDecoder::m_DecodeRow_SSSE3( pBGR, numberOfPixels, outputFormat, pDestination );
+		break;
+	default:
+		CBMPRowDecoder::m_DecodeRow_Scalar( pBGR, numberOfPixels, outputFormat, pDestination );
+		break;
+	}
+	return;
+}
+
+//static
+void CBMPRowDecoder::m_DecodeRow_Scalar( const unsigned char* pBGR, unsigned int numberOfPixels, enumOutputFormat outputFormat, unsigned char* pDestination )
+{
+	if ( outputFormat == CBMPRowDecoder::OUTPUT_RGBA )
+	{
+		for ( unsigned int pixel = 0; pixel != numberOfPixels; pixel++, pBGR += 3, pDestination += 4 )
+		{
+			pDestination[0] = pBGR[2];
+			pDestination[1] = pBGR[1];
+			pDestination[2] = pBGR[0];
+			pDestination[3] = 255;
+		}
+	}
+	else
+	{
+		for ( unsigned int pixel = 0; pixel != numberOfPixels; pixel++, pBGR += 3, pDestination += 3 )
+		{
+			pDestination[0] = pBGR[2];
+			pDestination[1] = pBGR[1];
+			pDestination[2] = pBGR[0];
+		}
+	}
+	return;
+}
+
+//static
+BMPDECODER_TARGET("ssse3")
+void CBMPRowDecoder::m_DecodeRow_SSSE3( const unsigned char* pBGR, unsigned int numberOfPixels, enumOutputFormat outputFormat, unsigned char* pDestination )
+{
+	// Each load is 16 bytes, but only 15 (5 pixels) or 12 (4 pixels) of them are used. So it stops
+	//	while there are still 6 pixels (18 bytes) left, so nothing past the end is read (or written).
+	unsigned int pixel = 0;
+	if ( outputFormat == CBMPRowDecoder::OUTPUT_RGBA )
+	{
+		const __m128i shuffle = _mm_setr_epi8( 2, 1, 0, -128,  5, 4, 3, -128,  8, 7, 6, -128,  11, 10, 9, -128 );
+		const __m128i alpha = _mm_set1_epi32( static_cast<int>( 0xFF000000 ) );
+		for ( ; pixel + 6 <= numberOfPixels; pixel += 4 )
+		{
+			__m128i bgr = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pBGR + pixel * 3 ) );
+			__m128i rgba = _mm_or_si128( _mm_shuffle_epi8( bgr, shuffle ), alpha );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( pDestination + pixel * 4 ), rgba );
+		}
+		CBMPRowDecoder::m_DecodeRow_Scalar( pBGR + pixel * 3, numberOfPixels - pixel, outputFormat, pDestination + pixel * 4 );
+	}
+	else
+	{	// (the 16th byte that's stored is the first byte of the next pixel, which the next store writes over)
+		const __m128i shuffle = _mm_setr_epi8( 2, 1, 0,  5, 4, 3,  8, 7, 6,  11, 10, 9,  14, 13, 12,  -128 );
+		for ( ; pixel + 6 <= numberOfPixels; pixel += 5 )
+		{
+			__m128i bgr = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pBGR + pixel * 3 ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( pDestination + pixel * 3 ), _mm_shuffle_epi8( bgr, shuffle ) );
+		}
+		CBMPRowDecoder::m_DecodeRow_Scalar( pBGR + pixel * 3, numberOfPixels - pixel, outputFormat, pDestination + pixel * 3 );
+	}
+	return;
+}
+
+//static
+BMPDECODER_TARGET("avx2")
+void CBMPRowDecoder::m_DecodeRow_AVX2( const unsigned char* pBGR, unsigned int numberOfPixels, enumOutputFormat outputFormat, unsigned char* pDestination )
+{
+	// The AVX2 shuffle only moves bytes around inside each 16 byte half, so for RGB (where
+	//	the pixels don't line up with the halves) it's no better than SSSE3
+	if ( outputFormat != CBMPRowDecoder::OUTPUT_RGBA )
+	{
+		CBMPRowDecoder::m_DecodeRow_SSSE3( pBGR, numberOfPixels, outputFormat, pDestination );
+		return;
+	}
+
+	// 8 pixels (24 bytes) at a time: the 3rd 8 bytes go to the top half, then each half is
+	//	shuffled like the SSSE3 version. The load is 32 bytes, so it stops with 11 pixels left.
+	const __m256i spread = _mm256_setr_epi32( 0, 1, 2, 0,  3, 4, 5, 0 );
+	const __m256i shuffle = _mm256_setr_epi8( 2, 1, 0, -128,  5, 4, 3, -128,  8, 7, 6, -128,  11, 10, 9, -128,
+	                                          2, 1, 0, -128,  5, 4, 3, -128,  8, 7, 6, -128,  11, 10, 9, -128 );
+	const __m256i alpha = _mm256_set1_epi32( static_cast<int>( 0xFF000000 ) );
+	unsigned int pixel = 0;
+	for ( ; pixel + 11 <= numberOfPixels; pixel += 8 )
+	{
+		__m256i bgr = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pBGR + pixel * 3 ) );
+		bgr = _mm256_permutevar8x32_epi32( bgr, spread );
+		__m256i rgba = _mm256_or_si256( _mm256_shuffle_epi8( bgr, shuffle ), alpha );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( pDestination + pixel * 4 ), rgba );
+	}
+	CBMPRowDecoder::m_DecodeRow_SSSE3( pBGR + pixel * 3, numberOfPixels - pixel, outputFormat, pDestination + pixel * 4 );
+	return;
+}
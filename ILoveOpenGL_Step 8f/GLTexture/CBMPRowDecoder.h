@@ -0,0 +1,56 @@
+#ifndef _CBMPRowDecoder_HG_
+#define _CBMPRowDecoder_HG_
+
+// Turns the pixels of a 24 bit BMP (blue, green, red, with each row padded to 4 bytes)
+//	into what OpenGL wants (red, green, blue, and maybe alpha; packed rows, bottom row first).
+// Each row is done in one go: 16 (or 32) bytes at a time are loaded, and the bytes are
+//	put in the right order with one "shuffle" (SSSE3 pshufb, or AVX2 vpshufb).
+//	Whatever's left at the end of each row is done one pixel at a time.
+// It checks which of those the CPU has once, the first time it's used.
+//
+// Doesn't touch anything past the end of each row (in the file, or the destination),
+//	so the destination can be mapped memory (like CGPUUploadRing), and the rows can be
+//	done in any order (or on different threads).
+
+class CBMPRowDecoder
+{
+public:
+	enum enumOutputFormat
+	{
+		OUTPUT_RGB = 0,		// 3 bytes a pixel (C24BitBMPpixel)
+		OUTPUT_RGBA			// 4 bytes a pixel (alpha is 255)
+	};
+
+	// pFirstRowInFile is the first row of pixels in the file (at the "offset to the pixels" in the header).
+	//	bTopRowFirst is true if the height in the header is negative (most BMPs are bottom row first).
+	// pDestination is width * height * (3 or 4) bytes; the bottom row goes first.
+	static void DecodeImage( const unsigned char* pFirstRowInFile, unsigned int width, unsigned int height, bool bTopRowFirst,
+	                         enumOutputFormat outputFormat, unsigned char* pDestination );
+	// The same thing, for rows firstRow to (but not including) lastRow of the destination
+	//	(so a big image can be split up)
+	static void DecodeRows( const unsigned char* pFirstRowInFile, unsigned int width, unsigned int height, bool bTopRowFirst,
+	                        enumOutputFormat outputFormat, unsigned char* pDestination, unsigned int firstRow, unsigned int lastRow );
+
+	// How many bytes each row takes in the file (3 bytes a pixel, padded to 4)
+	static unsigned int GetFileRowSizeInBytes( unsigned int width );
+	static unsigned int GetBytesPerPixel( enumOutputFormat outputFormat );
+
+	// One row: numberOfPixels BGR pixels to RGB (or RGBA)
+	static void DecodeRow( const unsigned char* pBGR, unsigned int numberOfPixels, enumOutputFormat outputFormat, unsigned char* pDestination );
+
+	enum enumInstructionSet
+	{
+		INSTRUCTIONS_SCALAR = 0,
+		INSTRUCTIONS_SSSE3,
+		INSTRUCTIONS_AVX2
+	};
+	// What the CPU has (what DecodeRow() uses)
+	static enumInstructionSet GetInstructionSet(void);
+
+private:
+	static void m_DecodeRow_Scalar( const unsigned char* pBGR, unsigned int numberOfPixels, enumOutputFormat outputFormat, unsigned char* pDestination );
+	static void m_DecodeRow_SSSE3( const unsigned char* pBGR, unsigned int numberOfPixels, enumOutputFormat outputFormat, unsigned char* pDestination );
+	static void m_DecodeRow_AVX2( const unsigned char* pBGR, unsigned int numberOfPixels, enumOutputFormat outputFormat, unsigned char* pDestination );
+};
+
+#endif
@@ -0,0 +1,853 @@
+#include "CBlockCompressor.h"
+#include "../CThreadPool.h"
+
+#include <emmintrin.h>	// SSE2
+#include <math.h>
+#include <string.h>		// for memcpy()
+
+// BC7 blocks are 128 bits, written starting at the bottom bit of the first byte
+static void WriteBits( unsigned long long bits[2], unsigned int &nextBit, unsigned int value, unsigned int numberOfBits )
+{
+	for ( unsigned int bit = 0; bit != numberOfBits; bit++, nextBit++ )
+	{
+		bits[nextBit / 64] |= static_cast<unsigned long long>( ( value >> bit ) & 1 ) << ( nextBit % 64 );
+	}
+	return;
+}
+
+//static
+unsigned int CBlockCompressor::GetBlockSizeInBytes( enumFormat format )
+{
+	return ( format == CBlockCompressor::FORMAT_BC1 ) ? 8 : 16;
+}
+
+//static
+unsigned int CBlockCompressor::GetCompressedSize( enumFormat format, unsigned int width, unsigned int height )
+{
+	return ( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * CBlockCompressor::GetBlockSizeInBytes( format );
+}
+
+//static
+GLenum CBlockCompressor::GetGLInternalFormat( enumFormat format )
+{
+	switch ( format )
+	{
+	case CBlockCompressor::FORMAT_BC3:	return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case CBlockCompressor::FORMAT_BC7:	return GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;
+	default:							return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	}
+}
+
+//static
+GLenum CBlockCompressor::GetGLBaseInternalFormat( enumFormat format )
+{
+	return ( format == CBlockCompressor::FORMAT_BC1 ) ? GL_RGB : GL_RGBA;
+}
+
+//static
+bool CBlockCompressor::IsFormatSupported( enumFormat format )
+{
+	if ( format == CBlockCompressor::FORMAT_BC7 )
+	{
+		return ( GLEW_ARB_texture_compression_bptc != 0 );
+	}
+	return ( GLEW_EXT_texture_compression_s3tc != 0 );
+}
+
+//static
+const char* CBlockCompressor::GetFormatName( enumFormat format )
+{
+	switch ( format )
+	{
+	case CBlockCompressor::FORMAT_BC1:	return "BC1";
+	case CBlockCompressor::FORMAT_BC3:	return "BC3";
+	case CBlockCompressor::FORMAT_BC7:	return "BC7";
+	}
+	return "unknown";
+}
+
+//static
+const char* CBlockCompressor::GetQualityName( enumQuality quality )
+{
+	switch ( quality )
+	{
+	case CBlockCompressor::QUALITY_FAST:	return "fast";
+	case CBlockCompressor::QUALITY_NORMAL:	return "normal";
+	case CBlockCompressor::QUALITY_HIGH:	return "high";
+	}
+	return "unknown";
+}
+
+//static
+void CBlockCompressor::m_GetBlock( const unsigned char* pPixels, unsigned int width, unsigned int height, unsigned int numberOfChannels,
+                                   unsigned int blockX, unsigned int blockY, sBlock &block )
+{
+	for ( unsigned int y = 0; y != 4; y++ )
+	{
+		// (past the edge, the edge pixels are used again)
+		unsigned int row = blockY * 4 + y;
+		row = ( row < height ) ? row : height - 1;
+		for ( unsigned int x = 0; x != 4; x++ )
+		{
+			unsigned int column = blockX * 4 + x;
+			column = ( column < width ) ? column : width - 1;
+			const unsigned char* pPixel = pPixels + ( static_cast<size_t>( row ) * width + column ) * numberOfChannels;
+			const unsigned int index = y * 4 + x;
+			block.red[index] = pPixel[0];
+			block.green[index] = pPixel[1];
+			block.blue[index] = pPixel[2];
+			block.alpha[index] = ( numberOfChannels == 4 ) ? pPixel[3] : 255.0f;
+		}
+	}
+	return;
+}
+
+//static
+float CBlockCompressor::m_PickIndices( const sBlock &block, const float palette[][4], unsigned int numberOfColours, bool bUseAlpha, unsigned char indices[16] )
+{
+	__m128 totalError = _mm_setzero_ps();
+	int bestIndices[4];
+	for ( unsigned int pixel = 0; pixel != 16; pixel += 4 )
+	{
+		const __m128 red = _mm_loadu_ps( block.red + pixel );
+		const __m128 green = _mm_loadu_ps( block.green + pixel );
+		const __m128 blue = _mm_loadu_ps( block.blue + pixel );
+		const __m128 alpha = _mm_loadu_ps( block.alpha + pixel );
+		__m128 bestError = _mm_set1_ps( 1.0e30f );
+		__m128i bestIndex = _mm_setzero_si128();
+		for ( unsigned int colour = 0; colour != numberOfColours; colour++ )
+		{
+			const __m128 redDifference = _mm_sub_ps( red, _mm_set1_ps( palette[colour][0] ) );
+			const __m128 greenDifference = _mm_sub_ps( green, _mm_set1_ps( palette[colour][1] ) );
+			const __m128 blueDifference = _mm_sub_ps( blue, _mm_set1_ps( palette[colour][2] ) );
+			__m128 error = _mm_add_ps( _mm_add_ps( _mm_mul_ps( redDifference, redDifference ), _mm_mul_ps( greenDifference, greenDifference ) ),
+			                           _mm_mul_ps( blueDifference, blueDifference ) );
+			if ( bUseAlpha )
+			{
+				const __m128 alphaDifference = _mm_sub_ps( alpha, _mm_set1_ps( palette[colour][3] ) );
+				error = _mm_add_ps( error, _mm_mul_ps( alphaDifference, alphaDifference ) );
+			}
+			// (closer ones replace the best so far; on a tie, the first one stays)
+			const __m128i isCloser = _mm_castps_si128( _mm_cmplt_ps( error, bestError ) );
+			bestIndex = _mm_or_si128( _mm_and_si128( isCloser, _mm_set1_epi32( colour ) ), _mm_andnot_si128( isCloser, bestIndex ) );
+			bestError = _mm_min_ps( error, bestError );
+		}
+		totalError = _mm_add_ps( totalError, bestError );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( bestIndices ), bestIndex );
+		for ( unsigned int index = 0; index != 4; index++ )
+		{
+			indices[pixel + index] = static_cast<unsigned char>( bestIndices[index] );
+		}
+	}
+	float errors[4];
+	_mm_storeu_ps( errors, totalError );
+	return errors[0] + errors[1] + errors[2] + errors[3];
+}
+
+//static
+void CBlockCompressor::m_GetEndPointsOnAxis( const sBlock &block, unsigned int numberOfChannels, float endPoint0[4], float endPoint1[4] )
+{
+	const float* channels[4] = { block.red, block.green, block.blue, block.alpha };
+
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float minimum[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+	float maximum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for ( unsigned int channel = 0; channel != 4; channel++ )
+	{
+		for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+		{
+			const float value = channels[channel][pixel];
+			mean[channel] += value;
+			minimum[channel] = ( value < minimum[channel] ) ? value : minimum[channel];
+			maximum[channel] = ( value > maximum[channel] ) ? value : maximum[channel];
+		}
+		mean[channel] /= 16.0f;
+	}
+
+	float covariance[4][4] = { { 0.0f } };
+	for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+	{
+		for ( unsigned int row = 0; row != numberOfChannels; row++ )
+		{
+			for ( unsigned int column = 0; column != numberOfChannels; column++ )
+			{
+				covariance[row][column] += ( channels[row][pixel] - mean[row] ) * ( channels[column][pixel] - mean[column] );
+			}
+		}
+	}
+
+	// The principal axis (the biggest eigenvector), by "power iteration"
+	float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for ( unsigned int channel = 0; channel != numberOfChannels; channel++ )
+	{
+		axis[channel] = maximum[channel] - minimum[channel];
+	}
+	for ( unsigned int iteration = 0; iteration != 8; iteration++ )
+	{
+		float newAxis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float biggest = 0.0f;
+		for ( unsigned int row = 0; row != numberOfChannels; row++ )
+		{
+			for ( unsigned int column = 0; column != numberOfChannels; column++ )
+			{
+				newAxis[row] += covariance[row][column] * axis[column];
+			}
+			biggest = ( fabsf( newAxis[row] ) > biggest ) ? fabsf( newAxis[row] ) : biggest;
+		}
+		if ( biggest < 1.0e-6f )
+		{
+			break;
+		}
+		for ( unsigned int channel = 0; channel != 4; channel++ )
+		{
+			axis[channel] = newAxis[channel] / biggest;
+		}
+	}
+
+	float axisLengthSquared = 0.0f;
+	for ( unsigned int channel = 0; channel != numberOfChannels; channel++ )
+	{
+		axisLengthSquared += axis[channel] * axis[channel];
+	}
+	// Where the pixels are along it (from the mean)
+	float nearest = 0.0f;
+	float farthest = 0.0f;
+	if ( axisLengthSquared > 1.0e-6f )
+	{
+		for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+		{
+			float distance = 0.0f;
+			for ( unsigned int channel = 0; channel != numberOfChannels; channel++ )
+			{
+				distance += ( channels[channel][pixel] - mean[channel] ) * axis[channel];
+			}
+			distance /= axisLengthSquared;
+			nearest = ( distance < nearest ) ? distance : nearest;
+			farthest = ( distance > farthest ) ? distance : farthest;
+		}
+	}
+	for ( unsigned int channel = 0; channel != 4; channel++ )
+	{
+		const float value0 = ( channel < numberOfChannels ) ? mean[channel] + axis[channel] * nearest : mean[channel];
+		const float value1 = ( channel < numberOfChannels ) ? mean[channel] + axis[channel] * farthest : mean[channel];
+		endPoint0[channel] = ( value0 < 0.0f ) ? 0.0f : ( ( value0 > 255.0f ) ? 255.0f : value0 );
+		endPoint1[channel] = ( value1 < 0.0f ) ? 0.0f : ( ( value1 > 255.0f ) ? 255.0f : value1 );
+	}
+	return;
+}
+
+//static
+void CBlockCompressor::m_GetEndPointsOfBox( const sBlock &block, unsigned int numberOfChannels, float endPoint0[4], float endPoint1[4] )
+{
+	const float* channels[4] = { block.red, block.green, block.blue, block.alpha };
+
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float minimum[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+	float maximum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	unsigned int widestChannel = 0;
+	for ( unsigned int channel = 0; channel != 4; channel++ )
+	{
+		for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+		{
+			const float value = channels[channel][pixel];
+			mean[channel] += value;
+			minimum[channel] = ( value < minimum[channel] ) ? value : minimum[channel];
+			maximum[channel] = ( value > maximum[channel] ) ? value : maximum[channel];
+		}
+		mean[channel] /= 16.0f;
+		if ( ( channel < numberOfChannels ) &&
+		     ( ( maximum[channel] - minimum[channel] ) > ( maximum[widestChannel] - minimum[widestChannel] ) ) )
+		{
+			widestChannel = channel;
+		}
+	}
+
+	for ( unsigned int channel = 0; channel != 4; channel++ )
+	{
+		// Pulled in a bit (most of the pixels aren't right in the corners)
+		const float inset = ( maximum[channel] - minimum[channel] ) / 16.0f;
+		float low = minimum[channel] + inset;
+		float high = maximum[channel] - inset;
+		// The box has 4 (or 8) diagonals; if this one goes down when the widest one goes up, it's the other way
+		float covariance = 0.0f;
+		for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+		{
+			covariance += ( channels[channel][pixel] - mean[channel] ) * ( channels[widestChannel][pixel] - mean[widestChannel] );
+		}
+		if ( covariance < 0.0f )
+		{
+			const float temp = low;
+			low = high;
+			high = temp;
+		}
+		endPoint0[channel] = low;
+		endPoint1[channel] = high;
+	}
+	return;
+}
+
+//static
+bool CBlockCompressor::m_FitEndPoints( const sBlock &block, const unsigned char indices[16], const float* weights, float endPoint0[4], float endPoint1[4] )
+{
+	// Each pixel is (1 - t) * endPoint0 + t * endPoint1; find the two that are closest to all of them
+	float sumOneMinusTSquared = 0.0f;
+	float sumOneMinusTTimesT = 0.0f;
+	float sumTSquared = 0.0f;
+	for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+	{
+		const float t = weights[ indices[pixel] ];
+		sumOneMinusTSquared += ( 1.0f - t ) * ( 1.0f - t );
+		sumOneMinusTTimesT += ( 1.0f - t ) * t;
+		sumTSquared += t * t;
+	}
+	const float determinant = sumOneMinusTSquared * sumTSquared - sumOneMinusTTimesT * sumOneMinusTTimesT;
+	if ( fabsf( determinant ) < 1.0e-6f )
+	{
+		return false;
+	}
+
+	const float* channels[4] = { block.red, block.green, block.blue, block.alpha };
+	for ( unsigned int channel = 0; channel != 4; channel++ )
+	{
+		float sumOneMinusTTimesValue = 0.0f;
+		float sumTTimesValue = 0.0f;
+		for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+		{
+			const float t = weights[ indices[pixel] ];
+			sumOneMinusTTimesValue += ( 1.0f - t ) * channels[channel][pixel];
+			sumTTimesValue += t * channels[channel][pixel];
+		}
+		const float value0 = ( sumTSquared * sumOneMinusTTimesValue - sumOneMinusTTimesT * sumTTimesValue ) / determinant;
+		const float value1 = ( sumOneMinusTSquared * sumTTimesValue - sumOneMinusTTimesT * sumOneMinusTTimesValue ) / determinant;
+		endPoint0[channel] = ( value0 < 0.0f ) ? 0.0f : ( ( value0 > 255.0f ) ? 255.0f : value0 );
+		endPoint1[channel] = ( value1 < 0.0f ) ? 0.0f : ( ( value1 > 255.0f ) ? 255.0f : value1 );
+	}
+	return true;
+}
+
+//static
+void CBlockCompressor::m_CompressBlockBC1( const sBlock &block, enumQuality quality, unsigned char* pDestination )
+{
+	// How far each index is from colour 0 (0 and 1 are the ends, 2 and 3 are 1/3 and 2/3 of the way)
+	static const float WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	auto to565 = []( const float colour[4] ) -> unsigned short
+	{
+		const unsigned int red = static_cast<unsigned int>( colour[0] * 31.0f / 255.0f + 0.5f );
+		const unsigned int green = static_cast<unsigned int>( colour[1] * 63.0f / 255.0f + 0.5f );
+		const unsigned int blue = static_cast<unsigned int>( colour[2] * 31.0f / 255.0f + 0.5f );
+		return static_cast<unsigned short>( ( red << 11 ) | ( green << 5 ) | blue );
+	};
+	auto from565 = []( unsigned short colour, float rgba[4] )
+	{
+		const unsigned int red = ( colour >> 11 ) & 31;
+		const unsigned int green = ( colour >> 5 ) & 63;
+		const unsigned int blue = colour & 31;
+		rgba[0] = static_cast<float>( ( red << 3 ) | ( red >> 2 ) );
+		rgba[1] = static_cast<float>( ( green << 2 ) | ( green >> 4 ) );
+		rgba[2] = static_cast<float>( ( blue << 3 ) | ( blue >> 2 ) );
+		rgba[3] = 255.0f;
+	};
+
+	// The best so far
+	unsigned short bestColour0 = 0;
+	unsigned short bestColour1 = 0;
+	unsigned char bestIndices[16] = { 0 };
+	float bestError = 1.0e30f;
+	// Tries these end points (rounded to 565), and keeps them if they're better
+	auto tryEndPoints = [&]( const float endPoint0[4], const float endPoint1[4] ) -> bool
+	{
+		unsigned short colour0 = to565( endPoint0 );
+		unsigned short colour1 = to565( endPoint1 );
+		// Colour 0 has to be the bigger one (or it's the 3 colour + transparent mode)
+		if ( colour0 < colour1 )
+		{
+			const unsigned short temp = colour0;
+			colour0 = colour1;
+			colour1 = temp;
+		}
+		float palette[4][4];
+		from565( colour0, palette[0] );
+		from565( colour1, palette[1] );
+		for ( unsigned int channel = 0; channel != 4; channel++ )
+		{
+			palette[2][channel] = ( 2.0f * palette[0][channel] + palette[1][channel] ) / 3.0f;
+			palette[3][channel] = ( palette[0][channel] + 2.0f * palette[1][channel] ) / 3.0f;
+		}
+		unsigned char indices[16];
+		// (if they're the same, it's the 3 colour mode, so only index 0 is safe)
+		const float error = CBlockCompressor::m_PickIndices( block, palette, ( colour0 == colour1 ) ? 1 : 4, false, indices );
+		if ( error >= bestError )
+		{
+			return false;
+		}
+		bestError = error;
+		bestColour0 = colour0;
+		bestColour1 = colour1;
+		for ( unsigned int pixel = 0; pixel != 16; pixel++ )	{ bestIndices[pixel] = indices[pixel]; }
+		return true;
+	};
+
+	float endPoint0[4];
+	float endPoint1[4];
+	if ( quality != CBlockCompressor::QUALITY_NORMAL )
+	{
+		CBlockCompressor::m_GetEndPointsOfBox( block, 3, endPoint0, endPoint1 );
+		tryEndPoints( endPoint0, endPoint1 );
+	}
+	if ( quality != CBlockCompressor::QUALITY_FAST )
+	{
+		CBlockCompressor::m_GetEndPointsOnAxis( block, 3, endPoint0, endPoint1 );
+		tryEndPoints( endPoint0, endPoint1 );
+
+		const unsigned int numberOfFits = ( quality == CBlockCompressor::QUALITY_HIGH ) ? 8 : 1;
+		for ( unsigned int fit = 0; fit != numberOfFits; fit++ )
+		{
+			// (the indices are for the best colours, which might have been swapped)
+			if ( ( bestColour0 == bestColour1 ) ||
+			     !CBlockCompressor::m_FitEndPoints( block, bestIndices, WEIGHTS, endPoint0, endPoint1 ) ||
+			     !tryEndPoints( endPoint0, endPoint1 ) )
+			{
+				break;
+			}
+		}
+	}
+
+	unsigned int packedIndices = 0;
+	for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+	{
+		packedIndices |= static_cast<unsigned int>( bestIndices[pixel] ) << ( pixel * 2 );
+	}
+	pDestination[0] = static_cast<unsigned char>( bestColour0 & 0xFF );
+	pDestination[1] = static_cast<unsigned char>( bestColour0 >> 8 );
+	pDestination[2] = static_cast<unsigned char>( bestColour1 & 0xFF );
+	pDestination[3] = static_cast<unsigned char>( bestColour1 >> 8 );
+	for ( unsigned int byte = 0; byte != 4; byte++ )
+	{
+		pDestination[4 + byte] = static_cast<unsigned char>( packedIndices >> ( byte * 8 ) );
+	}
+	return;
+}
+
+//static
+void CBlockCompressor::m_CompressBlockBC4Alpha( const sBlock &block, unsigned char* pDestination )
+{
+	float minimum = 255.0f;
+	float maximum = 0.0f;
+	for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+	{
+		minimum = ( block.alpha[pixel] < minimum ) ? block.alpha[pixel] : minimum;
+		maximum = ( block.alpha[pixel] > maximum ) ? block.alpha[pixel] : maximum;
+	}
+	// Alpha 0 is the biggest (that's the 8 value mode): 0 and 1 are the ends, 2 to 7 are in between
+	const unsigned int alpha0 = static_cast<unsigned int>( maximum + 0.5f );
+	const unsigned int alpha1 = static_cast<unsigned int>( minimum + 0.5f );
+	float palette[8];
+	palette[0] = static_cast<float>( alpha0 );
+	palette[1] = static_cast<float>( alpha1 );
+	for ( unsigned int step = 1; step != 7; step++ )
+	{
+		palette[step + 1] = static_cast<float>( ( ( 7 - step ) * alpha0 + step * alpha1 ) / 7 );
+	}
+
+	unsigned long long packedIndices = 0;
+	if ( alpha0 != alpha1 )
+	{
+		for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+		{
+			unsigned int bestIndex = 0;
+			float bestError = 1.0e30f;
+			for ( unsigned int index = 0; index != 8; index++ )
+			{
+				const float error = fabsf( block.alpha[pixel] - palette[index] );
+				if ( error < bestError )
+				{
+					bestError = error;
+					bestIndex = index;
+				}
+			}
+			packedIndices |= static_cast<unsigned long long>( bestIndex ) << ( pixel * 3 );
+		}
+	}
+	pDestination[0] = static_cast<unsigned char>( alpha0 );
+	pDestination[1] = static_cast<unsigned char>( alpha1 );
+	for ( unsigned int byte = 0; byte != 6; byte++ )
+	{
+		pDestination[2 + byte] = static_cast<unsigned char>( packedIndices >> ( byte * 8 ) );
+	}
+	return;
+}
+
+//static
+void CBlockCompressor::m_CompressBlockBC7( const sBlock &block, enumQuality quality, unsigned char* pDestination )
+{
+	const float error = CBlockCompressor::m_CompressBlockBC7Mode6( block, quality, pDestination );
+
+	// If the alpha changes, it might not go along with the colour, so try it on its own, too
+	float minimumAlpha = 255.0f;
+	float maximumAlpha = 0.0f;
+	for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+	{
+		minimumAlpha = ( block.alpha[pixel] < minimumAlpha ) ? block.alpha[pixel] : minimumAlpha;
+		maximumAlpha = ( block.alpha[pixel] > maximumAlpha ) ? block.alpha[pixel] : maximumAlpha;
+	}
+	if ( minimumAlpha != maximumAlpha )
+	{
+		unsigned char mode5Block[16];
+		if ( CBlockCompressor::m_CompressBlockBC7Mode5( block, quality, mode5Block ) < error )
+		{
+			memcpy( pDestination, mode5Block, sizeof(mode5Block) );
+		}
+	}
+	return;
+}
+
+//static
+float CBlockCompressor::m_CompressBlockBC7Mode6( const sBlock &block, enumQuality quality, unsigned char* pDestination )
+{
+	// Mode 6's 4 bit index weights (out of 64)
+	static const unsigned int INDEXWEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	static const float WEIGHTS[16] = { 0.0f / 64.0f, 4.0f / 64.0f, 9.0f / 64.0f, 13.0f / 64.0f, 17.0f / 64.0f, 21.0f / 64.0f, 26.0f / 64.0f, 30.0f / 64.0f,
+	                                   34.0f / 64.0f, 38.0f / 64.0f, 43.0f / 64.0f, 47.0f / 64.0f, 51.0f / 64.0f, 55.0f / 64.0f, 60.0f / 64.0f, 64.0f / 64.0f };
+
+	// Each end point is 7 bits a channel, and a "p" bit that's the bottom bit of all 4 of them
+	auto quantize = []( const float endPoint[4], unsigned int quantized[4], unsigned int &pBit )
+	{
+		float bestError = 1.0e30f;
+		for ( unsigned int tryPBit = 0; tryPBit != 2; tryPBit++ )
+		{
+			unsigned int tryQuantized[4];
+			float error = 0.0f;
+			for ( unsigned int channel = 0; channel != 4; channel++ )
+			{
+				int value = static_cast<int>( ( endPoint[channel] - tryPBit ) / 2.0f + 0.5f );
+				value = ( value < 0 ) ? 0 : ( ( value > 127 ) ? 127 : value );
+				tryQuantized[channel] = static_cast<unsigned int>( value );
+				const float difference = static_cast<float>( value * 2 + tryPBit ) - endPoint[channel];
+				error += difference * difference;
+			}
+			if ( error < bestError )
+			{
+				bestError = error;
+				pBit = tryPBit;
+				for ( unsigned int channel = 0; channel != 4; channel++ )	{ quantized[channel] = tryQuantized[channel]; }
+			}
+		}
+	};
+
+	unsigned int bestQuantized0[4] = { 0 };
+	unsigned int bestQuantized1[4] = { 0 };
+	unsigned int bestPBit0 = 0;
+	unsigned int bestPBit1 = 0;
+	unsigned char bestIndices[16] = { 0 };
+	float bestError = 1.0e30f;
+	auto tryEndPoints = [&]( const float endPoint0[4], const float endPoint1[4] ) -> bool
+	{
+		unsigned int quantized0[4];
+		unsigned int quantized1[4];
+		unsigned int pBit0 = 0;
+		unsigned int pBit1 = 0;
+		quantize( endPoint0, quantized0, pBit0 );
+		quantize( endPoint1, quantized1, pBit1 );
+		float palette[16][4];
+		for ( unsigned int index = 0; index != 16; index++ )
+		{
+			for ( unsigned int channel = 0; channel != 4; channel++ )
+			{
+				const unsigned int value0 = ( quantized0[channel] << 1 ) | pBit0;
+				const unsigned int value1 = ( quantized1[channel] << 1 ) | pBit1;
+				palette[index][channel] = static_cast<float>( ( ( 64 - INDEXWEIGHTS[index] ) * value0 + INDEXWEIGHTS[index] * value1 + 32 ) >> 6 );
+			}
+		}
+		unsigned char indices[16];
+		const float error = CBlockCompressor::m_PickIndices( block, palette, 16, true, indices );
+		if ( error >= bestError )
+		{
+			return false;
+		}
+		bestError = error;
+		bestPBit0 = pBit0;
+		bestPBit1 = pBit1;
+		for ( unsigned int channel = 0; channel != 4; channel++ )
+		{
+			bestQuantized0[channel] = quantized0[channel];
+			bestQuantized1[channel] = quantized1[channel];
+		}
+		for ( unsigned int pixel = 0; pixel != 16; pixel++ )	{ bestIndices[pixel] = indices[pixel]; }
+		return true;
+	};
+
+	float endPoint0[4];
+	float endPoint1[4];
+	if ( quality != CBlockCompressor::QUALITY_NORMAL )
+	{
+		CBlockCompressor::m_GetEndPointsOfBox( block, 4, endPoint0, endPoint1 );
+		tryEndPoints( endPoint0, endPoint1 );
+	}
+	if ( quality != CBlockCompressor::QUALITY_FAST )
+	{
+		CBlockCompressor::m_GetEndPointsOnAxis( block, 4, endPoint0, endPoint1 );
+		tryEndPoints( endPoint0, endPoint1 );
+
+		const unsigned int numberOfFits = ( quality == CBlockCompressor::QUALITY_HIGH ) ? 8 : 1;
+		for ( unsigned int fit = 0; fit != numberOfFits; fit++ )
+		{
+			if ( !CBlockCompressor::m_FitEndPoints( block, bestIndices, WEIGHTS, endPoint0, endPoint1 ) ||
+			     !tryEndPoints( endPoint0, endPoint1 ) )
+			{
+				break;
+			}
+		}
+	}
+
+	// The first pixel's index only has 3 bits (the top one is 0), so if it's 8 or more, the ends are swapped
+	if ( bestIndices[0] >= 8 )
+	{
+		for ( unsigned int channel = 0; channel != 4; channel++ )
+		{
+			const unsigned int temp = bestQuantized0[channel];
+			bestQuantized0[channel] = bestQuantized1[channel];
+			bestQuantized1[channel] = temp;
+		}
+		const unsigned int temp = bestPBit0;
+		bestPBit0 = bestPBit1;
+		bestPBit1 = temp;
+		for ( unsigned int pixel = 0; pixel != 16; pixel++ )	{ bestIndices[pixel] = static_cast<unsigned char>( 15 - bestIndices[pixel] ); }
+	}
+
+	unsigned long long bits[2] = { 0, 0 };
+	unsigned int nextBit = 0;
+	WriteBits( bits, nextBit, 1 << 6, 7 );		// Mode 6
+	for ( unsigned int channel = 0; channel != 4; channel++ )
+	{
+		WriteBits( bits, nextBit, bestQuantized0[channel], 7 );
+		WriteBits( bits, nextBit, bestQuantized1[channel], 7 );
+	}
+	WriteBits( bits, nextBit, bestPBit0, 1 );
+	WriteBits( bits, nextBit, bestPBit1, 1 );
+	WriteBits( bits, nextBit, bestIndices[0], 3 );
+	for ( unsigned int pixel = 1; pixel != 16; pixel++ )
+	{
+		WriteBits( bits, nextBit, bestIndices[pixel], 4 );
+	}
+	for ( unsigned int byte = 0; byte != 16; byte++ )
+	{
+		pDestination[byte] = static_cast<unsigned char>( bits[byte / 8] >> ( ( byte % 8 ) * 8 ) );
+	}
+	return bestError;
+}
+
+//static
+float CBlockCompressor::m_CompressBlockBC7Mode5( const sBlock &block, enumQuality quality, unsigned char* pDestination )
+{
+	// Mode 5's 2 bit index weights (out of 64), for the colour and the alpha
+	static const unsigned int INDEXWEIGHTS[4] = { 0, 21, 43, 64 };
+	static const float WEIGHTS[4] = { 0.0f, 21.0f / 64.0f, 43.0f / 64.0f, 1.0f };
+
+	// The colour ends are 7 bits a channel (the top bit is repeated at the bottom), the alpha ones 8
+	auto quantize = []( const float endPoint[4], unsigned int quantized[3] )
+	{
+		for ( unsigned int channel = 0; channel != 3; channel++ )
+		{
+			int value = static_cast<int>( endPoint[channel] * 127.0f / 255.0f + 0.5f );
+			quantized[channel] = static_cast<unsigned int>( ( value < 0 ) ? 0 : ( ( value > 127 ) ? 127 : value ) );
+		}
+	};
+
+	unsigned int bestQuantized0[3] = { 0 };
+	unsigned int bestQuantized1[3] = { 0 };
+	unsigned char bestIndices[16] = { 0 };
+	float bestError = 1.0e30f;
+	auto tryEndPoints = [&]( const float endPoint0[4], const float endPoint1[4] ) -> bool
+	{
+		unsigned int quantized0[3];
+		unsigned int quantized1[3];
+		quantize( endPoint0, quantized0 );
+		quantize( endPoint1, quantized1 );
+		float palette[4][4];
+		for ( unsigned int index = 0; index != 4; index++ )
+		{
+			for ( unsigned int channel = 0; channel != 3; channel++ )
+			{
+				const unsigned int value0 = ( quantized0[channel] << 1 ) | ( quantized0[channel] >> 6 );
+				const unsigned int value1 = ( quantized1[channel] << 1 ) | ( quantized1[channel] >> 6 );
+				palette[index][channel] = static_cast<float>( ( ( 64 - INDEXWEIGHTS[index] ) * value0 + INDEXWEIGHTS[index] * value1 + 32 ) >> 6 );
+			}
+			palette[index][3] = 255.0f;
+		}
+		unsigned char indices[16];
+		const float error = CBlockCompressor::m_PickIndices( block, palette, 4, false, indices );
+		if ( error >= bestError )
+		{
+			return false;
+		}
+		bestError = error;
+		for ( unsigned int channel = 0; channel != 3; channel++ )
+		{
+			bestQuantized0[channel] = quantized0[channel];
+			bestQuantized1[channel] = quantized1[channel];
+		}
+		for ( unsigned int pixel = 0; pixel != 16; pixel++ )	{ bestIndices[pixel] = indices[pixel]; }
+		return true;
+	};
+
+	// The colour (like BC1)
+	float endPoint0[4];
+	float endPoint1[4];
+	if ( quality != CBlockCompressor::QUALITY_NORMAL )
+	{
+		CBlockCompressor::m_GetEndPointsOfBox( block, 3, endPoint0, endPoint1 );
+		tryEndPoints( endPoint0, endPoint1 );
+	}
+	if ( quality != CBlockCompressor::QUALITY_FAST )
+	{
+		CBlockCompressor::m_GetEndPointsOnAxis( block, 3, endPoint0, endPoint1 );
+		tryEndPoints( endPoint0, endPoint1 );
+
+		const unsigned int numberOfFits = ( quality == CBlockCompressor::QUALITY_HIGH ) ? 8 : 1;
+		for ( unsigned int fit = 0; fit != numberOfFits; fit++ )
+		{
+			if ( !CBlockCompressor::m_FitEndPoints( block, bestIndices, WEIGHTS, endPoint0, endPoint1 ) ||
+			     !tryEndPoints( endPoint0, endPoint1 ) )
+			{
+				break;
+			}
+		}
+	}
+
+	// The alpha (the ends are the smallest and biggest)
+	unsigned int alpha0 = 255;
+	unsigned int alpha1 = 0;
+	for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+	{
+		const unsigned int alpha = static_cast<unsigned int>( block.alpha[pixel] + 0.5f );
+		alpha0 = ( alpha < alpha0 ) ? alpha : alpha0;
+		alpha1 = ( alpha > alpha1 ) ? alpha : alpha1;
+	}
+	unsigned char alphaIndices[16];
+	float alphaError = 0.0f;
+	for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+	{
+		float bestAlphaError = 1.0e30f;
+		for ( unsigned int index = 0; index != 4; index++ )
+		{
+			const float value = static_cast<float>( ( ( 64 - INDEXWEIGHTS[index] ) * alpha0 + INDEXWEIGHTS[index] * alpha1 + 32 ) >> 6 );
+			const float error = ( block.alpha[pixel] - value ) * ( block.alpha[pixel] - value );
+			if ( error < bestAlphaError )
+			{
+				bestAlphaError = error;
+				alphaIndices[pixel] = static_cast<unsigned char>( index );
+			}
+		}
+		alphaError += bestAlphaError;
+	}
+
+	// The first pixel's indices only have 1 bit each (the top one is 0), so the ends are swapped if they need it
+	if ( bestIndices[0] >= 2 )
+	{
+		for ( unsigned int channel = 0; channel != 3; channel++ )
+		{
+			const unsigned int temp = bestQuantized0[channel];
+			bestQuantized0[channel] = bestQuantized1[channel];
+			bestQuantized1[channel] = temp;
+		}
+		for ( unsigned int pixel = 0; pixel != 16; pixel++ )	{ bestIndices[pixel] = static_cast<unsigned char>( 3 - bestIndices[pixel] ); }
+	}
+	if ( alphaIndices[0] >= 2 )
+	{
+		const unsigned int temp = alpha0;
+		alpha0 = alpha1;
+		alpha1 = temp;
+		for ( unsigned int pixel = 0; pixel != 16; pixel++ )	{ alphaIndices[pixel] = static_cast<unsigned char>( 3 - alphaIndices[pixel] ); }
+	}
+
+	unsigned long long bits[2] = { 0, 0 };
+	unsigned int nextBit = 0;
+	WriteBits( bits, nextBit, 1 << 5, 6 );		// Mode 5
+	WriteBits( bits, nextBit, 0, 2 );			// No "rotation" (the alpha is the alpha)
+	for ( unsigned int channel = 0; channel != 3; channel++ )
+	{
+		WriteBits( bits, nextBit, bestQuantized0[channel], 7 );
+		WriteBits( bits, nextBit, bestQuantized1[channel], 7 );
+	}
+	WriteBits( bits, nextBit, alpha0, 8 );
+	WriteBits( bits, nextBit, alpha1, 8 );
+	for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+	{
+		WriteBits( bits, nextBit, bestIndices[pixel], ( pixel == 0 ) ? 1 : 2 );
+	}
+	for ( unsigned int pixel = 0; pixel != 16; pixel++ )
+	{
+		WriteBits( bits, nextBit, alphaIndices[pixel], ( pixel == 0 ) ? 1 : 2 );
+	}
+	for ( unsigned int byte = 0; byte != 16; byte++ )
+	{
+		pDestination[byte] = static_cast<unsigned char>( bits[byte / 8] >> ( ( byte % 8 ) * 8 ) );
+	}
+	return bestError + alphaError;
+}
+
+//static
+void CBlockCompressor::m_ForEachBand( unsigned int numberOfRows, unsigned int blocksPerRow, std::function<void(unsigned int firstRow, unsigned int lastRow)> doRows )
+{
+	unsigned int numberOfBands = 1;
+	if ( static_cast<unsigned long long>( numberOfRows ) * blocksPerRow >= CBlockCompressor::MINIMUMBLOCKSTOSPLIT )
+	{	// (a few for each thread, so they even out)
+		numberOfBands = CThreadPool::getSharedInstance()->GetNumberOfThreads() * 4;
+		if ( numberOfBands > numberOfRows )	{ numberOfBands = numberOfRows; }
+	}
+	if ( numberOfBands <= 1 )
+	{
+		doRows( 0, numberOfRows );
+		return;
+	}
+	CThreadPool::getSharedInstance()->ParallelFor( numberOfBands, [numberOfRows, numberOfBands, &doRows]( unsigned int band )
+	{
+		const unsigned int firstRow = static_cast<unsigned int>( static_cast<unsigned long long>( numberOfRows ) * band / numberOfBands );
+		const unsigned int lastRow = static_cast<unsigned int>( static_cast<unsigned long long>( numberOfRows ) * ( band + 1 ) / numberOfBands );
+		doRows( firstRow, lastRow );
+	} );
+	return;
+}
+
+//static
+bool CBlockCompressor::CompressImage( const unsigned char* pPixels, unsigned int width, unsigned int height, unsigned int numberOfChannels,
+                                      enumFormat format, enumQuality quality, unsigned char* pDestination )
+{
+	if ( ( pPixels == 0 ) || ( pDestination == 0 ) || ( width == 0 ) || ( height == 0 ) ||
+	     ( ( numberOfChannels != 3 ) && ( numberOfChannels != 4 ) ) )
+	{
+		return false;
+	}
+
+	const unsigned int blocksWide = ( width + 3 ) / 4;
+	const unsigned int blocksHigh = ( height + 3 ) / 4;
+	const unsigned int blockSizeInBytes = CBlockCompressor::GetBlockSizeInBytes( format );
+	CBlockCompressor::m_ForEachBand( blocksHigh, blocksWide, [&]( unsigned int firstRow, unsigned int lastRow )
+	{
+		CBlockCompressor::sBlock block;
+		for ( unsigned int blockY = firstRow; blockY != lastRow; blockY++ )
+		{
+			for ( unsigned int blockX = 0; blockX != blocksWide; blockX++ )
+			{
+				CBlockCompressor::m_GetBlock( pPixels, width, height, numberOfChannels, blockX, blockY, block );
+				unsigned char* pBlock = pDestination + ( static_cast<size_t>( blockY ) * blocksWide + blockX ) * blockSizeInBytes;
+				switch ( format )
+				{
+				case CBlockCompressor::FORMAT_BC1:
+					CBlockCompressor::m_CompressBlockBC1( block, quality, pBlock );
+					break;
+				case CBlockCompressor::FORMAT_BC3:
+					// (the alpha block, then a BC1 colour block)
+					CBlockCompressor::m_CompressBlockBC4Alpha( block, pBlock );
+					CBlockCompressor::m_CompressBlockBC1( block, quality, pBlock + 8 );
+					break;
+				case CBlockCompressor::FORMAT_BC7:
+					CBlockCompressor::m_CompressBlockBC7( block, quality, pBlock );
+					break;
+				}
+			}
+		}
+	} );
+	return true;
+}
@@ -0,0 +1,94 @@
+#ifndef _CBlockCompressor_HG_
+#define _CBlockCompressor_HG_
+
+// Block compresses (BCn, a.k.a. S3TC/DXT and BPTC) 8 bit RGB (or RGBA) images, on the CPU.
+// Each 4x4 block of pixels is stored in 8 or 16 bytes, and the GPU keeps them that way
+//	(instead of 4 bytes a pixel), so a BC1 texture takes 1/8th of the memory:
+//	- BC1 (DXT1):  8 bytes a block. Two 565 colours, and 2 bits a pixel between them. No alpha.
+//	- BC3 (DXT5): 16 bytes a block. BC1's colour, and the alpha like that, but 3 bits a pixel.
+//	- BC7 (BPTC): 16 bytes a block. Only two of its 8 "modes" are made (whichever is closer):
+//	  mode 6, two RGBA 7777+1 colours and 4 bits a pixel between them, and (if the alpha
+//	  isn't all the same) mode 5, where the alpha has its own two ends (and 2 bits a pixel),
+//	  for when it doesn't go along with the colour. Looks much better than BC1 (twice the size).
+// The "quality" is how hard it tries to find the best two colours for each block:
+//	- FAST:   the corners of the box around the block's colours
+//	- NORMAL: along the line the colours are spread out on the most (principal axis),
+//	          then one "least squares" fix of the ends, for the pixels that picked them
+//	- HIGH:   both of those, then the fix again until it stops getting better
+// Finding the closest of the colours for each pixel is done 4 pixels at a time (SSE2),
+//	and the rows of blocks are split up on the thread pool (see CThreadPool).
+//
+// The pixels are in rows (packed), in the same order as glTexImage2D() would want.
+//	Sizes that aren't multiples of 4 are fine (the edge pixels are repeated to fill the block).
+
+#include <GL/glew.h>
+#include <functional>
+
+class CBlockCompressor
+{
+public:
+	enum enumFormat
+	{
+		FORMAT_BC1 = 0,
+		FORMAT_BC3,
+		FORMAT_BC7
+	};
+	enum enumQuality
+	{
+		QUALITY_FAST = 0,
+		QUALITY_NORMAL,
+		QUALITY_HIGH
+	};
+
+	// numberOfChannels is 3 (RGB; alpha is 255) or 4 (RGBA). pDestination is GetCompressedSize() bytes.
+	static bool CompressImage( const unsigned char* pPixels, unsigned int width, unsigned int height, unsigned int numberOfChannels,
+	                           enumFormat format, enumQuality quality, unsigned char* pDestination );
+
+	static unsigned int GetBlockSizeInBytes( enumFormat format );
+	static unsigned int GetCompressedSize( enumFormat format, unsigned int width, unsigned int height );
+	// For glCompressedTexImage2D() (and the "base" one, GL_RGB or GL_RGBA)
+	static GLenum GetGLInternalFormat( enumFormat format );
+	static GLenum GetGLBaseInternalFormat( enumFormat format );
+	// Can this card use it? (needs OpenGL to be set up)
+	static bool IsFormatSupported( enumFormat format );
+
+	static const char* GetFormatName( enumFormat format );
+	static const char* GetQualityName( enumQuality quality );
+
+	static const unsigned int MAXBLOCKSIZEINBYTES = 16;
+
+private:
+	// One block, as floats (0 to 255), one array for each channel, so 4 pixels can be done at once
+	struct sBlock
+	{
+		float red[16];
+		float green[16];
+		float blue[16];
+		float alpha[16];
+	};
+	static void m_GetBlock( const unsigned char* pPixels, unsigned int width, unsigned int height, unsigned int numberOfChannels,
+	                        unsigned int blockX, unsigned int blockY, sBlock &block );
+
+	static void m_CompressBlockBC1( const sBlock &block, enumQuality quality, unsigned char* pDestination );
+	static void m_CompressBlockBC4Alpha( const sBlock &block, unsigned char* pDestination );
+	static void m_CompressBlockBC7( const sBlock &block, enumQuality quality, unsigned char* pDestination );
+	// (each returns the total squared error)
+	static float m_CompressBlockBC7Mode6( const sBlock &block, enumQuality quality, unsigned char* pDestination );
+	static float m_CompressBlockBC7Mode5( const sBlock &block, enumQuality quality, unsigned char* pDestination );
+
+	// Picks the closest colour in the palette (numberOfColours RGBA entries) for each pixel.
+	//	Returns the total (squared) error. Alpha is only counted if bUseAlpha.
+	static float m_PickIndices( const sBlock &block, const float palette[][4], unsigned int numberOfColours, bool bUseAlpha, unsigned char indices[16] );
+	// The two ends of the line through the block's colours (the principal axis), or of the box around them
+	static void m_GetEndPointsOnAxis( const sBlock &block, unsigned int numberOfChannels, float endPoint0[4], float endPoint1[4] );
+	static void m_GetEndPointsOfBox( const sBlock &block, unsigned int numberOfChannels, float endPoint0[4], float endPoint1[4] );
+	// The "least squares" end points for these indices, where weights[index] is how far each is from end point 0 (0 to 1).
+	//	Returns false if it can't be done (all the pixels picked the same one).
+	static bool m_FitEndPoints( const sBlock &block, const unsigned char indices[16], const float* weights, float endPoint0[4], float endPoint1[4] );
+
+	// Calls doRows() for bands of the block rows, on the thread pool (unless it's too small to bother)
+	static void m_ForEachBand( unsigned int numberOfRows, unsigned int blocksPerRow, std::function<void(unsigned int firstRow, unsigned int lastRow)> doRows );
+	static const unsigned int MINIMUMBLOCKSTOSPLIT = 256;
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include "CCookedTextureFile.h"
+
+#include <fstream>
+#include <string.h>		// for memset(), memcmp()
+
+static_assert( sizeof(CCookedTextureFile::sHeader) == 40, "The cooked texture header is expected to be 40 bytes" );
+
+CCookedTextureFile::CCookedTextureFile()
+{
+	this->m_pHeader = 0;
+	return;
+}
+
+CCookedTextureFile::~CCookedTextureFile()
+{
+	this->Close();
+	return;
+}
+
+//static
+unsigned long long CCookedTextureFile::m_GetMipLevelOffset( unsigned int width, unsigned int height, unsigned int level )
+{
+	// Updated: (64 bit, so a huge width and height in the header can't wrap around to a small size)
+	unsigned long long offset = 0;
+	for ( unsigned int levelAbove = 0; levelAbove != level; levelAbove++ )
+	{
+		const unsigned long long levelSize = static_cast<unsigned long long>( CImageResampler::GetMipLevelSize( width, levelAbove ) ) * 
+		                                     CImageResampler::GetMipLevelSize( height, levelAbove ) * 3;
+		offset += ( ( levelSize + CCookedTextureFile::BLOCKALIGNMENT - 1 ) / CCookedTextureFile::BLOCKALIGNMENT ) * CCookedTextureFile::BLOCKALIGNMENT;
+	}
+	return offset;
+}
+
+//static
+bool CCookedTextureFile::Save( std::string fileName, const void* pRGBPixels, unsigned int width, unsigned int height,
+                               const std::vector<CImageResampler::CImage> &vecMipLevels, unsigned long long cookKey, std::string &error )
+{
+	if ( ( pRGBPixels == 0 ) || ( width == 0 ) || ( height == 0 ) )
+	{
+		error = "There's no image to save.";
+		return false;
+	}
+	const unsigned int numberOfMipLevels = 1 + static_cast<unsigned int>( vecMipLevels.size() );
+	if ( numberOfMipLevels > CImageResampler::GetNumberOfMipLevels( width, height ) )
+	{
+		error = "There are too many mip levels.";
+		return false;
+	}
+	for ( unsigned int level = 1; level != numberOfMipLevels; level++ )
+	{
+		const CImageResampler::CImage &mipLevel = vecMipLevels[level - 1];
+		if ( ( mipLevel.width != CImageResampler::GetMipLevelSize( width, level ) ) || 
+		     ( mipLevel.height != CImageResampler::GetMipLevelSize( height, level ) ) ||
+		     ( mipLevel.vecPixels.size() != static_cast<size_t>( mipLevel.width ) * mipLevel.height * 3 ) )
+		{
+			error = "A mip level is the wrong size.";
+			return false;
+		}
+	}
+
+	// The sizes and offsets in the header are 32 bit
+	const unsigned long long pixelDataSizeInBytes = CCookedTextureFile::m_GetMipLevelOffset( width, height, numberOfMipLevels );
+	if ( pixelDataSizeInBytes > 0xFFFFFFFFULL )
+	{
+		error = "The image is too big.";
+		return false;
+	}
+
+	sHeader header;
+	memset( &header, 0, sizeof(sHeader) );
+	header.ctx[0] = 'c';	header.ctx[1] = 't';	header.ctx[2] = 'x';
+	header.version = CCookedTextureFile::VERSION;
+	header.pixelFormat = CCookedTextureFile::PIXEL_FORMAT_RGB8;
+	header.width = width;
+	header.height = height;
+	header.pixelDataOffset = ( ( sizeof(sHeader) + CCookedTextureFile::BLOCKALIGNMENT - 1 ) / CCookedTextureFile::BLOCKALIGNMENT ) * CCookedTextureFile::BLOCKALIGNMENT;
+	header.pixelDataSizeInBytes = static_cast<unsigned int>( pixelDataSizeInBytes );
+	header.cookKey = cookKey;
+	header.numberOfMipLevels = numberOfMipLevels;
+
+	std::ofstream theFile( fileName.c_str(), std::ios::binary );
+	if ( !theFile.is_open() )
+	{
+		error = "Can't open the file.";
+		return false;
+	}
+
+	const char padding[CCookedTextureFile::BLOCKALIGNMENT] = { 0 };
+	theFile.write( reinterpret_cast<const char*>( &header ), sizeof(sHeader) );
+	theFile.write( padding, header.pixelDataOffset - sizeof(sHeader) );
+	for ( unsigned int level = 0; level != numberOfMipLevels; level++ )
+	{
+		const unsigned int levelSize = ( level == 0 ) ? width * height * 3 : static_cast<unsigned int>( vecMipLevels[level - 1].vecPixels.size() );
+		const char* pLevelPixels = ( level == 0 ) ? static_cast<const char*>( pRGBPixels ) : reinterpret_cast<const char*>( vecMipLevels[level - 1].vecPixels.data() );
+		theFile.write( pLevelPixels, levelSize );
+		const unsigned int levelSizeWithPadding = static_cast<unsigned int>( CCookedTextureFile::m_GetMipLevelOffset( width, height, level + 1 ) - 
+		                                                                     CCookedTextureFile::m_GetMipLevelOffset( width, height, level ) );
+		theFile.write( padding, levelSizeWithPadding - levelSize );
+	}
+	if ( !theFile.good() )
+	{
+		error = "Couldn't write all of the file.";
+		return false;
+	}
+	theFile.close();
+
+	return true;
+}
+
+bool CCookedTextureFile::Open( std::string fileName, std::string &error )
+{
+	this->Close();
+
+	if ( !this->m_fileView.Open( fileName, error ) )
+	{
+		return false;
+	}
+
+	unsigned int fileSize = this->m_fileView.GetSize();
+	const sHeader* pHeader = reinterpret_cast<const sHeader*>( this->m_fileView.GetData() );
+
+	if ( ( fileSize < sizeof(sHeader) ) || ( memcmp( pHeader->ctx, "ctx", 3 ) != 0 ) ||
+		 ( pHeader->version != CCookedTextureFile::VERSION ) ||
+		 ( pHeader->pixelFormat != CCookedTextureFile::PIXEL_FORMAT_RGB8 ) )
+	{
+		error = "Isn't a cooked texture file (or it's a different version).";
+		this->Close();
+		return false;
+	}
+
+	// (level 0's size has to fit in 32 bits, too, since that's what the pixels are passed around with)
+	if ( ( pHeader->width == 0 ) || ( pHeader->height == 0 ) || ( pHeader->numberOfMipLevels == 0 ) ||
+		 ( pHeader->numberOfMipLevels > CImageResampler::GetNumberOfMipLevels( pHeader->width, pHeader->height ) ) ||
+		 ( ( static_cast<unsigned long long>( pHeader->width ) * pHeader->height * 3 ) > 0xFFFFFFFFULL ) )
+	{
+		error = "The cooked texture header doesn't make sense.";
+		this->Close();
+		return false;
+	}
+	unsigned long long expectedSize = CCookedTextureFile::m_GetMipLevelOffset( pHeader->width, pHeader->height, pHeader->numberOfMipLevels );
+	if ( ( pHeader->pixelDataSizeInBytes != expectedSize ) ||
+		 ( pHeader->pixelDataOffset < sizeof(sHeader) ) ||
+		 ( ( static_cast<unsigned long long>( pHeader->pixelDataOffset ) + pHeader->pixelDataSizeInBytes ) > fileSize ) )
+	{
+		error = "The cooked texture header doesn't match the file (or the file is too short).";
+		this->Close();
+		return false;
+	}
+
+	this->m_pHeader = pHeader;
+	return true;
+}
+
+void CCookedTextureFile::Close(void)
+{
+	this->m_fileView.Close();
+	this->m_pHeader = 0;
+	return;
+}
+
+bool CCookedTextureFile::IsOpen(void)
+{
+	return ( this->m_pHeader != 0 );
+}
+
+const void* CCookedTextureFile::GetPixels(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_fileView.GetData() + this->m_pHeader->pixelDataOffset;
+}
+
+unsigned int CCookedTextureFile::GetWidth(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->width;
+}
+
+unsigned int CCookedTextureFile::GetHeight(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->height;
+}
+
+unsigned long long CCookedTextureFile::GetCookKey(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->cookKey;
+}
+
+unsigned int CCookedTextureFile::GetNumberOfMipLevels(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->numberOfMipLevels;
+}
+
+const void* CCookedTextureFile::GetMipLevelPixels( unsigned int level )
+{
+	if ( ( this->m_pHeader == 0 ) || ( level >= this->m_pHeader->numberOfMipLevels ) )	{ return 0; }
+	return this->m_fileView.GetData() + this->m_pHeader->pixelDataOffset + 
+	       CCookedTextureFile::m_GetMipLevelOffset( this->m_pHeader->width, this->m_pHeader->height, level );
+}
+
+unsigned int CCookedTextureFile::GetMipLevelWidth( unsigned int level )
+{
+	if ( ( this->m_pHeader == 0 ) || ( level >= this->m_pHeader->numberOfMipLevels ) )	{ return 0; }
+	return CImageResampler::GetMipLevelSize( this->m_pHeader->width, level );
+}
+
+unsigned int CCookedTextureFile::GetMipLevelHeight( unsigned int level )
+{
+	if ( ( this->m_pHeader == 0 ) || ( level >= this->m_pHeader->numberOfMipLevels ) )	{ return 0; }
+	return CImageResampler::GetMipLevelSize( this->m_pHeader->height, level );
+}
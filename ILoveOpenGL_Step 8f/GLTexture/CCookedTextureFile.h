@@ -0,0 +1,79 @@
+#ifndef _CCookedTextureFile_HG_
+#define _CCookedTextureFile_HG_
+
+// "Cooked" (already decoded) texture file
+// Holds the pixels exactly the way CTextureFromBMP::LoadBMP2() leaves them
+//	(24 bit RGB, no row padding, bottom row first), so loading one is just mapping
+//	the file and passing the pixels to glTexSubImage2D().
+// Updated: Version 2 has the mip maps, too (see CImageResampler::BuildMipChain())
+//
+// File layout (little endian):
+//	- header: sHeader (40 bytes)
+//	- pixels: each mip level (width * height * 3 bytes), starting with level 0; each 
+//	  one starts on a 16 byte boundary
+
+#include <string>
+#include <vector>
+#include "../CFileView.h"
+#include "CImageResampler.h"
+
+class CCookedTextureFile
+{
+public:
+	CCookedTextureFile();
+	~CCookedTextureFile();
+
+	enum enumPixelFormat
+	{
+		PIXEL_FORMAT_RGB8 = 0		// C24BitBMPpixel
+	};
+
+	struct sHeader
+	{
+		char ctx[3];					// 0: "ctx"
+		unsigned char version;			// 3: VERSION
+		unsigned int pixelFormat;		// 4: enumPixelFormat
+		unsigned int width;				// 8
+		unsigned int height;			// 12
+		unsigned int pixelDataOffset;	// 16: from the start of the file
+		unsigned int pixelDataSizeInBytes;	// 20: all the levels (and the padding between them)
+		unsigned long long cookKey;		// 24: see CAssetCache (zero if it wasn't cooked)
+		unsigned int numberOfMipLevels;	// 32: including level 0 (so 1 if there aren't any mip maps)
+		unsigned int reserved;			// 36
+	};
+
+	static const unsigned char VERSION = 2;
+	static const unsigned int BLOCKALIGNMENT = 16;
+
+	// vecMipLevels are levels 1 and down (it can be empty)
+	static bool Save( std::string fileName, const void* pRGBPixels, unsigned int width, unsigned int height,
+	                  const std::vector<CImageResampler::CImage> &vecMipLevels, unsigned long long cookKey, std::string &error );
+
+	// Maps the file and checks the header. The pixels stay valid until Close()
+	bool Open( std::string fileName, std::string &error );
+	void Close(void);
+	bool IsOpen(void);
+
+	const void* GetPixels(void);
+	unsigned int GetWidth(void);
+	unsigned int GetHeight(void);
+	unsigned long long GetCookKey(void);
+	// Added: (level 0 is the same as GetPixels(), GetWidth() and GetHeight())
+	unsigned int GetNumberOfMipLevels(void);
+	const void* GetMipLevelPixels( unsigned int level );
+	unsigned int GetMipLevelWidth( unsigned int level );
+	unsigned int GetMipLevelHeight( unsigned int level );
+
+private:
+	// Can't be copied (it owns the file view)
+	CCookedTextureFile( const CCookedTextureFile &rhs );
+	CCookedTextureFile& operator=( const CCookedTextureFile &rhs );
+
+	CFileView m_fileView;
+	const sHeader* m_pHeader;
+
+	// Where each level starts (from the start of the pixels), and the total (with the padding)
+	static unsigned long long m_GetMipLevelOffset( unsigned int width, unsigned int height, unsigned int level );
+};
+
+#endif
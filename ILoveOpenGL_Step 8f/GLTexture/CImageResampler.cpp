@@ -0,0 +1,365 @@
+#include "CImageResampler.h"
+#include "../CThreadPool.h"
+
+#include <emmintrin.h>	// SSE2
+#include <math.h>
+
+//static
+unsigned int CImageResampler::GetMipLevelSize( unsigned int level0Size, unsigned int level )
+{
+	unsigned int size = ( level < 32 ) ? ( level0Size >> level ) : 0;
+	return ( size == 0 ) ? 1 : size;
+}
+
+//static
+unsigned int CImageResampler::GetNumberOfMipLevels( unsigned int width, unsigned int height )
+{
+	unsigned int biggest = ( width > height ) ? width : height;
+	unsigned int numberOfLevels = 1;
+	while ( biggest > 1 )
+	{
+		biggest >>= 1;
+		numberOfLevels++;
+	}
+	return numberOfLevels;
+}
+
+//static
+const char* CImageResampler::GetFilterName( enumFilter filter )
+{
+	switch ( filter )
+	{
+	case CImageResampler::FILTER_BOX:		return "box";
+	case CImageResampler::FILTER_KAISER:	return "Kaiser (width 3, alpha 4)";
+	case CImageResampler::FILTER_LANCZOS3:	return "Lanczos 3";
+	}
+	return "unknown";
+}
+
+//static
+double CImageResampler::m_FilterSupport( enumFilter filter )
+{
+	switch ( filter )
+	{
+	case CImageResampler::FILTER_KAISER:	return 3.0;
+	case CImageResampler::FILTER_LANCZOS3:	return 3.0;
+	default:								return 0.5;		// Box
+	}
+}
+
+//static
+double CImageResampler::m_FilterValue( enumFilter filter, double x )
+{
+	const double PI = 3.14159265358979323846;
+	// sin(pi x) / (pi x)
+	auto sinc = [PI]( double x ) -> double
+	{
+		if ( fabs( x ) < 1.0e-9 )	{ return 1.0; }
+		return sin( PI * x ) / ( PI * x );
+	};
+	// Modified Bessel function of the first kind (order 0) - the Kaiser window's "shape"
+	auto bessel0 = []( double x ) -> double
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for ( int k = 1; k != 50; k++ )
+		{
+			term *= ( x / ( 2.0 * k ) ) * ( x / ( 2.0 * k ) );
+			sum += term;
+			if ( term < sum * 1.0e-12 )	{ break; }
+		}
+		return sum;
+	};
+
+	switch ( filter )
+	{
+	case CImageResampler::FILTER_KAISER:
+		{
+			const double width = 3.0;
+			const double alpha = 4.0;
+			const double t = x / width;
+			if ( ( 1.0 - t * t ) < 0.0 )	{ return 0.0; }
+			return sinc( x ) * bessel0( alpha * sqrt( 1.0 - t * t ) ) / bessel0( alpha );
+		}
+	case CImageResampler::FILTER_LANCZOS3:
+		if ( fabs( x ) >= 3.0 )	{ return 0.0; }
+		return sinc( x ) * sinc( x / 3.0 );
+	default:	// Box (the right edge is left out, so a pixel on the edge isn't counted twice)
+		return ( ( x >= -0.5 ) && ( x < 0.5 ) ) ? 1.0 : 0.0;
+	}
+}
+
+//static
+void CImageResampler::m_CalculateWeights( unsigned int sourceSize, unsigned int destinationSize, enumFilter filter, sWeights &weights )
+{
+	// Making it smaller, the filter is stretched to cover all of the pixels that go into each one
+	const double scale = static_cast<double>( sourceSize ) / static_cast<double>( destinationSize );
+	const double filterScale = ( scale > 1.0 ) ? scale : 1.0;
+	const double support = CImageResampler::m_FilterSupport( filter ) * filterScale;
+
+	std::vector<unsigned int> vecFirst( destinationSize );
+	std::vector< std::vector<double> > vecPixelWeights( destinationSize );
+	unsigned int maxTaps = 1;
+	for ( unsigned int destination = 0; destination != destinationSize; destination++ )
+	{
+		// Where the middle of this pixel is in the source (the middle of source pixel s is s + 0.5)
+		const double centre = ( destination + 0.5 ) * scale;
+		const int left = static_cast<int>( floor( centre - support ) );
+		const int right = static_cast<int>( ceil( centre + support ) );
+		// The pixels past the edges are the edge pixels
+		const int firstSource = ( left < 0 ) ? 0 : left;
+		const int lastSource = ( right > static_cast<int>( sourceSize ) - 1 ) ? static_cast<int>( sourceSize ) - 1 : right;
+		std::vector<double> &vecWeights = vecPixelWeights[destination];
+		vecWeights.assign( lastSource - firstSource + 1, 0.0 );
+		double total = 0.0;
+		for ( int source = left; source <= right; source++ )
+		{
+			const double weight = CImageResampler::m_FilterValue( filter, ( source + 0.5 - centre ) / filterScale );
+			int clampedSource = ( source < firstSource ) ? firstSource : source;
+			clampedSource = ( clampedSource > lastSource ) ? lastSource : clampedSource;
+			vecWeights[clampedSource - firstSource] += weight;
+			total += weight;
+		}
+		if ( fabs( total ) < 1.0e-9 )
+		{	// (can't happen with these filters, but just in case: the nearest one)
+			vecWeights.assign( vecWeights.size(), 0.0 );
+			int nearest = static_cast<int>( centre ) - firstSource;
+			nearest = ( nearest < 0 ) ? 0 : ( ( nearest >= static_cast<int>( vecWeights.size() ) ) ? static_cast<int>( vecWeights.size() ) - 1 : nearest );
+			vecWeights[nearest] = 1.0;
+			total = 1.0;
+		}
+		// Add up to 1, and trim the zeros off the ends
+		unsigned int firstUsed = 0;
+		while ( ( firstUsed + 1 < vecWeights.size() ) && ( vecWeights[firstUsed] == 0.0 ) )	{ firstUsed++; }
+		unsigned int lastUsed = static_cast<unsigned int>( vecWeights.size() ) - 1;
+		while ( ( lastUsed > firstUsed ) && ( vecWeights[lastUsed] == 0.0 ) )	{ lastUsed--; }
+		std::vector<double> vecUsed;
+		for ( unsigned int index = firstUsed; index <= lastUsed; index++ )
+		{
+			vecUsed.push_back( vecWeights[index] / total );
+		}
+		vecWeights.swap( vecUsed );
+		vecFirst[destination] = firstSource + firstUsed;
+		if ( vecWeights.size() > maxTaps )	{ maxTaps = static_cast<unsigned int>( vecWeights.size() ); }
+	}
+
+	// All the same length, so the filtering loops are simple. If the taps would go past the
+	//	end, they start earlier (with zeros in front).
+	weights.numberOfTaps = maxTaps;
+	weights.vecFirstSource.resize( destinationSize );
+	weights.vecWeights.assign( static_cast<size_t>( destinationSize ) * maxTaps, 0.0f );
+	for ( unsigned int destination = 0; destination != destinationSize; destination++ )
+	{
+		unsigned int first = vecFirst[destination];
+		if ( first + maxTaps > sourceSize )	{ first = sourceSize - maxTaps; }
+		const unsigned int offset = vecFirst[destination] - first;
+		weights.vecFirstSource[destination] = first;
+		const std::vector<double> &vecWeights = vecPixelWeights[destination];
+		for ( unsigned int tap = 0; tap != vecWeights.size(); tap++ )
+		{
+			weights.vecWeights[destination * maxTaps + offset + tap] = static_cast<float>( vecWeights[tap] );
+		}
+	}
+	return;
+}
+
+//static
+const CImageResampler::sConversionTables& CImageResampler::m_GetConversionTables(void)
+{
+	// (only made the first time)
+	static const CImageResampler::sConversionTables* pTables = []()
+	{
+		CImageResampler::sConversionTables* pNewTables = new CImageResampler::sConversionTables();
+		for ( unsigned int value = 0; value != 256; value++ )
+		{
+			const double colour = value / 255.0;
+			pNewTables->unormToFloat[value] = static_cast<float>( colour );
+			pNewTables->sRGBToLinear[value] = static_cast<float>( ( colour <= 0.04045 ) ? ( colour / 12.92 ) : pow( ( colour + 0.055 ) / 1.055, 2.4 ) );
+		}
+		for ( unsigned int index = 0; index != 65536; index++ )
+		{
+			const double linear = index / 65535.0;
+			const double colour = ( linear <= 0.0031308 ) ? ( linear * 12.92 ) : ( 1.055 * pow( linear, 1.0 / 2.4 ) - 0.055 );
+			pNewTables->linearToSRGB[index] = static_cast<unsigned char>( colour * 255.0 + 0.5 );
+		}
+		return pNewTables;
+	}();
+	return *pTables;
+}
+
+//static
+void CImageResampler::m_RowToLinear( const unsigned char* pSource, unsigned int width, unsigned int numberOfChannels, bool bGammaCorrect, float* pLinear )
+{
+	const CImageResampler::sConversionTables &tables = CImageResampler::m_GetConversionTables();
+	const float* pColourTable = bGammaCorrect ? tables.sRGBToLinear : tables.unormToFloat;
+	for ( unsigned int pixel = 0; pixel != width; pixel++, pSource += numberOfChannels, pLinear += 4 )
+	{
+		const float alpha = ( numberOfChannels == 4 ) ? tables.unormToFloat[ pSource[3] ] : 1.0f;
+		_mm_storeu_ps( pLinear, _mm_setr_ps( pColourTable[ pSource[0] ], pColourTable[ pSource[1] ], pColourTable[ pSource[2] ], alpha ) );
+	}
+	return;
+}
+
+//static
+void CImageResampler::m_RowFromLinear( const float* pLinear, unsigned int width, unsigned int numberOfChannels, bool bGammaCorrect, unsigned char* pDestination )
+{
+	const CImageResampler::sConversionTables &tables = CImageResampler::m_GetConversionTables();
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 half = _mm_set1_ps( 0.5f );
+	// Gamma correct, the colours are looked up (alpha isn't); if not, all 4 are just rounded
+	const __m128 toIndex = bGammaCorrect ? _mm_setr_ps( 65535.0f, 65535.0f, 65535.0f, 255.0f ) : _mm_set1_ps( 255.0f );
+	int index[4];
+	for ( unsigned int pixel = 0; pixel != width; pixel++, pLinear += 4, pDestination += numberOfChannels )
+	{
+		// (the sharper filters can go a bit past 0 and 1)
+		__m128 value = _mm_min_ps( _mm_max_ps( _mm_loadu_ps( pLinear ), zero ), one );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( index ), _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( value, toIndex ), half ) ) );
+		if ( bGammaCorrect )
+		{
+			pDestination[0] = tables.linearToSRGB[ index[0] ];
+			pDestination[1] = tables.linearToSRGB[ index[1] ];
+			pDestination[2] = tables.linearToSRGB[ index[2] ];
+		}
+		else
+		{
+			pDestination[0] = static_cast<unsigned char>( index[0] );
+			pDestination[1] = static_cast<unsigned char>( index[1] );
+			pDestination[2] = static_cast<unsigned char>( index[2] );
+		}
+		if ( numberOfChannels == 4 )
+		{
+			pDestination[3] = static_cast<unsigned char>( index[3] );
+		}
+	}
+	return;
+}
+
+//static
+void CImageResampler::m_ForEachBand( unsigned int numberOfRows, unsigned int pixelsPerRow, std::function<void(unsigned int firstRow, unsigned int lastRow)> doRows )
+{
+	unsigned int numberOfBands = 1;
+	if ( static_cast<unsigned long long>( numberOfRows ) * pixelsPerRow >= CImageResampler::MINIMUMPIXELSTOSPLIT )
+	{	// (a few for each thread, so they even out)
+		numberOfBands = CThreadPool::getSharedInstance()->GetNumberOfThreads() * 4;
+		if ( numberOfBands > numberOfRows )	{ numberOfBands = numberOfRows; }
+	}
+	if ( numberOfBands <= 1 )
+	{
+		doRows( 0, numberOfRows );
+		return;
+	}
+	CThreadPool::getSharedInstance()->ParallelFor( numberOfBands, [numberOfRows, numberOfBands, &doRows]( unsigned int band )
+	{
+		const unsigned int firstRow = static_cast<unsigned int>( static_cast<unsigned long long>( numberOfRows ) * band / numberOfBands );
+		const unsigned int lastRow = static_cast<unsigned int>( static_cast<unsigned long long>( numberOfRows ) * ( band + 1 ) / numberOfBands );
+		doRows( firstRow, lastRow );
+	} );
+	return;
+}
+
+//static
+bool CImageResampler::Resize( const unsigned char* pSource, unsigned int sourceWidth, unsigned int sourceHeight, unsigned int numberOfChannels,
+                              unsigned char* pDestination, unsigned int destinationWidth, unsigned int destinationHeight,
+                              enumFilter filter, bool bGammaCorrect )
+{
+	if ( ( pSource == 0 ) || ( pDestination == 0 ) || ( sourceWidth == 0 ) || ( sourceHeight == 0 ) ||
+		 ( destinationWidth == 0 ) || ( destinationHeight == 0 ) || ( ( numberOfChannels != 3 ) && ( numberOfChannels != 4 ) ) )
+	{
+		return false;
+	}
+
+	CImageResampler::sWeights horizontal;
+	CImageResampler::sWeights vertical;
+	CImageResampler::m_CalculateWeights( sourceWidth, destinationWidth, filter, horizontal );
+	CImageResampler::m_CalculateWeights( sourceHeight, destinationHeight, filter, vertical );
+
+	// 1st, each row of the source to the new width (4 linear floats a pixel)
+	const size_t floatsPerRow = static_cast<size_t>( destinationWidth ) * 4;
+	std::vector<float> vecRows( floatsPerRow * sourceHeight );
+	CImageResampler::m_ForEachBand( sourceHeight, sourceWidth, [&]( unsigned int firstRow, unsigned int lastRow )
+	{
+		std::vector<float> vecLinear( static_cast<size_t>( sourceWidth ) * 4 );
+		const unsigned int numberOfTaps = horizontal.numberOfTaps;
+		for ( unsigned int row = firstRow; row != lastRow; row++ )
+		{
+			CImageResampler::m_RowToLinear( pSource + static_cast<size_t>( row ) * sourceWidth * numberOfChannels, sourceWidth,
+			                                numberOfChannels, bGammaCorrect, vecLinear.data() );
+			float* pRow = vecRows.data() + floatsPerRow * row;
+			for ( unsigned int column = 0; column != destinationWidth; column++ )
+			{
+				const float* pWeights = horizontal.vecWeights.data() + static_cast<size_t>( column ) * numberOfTaps;
+				const float* pPixels = vecLinear.data() + static_cast<size_t>( horizontal.vecFirstSource[column] ) * 4;
+				__m128 sum = _mm_setzero_ps();
+				for ( unsigned int tap = 0; tap != numberOfTaps; tap++ )
+				{
+					sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( pWeights[tap] ), _mm_loadu_ps( pPixels + tap * 4 ) ) );
+				}
+				_mm_storeu_ps( pRow + column * 4, sum );
+			}
+		}
+	} );
+
+	// 2nd, each column to the new height (all the columns of a row at once)
+	CImageResampler::m_ForEachBand( destinationHeight, destinationWidth, [&]( unsigned int firstRow, unsigned int lastRow )
+	{
+		std::vector<float> vecLinear( floatsPerRow );
+		std::vector<const float*> vecTapRows( vertical.numberOfTaps );
+		const unsigned int numberOfTaps = vertical.numberOfTaps;
+		for ( unsigned int row = firstRow; row != lastRow; row++ )
+		{
+			const float* pWeights = vertical.vecWeights.data() + static_cast<size_t>( row ) * numberOfTaps;
+			for ( unsigned int tap = 0; tap != numberOfTaps; tap++ )
+			{
+				vecTapRows[tap] = vecRows.data() + floatsPerRow * ( vertical.vecFirstSource[row] + tap );
+			}
+			for ( size_t index = 0; index < floatsPerRow; index += 4 )
+			{
+				__m128 sum = _mm_setzero_ps();
+				for ( unsigned int tap = 0; tap != numberOfTaps; tap++ )
+				{
+					sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( pWeights[tap] ), _mm_loadu_ps( vecTapRows[tap] + index ) ) );
+				}
+				_mm_storeu_ps( vecLinear.data() + index, sum );
+			}
+			CImageResampler::m_RowFromLinear( vecLinear.data(), destinationWidth, numberOfChannels, bGammaCorrect,
+			                                  pDestination + static_cast<size_t>( row ) * destinationWidth * numberOfChannels );
+		}
+	} );
+
+	return true;
+}
+
+//static
+bool CImageResampler::BuildMipChain( const unsigned char* pLevel0, unsigned int width, unsigned int height, unsigned int numberOfChannels,
+                                     enumFilter filter, bool bGammaCorrect, std::vector<CImage> &vecMipLevels )
+{
+	vecMipLevels.clear();
+	if ( ( pLevel0 == 0 ) || ( width == 0 ) || ( height == 0 ) )
+	{
+		return false;
+	}
+	const unsigned int numberOfLevels = CImageResampler::GetNumberOfMipLevels( width, height );
+	vecMipLevels.resize( numberOfLevels - 1 );
+
+	const unsigned char* pLevelAbove = pLevel0;
+	unsigned int widthAbove = width;
+	unsigned int heightAbove = height;
+	for ( unsigned int level = 1; level != numberOfLevels; level++ )
+	{
+		CImageResampler::CImage &mipLevel = vecMipLevels[level - 1];
+		mipLevel.width = CImageResampler::GetMipLevelSize( width, level );
+		mipLevel.height = CImageResampler::GetMipLevelSize( height, level );
+		mipLevel.vecPixels.resize( static_cast<size_t>( mipLevel.width ) * mipLevel.height * numberOfChannels );
+		if ( !CImageResampler::Resize( pLevelAbove, widthAbove, heightAbove, numberOfChannels,
+		                               mipLevel.vecPixels.data(), mipLevel.width, mipLevel.height, filter, bGammaCorrect ) )
+		{
+			vecMipLevels.clear();
+			return false;
+		}
+		pLevelAbove = mipLevel.vecPixels.data();
+		widthAbove = mipLevel.width;
+		heightAbove = mipLevel.height;
+	}
+	return true;
+}
@@ -0,0 +1,80 @@
+#ifndef _CImageResampler_HG_
+#define _CImageResampler_HG_
+
+// Resizes 8 bit RGB (or RGBA) images, and makes mip maps out of them, on the CPU.
+// It's "separable": each row is filtered to the new width, then each column to the new height.
+//	The weights for each new pixel are worked out once (per size), and the edges are
+//	clamped (the edge pixels are repeated).
+// If it's gamma correct, the colours are turned into linear ones (from sRGB) first, and
+//	back after, so dark and bright pixels get averaged properly (alpha is always linear).
+// The filtering is done with 4 floats a pixel (SSE2), and the rows are split up on the
+//	thread pool (see CThreadPool). Each pixel is worked out the same way no matter which
+//	thread does it, so it always gives the same result.
+
+#include <vector>
+#include <functional>
+
+class CImageResampler
+{
+public:
+	enum enumFilter
+	{
+		FILTER_BOX = 0,		// Average (for halving an image, the 2x2 pixels; nearest when it's made bigger)
+		FILTER_KAISER,		// Kaiser windowed sinc (3 pixels wide, alpha = 4) - sharp, not much ringing
+		FILTER_LANCZOS3		// Lanczos (3 pixels wide) - sharpest, but can "ring" a bit
+	};
+
+	class CImage
+	{
+	public:
+		CImage() : width(0), height(0) {};
+		unsigned int width;
+		unsigned int height;
+		std::vector<unsigned char> vecPixels;		// packed rows, bottom row first (like LoadBMP2)
+	};
+
+	// numberOfChannels is 3 (RGB) or 4 (RGBA). pDestination is destinationWidth * destinationHeight * numberOfChannels bytes.
+	// Any sizes work (bigger, smaller, not powers of 2). Returns false if a size is zero (or the channels aren't 3 or 4).
+	static bool Resize( const unsigned char* pSource, unsigned int sourceWidth, unsigned int sourceHeight, unsigned int numberOfChannels,
+	                    unsigned char* pDestination, unsigned int destinationWidth, unsigned int destinationHeight,
+	                    enumFilter filter, bool bGammaCorrect );
+
+	// Levels 1 and down (level 0 is pLevel0): each one is half the one before it (rounded down,
+	//	but at least 1), like OpenGL wants, all the way to 1x1. Each is made from the one before.
+	static bool BuildMipChain( const unsigned char* pLevel0, unsigned int width, unsigned int height, unsigned int numberOfChannels,
+	                           enumFilter filter, bool bGammaCorrect, std::vector<CImage> &vecMipLevels );
+	// Including level 0 (a 256x64 image has 9)
+	static unsigned int GetNumberOfMipLevels( unsigned int width, unsigned int height );
+	static unsigned int GetMipLevelSize( unsigned int level0Size, unsigned int level );
+
+	static const char* GetFilterName( enumFilter filter );
+
+private:
+	// The weights for each pixel, going one way (all the same length; the unused ones are zero)
+	struct sWeights
+	{
+		unsigned int numberOfTaps;
+		std::vector<unsigned int> vecFirstSource;
+		std::vector<float> vecWeights;		// numberOfTaps for each destination pixel
+	};
+	static void m_CalculateWeights( unsigned int sourceSize, unsigned int destinationSize, enumFilter filter, sWeights &weights );
+	static double m_FilterValue( enumFilter filter, double x );
+	static double m_FilterSupport( enumFilter filter );
+
+	// One row to and from linear (4 floats a pixel)
+	static void m_RowToLinear( const unsigned char* pSource, unsigned int width, unsigned int numberOfChannels, bool bGammaCorrect, float* pLinear );
+	static void m_RowFromLinear( const float* pLinear, unsigned int width, unsigned int numberOfChannels, bool bGammaCorrect, unsigned char* pDestination );
+	struct sConversionTables
+	{
+		float sRGBToLinear[256];
+		float unormToFloat[256];
+		unsigned char linearToSRGB[65536];		// index is the linear value * 65535
+	};
+	static const sConversionTables& m_GetConversionTables(void);
+
+	// Calls doRows() for bands of the rows, on the thread pool (unless it's too small to bother)
+	static void m_ForEachBand( unsigned int numberOfRows, unsigned int pixelsPerRow, std::function<void(unsigned int firstRow, unsigned int lastRow)> doRows );
+	static const unsigned int MINIMUMPIXELSTOSPLIT = 64 * 64;
+};
+
+#endif
@@ -0,0 +1,275 @@
+#include "CKTXFile.h"
+#include "CImageResampler.h"
+
+#include <fstream>
+#include <string.h>		// for memset(), memcmp(), memcpy(), strlen()
+
+static_assert( sizeof(CKTXFile::sHeader) == 64, "The KTX header is expected to be 64 bytes" );
+
+//static
+const unsigned char CKTXFile::IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+//static
+const char* CKTXFile::KEYCOOKKEY = "ILoveOpenGL.cookKey";
+
+CKTXFile::CKTXFile()
+{
+	this->m_pHeader = 0;
+	this->m_cookKey = 0;
+	return;
+}
+
+CKTXFile::~CKTXFile()
+{
+	this->Close();
+	return;
+}
+
+//static
+unsigned int CKTXFile::m_PadTo4( unsigned int size )
+{
+	return ( size + 3 ) & ~3u;
+}
+
+//static
+bool CKTXFile::Save( std::string fileName, unsigned int glInternalFormat, unsigned int glBaseInternalFormat,
+                     unsigned int width, unsigned int height, const std::vector< std::vector<unsigned char> > &vecMipLevels,
+                     unsigned long long cookKey, std::string &error )
+{
+	if ( ( width == 0 ) || ( height == 0 ) || vecMipLevels.empty() )
+	{
+		error = "There's no image to save.";
+		return false;
+	}
+	if ( vecMipLevels.size() > CImageResampler::GetNumberOfMipLevels( width, height ) )
+	{
+		error = "There are too many mip levels.";
+		return false;
+	}
+
+	// The key/value pairs (each one padded to 4 bytes)
+	std::vector<char> vecKeyValueData;
+	auto addKeyValue = [&vecKeyValueData]( const char* key, const void* pValue, unsigned int valueSize )
+	{
+		const unsigned int keyAndValueByteSize = static_cast<unsigned int>( strlen( key ) ) + 1 + valueSize;
+		const size_t start = vecKeyValueData.size();
+		vecKeyValueData.resize( start + sizeof(unsigned int) + CKTXFile::m_PadTo4( keyAndValueByteSize ), 0 );
+		memcpy( &vecKeyValueData[start], &keyAndValueByteSize, sizeof(unsigned int) );
+		memcpy( &vecKeyValueData[start + sizeof(unsigned int)], key, strlen( key ) + 1 );
+		memcpy( &vecKeyValueData[start + sizeof(unsigned int) + strlen( key ) + 1], pValue, valueSize );
+	};
+	const char orientation[] = "S=r,T=u";
+	addKeyValue( "KTXorientation", orientation, sizeof(orientation) );
+	addKeyValue( CKTXFile::KEYCOOKKEY, &cookKey, sizeof(cookKey) );
+
+	sHeader header;
+	memset( &header, 0, sizeof(sHeader) );
+	memcpy( header.identifier, CKTXFile::IDENTIFIER, sizeof(header.identifier) );
+	header.endianness = CKTXFile::ENDIANNESS;
+	header.glType = 0;
+	header.glTypeSize = 1;
+	header.glFormat = 0;
+	header.glInternalFormat = glInternalFormat;
+	header.glBaseInternalFormat = glBaseInternalFormat;
+	header.pixelWidth = width;
+	header.pixelHeight = height;
+	header.numberOfFaces = 1;
+	header.numberOfMipmapLevels = static_cast<unsigned int>( vecMipLevels.size() );
+	header.bytesOfKeyValueData = static_cast<unsigned int>( vecKeyValueData.size() );
+
+	std::ofstream theFile( fileName.c_str(), std::ios::binary );
+	if ( !theFile.is_open() )
+	{
+		error = "Can't open the file.";
+		return false;
+	}
+
+	const char padding[4] = { 0 };
+	theFile.write( reinterpret_cast<const char*>( &header ), sizeof(sHeader) );
+	theFile.write( vecKeyValueData.data(), vecKeyValueData.size() );
+	for ( std::vector< std::vector<unsigned char> >::const_iterator itLevel = vecMipLevels.begin(); itLevel != vecMipLevels.end(); itLevel++ )
+	{
+		const unsigned int imageSize = static_cast<unsigned int>( itLevel->size() );
+		theFile.write( reinterpret_cast<const char*>( &imageSize ), sizeof(unsigned int) );
+		theFile.write( reinterpret_cast<const char*>( itLevel->data() ), imageSize );
+		theFile.write( padding, CKTXFile::m_PadTo4( imageSize ) - imageSize );
+	}
+	if ( !theFile.good() )
+	{
+		error = "Couldn't write all of the file.";
+		return false;
+	}
+	theFile.close();
+
+	return true;
+}
+
+bool CKTXFile::Open( std::string fileName, std::string &error )
+{
+	this->Close();
+
+	if ( !this->m_fileView.Open( fileName, error ) )
+	{
+		return false;
+	}
+
+	const unsigned int fileSize = this->m_fileView.GetSize();
+	const char* pData = this->m_fileView.GetData();
+	const sHeader* pHeader = reinterpret_cast<const sHeader*>( pData );
+
+	if ( ( fileSize < sizeof(sHeader) ) || ( memcmp( pHeader->identifier, CKTXFile::IDENTIFIER, sizeof(pHeader->identifier) ) != 0 ) )
+	{
+		error = "Isn't a KTX file.";
+		this->Close();
+		return false;
+	}
+	if ( pHeader->endianness != CKTXFile::ENDIANNESS )
+	{
+		error = "The KTX file is big endian.";
+		this->Close();
+		return false;
+	}
+	if ( ( pHeader->glType != 0 ) || ( pHeader->glFormat != 0 ) || ( pHeader->pixelDepth != 0 ) ||
+	     ( pHeader->numberOfArrayElements != 0 ) || ( pHeader->numberOfFaces != 1 ) )
+	{
+		error = "The KTX file isn't a block compressed 2D texture.";
+		this->Close();
+		return false;
+	}
+	// (zero mip levels means "make them", which there's no way to do for a compressed texture)
+	if ( ( pHeader->pixelWidth == 0 ) || ( pHeader->pixelHeight == 0 ) || ( pHeader->numberOfMipmapLevels == 0 ) ||
+	     ( pHeader->numberOfMipmapLevels > CImageResampler::GetNumberOfMipLevels( pHeader->pixelWidth, pHeader->pixelHeight ) ) )
+	{
+		error = "The KTX header doesn't make sense.";
+		this->Close();
+		return false;
+	}
+
+	// The key/value pairs (only the cook key is used)
+	unsigned long long keyValueEnd = static_cast<unsigned long long>( sizeof(sHeader) ) + pHeader->bytesOfKeyValueData;
+	if ( keyValueEnd > fileSize )
+	{
+		error = "The KTX file is too short.";
+		this->Close();
+		return false;
+	}
+	unsigned int offset = sizeof(sHeader);
+	while ( offset + sizeof(unsigned int) <= keyValueEnd )
+	{
+		unsigned int keyAndValueByteSize = 0;
+		memcpy( &keyAndValueByteSize, pData + offset, sizeof(unsigned int) );
+		offset += sizeof(unsigned int);
+		if ( keyAndValueByteSize > keyValueEnd - offset )
+		{
+			error = "A KTX key/value pair is too long.";
+			this->Close();
+			return false;
+		}
+		const unsigned int keySize = static_cast<unsigned int>( strlen( CKTXFile::KEYCOOKKEY ) ) + 1;
+		if ( ( keyAndValueByteSize == keySize + sizeof(unsigned long long) ) &&
+		     ( memcmp( pData + offset, CKTXFile::KEYCOOKKEY, keySize ) == 0 ) )
+		{
+			memcpy( &(this->m_cookKey), pData + offset + keySize, sizeof(unsigned long long) );
+		}
+		offset += CKTXFile::m_PadTo4( keyAndValueByteSize );
+	}
+	offset = static_cast<unsigned int>( keyValueEnd );
+
+	// Each level is its size, then the blocks
+	for ( unsigned int level = 0; level != pHeader->numberOfMipmapLevels; level++ )
+	{
+		unsigned int imageSize = 0;
+		if ( static_cast<unsigned long long>( offset ) + sizeof(unsigned int) > fileSize )
+		{
+			error = "The KTX file is too short.";
+			this->Close();
+			return false;
+		}
+		memcpy( &imageSize, pData + offset, sizeof(unsigned int) );
+		offset += sizeof(unsigned int);
+		if ( ( imageSize == 0 ) || ( static_cast<unsigned long long>( offset ) + imageSize > fileSize ) )
+		{
+			error = "The KTX file is too short.";
+			this->Close();
+			return false;
+		}
+		this->m_vecMipLevelOffsets.push_back( offset );
+		this->m_vecMipLevelSizes.push_back( imageSize );
+		offset += CKTXFile::m_PadTo4( imageSize );
+	}
+
+	this->m_pHeader = pHeader;
+	return true;
+}
+
+void CKTXFile::Close(void)
+{
+	this->m_fileView.Close();
+	this->m_pHeader = 0;
+	this->m_cookKey = 0;
+	this->m_vecMipLevelOffsets.clear();
+	this->m_vecMipLevelSizes.clear();
+	return;
+}
+
+bool CKTXFile::IsOpen(void)
+{
+	return ( this->m_pHeader != 0 );
+}
+
+unsigned int CKTXFile::GetGLInternalFormat(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->glInternalFormat;
+}
+
+unsigned int CKTXFile::GetGLBaseInternalFormat(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->glBaseInternalFormat;
+}
+
+unsigned int CKTXFile::GetWidth(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->pixelWidth;
+}
+
+unsigned int CKTXFile::GetHeight(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->pixelHeight;
+}
+
+unsigned long long CKTXFile::GetCookKey(void)
+{
+	return this->m_cookKey;
+}
+
+unsigned int CKTXFile::GetNumberOfMipLevels(void)
+{
+	return static_cast<unsigned int>( this->m_vecMipLevelSizes.size() );
+}
+
+const void* CKTXFile::GetMipLevelData( unsigned int level )
+{
+	if ( level >= this->m_vecMipLevelOffsets.size() )	{ return 0; }
+	return this->m_fileView.GetData() + this->m_vecMipLevelOffsets[level];
+}
+
+unsigned int CKTXFile::GetMipLevelSizeInBytes( unsigned int level )
+{
+	if ( level >= this->m_vecMipLevelSizes.size() )	{ return 0; }
+	return this->m_vecMipLevelSizes[level];
+}
+
+unsigned int CKTXFile::GetMipLevelWidth( unsigned int level )
+{
+	if ( ( this->m_pHeader == 0 ) || ( level >= this->m_vecMipLevelSizes.size() ) )	{ return 0; }
+	return CImageResampler::GetMipLevelSize( this->m_pHeader->pixelWidth, level );
+}
+
+unsigned int CKTXFile::GetMipLevelHeight( unsigned int level )
+{
+	if ( ( this->m_pHeader == 0 ) || ( level >= this->m_vecMipLevelSizes.size() ) )	{ return 0; }
+	return CImageResampler::GetMipLevelSize( this->m_pHeader->pixelHeight, level );
+}
@@ -0,0 +1,88 @@
+#ifndef _CKTXFile_HG_
+#define _CKTXFile_HG_
+
+// KTX (version 1.1, Khronos) texture file, for the block compressed textures (see CBlockCompressor)
+// It's the "already how the GPU wants it" format: each mip level is passed to
+//	glCompressedTexImage2D() straight out of the (mapped) file.
+// Only 2D, block compressed (glType of 0), little endian files are read; anything else
+//	(cube maps, arrays, uncompressed) isn't something this loads, so Open() says so.
+//
+// File layout (little endian):
+//	- header: sHeader (64 bytes)
+//	- key/value data: bytesOfKeyValueData bytes. Each is a 4 byte size, "key\0value", then
+//	  padding to 4 bytes. This writes "KTXorientation" (the rows are bottom row first, like
+//	  OpenGL, so "S=r,T=u") and KEYCOOKKEY (the 8 byte cook key, see CAssetCache).
+//	- each mip level, starting with level 0: a 4 byte size, then the blocks (then padding to 4)
+
+#include <string>
+#include <vector>
+#include "../CFileView.h"
+
+class CKTXFile
+{
+public:
+	CKTXFile();
+	~CKTXFile();
+
+	struct sHeader
+	{
+		unsigned char identifier[12];			// 0: IDENTIFIER
+		unsigned int endianness;				// 12: ENDIANNESS
+		unsigned int glType;					// 16: 0 for compressed
+		unsigned int glTypeSize;				// 20: 1 for compressed
+		unsigned int glFormat;					// 24: 0 for compressed
+		unsigned int glInternalFormat;			// 28: like GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+		unsigned int glBaseInternalFormat;		// 32: GL_RGB or GL_RGBA
+		unsigned int pixelWidth;				// 36
+		unsigned int pixelHeight;				// 40
+		unsigned int pixelDepth;				// 44: 0 for 2D
+		unsigned int numberOfArrayElements;		// 48: 0 if it's not an array
+		unsigned int numberOfFaces;				// 52: 1 (6 for cube maps)
+		unsigned int numberOfMipmapLevels;		// 56: including level 0
+		unsigned int bytesOfKeyValueData;		// 60
+	};
+
+	static const unsigned char IDENTIFIER[12];
+	static const unsigned int ENDIANNESS = 0x04030201;
+	static const char* KEYCOOKKEY;
+
+	// vecMipLevels are the blocks for each level, starting with level 0
+	static bool Save( std::string fileName, unsigned int glInternalFormat, unsigned int glBaseInternalFormat,
+	                  unsigned int width, unsigned int height, const std::vector< std::vector<unsigned char> > &vecMipLevels,
+	                  unsigned long long cookKey, std::string &error );
+
+	// Maps the file and checks the header (and that all the levels are there). The data stays valid until Close()
+	bool Open( std::string fileName, std::string &error );
+	void Close(void);
+	bool IsOpen(void);
+
+	unsigned int GetGLInternalFormat(void);
+	unsigned int GetGLBaseInternalFormat(void);
+	unsigned int GetWidth(void);
+	unsigned int GetHeight(void);
+	// Zero if there's no KEYCOOKKEY
+	unsigned long long GetCookKey(void);
+	// Including level 0
+	unsigned int GetNumberOfMipLevels(void);
+	const void* GetMipLevelData( unsigned int level );
+	unsigned int GetMipLevelSizeInBytes( unsigned int level );
+	unsigned int GetMipLevelWidth( unsigned int level );
+	unsigned int GetMipLevelHeight( unsigned int level );
+
+private:
+	// Can't be copied (it owns the file view)
+	CKTXFile( const CKTXFile &rhs );
+	CKTXFile& operator=( const CKTXFile &rhs );
+
+	CFileView m_fileView;
+	const sHeader* m_pHeader;
+	unsigned long long m_cookKey;
+	// Where each level's blocks are in the file, and how big they are
+	std::vector<unsigned int> m_vecMipLevelOffsets;
+	std::vector<unsigned int> m_vecMipLevelSizes;
+
+	// Rounds up to the next multiple of 4
+	static unsigned int m_PadTo4( unsigned int size );
+};
+
+#endif
@@ -11,6 +11,12 @@
 
 #include <fstream>
 #include <iostream>
+#include <vector>
+#include <string.h>		// for memcpy()
+#include "../CFileView.h"
+#include "CCookedTextureFile.h"
+#include "CKTXFile.h"
+#include "CBMPRowDecoder.h"
 
 //#define GL_VERSION_IS_42_OR_HIGHER
 
@@ -27,7 +33,8 @@ CTextureFromBMP::CTextureFromBMP()
   m_PixelsPerMeterX(0), m_PixelsPerMeterY(0), 
   m_numberOfLookUpTableEntries(0), m_numberOfImportantColours(0),
   m_textureNumber(0), m_bHave_cout_output(false), /*m_textureUnit(0),*/
-  m_bIsCubeMap(false), m_bIs2DTexture(false)
+  m_bIsCubeMap(false), m_bIs2DTexture(false), m_pUploadRing(0),
+  m_compressedInternalFormat(0), m_compressedBaseInternalFormat(0), m_sizeInGPUMemory(0), m_bIsCompressed(false)
 {
 	return;
 }
@@ -48,6 +55,22 @@ GLuint CTextureFromBMP::getTextureNumber(void)
 	return this->m_textureNumber;
 }
 
+void CTextureFromBMP::SetUploadRing( CGPUUploadRing* pUploadRing )
+{
+	this->m_pUploadRing = pUploadRing;
+	return;
+}
+
+unsigned long CTextureFromBMP::GetSizeInGPUMemory(void)
+{
+	return this->m_sizeInGPUMemory;
+}
+
+bool CTextureFromBMP::IsCompressed(void)
+{
+	return this->m_bIsCompressed;
+}
+
 std::string CTextureFromBMP::getTextureName(void)
 {
 	return this->m_textureName;
@@ -61,7 +84,8 @@ std::string CTextureFromBMP::getFileNameFullPath(void)
 
 
 bool CTextureFromBMP::CreateNewTextureFromBMPFile2( std::string textureName, std::string fileNameFullPath, 
-												    /*GLenum textureUnit,*/ bool bGenerateMIPMap )	
+												    /*GLenum textureUnit,*/ bool bGenerateMIPMap,
+												    std::string cookedFileToSave /*=""*/, unsigned long long cookKey /*=0*/ )	
 {
 	bool bReturnVal = true;
 
@@ -71,7 +95,7 @@ bool CTextureFromBMP::CreateNewTextureFromBMPFile2( std::string textureName, std
 	// Worked?
 	if ( ( glGetError() & GL_INVALID_VALUE ) == GL_INVALID_VALUE )
 	{
-		bReturnVal = false;
+		this->m_DeleteTextureName();
 		return false;
 	}
 
@@ -79,38 +103,277 @@ bool CTextureFromBMP::CreateNewTextureFromBMPFile2( std::string textureName, std
 	//{
 	//	return false;
 	//}
+	// Added: If it's not being cooked, the rows are decoded straight into the upload ring 
+	//	(as RGBA, which the drivers like better), so there's no copy of the pixels in between
+	if ( ( this->m_pUploadRing != 0 ) && cookedFileToSave.empty() )
+	{
+		CFileView theFile;
+		std::string openError;
+		const unsigned char* pFirstRow = 0;
+		bool bTopRowFirst = false;
+		if ( !theFile.Open( fileNameFullPath, openError ) )
+		{
+			this->m_lastErrorNum = CTextureFromBMP::ERORR_FILE_WONT_OPEN;
+			this->m_DeleteTextureName();
+			return false;
+		}
+		if ( !this->m_ReadBMPHeader( theFile.GetData(), theFile.GetSize(), pFirstRow, bTopRowFirst ) )
+		{
+			this->m_DeleteTextureName();
+			return false;
+		}
+		this->m_fileNameFullPath = fileNameFullPath;
+		this->m_textureName = textureName;
+
+		const unsigned int width = this->m_numberOfColumns;
+		const unsigned int height = this->m_numberOfRows;
+		bReturnVal = this->m_Upload2DTexture( 0, bGenerateMIPMap, GL_RGBA, 
+			[pFirstRow, width, height, bTopRowFirst]( void* pDestination )
+			{
+				CBMPRowDecoder::DecodeImage( pFirstRow, width, height, bTopRowFirst, CBMPRowDecoder::OUTPUT_RGBA, 
+				                             static_cast<unsigned char*>( pDestination ) );
+			} );
+		if ( !bReturnVal )
+		{
+			this->m_DeleteTextureName();
+		}
+		return bReturnVal;
+	}
+
 	if ( !this->LoadBMP2( fileNameFullPath ) )
 	{
+		this->m_DeleteTextureName();
+		return false;
+	}
+
+	this->m_fileNameFullPath = fileNameFullPath;
+	this->m_textureName = textureName;
+
+	// Added: Save the decoded pixels so next time they don't have to be decoded
+	//	(it doesn't matter if this doesn't work; it'll just be decoded again next time)
+	if ( !cookedFileToSave.empty() )
+	{
+		this->SaveCookedFile( cookedFileToSave, cookKey );
+	}
+
+	bReturnVal = this->m_Upload2DTexture( this->m_p_theImages, bGenerateMIPMap );
+	if ( !bReturnVal )
+	{
+		this->m_DeleteTextureName();
+	}
+
+	this->ClearBMP();
+
+	return bReturnVal;
+}
+
+// Added: Same as above, but the pixels are already decoded (see CCookedTextureFile)
+bool CTextureFromBMP::CreateNewTextureFromCookedFile( std::string textureName, std::string cookedFileName, 
+                                                      unsigned long long cookKey, bool bGenerateMIPMap )
+{
+	CCookedTextureFile cookedFile;
+	std::string error;
+	if ( !cookedFile.Open( cookedFileName, error ) )
+	{
+		this->m_lastErrorNum = CTextureFromBMP::ERORR_FILE_WONT_OPEN;
 		return false;
 	}
+	// Out of date?
+	if ( cookedFile.GetCookKey() != cookKey )
+	{
+		this->m_lastErrorNum = CTextureFromBMP::ERORR_FILE_WONT_OPEN;
+		return false;
+	}
+
+	glGenTextures( 1, &(this->m_textureNumber) );
+	// Worked?
+	if ( ( glGetError() & GL_INVALID_VALUE ) == GL_INVALID_VALUE )
+	{
+		this->m_DeleteTextureName();
+		return false;
+	}
+
+	this->m_fileNameFullPath = cookedFileName;
+	this->m_textureName = textureName;
+	// Same as what LoadBMP2() sets
+	this->m_numberOfColumns = cookedFile.GetWidth();
+	this->m_numberOfRows = cookedFile.GetHeight();
+	this->m_Height = this->m_OriginalHeight = this->m_numberOfRows;
+	this->m_Width = this->m_OriginalWidth = this->m_numberOfColumns;
+	this->m_bitPerPixel = 24;
+
+	// Straight from the mapped file (mip maps and all)
+	std::vector<const void*> vecMipLevelPixels;
+	for ( unsigned int level = 1; level < cookedFile.GetNumberOfMipLevels(); level++ )
+	{
+		vecMipLevelPixels.push_back( cookedFile.GetMipLevelPixels( level ) );
+	}
+	if ( !this->m_Upload2DTexture( cookedFile.GetPixels(), bGenerateMIPMap, GL_RGB, nullptr, vecMipLevelPixels ) )
+	{
+		this->m_DeleteTextureName();
+		return false;
+	}
+	return true;
+}
+
+bool CTextureFromBMP::SaveCookedFile( std::string cookedFileName, unsigned long long cookKey )
+{
+	static_assert( sizeof(C24BitBMPpixel) == 3, "The pixels are saved (and passed to OpenGL) as packed RGB bytes" );
+
+	// Updated: The mip maps are always saved, too (so they're only ever made once)
+	if ( this->m_vecMipChain.empty() )
+	{
+		this->GenerateMipChain();
+	}
+
+	std::string error;
+	return CCookedTextureFile::Save( cookedFileName, this->m_p_theImages, 
+	                                 this->m_numberOfColumns, this->m_numberOfRows, this->m_vecMipChain, cookKey, error );
+}
+
+bool CTextureFromBMP::LoadCookedFile( std::string cookedFileName, unsigned long long cookKey )
+{
+	CCookedTextureFile cookedFile;
+	std::string error;
+	if ( !cookedFile.Open( cookedFileName, error ) || ( cookedFile.GetCookKey() != cookKey ) )
+	{
+		this->m_lastErrorNum = CTextureFromBMP::ERORR_FILE_WONT_OPEN;
+		return false;
+	}
+	// Same as what LoadBMP2() sets
+	this->m_numberOfColumns = cookedFile.GetWidth();
+	this->m_numberOfRows = cookedFile.GetHeight();
+	this->m_Height = this->m_OriginalHeight = this->m_numberOfRows;
+	this->m_Width = this->m_OriginalWidth = this->m_numberOfColumns;
+	this->m_bitPerPixel = 24;
+
+	const unsigned long numberOfPixels = this->m_numberOfColumns * this->m_numberOfRows;
+	this->m_p_theImages = new C24BitBMPpixel[numberOfPixels];
+	memcpy( reinterpret_cast<unsigned char*>( this->m_p_theImages ), cookedFile.GetPixels(), numberOfPixels * sizeof(C24BitBMPpixel) );
+
+	this->m_vecMipChain.resize( cookedFile.GetNumberOfMipLevels() - 1 );
+	for ( unsigned int level = 1; level < cookedFile.GetNumberOfMipLevels(); level++ )
+	{
+		CImageResampler::CImage &mipLevel = this->m_vecMipChain[level - 1];
+		mipLevel.width = cookedFile.GetMipLevelWidth( level );
+		mipLevel.height = cookedFile.GetMipLevelHeight( level );
+		const unsigned char* pLevelPixels = static_cast<const unsigned char*>( cookedFile.GetMipLevelPixels( level ) );
+		mipLevel.vecPixels.assign( pLevelPixels, pLevelPixels + mipLevel.width * mipLevel.height * 3 );
+	}
+	return true;
+}
 
+bool CTextureFromBMP::CreateNewTextureFromLoadedPixels( std::string textureName, std::string fileNameFullPath, bool bGenerateMIPMap )
+{
+	if ( ( this->m_p_theImages == 0 ) && this->m_vecCompressedLevels.empty() )
+	{
+		return false;
+	}
+	glGenTextures( 1, &(this->m_textureNumber) );
+	// Worked?
+	if ( ( glGetError() & GL_INVALID_VALUE ) == GL_INVALID_VALUE )
+	{
+		this->m_DeleteTextureName();
+		this->ClearBMP();
+		return false;
+	}
 	this->m_fileNameFullPath = fileNameFullPath;
 	this->m_textureName = textureName;
 
+	bool bReturnVal = false;
+	if ( !this->m_vecCompressedLevels.empty() )
+	{	// Added: (block compressed)
+		std::vector<const void*> vecLevelData;
+		std::vector<unsigned int> vecLevelSizes;
+		for ( std::vector< std::vector<unsigned char> >::const_iterator itLevel = this->m_vecCompressedLevels.begin(); 
+		      itLevel != this->m_vecCompressedLevels.end(); itLevel++ )
+		{
+			vecLevelData.push_back( itLevel->data() );
+			vecLevelSizes.push_back( static_cast<unsigned int>( itLevel->size() ) );
+		}
+		bReturnVal = this->m_UploadCompressed2DTexture( this->m_compressedInternalFormat, vecLevelData, vecLevelSizes, bGenerateMIPMap );
+	}
+	else
+	{
+		bReturnVal = this->m_Upload2DTexture( this->m_p_theImages, bGenerateMIPMap );
+	}
+	if ( !bReturnVal )
+	{
+		this->m_DeleteTextureName();
+	}
+
+	this->ClearBMP();
+
+	return bReturnVal;
+}
+
+// Added: Split out of CreateNewTextureFromBMPFile2(), so the cooked textures can use it, too
+bool CTextureFromBMP::m_Upload2DTexture( const void* pPixels, bool bGenerateMIPMap, GLenum pixelFormat /*=GL_RGB*/, 
+                                         std::function<void(void* pDestination)> writePixels /*=nullptr*/,
+                                         std::vector<const void*> vecMipLevelPixels /*=std::vector<const void*>()*/ )
+{
+	const unsigned int bytesPerPixel = ( pixelFormat == GL_RGBA ) ? 4 : 3;
+	const unsigned int sizeInBytes = static_cast<unsigned int>( this->m_numberOfColumns * this->m_numberOfRows * bytesPerPixel );
+
+	// Updated: The mip maps are made here, on the CPU (see CImageResampler), instead of 
+	//	by glGenerateMipmap(), unless they already were (GenerateMipChain(), or a cooked file)
+	std::vector<unsigned char> vecLevel0Pixels;
+	std::vector<CImageResampler::CImage> vecNewMipChain;
+	if ( bGenerateMIPMap && vecMipLevelPixels.empty() )
+	{
+		const std::vector<CImageResampler::CImage>* pMipChain = &(this->m_vecMipChain);
+		if ( ( pPixels != this->m_p_theImages ) || ( pixelFormat != GL_RGB ) || this->m_vecMipChain.empty() )
+		{
+			// (if it was going to be written right into the upload ring, it's needed here first)
+			if ( writePixels )
+			{
+				vecLevel0Pixels.resize( sizeInBytes );
+				writePixels( vecLevel0Pixels.data() );
+				pPixels = vecLevel0Pixels.data();
+				writePixels = nullptr;
+			}
+			CImageResampler::BuildMipChain( static_cast<const unsigned char*>( pPixels ), this->m_numberOfColumns, this->m_numberOfRows, 
+			                                bytesPerPixel, CTextureFromBMP::MIPMAPFILTER, CTextureFromBMP::MIPMAPGAMMACORRECT, vecNewMipChain );
+			pMipChain = &vecNewMipChain;
+		}
+		for ( std::vector<CImageResampler::CImage>::const_iterator itLevel = pMipChain->begin(); itLevel != pMipChain->end(); itLevel++ )
+		{
+			vecMipLevelPixels.push_back( itLevel->vecPixels.data() );
+		}
+	}
+	const unsigned int numberOfLevels = bGenerateMIPMap ? 1 + static_cast<unsigned int>( vecMipLevelPixels.size() ) : 1;
+
 	// Good to go (valid texture ID and loaded bitmap...
 	// Now set the texture...
 	//glActiveTexture( textureUnit );	// GL_TEXTURE0, GL_TEXTURE1, etc.
 	glBindTexture(GL_TEXTURE_2D, this->m_textureNumber);
 
+	// Updated: The rows are packed (the default is that each row starts on 4 bytes, which RGB rows 
+	//	only do if the width is a multiple of 4)
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
 #ifndef GL_VERSION_IS_42_OR_HIGHER
-	glTexImage2D( GL_TEXTURE_2D,		// target (2D, 3D, etc.)
-				 0,					// MIP map level 
-				 GL_RGBA,			// internal format
-				 this->m_numberOfColumns,	// width (pixels)
-				 this->m_numberOfRows,	// height (pixels)
-				 0,					// border (0 or 1)
-				 GL_RGB,			// format of pixel data
-				 GL_UNSIGNED_BYTE,	// type of pixel data
-				 this->m_p_theImages);	// pointer to data in memory
+	for ( unsigned int level = 0; level != numberOfLevels; level++ )
+	{
+		glTexImage2D( GL_TEXTURE_2D,		// target (2D, 3D, etc.)
+					 level,				// MIP map level 
+					 GL_RGBA,			// internal format
+					 CImageResampler::GetMipLevelSize( this->m_numberOfColumns, level ),	// width (pixels)
+					 CImageResampler::GetMipLevelSize( this->m_numberOfRows, level ),	// height (pixels)
+					 0,					// border (0 or 1)
+					 pixelFormat,		// format of pixel data
+					 GL_UNSIGNED_BYTE,	// type of pixel data
+					 0);				// Updated: just the storage (the pixels go in with glTexSubImage2D(), below)
+	}
 #else
 	glTexStorage2D( GL_TEXTURE_2D, 
-		            1, 
+		            numberOfLevels, 
 					GL_RGBA8, 
 					this->m_numberOfColumns, 
 					this->m_numberOfRows );
 #endif
 
-	if ( this->bWasThereAnOpenGLError() )	{ return false;	}
+	if ( this->bWasThereAnOpenGLError() )	{ glPixelStorei( GL_UNPACK_ALIGNMENT, 4 ); return false;	}
 
 	//for ( int index = 0; index != 400; index++ )
 	//{
@@ -119,24 +382,43 @@ bool CTextureFromBMP::CreateNewTextureFromBMPFile2( std::string textureName, std
 	//	std::cout << (int)this->m_p_theImages[index].bluePixel << std::endl;
 	//}
 
-	glTexSubImage2D( GL_TEXTURE_2D, 
-		             0,		// Level 0
-					 0, 0,	// Offset of 0,0
-					 this->m_numberOfColumns, 
-					 this->m_numberOfRows,
-					 GL_RGB,			// Pixel data format
-					 GL_UNSIGNED_BYTE,	// Pixel data type  
-					 this->m_p_theImages );
+	this->m_Upload2DTextureLevel( 0, this->m_numberOfColumns, this->m_numberOfRows, pixelFormat, pPixels, writePixels );
+	for ( unsigned int level = 1; level != numberOfLevels; level++ )
+	{
+		this->m_Upload2DTextureLevel( level, CImageResampler::GetMipLevelSize( this->m_numberOfColumns, level ), 
+		                              CImageResampler::GetMipLevelSize( this->m_numberOfRows, level ), 
+		                              pixelFormat, vecMipLevelPixels[level - 1], nullptr );
+	}
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
 
 	if ( this->bWasThereAnOpenGLError() )	{ return false;	}
 
-	this->ClearBMP();
-
+	this->m_Set2DTextureParameters( numberOfLevels );
 
-	if ( bGenerateMIPMap )
+	// Added: (the internal format is GL_RGBA, so 4 bytes a pixel)
+	this->m_sizeInGPUMemory = 0;
+	for ( unsigned int level = 0; level != numberOfLevels; level++ )
 	{
-		glGenerateMipmap( GL_TEXTURE_2D );		// OpenGL 4.0
+		this->m_sizeInGPUMemory += CImageResampler::GetMipLevelSize( this->m_numberOfColumns, level ) * 
+		                           CImageResampler::GetMipLevelSize( this->m_numberOfRows, level ) * 4;
 	}
+	this->m_bIsCompressed = false;
+
+	//this->m_textureUnit = textureUnit;
+
+	this->m_bIs2DTexture = true;
+
+	//glBindTexture(GL_TEXTURE_2D, 0);
+
+	return true;
+}
+
+void CTextureFromBMP::m_Set2DTextureParameters( unsigned int numberOfLevels )
+{
+	// Updated: (instead of glGenerateMipmap()) Only the levels that are there are used, so 
+	//	it's still "complete" if there aren't any mip maps
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0 );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numberOfLevels - 1 );
 
 	//if ( this->bWasThereAnOpenGLError() )	{ return false;	}
 
@@ -154,13 +436,219 @@ bool CTextureFromBMP::CreateNewTextureFromBMPFile2( std::string textureName, std
 
 	//if ( this->bWasThereAnOpenGLError() )	{ return false;	}
 
-	//this->m_textureUnit = textureUnit;
+	return;
+}
 
-	this->m_bIs2DTexture = true;
+void CTextureFromBMP::m_DeleteTextureName(void)
+{
+	if ( this->m_textureNumber != 0 )
+	{
+		glDeleteTextures( 1, &(this->m_textureNumber) );
+		this->m_textureNumber = 0;
+	}
+	return;
+}
 
-	//glBindTexture(GL_TEXTURE_2D, 0);
+void CTextureFromBMP::m_Upload2DTextureLevel( GLint level, unsigned int width, unsigned int height, GLenum pixelFormat, 
+                                              const void* pPixels, std::function<void(void* pDestination)> writePixels )
+{
+	const unsigned int bytesPerPixel = ( pixelFormat == GL_RGBA ) ? 4 : 3;
+	const unsigned int sizeInBytes = width * height * bytesPerPixel;
+	if ( ( this->m_pUploadRing != 0 ) && writePixels )
+	{	// Added: (written right into the ring)
+		this->m_pUploadRing->UploadToTexture2D( level, 0, 0, width, height, pixelFormat, GL_UNSIGNED_BYTE, writePixels, sizeInBytes );
+	}
+	else if ( this->m_pUploadRing != 0 )
+	{	// Added: (the rows are packed, 3 bytes a pixel)
+		this->m_pUploadRing->UploadToTexture2D( level, 0, 0, width, height, pixelFormat, GL_UNSIGNED_BYTE, pPixels, sizeInBytes );
+	}
+	else
+	{
+		std::vector<unsigned char> vecPixels;
+		if ( writePixels )
+		{
+			vecPixels.resize( sizeInBytes );
+			writePixels( vecPixels.data() );
+			pPixels = vecPixels.data();
+		}
+		glTexSubImage2D( GL_TEXTURE_2D, 
+			             level,
+						 0, 0,	// Offset of 0,0
+						 width, 
+						 height,
+						 pixelFormat,		// Pixel data format
+						 GL_UNSIGNED_BYTE,	// Pixel data type  
+						 pPixels );
+	}
+	return;
+}
 
-	return bReturnVal;
+bool CTextureFromBMP::GenerateMipChain(void)
+{
+	if ( this->m_p_theImages == 0 )
+	{
+		return false;
+	}
+	return CImageResampler::BuildMipChain( reinterpret_cast<const unsigned char*>( this->m_p_theImages ), this->m_numberOfColumns, this->m_numberOfRows, 
+	                                       3, CTextureFromBMP::MIPMAPFILTER, CTextureFromBMP::MIPMAPGAMMACORRECT, this->m_vecMipChain );
+}
+
+bool CTextureFromBMP::CompressLoadedPixels( CBlockCompressor::enumFormat format, CBlockCompressor::enumQuality quality )
+{
+	if ( this->m_p_theImages == 0 )
+	{
+		return false;
+	}
+	// (the mip maps are made from the uncompressed pixels, then each one is compressed)
+	if ( this->m_vecMipChain.empty() && !this->GenerateMipChain() )
+	{
+		return false;
+	}
+
+	this->m_vecCompressedLevels.resize( 1 + this->m_vecMipChain.size() );
+	for ( unsigned int level = 0; level != this->m_vecCompressedLevels.size(); level++ )
+	{
+		const unsigned char* pLevelPixels = ( level == 0 ) ? reinterpret_cast<const unsigned char*>( this->m_p_theImages ) 
+		                                                   : this->m_vecMipChain[level - 1].vecPixels.data();
+		const unsigned int width = CImageResampler::GetMipLevelSize( this->m_numberOfColumns, level );
+		const unsigned int height = CImageResampler::GetMipLevelSize( this->m_numberOfRows, level );
+		std::vector<unsigned char> &vecBlocks = this->m_vecCompressedLevels[level];
+		vecBlocks.resize( CBlockCompressor::GetCompressedSize( format, width, height ) );
+		if ( !CBlockCompressor::CompressImage( pLevelPixels, width, height, 3, format, quality, vecBlocks.data() ) )
+		{
+			this->m_vecCompressedLevels.clear();
+			return false;
+		}
+	}
+	this->m_compressedInternalFormat = CBlockCompressor::GetGLInternalFormat( format );
+	this->m_compressedBaseInternalFormat = CBlockCompressor::GetGLBaseInternalFormat( format );
+	return true;
+}
+
+bool CTextureFromBMP::SaveKTXFile( std::string ktxFileName, unsigned long long cookKey )
+{
+	if ( this->m_vecCompressedLevels.empty() )
+	{
+		return false;
+	}
+	std::string error;
+	return CKTXFile::Save( ktxFileName, this->m_compressedInternalFormat, this->m_compressedBaseInternalFormat, 
+	                       this->m_numberOfColumns, this->m_numberOfRows, this->m_vecCompressedLevels, cookKey, error );
+}
+
+bool CTextureFromBMP::LoadKTXFile( std::string ktxFileName, unsigned long long cookKey )
+{
+	CKTXFile ktxFile;
+	std::string error;
+	if ( !ktxFile.Open( ktxFileName, error ) || ( ktxFile.GetCookKey() != cookKey ) )
+	{
+		this->m_lastErrorNum = CTextureFromBMP::ERORR_FILE_WONT_OPEN;
+		return false;
+	}
+	// Same as what LoadBMP2() sets
+	this->m_numberOfColumns = ktxFile.GetWidth();
+	this->m_numberOfRows = ktxFile.GetHeight();
+	this->m_Height = this->m_OriginalHeight = this->m_numberOfRows;
+	this->m_Width = this->m_OriginalWidth = this->m_numberOfColumns;
+	this->m_bitPerPixel = 24;
+
+	this->m_compressedInternalFormat = ktxFile.GetGLInternalFormat();
+	this->m_compressedBaseInternalFormat = ktxFile.GetGLBaseInternalFormat();
+	this->m_vecCompressedLevels.resize( ktxFile.GetNumberOfMipLevels() );
+	for ( unsigned int level = 0; level != ktxFile.GetNumberOfMipLevels(); level++ )
+	{
+		const unsigned char* pBlocks = static_cast<const unsigned char*>( ktxFile.GetMipLevelData( level ) );
+		this->m_vecCompressedLevels[level].assign( pBlocks, pBlocks + ktxFile.GetMipLevelSizeInBytes( level ) );
+	}
+	return true;
+}
+
+// Added: Same as CreateNewTextureFromCookedFile(), but the blocks are already compressed
+bool CTextureFromBMP::CreateNewTextureFromKTXFile( std::string textureName, std::string ktxFileName, 
+                                                   unsigned long long cookKey, bool bGenerateMIPMap )
+{
+	CKTXFile ktxFile;
+	std::string error;
+	if ( !ktxFile.Open( ktxFileName, error ) )
+	{
+		this->m_lastErrorNum = CTextureFromBMP::ERORR_FILE_WONT_OPEN;
+		return false;
+	}
+	// Out of date?
+	if ( ktxFile.GetCookKey() != cookKey )
+	{
+		this->m_lastErrorNum = CTextureFromBMP::ERORR_FILE_WONT_OPEN;
+		return false;
+	}
+
+	glGenTextures( 1, &(this->m_textureNumber) );
+	// Worked?
+	if ( ( glGetError() & GL_INVALID_VALUE ) == GL_INVALID_VALUE )
+	{
+		this->m_DeleteTextureName();
+		return false;
+	}
+
+	this->m_fileNameFullPath = ktxFileName;
+	this->m_textureName = textureName;
+	// Same as what LoadBMP2() sets
+	this->m_numberOfColumns = ktxFile.GetWidth();
+	this->m_numberOfRows = ktxFile.GetHeight();
+	this->m_Height = this->m_OriginalHeight = this->m_numberOfRows;
+	this->m_Width = this->m_OriginalWidth = this->m_numberOfColumns;
+	this->m_bitPerPixel = 24;
+
+	// Straight from the mapped file
+	std::vector<const void*> vecLevelData;
+	std::vector<unsigned int> vecLevelSizes;
+	for ( unsigned int level = 0; level != ktxFile.GetNumberOfMipLevels(); level++ )
+	{
+		vecLevelData.push_back( ktxFile.GetMipLevelData( level ) );
+		vecLevelSizes.push_back( ktxFile.GetMipLevelSizeInBytes( level ) );
+	}
+	if ( !this->m_UploadCompressed2DTexture( ktxFile.GetGLInternalFormat(), vecLevelData, vecLevelSizes, bGenerateMIPMap ) )
+	{
+		this->m_DeleteTextureName();
+		return false;
+	}
+	return true;
+}
+
+// Added: The blocks go to the GPU as they are (it decompresses them when it samples the texture), 
+//	so this doesn't go through the upload ring; there's nothing to convert, and they're 1/4 to 1/8th the size.
+bool CTextureFromBMP::m_UploadCompressed2DTexture( GLenum internalFormat, const std::vector<const void*> &vecLevelData, 
+                                                   const std::vector<unsigned int> &vecLevelSizes, bool bGenerateMIPMap )
+{
+	const unsigned int numberOfLevels = bGenerateMIPMap ? static_cast<unsigned int>( vecLevelData.size() ) : 1;
+	if ( vecLevelData.empty() || ( vecLevelData.size() != vecLevelSizes.size() ) )
+	{
+		return false;
+	}
+
+	glBindTexture( GL_TEXTURE_2D, this->m_textureNumber );
+
+	this->m_sizeInGPUMemory = 0;
+	for ( unsigned int level = 0; level != numberOfLevels; level++ )
+	{
+		glCompressedTexImage2D( GL_TEXTURE_2D, 
+		                        level, 
+		                        internalFormat, 
+		                        CImageResampler::GetMipLevelSize( this->m_numberOfColumns, level ), 
+		                        CImageResampler::GetMipLevelSize( this->m_numberOfRows, level ), 
+		                        0,						// border
+		                        vecLevelSizes[level], 
+		                        vecLevelData[level] );
+		this->m_sizeInGPUMemory += vecLevelSizes[level];
+	}
+
+	if ( this->bWasThereAnOpenGLError() )	{ return false;	}
+
+	this->m_Set2DTextureParameters( numberOfLevels );
+
+	this->m_bIsCompressed = true;
+	this->m_bIs2DTexture = true;
+
+	return true;
 }
 
 
@@ -340,7 +828,7 @@ bool CTextureFromBMP::CreateNewTextureFromBMPFile( std::string textureName, std:
 	// Worked?
 	if ( ( glGetError() & GL_INVALID_VALUE ) == GL_INVALID_VALUE )
 	{
-		bReturnVal = false;
+		this->m_DeleteTextureName();
 		return false;
 	}
 	
@@ -497,6 +985,12 @@ bool CTextureFromBMP::CreateNewTextureFromBMPFile( std::string textureName, std:
 	this->m_fileNameFullPath = fileNameFullPath;
 	this->m_textureName = textureName;
 
+	// Added: (the texture wasn't made, so give the name back)
+	if ( !bReturnVal )
+	{
+		this->m_DeleteTextureName();
+	}
+
 	// All done.
 	return bReturnVal;
 }
@@ -505,6 +999,8 @@ bool CTextureFromBMP::ClearBMP( void )
 {
 	delete [] this->m_p_theImages;
 	this->m_p_theImages = 0;
+	this->m_vecMipChain.clear();
+	this->m_vecCompressedLevels.clear();
 	return true;
 }
 
@@ -540,10 +1036,11 @@ bool CTextureFromBMP::CreateNewBMPFromCurrentTexture( int mipMapLevel )
 	this->m_numberOfLookUpTableEntries = 0;	// Always seem to be zero.
 	this->m_numberOfImportantColours = 0;	// Always seem to be zero.
 
-	this->m_numberOfColumns = textureHeight;
-	this->m_numberOfRows = textureWidth;
+	// Updated: (the columns are the width; they were the other way around)
+	this->m_numberOfColumns = textureWidth;
+	this->m_numberOfRows = textureHeight;
 
-	long bytesPerRow = ((3 * this->m_numberOfRows + 3) / 4) * 4;
+	long bytesPerRow = CBMPRowDecoder::GetFileRowSizeInBytes( this->m_numberOfColumns );
 	this->m_FileSize = this->m_numberOfRows * bytesPerRow + 54;
 
 	return true;
@@ -570,8 +1067,9 @@ bool CTextureFromBMP::SaveBMP( std::string fileName )
 	this->WriteAsUnsignedShort( this->m_reserved2, theFile );			// 0
 	this->WriteAsUnsignedLong( this->m_offsetInBits, theFile );			//54
 	this->WriteAsUnsignedLong( this->m_headerSize, theFile );			//40
-	this->WriteAsUnsignedLong( this->m_numberOfRows, theFile );
+	// Updated: Width, then height
 	this->WriteAsUnsignedLong( this->m_numberOfColumns, theFile );
+	this->WriteAsUnsignedLong( this->m_numberOfRows, theFile );
 	this->WriteAsUnsignedShort( this->m_numberOfPlanes, theFile );		// 1
 	this->WriteAsUnsignedShort( this->m_bitPerPixel, theFile );			// 24
 	this->WriteAsUnsignedLong( this->m_compressionMode, theFile );
@@ -582,7 +1080,7 @@ bool CTextureFromBMP::SaveBMP( std::string fileName )
 	this->WriteAsUnsignedLong( this->m_numberOfImportantColours, theFile );
 
 
-	long bytesPerRow = ((3 * this->m_numberOfRows + 3) / 4) * 4;
+	long bytesPerRow = CBMPRowDecoder::GetFileRowSizeInBytes( this->m_numberOfColumns );
 	long numberOfPaddingBytes = bytesPerRow - 3 * this->m_numberOfColumns;
 
 	// Write the bitmap data to the file... 
@@ -659,36 +1157,21 @@ unsigned long CTextureFromBMP::ReadNextUnsignedLong(char* data, unsigned long &i
 	return ulTheReturnVal;
 }
 
-// Loads it in one "go" instead of streaming it
-bool CTextureFromBMP::LoadBMP2( std::string fileName )
+// Added: Split out of LoadBMP2(), so CreateNewTextureFromBMPFile2() can decode straight into the upload ring
+bool CTextureFromBMP::m_ReadBMPHeader( char* pRawData, unsigned long fileSize, const unsigned char* &pFirstRow, bool &bTopRowFirst )
 {
-	std::ifstream theFile;
-	if ( this->m_bHave_cout_output )
+	// Is it big enough to have the header?
+	if ( fileSize < 54 )
 	{
-		std::cout << "Reading texture file: " << fileName;
-	}
-	theFile.open(fileName.c_str(), std::ios_base::binary);
-	if ( !theFile )
-	{
-		this->m_lastErrorNum = CTextureFromBMP::ERORR_FILE_WONT_OPEN;
+		this->m_lastErrorNum = CTextureFromBMP::ERROR_NOT_A_BMP_FILE;
 		return false;
 	}
-	// Scan to the end to get the size
-	theFile.seekg(0, std::ios::end);
-	std::ios::pos_type fileSize = theFile.tellg();
-	// Return to start
-	theFile.seekg(0, std::ios::beg);
-		
-	char* pRawData = new char[ static_cast<unsigned int>(fileSize) ];
-	
-	theFile.read( pRawData, fileSize );
-	theFile.close();
 
 	// Now go through and decode the BMP file.
 	unsigned long curIndex = 0;
 	char letter1 = this->ReadNextChar( pRawData, curIndex ); 
 	char letter2 = this->ReadNextChar( pRawData, curIndex );
-	if ((letter1 != 'B') && (letter2 != 'M'))
+	if ((letter1 != 'B') || (letter2 != 'M'))
 	{
 		this->m_lastErrorNum = CTextureFromBMP::ERROR_NOT_A_BMP_FILE;
 		return false;
@@ -699,10 +1182,14 @@ bool CTextureFromBMP::LoadBMP2( std::string fileName )
 	this->m_reserved2 = this->ReadNextUnsignedShort(pRawData, curIndex);
 	this->m_offsetInBits = this->ReadNextUnsignedLong(pRawData, curIndex);
     this->m_headerSize = this->ReadNextUnsignedLong(pRawData, curIndex);
-    this->m_numberOfRows = this->ReadNextUnsignedLong(pRawData, curIndex);
-	this->m_Height = this->m_OriginalHeight = this->m_numberOfRows;
+	// Updated: The width is first (it used to be read into m_numberOfRows, so anything that 
+	//	wasn't square came out sideways). A negative height means the top row is first.
     this->m_numberOfColumns = this->ReadNextUnsignedLong(pRawData, curIndex);
 	this->m_Width = this->m_OriginalWidth = this->m_numberOfColumns;
+	const int signedHeight = static_cast<int>( static_cast<unsigned int>( this->ReadNextUnsignedLong(pRawData, curIndex) ) );
+	bTopRowFirst = ( signedHeight < 0 );
+    this->m_numberOfRows = bTopRowFirst ? static_cast<unsigned long>( -static_cast<long long>( signedHeight ) ) : signedHeight;
+	this->m_Height = this->m_OriginalHeight = this->m_numberOfRows;
     this->m_numberOfPlanes = this->ReadNextUnsignedShort(pRawData, curIndex);
     this->m_bitPerPixel = this->ReadNextUnsignedShort(pRawData, curIndex);
 	// Is is a 24 bit bitmap?
@@ -713,15 +1200,61 @@ bool CTextureFromBMP::LoadBMP2( std::string fileName )
 	}
 
 	this->m_compressionMode = this->ReadNextUnsignedLong(pRawData, curIndex);
+	// Only uncompressed (BI_RGB) pixels can be decoded. BI_RLE8, BI_BITFIELDS, etc. aren't rows of BGR triples
+	if ( this->m_compressionMode != 0 )
+	{
+		this->m_lastErrorNum = CTextureFromBMP::ERROR_NOT_A_24_BIT_BITMAP;
+		return false;
+	}
 	this->m_imageSizeInBytes = this->ReadNextUnsignedLong(pRawData, curIndex);
 	this->m_PixelsPerMeterX = this->ReadNextUnsignedLong(pRawData, curIndex);
 	this->m_PixelsPerMeterY = this->ReadNextUnsignedLong(pRawData, curIndex);
 	this->m_numberOfLookUpTableEntries = this->ReadNextUnsignedLong(pRawData, curIndex);
 	this->m_numberOfImportantColours = this->ReadNextUnsignedLong(pRawData, curIndex);
-				
-	// 
-	long bytesPerRow = ((3 * this->m_numberOfRows + 3) / 4) * 4;
-	long numberOfPaddingBytes = bytesPerRow - 3 * this->m_numberOfColumns;
+
+	// Updated: The pixels start where the header says (the newer headers are bigger than 40 bytes)
+	unsigned long long pixelOffset = curIndex;
+	if ( ( this->m_offsetInBits >= curIndex ) && ( this->m_offsetInBits <= fileSize ) )
+	{
+		pixelOffset = this->m_offsetInBits;
+	}
+
+	// Make sure the pixels are all there (reading past the end of the file would crash)
+	// (the last row doesn't need its padding)
+	const unsigned long long bytesPerRow = CBMPRowDecoder::GetFileRowSizeInBytes( this->m_numberOfColumns );
+	if ( ( this->m_numberOfColumns == 0 ) || ( this->m_numberOfRows == 0 ) ||
+	     ( pixelOffset + bytesPerRow * ( this->m_numberOfRows - 1 ) + 3ULL * this->m_numberOfColumns > fileSize ) )
+	{
+		this->m_lastErrorNum = CTextureFromBMP::ERROR_NOT_A_BMP_FILE;
+		return false;
+	}
+	pFirstRow = reinterpret_cast<const unsigned char*>( pRawData + pixelOffset );
+
+	return true;
+}
+
+// Loads it in one "go" instead of streaming it
+bool CTextureFromBMP::LoadBMP2( std::string fileName )
+{
+	if ( this->m_bHave_cout_output )
+	{
+		std::cout << "Reading texture file: " << fileName;
+	}
+	// Memory mapped (and unmapped when theFile goes out of scope)
+	CFileView theFile;
+	std::string openError;
+	if ( !theFile.Open( fileName, openError ) )
+	{
+		this->m_lastErrorNum = CTextureFromBMP::ERORR_FILE_WONT_OPEN;
+		return false;
+	}
+
+	const unsigned char* pFirstRow = 0;
+	bool bTopRowFirst = false;
+	if ( !this->m_ReadBMPHeader( theFile.GetData(), theFile.GetSize(), pFirstRow, bTopRowFirst ) )
+	{
+		return false;
+	}
 
 	// Allocate enough space...
 	this->m_p_theImages = new C24BitBMPpixel[this->m_numberOfRows * this->m_numberOfColumns];
@@ -733,55 +1266,10 @@ bool CTextureFromBMP::LoadBMP2( std::string fileName )
 		return false;
 	}
 
+	// Updated: A row at a time (not a byte at a time), bottom row first
+	CBMPRowDecoder::DecodeImage( pFirstRow, this->m_numberOfColumns, this->m_numberOfRows, bTopRowFirst, 
+	                             CBMPRowDecoder::OUTPUT_RGB, reinterpret_cast<unsigned char*>( this->m_p_theImages ) );
 
-	// Read the bitmap into memory...
-	unsigned long bytesRead = 0;
-	unsigned long totalBytesInFile = this->m_numberOfRows * this->m_numberOfColumns;
-	unsigned long pixelCount = 0;
-
-	for (unsigned long row = 0; row < m_numberOfRows; row++)
-	{
-		for (unsigned long col = 0; col < m_numberOfColumns; col++)
-		{
-			char theblue = this->ReadNextChar(pRawData, curIndex);
-			char thegreen = this->ReadNextChar(pRawData, curIndex);
-			char thered = this->ReadNextChar(pRawData, curIndex);
-
-			this->m_p_theImages[pixelCount].redPixel = static_cast<unsigned char>(thered);
-			this->m_p_theImages[pixelCount].greenPixel = static_cast<unsigned char>(thegreen);
-			this->m_p_theImages[pixelCount].bluePixel = static_cast<unsigned char>(theblue);
-							//m_p_theImages[pixelCount].alphaPixel = 255;
-							
-#ifdef DEBUG_MODE_BITMAPREAD
-			std::cout << (static_cast<unsigned int>(thered) & 0x00FF) << ", ";
-			std::cout << (static_cast<unsigned int>(thegreen) & 0x00FF) << ", ";
-			std::cout << (static_cast<unsigned int>(theblue) & 0x00FF) << "\t";
-#endif
-			pixelCount++;
-			bytesRead += 3;	// Add three bytes
-		}// for (unsigned long col
-#ifdef DEBUG_MODE_BITMAPREAD
-		std::cout << std::endl;
-#endif
-		// We are at the end of the row and there will 
-		//	still be bytes padding up to a multiple of 4...
-		// Read and discard these...
-		for (int discardedBytes = 0; discardedBytes < numberOfPaddingBytes; discardedBytes++)
-		{
-			char tempChar = this->ReadNextChar(pRawData, curIndex);
-		}
-		// How much have we read?
-		// NOTE: This really isn't percent, but it does the job of 
-		//	printing out fewer dots.
-		int percentRead = static_cast<int>( (static_cast<double>(bytesRead) / static_cast<double>(totalBytesInFile)) * 100);
-		if ((percentRead % 25) == 0)
-		{
-			if ( this->m_bHave_cout_output )
-			{
-				std::cout << ".";
-			}
-		}
-	}// for (unsigned long row...
 	if ( this->m_bHave_cout_output )
 	{
 		std::cout << "complete." << std::endl;
@@ -1194,11 +1682,33 @@ bool CTextureFromBMP::RestoreOldTextureEnvironmentMode(void)
 //|_| \_\___|___/_/___\___|____/|_|\__|_| |_| |_|\__,_| .__/
 //                                                    |_|
 // This filters a bitmap into a new size (likely powers of 2 in width or height)
+// Updated: Done with CImageResampler (MIPMAPFILTER). The original size is still in m_OriginalHeight and m_OriginalWidth.
 bool CTextureFromBMP::ResizeBitmap(int DesiredHeight, int DesiredWidth)
 {
-	bool bReturnVal = true;
-	// No implementation yet.
-	return bReturnVal;
+	if ( ( this->m_p_theImages == 0 ) || ( DesiredHeight <= 0 ) || ( DesiredWidth <= 0 ) )
+	{
+		return false;
+	}
+	if ( ( static_cast<unsigned long>( DesiredHeight ) == this->m_numberOfRows ) && ( static_cast<unsigned long>( DesiredWidth ) == this->m_numberOfColumns ) )
+	{
+		return true;
+	}
+
+	C24BitBMPpixel* p_theResizedImage = new C24BitBMPpixel[ static_cast<size_t>( DesiredWidth ) * DesiredHeight ];
+	if ( !CImageResampler::Resize( reinterpret_cast<const unsigned char*>( this->m_p_theImages ), this->m_numberOfColumns, this->m_numberOfRows, 3, 
+	                               reinterpret_cast<unsigned char*>( p_theResizedImage ), DesiredWidth, DesiredHeight, 
+	                               CTextureFromBMP::MIPMAPFILTER, CTextureFromBMP::MIPMAPGAMMACORRECT ) )
+	{
+		delete [] p_theResizedImage;
+		return false;
+	}
+	delete [] this->m_p_theImages;
+	this->m_p_theImages = p_theResizedImage;
+	this->m_numberOfColumns = this->m_Width = DesiredWidth;
+	this->m_numberOfRows = this->m_Height = DesiredHeight;
+	// (the old mip maps don't match any more)
+	this->m_vecMipChain.clear();
+	return true;
 }
 
 // This is for error handling.
@@ -10,7 +10,12 @@
 
 #include <fstream>
 #include <string>
+#include <functional>
+#include <vector>
 #include "C24BitBMPpixel.h"
+#include "CImageResampler.h"
+#include "CBlockCompressor.h"
+#include "../CGPUUploadRing.h"
 //#include <gl\glext.h>		// OpenGL Extensions (for cube mapping)
 #include <GL\glew.h>
 #include <gl\freeglut.h>
@@ -27,7 +32,41 @@ public:
 	// CHANGE: Now pass the texture unit, not the texture number...
 	// (texture number is created automatically). Pass GL_TEXTURE0, GL_TEXTURE1, etc. 
 	bool CreateNewTextureFromBMPFile( std::string textureName, std::string fileNameFullPath /*, GLenum textureUnit*/ );		
-	bool CreateNewTextureFromBMPFile2( std::string textureName, std::string fileNameFullPath, /*GLenum textureUnit,*/ bool bGenerateMIPMap );		
+	// Added: If cookedFileToSave isn't empty, the decoded pixels are saved there, too (see CAssetCache)
+	bool CreateNewTextureFromBMPFile2( std::string textureName, std::string fileNameFullPath, /*GLenum textureUnit,*/ bool bGenerateMIPMap,
+	                                   std::string cookedFileToSave = "", unsigned long long cookKey = 0 );		
+	// Added: Loads a CCookedTextureFile. Returns false if it's not there, or it's not cookKey (out of date)
+	bool CreateNewTextureFromCookedFile( std::string textureName, std::string cookedFileName, unsigned long long cookKey, bool bGenerateMIPMap );
+	// Added: Saves what LoadBMP2() loaded as a CCookedTextureFile
+	bool SaveCookedFile( std::string cookedFileName, unsigned long long cookKey );
+	// Added: Reads a CCookedTextureFile into memory, like LoadBMP2() does for a BMP (no OpenGL,
+	//	so it can be done on another thread). Returns false if it's not there, or it's not cookKey.
+	bool LoadCookedFile( std::string cookedFileName, unsigned long long cookKey );
+	// Added: Creates the texture from what LoadBMP2() (or LoadCookedFile()) loaded, then clears it
+	// Updated: If it was block compressed (CompressLoadedPixels() or LoadKTXFile()), those blocks are used
+	bool CreateNewTextureFromLoadedPixels( std::string textureName, std::string fileNameFullPath, bool bGenerateMIPMap );
+	// Added: Makes the mip maps from what's loaded, on the CPU (no OpenGL, so it can be done on 
+	//	another thread). The texture uses them (instead of glGenerateMipmap()), and SaveCookedFile() saves them.
+	//	If this isn't called, they're made when the texture is (if bGenerateMIPMap is true).
+	bool GenerateMipChain(void);
+	// Added: How the mip maps (and ResizeBitmap()) are filtered (see CImageResampler)
+	static const CImageResampler::enumFilter MIPMAPFILTER = CImageResampler::FILTER_KAISER;
+	static const bool MIPMAPGAMMACORRECT = true;
+	// Added: Block compresses what's loaded (and the mip maps, which are made if they aren't 
+	//	already), on the CPU (see CBlockCompressor). No OpenGL, so it can be done on another thread. 
+	//	CreateNewTextureFromLoadedPixels() uses the compressed ones after this.
+	bool CompressLoadedPixels( CBlockCompressor::enumFormat format, CBlockCompressor::enumQuality quality );
+	// Added: Saves what CompressLoadedPixels() made as a CKTXFile
+	bool SaveKTXFile( std::string ktxFileName, unsigned long long cookKey );
+	// Added: Reads a (block compressed) CKTXFile into memory, like LoadCookedFile() (no OpenGL). 
+	//	Returns false if it's not there, or it's not cookKey.
+	bool LoadKTXFile( std::string ktxFileName, unsigned long long cookKey );
+	// Added: Loads a CKTXFile, straight from the file to glCompressedTexImage2D(). 
+	//	Returns false if it's not there, or it's not cookKey (out of date).
+	bool CreateNewTextureFromKTXFile( std::string textureName, std::string ktxFileName, unsigned long long cookKey, bool bGenerateMIPMap );
+	// Added: About how much video memory the texture takes (all the mip levels)
+	unsigned long GetSizeInGPUMemory(void);
+	bool IsCompressed(void);
 	bool CreateNewTextureFromBMPFile_OLD(std::string fileName, GLuint textureNumber);		
 
 	// _____  _     _                        _     _                         
@@ -43,6 +82,8 @@ public:
 	//									   GLenum &errorEnum, std::string &errorString, std::string &errorDetails );
 	bool CreateNewBMPFromCurrentTexture( int mipMapLevel );
 	bool LoadBMP( std::string fileName );
+	// Updated: Each row is decoded in one go (see CBMPRowDecoder), and top row first BMPs 
+	//	(negative height) work. m_numberOfColumns is the width, and m_numberOfRows the height.
 	bool LoadBMP2( std::string fileName );		// Faster loader
 	bool SaveBMP( std::string fileName );
 	// Deletes the data (and the array) - used after calling LoadBMP
@@ -53,6 +94,7 @@ public:
 
 	void SetDebug_cout_output( bool bHave_cout_output );
 
+	// Updated: Resizes what's loaded (any size, up or down) with MIPMAPFILTER
 	bool ResizeBitmap(int DesiredHeight, int DesiredWidth);
 	// Returns true if texture exists and can be applied
 	bool MakeTextureActive(void);
@@ -94,7 +136,40 @@ public:
 	//
 	GLuint getTextureNumber(void);
 	//GLenum getTextureUnit(void);
+	// Added: Set this before CreateNewTextureFrom...() to have the pixels go through 
+	//	the upload ring (see CGPUUploadRing). 0 (the default) is glTexSubImage2D() from memory.
+	void SetUploadRing( CGPUUploadRing* pUploadRing );
 private:
+	CGPUUploadRing* m_pUploadRing;
+	// Added: Creates the texture from 24 bit RGB pixels (m_numberOfColumns x m_numberOfRows)
+	// Updated: Or pixelFormat (GL_RGB or GL_RGBA) pixels that writePixels() writes (into the 
+	//	upload ring, if there is one); pPixels is 0 then.
+	// Updated: Each mip level is uploaded, too. vecMipLevelPixels are levels 1 and down (if they're 
+	//	already made, like from a cooked file); if it's empty, they're made here (or m_vecMipChain is used).
+	bool m_Upload2DTexture( const void* pPixels, bool bGenerateMIPMap, GLenum pixelFormat = GL_RGB, 
+	                        std::function<void(void* pDestination)> writePixels = nullptr, 
+	                        std::vector<const void*> vecMipLevelPixels = std::vector<const void*>() );
+	// glTexSubImage2D() for one level (through the upload ring, if there is one)
+	void m_Upload2DTextureLevel( GLint level, unsigned int width, unsigned int height, GLenum pixelFormat, 
+	                             const void* pPixels, std::function<void(void* pDestination)> writePixels );
+	// Added: Creates the texture from block compressed levels (level 0 and down), with glCompressedTexImage2D()
+	bool m_UploadCompressed2DTexture( GLenum internalFormat, const std::vector<const void*> &vecLevelData, 
+	                                  const std::vector<unsigned int> &vecLevelSizes, bool bGenerateMIPMap );
+	// Added: The filtering, wrapping, and mip levels used (split out of m_Upload2DTexture())
+	void m_Set2DTextureParameters( unsigned int numberOfLevels );
+	// Added: Gives back the name from glGenTextures() (when the texture couldn't be made), and sets m_textureNumber to 0
+	void m_DeleteTextureName(void);
+	// Added: What CompressLoadedPixels() (or LoadKTXFile()) made: each level's blocks, starting with level 0
+	std::vector< std::vector<unsigned char> > m_vecCompressedLevels;
+	GLenum m_compressedInternalFormat;
+	GLenum m_compressedBaseInternalFormat;
+	unsigned long m_sizeInGPUMemory;
+	bool m_bIsCompressed;
+	// Added: Levels 1 and down of m_p_theImages (see GenerateMipChain())
+	std::vector<CImageResampler::CImage> m_vecMipChain;
+	// Added: Checks the header (and that the pixels are all there), and sets the members from it. 
+	//	pFirstRow is the first row of pixels in the file.
+	bool m_ReadBMPHeader( char* pRawData, unsigned long fileSize, const unsigned char* &pFirstRow, bool &bTopRowFirst );
 	// The actual image information
 	C24BitBMPpixel* m_p_theImages;	
 	//C32BitBMPpixel* m_p_theImages;	
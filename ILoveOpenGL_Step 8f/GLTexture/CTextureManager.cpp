@@ -1,5 +1,10 @@
 #include "CTextureManager.h"
+#include "CCookedTextureFile.h"
+#include "CKTXFile.h"
+#include "../CThreadPool.h"
+#include "../CHRTimer.h"
 #include <sstream>
+#include <future>
 
 // Written by Michael Feeney, Fanshawe College, 2010
 // mfeeney@fanshawec.on.ca
@@ -11,6 +16,10 @@
 CTextureManager::CTextureManager()
 {
 	this->m_currentFrameBuffer = 0;	// Zero is default framebuffer
+	this->m_pUploadRing = 0;
+	this->m_bCompressTextures = true;
+	this->m_compressionFormat = CTextureManager::DEFAULTCOMPRESSIONFORMAT;
+	this->m_compressionQuality = CTextureManager::DEFAULTCOMPRESSIONQUALITY;
 	return;
 }
 
@@ -25,6 +34,117 @@ void CTextureManager::setBasePath( std::string basePath )
 	return;
 }
 
+//static 
+const std::string CTextureManager::TEXTURECOOKSETTINGS = std::string( "ctx v2: 24 bit RGB, bottom row first, width x height (as LoadBMP2), mips: " ) + 
+                                                         CImageResampler::GetFilterName( CTextureFromBMP::MIPMAPFILTER ) + 
+                                                         ( CTextureFromBMP::MIPMAPGAMMACORRECT ? ", gamma correct" : "" );
+
+void CTextureManager::SetCookedCacheFolder( std::string cacheFolder )
+{
+	this->m_cookedCache.SetCacheFolder( cacheFolder );
+	return;
+}
+
+void CTextureManager::SetUploadRing( CGPUUploadRing* pUploadRing )
+{
+	this->m_pUploadRing = pUploadRing;
+	return;
+}
+
+void CTextureManager::SetTextureCompression( bool bCompressTextures, CBlockCompressor::enumFormat format /*=DEFAULTCOMPRESSIONFORMAT*/, 
+                                             CBlockCompressor::enumQuality quality /*=DEFAULTCOMPRESSIONQUALITY*/ )
+{
+	this->m_bCompressTextures = bCompressTextures;
+	this->m_compressionFormat = format;
+	this->m_compressionQuality = quality;
+	return;
+}
+
+//static 
+std::string CTextureManager::GetCompressedCookSettings( CBlockCompressor::enumFormat format, CBlockCompressor::enumQuality quality )
+{
+	return CTextureManager::TEXTURECOOKSETTINGS + ", ktx: " + CBlockCompressor::GetFormatName( format ) + 
+	       " (" + CBlockCompressor::GetQualityName( quality ) + ")";
+}
+
+bool CTextureManager::m_IsCompressionUsable(void)
+{
+	return this->m_bCompressTextures && this->m_cookedCache.IsEnabled() && 
+	       CBlockCompressor::IsFormatSupported( this->m_compressionFormat );
+}
+
+unsigned long long CTextureManager::GetTotalSizeInGPUMemory(void)
+{
+	unsigned long long totalSize = 0;
+	for ( std::map< std::string, CTextureFromBMP* >::iterator itTexture = this->m_map_TexNameToTexture.begin();
+		  itTexture != this->m_map_TexNameToTexture.end(); itTexture++ )
+	{
+		totalSize += itTexture->second->GetSizeInGPUMemory();
+	}
+	return totalSize;
+}
+
+//static 
+bool CTextureManager::CookBMPFile( std::string bmpFileFullPath, CAssetCache &cache, bool &bWasAlreadyUpToDate, std::string &error, 
+                                   bool bCompress /*=true*/, 
+                                   CBlockCompressor::enumFormat compressionFormat /*=DEFAULTCOMPRESSIONFORMAT*/, 
+                                   CBlockCompressor::enumQuality compressionQuality /*=DEFAULTCOMPRESSIONQUALITY*/ )
+{
+	bWasAlreadyUpToDate = false;
+
+	unsigned long long cookKey = 0;
+	unsigned long long compressedCookKey = 0;
+	if ( !CAssetCache::CalculateCookKey( bmpFileFullPath, CTextureManager::TEXTURECOOKSETTINGS, cookKey ) || 
+	     ( bCompress && !CAssetCache::CalculateCookKey( bmpFileFullPath, CTextureManager::GetCompressedCookSettings( compressionFormat, compressionQuality ), compressedCookKey ) ) )
+	{
+		error = "Can't read " + bmpFileFullPath;
+		return false;
+	}
+	std::string cookedFile = cache.GetCookedFileName( bmpFileFullPath, ".ctx" );
+	std::string ktxFile = cache.GetCookedFileName( bmpFileFullPath, ".ktx" );
+
+	// Already done?
+	CCookedTextureFile existingFile;
+	std::string openError;
+	const bool bCookedFileUpToDate = existingFile.Open( cookedFile, openError ) && ( existingFile.GetCookKey() == cookKey );
+	existingFile.Close();
+	bool bKTXFileUpToDate = true;
+	if ( bCompress )
+	{
+		CKTXFile existingKTXFile;
+		bKTXFileUpToDate = existingKTXFile.Open( ktxFile, openError ) && ( existingKTXFile.GetCookKey() == compressedCookKey );
+	}
+	if ( bCookedFileUpToDate && bKTXFileUpToDate )
+	{
+		bWasAlreadyUpToDate = true;
+		return true;
+	}
+
+	CTextureFromBMP bmpFile;
+	if ( !bmpFile.LoadBMP2( bmpFileFullPath ) )
+	{
+		error = "Can't load " + bmpFileFullPath + " (" + bmpFile.DecodeLastError( bmpFile.GetLastErrorNumber() ) + ")";
+		return false;
+	}
+	if ( !bCookedFileUpToDate && ( !cache.CreateCacheFolder() || !bmpFile.SaveCookedFile( cookedFile, cookKey ) ) )
+	{
+		bmpFile.ClearBMP();
+		error = "Can't save " + cookedFile;
+		return false;
+	}
+	// Added: (from the same mip maps)
+	if ( !bKTXFileUpToDate && ( !cache.CreateCacheFolder() || !bmpFile.CompressLoadedPixels( compressionFormat, compressionQuality ) || 
+	                            !bmpFile.SaveKTXFile( ktxFile, compressedCookKey ) ) )
+	{
+		bmpFile.ClearBMP();
+		error = "Can't save " + ktxFile;
+		return false;
+	}
+	bmpFile.ClearBMP();
+
+	return true;
+}
+
 void CTextureManager::m_appendErrorString( std::string nextErrorText )
 {
 	std::stringstream ss;
@@ -124,8 +244,63 @@ bool CTextureManager::Create2DTextureFromBMPFile( std::string textureFileName, b
 	//	return false;
 	//}
 
+	// Added: Is there a block compressed version? If not, the BMP is compressed now (and saved for next time)
+	unsigned long long compressedCookKey = 0;
+	if ( this->m_IsCompressionUsable() && 
+	     CAssetCache::CalculateCookKey( fileToLoadFullPath, CTextureManager::GetCompressedCookSettings( this->m_compressionFormat, this->m_compressionQuality ), 
+	                                    compressedCookKey ) )
+	{
+		std::string ktxFile = this->m_cookedCache.GetCookedFileName( fileToLoadFullPath, ".ktx" );
+		CTextureFromBMP* pCompressedTexture = new CTextureFromBMP();
+		if ( pCompressedTexture->CreateNewTextureFromKTXFile( textureFileName, ktxFile, compressedCookKey, bGenerateMIPMap ) )
+		{
+			this->m_map_TexNameToTexture[ textureFileName ] = pCompressedTexture;
+			return true;
+		}
+		if ( pCompressedTexture->LoadBMP2( fileToLoadFullPath ) && 
+		     pCompressedTexture->CompressLoadedPixels( this->m_compressionFormat, this->m_compressionQuality ) )
+		{
+			if ( this->m_cookedCache.CreateCacheFolder() )
+			{
+				pCompressedTexture->SaveKTXFile( ktxFile, compressedCookKey );
+			}
+			if ( pCompressedTexture->CreateNewTextureFromLoadedPixels( textureFileName, fileToLoadFullPath, bGenerateMIPMap ) )
+			{
+				this->m_map_TexNameToTexture[ textureFileName ] = pCompressedTexture;
+				return true;
+			}
+		}
+		// (didn't work, so it's loaded the uncompressed way, below)
+		pCompressedTexture->ClearBMP();
+		delete pCompressedTexture;
+	}
+
+	// Added: Is there a cooked version? 
+	std::string cookedFileToSave;
+	unsigned long long cookKey = 0;
+	if ( this->m_cookedCache.IsEnabled() && 
+		 CAssetCache::CalculateCookKey( fileToLoadFullPath, CTextureManager::TEXTURECOOKSETTINGS, cookKey ) )
+	{
+		std::string cookedFile = this->m_cookedCache.GetCookedFileName( fileToLoadFullPath, ".ctx" );
+		CTextureFromBMP* pCookedTexture = new CTextureFromBMP();
+		pCookedTexture->SetUploadRing( this->m_pUploadRing );
+		if ( pCookedTexture->CreateNewTextureFromCookedFile( textureFileName, cookedFile, cookKey, bGenerateMIPMap ) )
+		{
+			this->m_map_TexNameToTexture[ textureFileName ] = pCookedTexture;
+			return true;
+		}
+		delete pCookedTexture;
+		// Not there (or out of date), so cook it this time around
+		if ( this->m_cookedCache.CreateCacheFolder() )
+		{
+			cookedFileToSave = cookedFile;
+		}
+	}
+
 	CTextureFromBMP* pTempTexture = new CTextureFromBMP();
-	if ( ! pTempTexture->CreateNewTextureFromBMPFile2( textureFileName, fileToLoadFullPath, /*textureUnit,*/ bGenerateMIPMap ) )
+	pTempTexture->SetUploadRing( this->m_pUploadRing );
+	if ( ! pTempTexture->CreateNewTextureFromBMPFile2( textureFileName, fileToLoadFullPath, /*textureUnit,*/ bGenerateMIPMap, 
+	                                                   cookedFileToSave, cookKey ) )
 	{
 		this->m_appendErrorString( "Can't load " );
 		this->m_appendErrorString( fileToLoadFullPath );
@@ -143,6 +318,144 @@ bool CTextureManager::Create2DTextureFromBMPFile( std::string textureFileName, b
 
 
 
+bool CTextureManager::Create2DTexturesFromBMPFiles( const std::vector<std::string> &vecTextureFileNames, bool bGenerateMIPMap, 
+                                                    std::vector<CTextureLoadTiming> &vecTimings )
+{
+	const unsigned int numberOfTextures = static_cast<unsigned int>( vecTextureFileNames.size() );
+	vecTimings.clear();
+	vecTimings.resize( numberOfTextures );
+
+	// (once, here, instead of by each job)
+	const bool bUseCookedFiles = this->m_cookedCache.IsEnabled();
+	const bool bSaveCookedFiles = bUseCookedFiles && this->m_cookedCache.CreateCacheFolder();
+	// Added: (and whether the card can use the compressed ones is checked here, where OpenGL is)
+	const bool bCompressTextures = this->m_IsCompressionUsable();
+	const CBlockCompressor::enumFormat compressionFormat = this->m_compressionFormat;
+	const CBlockCompressor::enumQuality compressionQuality = this->m_compressionQuality;
+	const std::string compressedCookSettings = CTextureManager::GetCompressedCookSettings( compressionFormat, compressionQuality );
+
+	// Each job only touches its own texture (and timing), so they don't need a lock
+	std::vector< CTextureFromBMP* > vecTextures( numberOfTextures, 0 );
+	std::vector< std::future<void> > vecJobs;
+	vecJobs.reserve( numberOfTextures );
+	for ( unsigned int index = 0; index != numberOfTextures; index++ )
+	{
+		CTextureFromBMP* pTexture = new CTextureFromBMP();
+		pTexture->SetUploadRing( this->m_pUploadRing );
+		vecTextures[index] = pTexture;
+
+		CTextureLoadTiming* pTiming = &(vecTimings[index]);
+		pTiming->textureFileName = vecTextureFileNames[index];
+		const std::string fileToLoadFullPath = this->m_basePath + "/" + vecTextureFileNames[index];
+		const std::string cookedFile = bUseCookedFiles ? this->m_cookedCache.GetCookedFileName( fileToLoadFullPath, ".ctx" ) : "";
+		const std::string ktxFile = bCompressTextures ? this->m_cookedCache.GetCookedFileName( fileToLoadFullPath, ".ktx" ) : "";
+
+		vecJobs.push_back( CThreadPool::getSharedInstance()->AddJob( [pTexture, pTiming, fileToLoadFullPath, cookedFile, bSaveCookedFiles, bGenerateMIPMap,
+		                                                               ktxFile, compressedCookSettings, compressionFormat, compressionQuality]()
+		{
+			CHRTimer timer;
+			timer.Reset();
+			timer.Start();
+
+			// Added: Same as Create2DTextureFromBMPFile(): the block compressed one if it's up to date, 
+			//	if not, the BMP, compressed now (and saved for next time)
+			unsigned long long compressedCookKey = 0;
+			if ( !ktxFile.empty() && CAssetCache::CalculateCookKey( fileToLoadFullPath, compressedCookSettings, compressedCookKey ) )
+			{
+				if ( pTexture->LoadKTXFile( ktxFile, compressedCookKey ) )
+				{
+					pTiming->bFromCookedFile = true;
+					pTiming->bCompressed = true;
+				}
+				else if ( pTexture->LoadBMP2( fileToLoadFullPath ) && pTexture->CompressLoadedPixels( compressionFormat, compressionQuality ) )
+				{
+					pTiming->bCompressed = true;
+					if ( bSaveCookedFiles )
+					{
+						pTexture->SaveKTXFile( ktxFile, compressedCookKey );
+					}
+				}
+				if ( pTiming->bCompressed )
+				{
+					pTiming->bLoaded = true;
+					pTiming->decodeSeconds = timer.GetElapsedSeconds();
+					return;
+				}
+				// (didn't work, so it's loaded the uncompressed way, below)
+				pTexture->ClearBMP();
+			}
+
+			// Same as Create2DTextureFromBMPFile(): the cooked one if it's up to date, if not, 
+			//	the BMP (and cook it for next time)
+			unsigned long long cookKey = 0;
+			const bool bHaveCookKey = !cookedFile.empty() && 
+			                          CAssetCache::CalculateCookKey( fileToLoadFullPath, CTextureManager::TEXTURECOOKSETTINGS, cookKey );
+			if ( bHaveCookKey )
+			{
+				pTiming->bFromCookedFile = pTexture->LoadCookedFile( cookedFile, cookKey );
+			}
+			if ( !pTiming->bFromCookedFile )
+			{
+				pTiming->bLoaded = pTexture->LoadBMP2( fileToLoadFullPath );
+				// (the cooked files have the mip maps, so they're made for those, too)
+				if ( pTiming->bLoaded && ( bGenerateMIPMap || ( bHaveCookKey && bSaveCookedFiles ) ) )
+				{
+					pTexture->GenerateMipChain();
+				}
+				if ( pTiming->bLoaded && bHaveCookKey && bSaveCookedFiles )
+				{
+					pTexture->SaveCookedFile( cookedFile, cookKey );
+				}
+			}
+			else
+			{
+				pTiming->bLoaded = true;
+			}
+			pTiming->decodeSeconds = timer.GetElapsedSeconds();
+		} ) );
+	}
+
+	// Create them in order (OpenGL), each one as soon as it's decoded
+	bool bAllLoaded = true;
+	CHRTimer timer;
+	for ( unsigned int index = 0; index != numberOfTextures; index++ )
+	{
+		CTextureLoadTiming &timing = vecTimings[index];
+		timer.Reset();
+		timer.Start();
+		vecJobs[index].wait();
+		timing.waitSeconds = timer.GetElapsedSeconds( true );
+
+		const std::string &textureFileName = vecTextureFileNames[index];
+		CTextureFromBMP* pTexture = vecTextures[index];
+		if ( timing.bLoaded )
+		{
+			timing.bLoaded = pTexture->CreateNewTextureFromLoadedPixels( textureFileName, this->m_basePath + "/" + textureFileName, bGenerateMIPMap );
+		}
+		timing.uploadSeconds = timer.GetElapsedSeconds();
+
+		if ( !timing.bLoaded )
+		{
+			this->m_appendErrorString( "Can't load " );
+			this->m_appendErrorString( this->m_basePath + "/" + textureFileName );
+			this->m_appendErrorString( "\n" );
+			pTexture->ClearBMP();
+			delete pTexture;
+			bAllLoaded = false;
+			continue;
+		}
+		// (loading it again replaces it)
+		std::map< std::string, CTextureFromBMP* >::iterator itTexture = this->m_map_TexNameToTexture.find( textureFileName );
+		if ( itTexture != this->m_map_TexNameToTexture.end() )
+		{
+			delete itTexture->second;
+		}
+		this->m_map_TexNameToTexture[ textureFileName ] = pTexture;
+	}
+
+	return bAllLoaded;
+}
+
 //bool CTextureManager::CreateCubeTextureFromBMPFiles( std::string cubeMapName, 
 //													 std::string posX_fileName, std::string negX_fileName, 
 //	                                                 std::string posY_fileName, std::string negY_fileName, 
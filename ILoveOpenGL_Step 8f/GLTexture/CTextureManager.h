@@ -16,7 +16,23 @@
 #include "CTextureFromBMP.h"
 #include <map>
 #include <string>
+#include <vector>
 #include "../CError/COpenGLError.h"
+#include "../CAssetCache.h"
+
+// Added: See CTextureManager::Create2DTexturesFromBMPFiles()
+class CTextureLoadTiming
+{
+public:
+	CTextureLoadTiming() : bLoaded(false), bFromCookedFile(false), bCompressed(false), decodeSeconds(0.0f), waitSeconds(0.0f), uploadSeconds(0.0f) {};
+	std::string textureFileName;
+	bool bLoaded;
+	bool bFromCookedFile;
+	bool bCompressed;		// Added: Block compressed (see CTextureManager::SetTextureCompression())
+	float decodeSeconds;	// Reading and decoding the file, and the mip maps (and compressing them) (on a worker thread)
+	float waitSeconds;		// How long the OpenGL thread waited for that
+	float uploadSeconds;	// Creating the texture (on the OpenGL thread)
+};
 
 class CTextureManager
 {
@@ -28,6 +44,42 @@ public:
 //	bool loadTexture( std::string fileName );
 
 	bool Create2DTextureFromBMPFile( std::string textureFileName, bool bGenerateMIPMap );
+	// Added: Loads a bunch of them at once. The files are read and decoded (or the cooked ones read) 
+	//	on the thread pool (see CThreadPool), all at the same time. Then the textures are created 
+	//	on this thread, in the same order as the file names, as soon as each one is ready.
+	// vecTimings gets one for each file (in the same order).
+	// Returns false if any of them didn't load (getLastError() says which ones).
+	bool Create2DTexturesFromBMPFiles( const std::vector<std::string> &vecTextureFileNames, bool bGenerateMIPMap, 
+	                                   std::vector<CTextureLoadTiming> &vecTimings );
+
+	// Added: If this is set, Create2DTextureFromBMPFile() uses the cooked (already decoded) 
+	//	version of the BMP if it's up to date, and saves one if it isn't. Empty turns it off.
+	void SetCookedCacheFolder( std::string cacheFolder );
+	// Added: Decodes the BMP into the cache (if it's not already there and up to date). Doesn't need OpenGL.
+	// Updated: And block compresses it into a .ktx file, too (if bCompress), so either one can be loaded
+	static bool CookBMPFile( std::string bmpFileFullPath, CAssetCache &cache, bool &bWasAlreadyUpToDate, std::string &error, 
+	                         bool bCompress = true, 
+	                         CBlockCompressor::enumFormat compressionFormat = CTextureManager::DEFAULTCOMPRESSIONFORMAT, 
+	                         CBlockCompressor::enumQuality compressionQuality = CTextureManager::DEFAULTCOMPRESSIONQUALITY );
+	// How the BMPs are cooked (part of the cook key)
+	static const std::string TEXTURECOOKSETTINGS;
+	// Added: If this is on (it is by default), and there's a cooked cache folder, the textures are block 
+	//	compressed (see CBlockCompressor), and the compressed ones are cooked (as CKTXFile .ktx files), 
+	//	so they're only compressed once. They take 1/4 (BC3, BC7) to 1/8th (BC1) of the video memory.
+	//	If the card can't do that format, it goes back to the uncompressed (.ctx) ones.
+	void SetTextureCompression( bool bCompressTextures, 
+	                            CBlockCompressor::enumFormat format = CTextureManager::DEFAULTCOMPRESSIONFORMAT, 
+	                            CBlockCompressor::enumQuality quality = CTextureManager::DEFAULTCOMPRESSIONQUALITY );
+	// (the BMPs don't have alpha, so BC1 is plenty)
+	static const CBlockCompressor::enumFormat DEFAULTCOMPRESSIONFORMAT = CBlockCompressor::FORMAT_BC1;
+	static const CBlockCompressor::enumQuality DEFAULTCOMPRESSIONQUALITY = CBlockCompressor::QUALITY_NORMAL;
+	// How the compressed ones are cooked (TEXTURECOOKSETTINGS, and the format and quality)
+	static std::string GetCompressedCookSettings( CBlockCompressor::enumFormat format, CBlockCompressor::enumQuality quality );
+	// Added: About how much video memory all the textures take
+	unsigned long long GetTotalSizeInGPUMemory(void);
+	// Added: The textures loaded after this is set upload through it (see CGPUUploadRing). 
+	//	0 (the default) is the old way. It isn't owned by the texture manager.
+	void SetUploadRing( CGPUUploadRing* pUploadRing );
 	//bool CreateCubeTextureFromBMPFiles( std::string cubeMapName, 
 	//	                                std::string posX_fileName, std::string negX_fileName, 
 	//                                    std::string posY_fileName, std::string negY_fileName, 
@@ -104,6 +156,14 @@ private:
 	//static const GLuint m_BASETEXTURE = GL_TEXTURE0;
 	std::string m_basePath;
 	std::string m_lastError;
+	CAssetCache m_cookedCache;
+	CGPUUploadRing* m_pUploadRing;
+	// Added: See SetTextureCompression()
+	bool m_bCompressTextures;
+	CBlockCompressor::enumFormat m_compressionFormat;
+	CBlockCompressor::enumQuality m_compressionQuality;
+	// Is it on, with somewhere to cook them, and can the card do it? (needs OpenGL)
+	bool m_IsCompressionUsable(void);
 	void m_appendErrorString( std::string nextErrorText );
 	void m_appendErrorStringLine( std::string nextErrorTextLine );
 
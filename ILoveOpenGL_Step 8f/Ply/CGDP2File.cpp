@@ -0,0 +1,344 @@
+#include "CGDP2File.h"
+#include "CPlyFile5nt.h"
+#include "CPlyVertexLayout.h"
+
+#include <fstream>
+#include <string.h>		// for memset(), memcmp()
+#include <stddef.h>		// for offsetof()
+
+static_assert( sizeof(CGDP2File::sHeader) == 192, "The GDP v4 header is expected to be 192 bytes" );
+static_assert( sizeof(CGDP2File::sVertex) == 64, "The GDP v2 vertex is expected to be 16 packed floats" );
+
+CGDP2File::CGDP2File()
+{
+	this->m_pHeader = 0;
+	return;
+}
+
+CGDP2File::~CGDP2File()
+{
+	this->Close();
+	return;
+}
+
+//static
+const CPlyVertexLayout& CGDP2File::GetVertexLayout(void)
+{
+	// (made once, the first time it's needed)
+	static const CPlyVertexLayout theLayout = CGDP2File::m_MakeVertexLayout();
+	return theLayout;
+}
+
+//static
+CPlyVertexLayout CGDP2File::m_MakeVertexLayout(void)
+{
+	CPlyVertexLayout layout;
+	layout.AddAttribute( CPlyVertexStreams::STREAM_POSITION, offsetof( sVertex, Position ), 4, 0.0f, 0.0f, 0.0f, 1.0f );	// w = 1
+	layout.AddAttribute( CPlyVertexStreams::STREAM_NORMAL, offsetof( sVertex, Normal ), 4, 0.0f, 0.0f, 0.0f, 1.0f );		// (1.0 unless...)
+	layout.AddAttribute( CPlyVertexStreams::STREAM_COLOUR, offsetof( sVertex, RGBA ), 4 );
+	layout.AddAttribute( CPlyVertexStreams::STREAM_TEX0, offsetof( sVertex, UVx2 ), 2 );
+	layout.AddAttribute( CPlyVertexStreams::STREAM_TEX1, offsetof( sVertex, UVx2 ) + 2 * sizeof(float), 2 );
+	layout.SetVertexSizeInBytes( sizeof(sVertex) );
+	return layout;
+}
+
+//static
+void CGDP2File::BuildVertexBuffer( CPlyFile5nt &plyFile, std::vector<sVertex> &vecVertices )
+{
+	vecVertices.resize( plyFile.GetNumberOfVerticies() );
+	if ( !vecVertices.empty() )
+	{
+		plyFile.ExportVertices( CGDP2File::GetVertexLayout(), &(vecVertices[0]) );
+	}
+	return;
+}
+
+//static
+bool CGDP2File::Save( CPlyFile5nt &plyFile, const std::vector<unsigned int> &vecIndices, const sLODChain &LODChain, 
+                      const CPlyVertexLayout &compactLayout, const sCompactFormat &compactFormat, 
+                      std::wstring fileName, unsigned long long cookKey, std::wstring &error )
+{
+	if ( ( plyFile.GetNumberOfVerticies() <= 0 ) || ( plyFile.GetNumberOfElements() <= 0 ) )
+	{
+		error = L"ERROR: There's no model to save.";
+		return false;
+	}
+	if ( ( vecIndices.size() < static_cast<size_t>( plyFile.GetNumberOfElements() ) * 3 ) || 
+		 ( ( vecIndices.size() % 3 ) != 0 ) || ( LODChain.numberOfLODs > CGDP2File::MAXLODS ) )
+	{
+		error = L"ERROR: The indices (or the LODs) don't match the model.";
+		return false;
+	}
+
+	std::vector<sVertex> vecVertices;
+	CGDP2File::BuildVertexBuffer( plyFile, vecVertices );
+	// Added: And again, the compact way
+	std::vector<char> vecCompactVertices( static_cast<size_t>( plyFile.GetNumberOfVerticies() ) * compactLayout.GetVertexSizeInBytes() );
+	if ( !vecCompactVertices.empty() )
+	{
+		plyFile.ExportVertices( compactLayout, &(vecCompactVertices[0]) );
+	}
+
+	sHeader header;
+	memset( &header, 0, sizeof(sHeader) );
+	header.gdp[0] = 'g';	header.gdp[1] = 'd';	header.gdp[2] = 'p';
+	header.version = CGDP2File::GDPVERSION;
+	header.bIsLittleEndian = CGDP2File::m_bIsThisMachineLittleEndian() ? 1 : 0;
+	header.bHadNormalsInFile = plyFile.bHasNormalsInFile() ? 1 : 0;
+	header.bHadTextureCoordinatesInFile = plyFile.bHasTextureCoordinatesInFile() ? 1 : 0;
+	header.vertexSizeInBytes = sizeof(sVertex);
+	header.numberOfVertices = static_cast<unsigned int>( plyFile.GetNumberOfVerticies() );
+	header.numberOfIndices = static_cast<unsigned int>( plyFile.GetNumberOfElements() ) * 3;
+	header.indexSizeInBytes = ( header.numberOfVertices <= CGDP2File::MAXVERTICESFOR16BITINDICES ) ? 2 : 4;
+	header.vertexDataOffset = CGDP2File::m_AlignUp( sizeof(sHeader) );
+	header.indexDataOffset = CGDP2File::m_AlignUp( header.vertexDataOffset + header.numberOfVertices * header.vertexSizeInBytes );
+	header.cookKey = cookKey;
+	header.numberOfIndicesWithLODs = static_cast<unsigned int>( vecIndices.size() );
+	header.LODChain = LODChain;
+	header.compactVertexSizeInBytes = compactLayout.GetVertexSizeInBytes();
+	header.compactVertexDataOffset = CGDP2File::m_AlignUp( header.indexDataOffset + header.numberOfIndicesWithLODs * header.indexSizeInBytes );
+	header.compactFormat = compactFormat;
+
+	header.maxExtent = plyFile.getMaxExtent(true);		// true: recalculate
+	header.minXYZ[0] = plyFile.getMinX();	header.maxXYZ[0] = plyFile.getMaxX();
+	header.minXYZ[1] = plyFile.getMinY();	header.maxXYZ[1] = plyFile.getMaxY();
+	header.minXYZ[2] = plyFile.getMinZ();	header.maxXYZ[2] = plyFile.getMaxZ();
+
+	// Indices, in whatever size they are going to be
+	std::vector<unsigned short> vecIndices16;
+	const char* pIndexData = reinterpret_cast<const char*>( &(vecIndices[0]) );
+	if ( header.indexSizeInBytes == 2 )
+	{
+		vecIndices16.assign( vecIndices.begin(), vecIndices.end() );
+		pIndexData = reinterpret_cast<const char*>( &(vecIndices16[0]) );
+	}
+
+	std::ofstream theGDPFile( fileName.c_str(), std::ios::binary );
+	if ( !theGDPFile.is_open() )
+	{
+		error = L"Can't open the file. Sorry it didn't work out.";
+		return false;
+	}
+
+	// One write per block (header, vertices, indices, compact vertices), plus the zero padding in between
+	const char padding[CGDP2File::BLOCKALIGNMENT] = { 0 };
+	theGDPFile.write( reinterpret_cast<const char*>( &header ), sizeof(sHeader) );
+	theGDPFile.write( padding, header.vertexDataOffset - sizeof(sHeader) );
+	theGDPFile.write( reinterpret_cast<const char*>( &(vecVertices[0]) ), header.numberOfVertices * header.vertexSizeInBytes );
+	theGDPFile.write( padding, header.indexDataOffset - ( header.vertexDataOffset + header.numberOfVertices * header.vertexSizeInBytes ) );
+	theGDPFile.write( pIndexData, header.numberOfIndicesWithLODs * header.indexSizeInBytes );
+	theGDPFile.write( padding, header.compactVertexDataOffset - ( header.indexDataOffset + header.numberOfIndicesWithLODs * header.indexSizeInBytes ) );
+	if ( !vecCompactVertices.empty() )
+	{
+		theGDPFile.write( &(vecCompactVertices[0]), vecCompactVertices.size() );
+	}
+
+	if ( !theGDPFile.good() )
+	{
+		error = L"ERROR: Couldn't write all of the GDP file.";
+		return false;
+	}
+	theGDPFile.close();
+
+	return true;
+}
+
+bool CGDP2File::Open( std::wstring fileName, std::wstring &error )
+{
+	this->Close();
+
+	std::wstring openError;
+	if ( !this->m_fileView.Open( fileName, openError ) )
+	{
+		error = L"Can't open the file. Sorry it didn't work out. (" + openError + L")";
+		return false;
+	}
+
+	unsigned int fileSize = this->m_fileView.GetSize();
+	const sHeader* pHeader = reinterpret_cast<const sHeader*>( this->m_fileView.GetData() );
+
+	if ( ( fileSize < sizeof(sHeader) ) || ( memcmp( pHeader->gdp, "gdp", 3 ) != 0 ) )
+	{
+		error = L"ERROR: Isn't a valid GDP file.";
+		this->Close();
+		return false;
+	}
+	if ( pHeader->version != CGDP2File::GDPVERSION )
+	{
+		error = L"ERROR: Isn't a version 4 (cooked) GDP file.";
+		this->Close();
+		return false;
+	}
+	// It's used in place, so there's no swapping the bytes around
+	if ( ( pHeader->bIsLittleEndian != 0 ) != CGDP2File::m_bIsThisMachineLittleEndian() )
+	{
+		error = L"ERROR: The GDP file was saved on a machine with a different byte order.";
+		this->Close();
+		return false;
+	}
+
+	unsigned long long vertexDataEnd = static_cast<unsigned long long>( pHeader->vertexDataOffset )
+		+ static_cast<unsigned long long>( pHeader->numberOfVertices ) * pHeader->vertexSizeInBytes;
+	unsigned long long indexDataEnd = static_cast<unsigned long long>( pHeader->indexDataOffset )
+		+ static_cast<unsigned long long>( pHeader->numberOfIndicesWithLODs ) * pHeader->indexSizeInBytes;
+	unsigned long long compactVertexDataEnd = static_cast<unsigned long long>( pHeader->compactVertexDataOffset )
+		+ static_cast<unsigned long long>( pHeader->numberOfVertices ) * pHeader->compactVertexSizeInBytes;
+	// (the index size is the same one Save() picks, since cMeshManager uses them as they are)
+	const unsigned int indexSizeInBytes = ( pHeader->numberOfVertices <= CGDP2File::MAXVERTICESFOR16BITINDICES ) ? 2 : 4;
+	if ( ( pHeader->numberOfVertices == 0 ) || ( pHeader->numberOfIndices == 0 ) ||
+		 ( pHeader->vertexSizeInBytes != sizeof(sVertex) ) ||
+		 ( pHeader->indexSizeInBytes != indexSizeInBytes ) ||
+		 ( ( pHeader->numberOfIndices % 3 ) != 0 ) ||
+		 ( ( pHeader->numberOfIndicesWithLODs % 3 ) != 0 ) ||
+		 ( pHeader->numberOfIndicesWithLODs < pHeader->numberOfIndices ) ||
+		 ( ( pHeader->vertexDataOffset % CGDP2File::BLOCKALIGNMENT ) != 0 ) ||
+		 ( ( pHeader->indexDataOffset % CGDP2File::BLOCKALIGNMENT ) != 0 ) ||
+		 ( pHeader->vertexDataOffset < sizeof(sHeader) ) ||
+		 ( pHeader->indexDataOffset < vertexDataEnd ) ||
+		 ( indexDataEnd > fileSize ) ||
+		 ( pHeader->compactVertexSizeInBytes == 0 ) ||
+		 ( ( pHeader->compactVertexDataOffset % CGDP2File::BLOCKALIGNMENT ) != 0 ) ||
+		 ( pHeader->compactVertexDataOffset < indexDataEnd ) ||
+		 ( compactVertexDataEnd > fileSize ) )
+	{
+		error = L"ERROR: The GDP file header doesn't match the file (or the file is too short).";
+		this->Close();
+		return false;
+	}
+	// Added: Each LOD has to be in the index data
+	bool bLODsAreValid = ( pHeader->LODChain.numberOfLODs <= CGDP2File::MAXLODS );
+	for ( unsigned int LOD = 0; bLODsAreValid && ( LOD != pHeader->LODChain.numberOfLODs ); LOD++ )
+	{
+		const sLOD &theLOD = pHeader->LODChain.LODs[LOD];
+		bLODsAreValid = ( ( theLOD.firstIndex % 3 ) == 0 ) && 
+		                ( static_cast<unsigned long long>( theLOD.firstIndex ) + static_cast<unsigned long long>( theLOD.numberOfTriangles ) * 3 
+		                  <= pHeader->numberOfIndicesWithLODs );
+	}
+	if ( !bLODsAreValid )
+	{
+		error = L"ERROR: The GDP file's LODs aren't in the index data.";
+		this->Close();
+		return false;
+	}
+	// Added: Only the types the compact format picks from
+	const sCompactFormat &compactFormat = pHeader->compactFormat;
+	if ( ( compactFormat.bHasColours && ( compactFormat.colourType != CPlyVertexLayout::TYPE_UNORM8 ) && 
+	                                    ( compactFormat.colourType != CPlyVertexLayout::TYPE_FLOAT16 ) ) || 
+		 ( ( compactFormat.UVType != CPlyVertexLayout::TYPE_FLOAT16 ) && ( compactFormat.UVType != CPlyVertexLayout::TYPE_FLOAT32 ) ) )
+	{
+		error = L"ERROR: The GDP file's compact vertex format isn't one that can be loaded.";
+		this->Close();
+		return false;
+	}
+
+	this->m_pHeader = pHeader;
+	return true;
+}
+
+void CGDP2File::Close(void)
+{
+	this->m_fileView.Close();
+	this->m_pHeader = 0;
+	return;
+}
+
+bool CGDP2File::IsOpen(void)
+{
+	return ( this->m_pHeader != 0 );
+}
+
+const CGDP2File::sHeader* CGDP2File::GetHeader(void)
+{
+	return this->m_pHeader;
+}
+
+const CGDP2File::sVertex* CGDP2File::GetVertices(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return reinterpret_cast<const sVertex*>( this->m_fileView.GetData() + this->m_pHeader->vertexDataOffset );
+}
+
+const void* CGDP2File::GetCompactVertices(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_fileView.GetData() + this->m_pHeader->compactVertexDataOffset;
+}
+
+const CGDP2File::sCompactFormat* CGDP2File::GetCompactFormat(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return &(this->m_pHeader->compactFormat);
+}
+
+unsigned int CGDP2File::GetCompactVertexSizeInBytes(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->compactVertexSizeInBytes;
+}
+
+const void* CGDP2File::GetIndices(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_fileView.GetData() + this->m_pHeader->indexDataOffset;
+}
+
+unsigned int CGDP2File::GetNumberOfVertices(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->numberOfVertices;
+}
+
+unsigned int CGDP2File::GetNumberOfIndices(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->numberOfIndices;
+}
+
+unsigned int CGDP2File::GetNumberOfIndicesWithLODs(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->numberOfIndicesWithLODs;
+}
+
+const CGDP2File::sLODChain* CGDP2File::GetLODChain(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return &(this->m_pHeader->LODChain);
+}
+
+unsigned int CGDP2File::GetIndexSizeInBytes(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->indexSizeInBytes;
+}
+
+unsigned int CGDP2File::GetVertexDataSizeInBytes(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->numberOfVertices * this->m_pHeader->vertexSizeInBytes;
+}
+
+unsigned int CGDP2File::GetIndexDataSizeInBytes(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->numberOfIndicesWithLODs * this->m_pHeader->indexSizeInBytes;
+}
+
+unsigned long long CGDP2File::GetCookKey(void)
+{
+	if ( this->m_pHeader == 0 )	{ return 0; }
+	return this->m_pHeader->cookKey;
+}
+
+//static
+unsigned int CGDP2File::m_AlignUp( unsigned int offset )
+{
+	return ( offset + CGDP2File::BLOCKALIGNMENT - 1 ) & ~( CGDP2File::BLOCKALIGNMENT - 1 );
+}
+
+//static
+bool CGDP2File::m_bIsThisMachineLittleEndian(void)
+{
+	const unsigned int one = 1;
+	return ( *reinterpret_cast<const unsigned char*>( &one ) == 1 );
+}
@@ -0,0 +1,156 @@
+#ifndef _CGDP2File_HG_
+#define _CGDP2File_HG_
+
+// GDP version 2 ("cooked") model file
+// Version 1 (CPlyFile5nt::SaveGDPFile) is basically a binary PLY: each property is in
+//	its own array, so it still has to be turned into vertices after it's loaded.
+// Version 2 stores the final, interleaved vertex buffer and the index buffer, exactly
+//	the way they get passed to glBufferData(). Normals, texture coordinates and the
+//	extents are all worked out when the file is saved, so "loading" is just mapping the
+//	file and pointing OpenGL at it.
+// Version 3 adds the level of detail (LOD) chain and the bounding sphere (see 
+//	cMeshManager::m_BuildLODChain()), so those aren't redone every time it's loaded, either.
+// Version 4 adds the same vertices in the compact (quantised) format, and what was picked 
+//	for it (see cMeshManager::m_PickCompactVertexFormat()), so either format is ready to go.
+//
+// File layout (little endian, each block starts on a 16 byte boundary):
+//	- header: sHeader (192 bytes)
+//	- vertices: numberOfVertices * sVertex (64 bytes each)
+//	- indices: numberOfIndicesWithLODs * indexSizeInBytes (2 bytes if the model has 65536 or
+//	  fewer vertices, 4 bytes if it's bigger than that). The full model is first (numberOfIndices),
+//	  then each of the lower detail levels.
+//	- compact vertices: numberOfVertices * compactVertexSizeInBytes
+
+#include <string>
+#include <vector>
+#include "../CFileView.h"
+
+class CPlyFile5nt;
+class CPlyVertexLayout;
+
+class CGDP2File
+{
+public:
+	CGDP2File();
+	~CGDP2File();
+
+	// Same layout as Vertex_xyz_n_RGB_UVx2 (and the shader's in_Position, in_Normal, etc.)
+	struct sVertex
+	{
+		float Position[4];
+		float Normal[4];
+		float RGBA[4];
+		float UVx2[4];
+	};
+
+	static const unsigned int MAXLODS = 5;
+
+	// Added: One level of detail (same as cLODInfo)
+	struct sLOD
+	{
+		unsigned int firstIndex;					// From the start of the index data
+		unsigned int numberOfTriangles;
+		float relativeError;						// As a fraction of the bounding radius
+	};
+	// Added: LODs[0] is the full model. The bounding sphere is in model space.
+	struct sLODChain
+	{
+		unsigned int numberOfLODs;
+		sLOD LODs[MAXLODS];
+		float boundingCentre[3];
+		float boundingRadius;
+	};
+
+	// Added: How the compact vertices were written. The layout is made from this 
+	//	(see cMeshManager::m_MakeCompactVertexLayout())
+	struct sCompactFormat
+	{
+		float positionDecodeOffset[3];				// The bounding box (the positions are 0 to 65535 across it)
+		float positionDecodeScale[3];
+		unsigned char bHasColours;
+		unsigned char colourType;					// CPlyVertexLayout::TYPE_UNORM8 or TYPE_FLOAT16
+		unsigned char UVType;						// CPlyVertexLayout::TYPE_FLOAT16 or TYPE_FLOAT32
+		unsigned char bHasTex1;
+	};
+
+	// The first 4 chars are the same as version 1 ("gdp" and the version),
+	//	so CPlyFile5nt::OpenGDPFile() can tell them apart
+	struct sHeader
+	{
+		char gdp[3];								// 0: "gdp"
+		unsigned char version;						// 3: GDPVERSION
+		unsigned char bIsLittleEndian;				// 4
+		unsigned char bHadNormalsInFile;			// 5: if not, they were calculated
+		unsigned char bHadTextureCoordinatesInFile;	// 6: if not, they are spherical
+		unsigned char indexSizeInBytes;				// 7: 2 or 4
+		unsigned int vertexSizeInBytes;				// 8: sizeof(sVertex)
+		unsigned int numberOfVertices;				// 12
+		unsigned int numberOfIndices;				// 16: 3 per triangle (just the full model)
+		unsigned int vertexDataOffset;				// 20: from the start of the file
+		unsigned int indexDataOffset;				// 24: from the start of the file
+		float minXYZ[3];							// 28
+		float maxXYZ[3];							// 40
+		float maxExtent;							// 52
+		unsigned long long cookKey;					// 56: see CAssetCache (zero if it wasn't cooked)
+		unsigned int numberOfIndicesWithLODs;		// 64: the full model, then the LODs
+		sLODChain LODChain;							// 68
+		unsigned int compactVertexSizeInBytes;		// 148
+		unsigned int compactVertexDataOffset;		// 152: from the start of the file
+		sCompactFormat compactFormat;				// 156
+		unsigned int reserved[2];					// 184: (zeros)
+	};
+
+	// Updated: Version 3 has the LODs, version 4 has the compact vertices
+	static const unsigned char GDPVERSION = 4;
+	static const unsigned int BLOCKALIGNMENT = 16;
+	// Above this, the indices don't fit into 16 bits
+	static const unsigned int MAXVERTICESFOR16BITINDICES = 65536;
+
+	// Added: sVertex as a CPlyVertexLayout (w of the position and normal is 1.0), for CPlyFile5nt::ExportVertices()
+	// (cMeshManager::LoadPlyIntoVBO() uses this to write right into the vertex buffer)
+	static const CPlyVertexLayout& GetVertexLayout(void);
+	// Copies the ply vertices into the interleaved (GPU) format
+	static void BuildVertexBuffer( CPlyFile5nt &plyFile, std::vector<sVertex> &vecVertices );
+	// Saves the model as it is, so calculate the normals, etc. before calling this
+	// cookKey is stored in the header (CAssetCache uses it to tell if the file is out of date)
+	// Updated: vecIndices is the full model (the ply's triangles), then the LODs in LODChain
+	// Updated: compactLayout (made from compactFormat) is how the compact vertices are written
+	static bool Save( CPlyFile5nt &plyFile, const std::vector<unsigned int> &vecIndices, const sLODChain &LODChain, 
+	                  const CPlyVertexLayout &compactLayout, const sCompactFormat &compactFormat, 
+	                  std::wstring fileName, unsigned long long cookKey, std::wstring &error );
+
+	// Maps the file and checks the header. The data stays valid until Close()
+	// NOTE: It doesn't check the index values (that would mean going through all of them)
+	bool Open( std::wstring fileName, std::wstring &error );
+	void Close(void);
+	bool IsOpen(void);
+
+	const sHeader* GetHeader(void);
+	const sVertex* GetVertices(void);
+	const void* GetCompactVertices(void);
+	const sCompactFormat* GetCompactFormat(void);
+	unsigned int GetCompactVertexSizeInBytes(void);
+	const void* GetIndices(void);			// unsigned short or unsigned int (see GetIndexSizeInBytes())
+	unsigned int GetNumberOfVertices(void);
+	unsigned int GetNumberOfIndices(void);				// Just the full model
+	unsigned int GetNumberOfIndicesWithLODs(void);
+	const sLODChain* GetLODChain(void);
+	unsigned int GetIndexSizeInBytes(void);
+	unsigned int GetVertexDataSizeInBytes(void);
+	unsigned int GetIndexDataSizeInBytes(void);			// All the LODs
+	unsigned long long GetCookKey(void);
+
+private:
+	// Can't be copied (it owns the file view)
+	CGDP2File( const CGDP2File &rhs );
+	CGDP2File& operator=( const CGDP2File &rhs );
+
+	static CPlyVertexLayout m_MakeVertexLayout(void);
+	static unsigned int m_AlignUp( unsigned int offset );
+	static bool m_bIsThisMachineLittleEndian(void);
+
+	CFileView m_fileView;
+	const sHeader* m_pHeader;
+};
+
+#endif
@@ -0,0 +1,365 @@
+#include "CMeshOptimizer.h"
+
+#include <math.h>
+#include <algorithm>
+
+//static
+const float CMeshOptimizer::DEFAULTOVERDRAWTHRESHOLD = 1.05f;
+//static
+// (the value is in the header; this is here since assign() takes it by reference)
+const unsigned int CMeshOptimizer::UNUSEDVERTEX;
+
+//static
+void CMeshOptimizer::OptimizeVertexCache( std::vector<unsigned int> &vecIndices, unsigned int numberOfVertices,
+                                          unsigned int cacheSize, std::vector<unsigned int> &vecClusters )
+{
+	vecClusters.clear();
+	const unsigned int numberOfTriangles = static_cast<unsigned int>( vecIndices.size() / 3 );
+	if ( ( numberOfTriangles == 0 ) || ( numberOfVertices == 0 ) )
+	{
+		return;
+	}
+
+	// How many triangles (that haven't been drawn yet) use each vertex
+	std::vector<unsigned int> vecLiveTriangles( numberOfVertices, 0 );
+	for ( unsigned int index = 0; index != numberOfTriangles * 3; index++ )
+	{
+		vecLiveTriangles[ vecIndices[index] ]++;
+	}
+	// Which triangles use each vertex (all in one array: vertex N's are from vecAdjacencyStart[N] to vecAdjacencyStart[N+1])
+	std::vector<unsigned int> vecAdjacencyStart( numberOfVertices + 1, 0 );
+	for ( unsigned int vertex = 0; vertex != numberOfVertices; vertex++ )
+	{
+		vecAdjacencyStart[vertex + 1] = vecAdjacencyStart[vertex] + vecLiveTriangles[vertex];
+	}
+	std::vector<unsigned int> vecAdjacency( numberOfTriangles * 3 );
+	std::vector<unsigned int> vecNextAdjacency( vecAdjacencyStart.begin(), vecAdjacencyStart.end() - 1 );
+	for ( unsigned int index = 0; index != numberOfTriangles * 3; index++ )
+	{
+		vecAdjacency[ vecNextAdjacency[ vecIndices[index] ]++ ] = index / 3;
+	}
+
+	std::vector<unsigned int> vecCacheTimeStamps( numberOfVertices, 0 );
+	std::vector<bool> vecIsEmitted( numberOfTriangles, false );
+	std::vector<unsigned int> vecDeadEndStack;
+	std::vector<unsigned int> vecCandidates;
+	std::vector<unsigned int> vecNewIndices;
+	vecNewIndices.reserve( numberOfTriangles * 3 );
+
+	// (Starting the time at cacheSize + 1 means nothing is in the cache to start with)
+	unsigned int timeStamp = cacheSize + 1;
+	unsigned int cursor = 0;
+	int fanningVertex = vecIndices[0];
+	bool bIsNewCluster = true;
+
+	while ( fanningVertex >= 0 )
+	{
+		// Draw all the triangles around this vertex that haven't been drawn yet
+		vecCandidates.clear();
+		for ( unsigned int adjIndex = vecAdjacencyStart[fanningVertex]; adjIndex != vecAdjacencyStart[fanningVertex + 1]; adjIndex++ )
+		{
+			unsigned int triangle = vecAdjacency[adjIndex];
+			if ( vecIsEmitted[triangle] )
+			{
+				continue;
+			}
+			if ( bIsNewCluster )
+			{
+				vecClusters.push_back( static_cast<unsigned int>( vecNewIndices.size() / 3 ) );
+				bIsNewCluster = false;
+			}
+			for ( unsigned int corner = 0; corner != 3; corner++ )
+			{
+				unsigned int vertex = vecIndices[triangle * 3 + corner];
+				vecNewIndices.push_back( vertex );
+				vecDeadEndStack.push_back( vertex );
+				vecCandidates.push_back( vertex );
+				vecLiveTriangles[vertex]--;
+				if ( ( timeStamp - vecCacheTimeStamps[vertex] ) > cacheSize )
+				{	// It wasn't in the cache, so it is now
+					vecCacheTimeStamps[vertex] = timeStamp;
+					timeStamp++;
+				}
+			}
+			vecIsEmitted[triangle] = true;
+		}
+
+		// Pick the next vertex to fan around: the one that's been in the cache the longest,
+		//	but will still be in there after all its triangles are drawn
+		int nextVertex = -1;
+		int bestPriority = -1;
+		for ( std::vector<unsigned int>::iterator itCandidate = vecCandidates.begin(); itCandidate != vecCandidates.end(); itCandidate++ )
+		{
+			unsigned int vertex = *itCandidate;
+			if ( vecLiveTriangles[vertex] == 0 )
+			{
+				continue;
+			}
+			int priority = 0;
+			unsigned int age = timeStamp - vecCacheTimeStamps[vertex];
+			if ( ( age + 2 * vecLiveTriangles[vertex] ) <= cacheSize )
+			{
+				priority = static_cast<int>( age );
+			}
+			if ( priority > bestPriority )
+			{
+				bestPriority = priority;
+				nextVertex = static_cast<int>( vertex );
+			}
+		}
+		if ( nextVertex == -1 )
+		{	// Dead end, so start again somewhere else
+			nextVertex = CMeshOptimizer::m_SkipDeadEnd( vecLiveTriangles, vecDeadEndStack, cursor, numberOfVertices );
+			bIsNewCluster = true;
+		}
+		fanningVertex = nextVertex;
+	}// while ( fanningVertex >= 0 )
+
+	vecIndices.swap( vecNewIndices );
+	return;
+}
+
+//static
+int CMeshOptimizer::m_SkipDeadEnd( const std::vector<unsigned int> &vecLiveTriangles, std::vector<unsigned int> &vecDeadEndStack,
+                                   unsigned int &cursor, unsigned int numberOfVertices )
+{
+	// Something that was used recently (so it might still be in the cache)...
+	while ( !vecDeadEndStack.empty() )
+	{
+		unsigned int vertex = vecDeadEndStack.back();
+		vecDeadEndStack.pop_back();
+		if ( vecLiveTriangles[vertex] > 0 )
+		{
+			return static_cast<int>( vertex );
+		}
+	}
+	// ...or the next one (in order) that still has triangles
+	for ( ; cursor != numberOfVertices; cursor++ )
+	{
+		if ( vecLiveTriangles[cursor] > 0 )
+		{
+			return static_cast<int>( cursor );
+		}
+	}
+	return -1;	// All done
+}
+
+//static
+void CMeshOptimizer::OptimizeOverdraw( std::vector<unsigned int> &vecIndices, std::vector<unsigned int> &vecClusters,
+                                       const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+                                       unsigned int cacheSize, float threshold )
+{
+	const unsigned int numberOfTriangles = static_cast<unsigned int>( vecIndices.size() / 3 );
+	if ( ( numberOfTriangles == 0 ) || ( numberOfVertices == 0 ) || ( pPositions == 0 ) )
+	{
+		return;
+	}
+	if ( vecClusters.empty() || ( vecClusters[0] != 0 ) )
+	{
+		vecClusters.insert( vecClusters.begin(), 0 );
+	}
+
+	// The clusters from OptimizeVertexCache() can be very big (the whole model, sometimes),
+	//	so split them up more, as long as it doesn't hurt the cache too much. A cluster is
+	//	split as soon as the triangles so far are within threshold of the ACMR of the whole thing.
+	std::vector<unsigned int> vecSoftClusters;
+	std::vector<unsigned int> vecCacheTimeStamps( numberOfVertices, 0 );
+	unsigned int timeStamp = cacheSize + 1;
+	for ( unsigned int clusterIndex = 0; clusterIndex != vecClusters.size(); clusterIndex++ )
+	{
+		unsigned int firstTriangle = vecClusters[clusterIndex];
+		unsigned int endTriangle = ( clusterIndex + 1 < vecClusters.size() ) ? vecClusters[clusterIndex + 1] : numberOfTriangles;
+
+		timeStamp += cacheSize + 1;		// Flush the cache
+		unsigned int clusterMisses = 0;
+		for ( unsigned int triangle = firstTriangle; triangle != endTriangle; triangle++ )
+		{
+			clusterMisses += CMeshOptimizer::m_SimulateTriangle( &(vecIndices[triangle * 3]), vecCacheTimeStamps, timeStamp, cacheSize );
+		}
+		float clusterThreshold = threshold * static_cast<float>( clusterMisses ) / static_cast<float>( endTriangle - firstTriangle );
+
+		timeStamp += cacheSize + 1;
+		vecSoftClusters.push_back( firstTriangle );
+		unsigned int softFirstTriangle = firstTriangle;
+		unsigned int softMisses = 0;
+		for ( unsigned int triangle = firstTriangle; triangle != endTriangle; triangle++ )
+		{
+			softMisses += CMeshOptimizer::m_SimulateTriangle( &(vecIndices[triangle * 3]), vecCacheTimeStamps, timeStamp, cacheSize );
+			if ( ( triangle + 1 != endTriangle ) &&
+			     ( static_cast<float>( softMisses ) <= clusterThreshold * static_cast<float>( triangle + 1 - softFirstTriangle ) ) )
+			{
+				vecSoftClusters.push_back( triangle + 1 );
+				softFirstTriangle = triangle + 1;
+				softMisses = 0;
+				timeStamp += cacheSize + 1;
+			}
+		}
+	}// for ( unsigned int clusterIndex
+
+	// Work out the (area weighted) centre and normal of each cluster, and of the whole model
+	struct sCluster
+	{
+		unsigned int firstTriangle;
+		unsigned int endTriangle;
+		double centre[3];
+		double normal[3];
+		double area;
+		float sortKey;
+	};
+	std::vector<sCluster> vecClusterInfo( vecSoftClusters.size() );
+	double modelCentre[3] = { 0.0, 0.0, 0.0 };
+	double modelArea = 0.0;
+	const char* pPositionBytes = reinterpret_cast<const char*>( pPositions );
+	for ( unsigned int clusterIndex = 0; clusterIndex != vecSoftClusters.size(); clusterIndex++ )
+	{
+		sCluster &cluster = vecClusterInfo[clusterIndex];
+		cluster.firstTriangle = vecSoftClusters[clusterIndex];
+		cluster.endTriangle = ( clusterIndex + 1 < vecSoftClusters.size() ) ? vecSoftClusters[clusterIndex + 1] : numberOfTriangles;
+		cluster.centre[0] = cluster.centre[1] = cluster.centre[2] = 0.0;
+		cluster.normal[0] = cluster.normal[1] = cluster.normal[2] = 0.0;
+		cluster.area = 0.0;
+		for ( unsigned int triangle = cluster.firstTriangle; triangle != cluster.endTriangle; triangle++ )
+		{
+			const float* p0 = reinterpret_cast<const float*>( pPositionBytes + vecIndices[triangle * 3 + 0] * positionStrideInBytes );
+			const float* p1 = reinterpret_cast<const float*>( pPositionBytes + vecIndices[triangle * 3 + 1] * positionStrideInBytes );
+			const float* p2 = reinterpret_cast<const float*>( pPositionBytes + vecIndices[triangle * 3 + 2] * positionStrideInBytes );
+			double edge1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			double edge2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			// The cross product is the normal, and it's twice the area long
+			double cross[3] = { edge1[1] * edge2[2] - edge1[2] * edge2[1],
+			                    edge1[2] * edge2[0] - edge1[0] * edge2[2],
+			                    edge1[0] * edge2[1] - edge1[1] * edge2[0] };
+			double area = sqrt( cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2] );
+			for ( unsigned int axis = 0; axis != 3; axis++ )
+			{
+				cluster.centre[axis] += area * ( p0[axis] + p1[axis] + p2[axis] ) / 3.0;
+				cluster.normal[axis] += cross[axis];
+			}
+			cluster.area += area;
+		}
+		for ( unsigned int axis = 0; axis != 3; axis++ )
+		{
+			modelCentre[axis] += cluster.centre[axis];
+		}
+		modelArea += cluster.area;
+	}// for ( unsigned int clusterIndex
+	if ( modelArea > 0.0 )
+	{
+		for ( unsigned int axis = 0; axis != 3; axis++ )	{ modelCentre[axis] /= modelArea; }
+	}
+
+	// The clusters that are furthest out (along the way they face) are drawn first,
+	//	since they're the most likely to be in front of the others
+	for ( std::vector<sCluster>::iterator itCluster = vecClusterInfo.begin(); itCluster != vecClusterInfo.end(); itCluster++ )
+	{
+		itCluster->sortKey = 0.0f;
+		double normalLength = sqrt( itCluster->normal[0] * itCluster->normal[0] +
+		                            itCluster->normal[1] * itCluster->normal[1] +
+		                            itCluster->normal[2] * itCluster->normal[2] );
+		if ( ( itCluster->area <= 0.0 ) || ( normalLength <= 0.0 ) )
+		{
+			continue;
+		}
+		double sortKey = 0.0;
+		for ( unsigned int axis = 0; axis != 3; axis++ )
+		{
+			sortKey += ( itCluster->centre[axis] / itCluster->area - modelCentre[axis] ) * ( itCluster->normal[axis] / normalLength );
+		}
+		itCluster->sortKey = static_cast<float>( sortKey );
+	}
+	std::vector<unsigned int> vecOrder( vecClusterInfo.size() );
+	for ( unsigned int index = 0; index != vecOrder.size(); index++ )	{ vecOrder[index] = index; }
+	std::stable_sort( vecOrder.begin(), vecOrder.end(),
+	                  [&vecClusterInfo]( unsigned int a, unsigned int b ) { return vecClusterInfo[a].sortKey > vecClusterInfo[b].sortKey; } );
+
+	std::vector<unsigned int> vecNewIndices;
+	vecNewIndices.reserve( vecIndices.size() );
+	vecClusters.clear();
+	for ( std::vector<unsigned int>::iterator itOrder = vecOrder.begin(); itOrder != vecOrder.end(); itOrder++ )
+	{
+		const sCluster &cluster = vecClusterInfo[*itOrder];
+		vecClusters.push_back( static_cast<unsigned int>( vecNewIndices.size() / 3 ) );
+		vecNewIndices.insert( vecNewIndices.end(), vecIndices.begin() + cluster.firstTriangle * 3, vecIndices.begin() + cluster.endTriangle * 3 );
+	}
+	vecIndices.swap( vecNewIndices );
+	return;
+}
+
+//static
+unsigned int CMeshOptimizer::OptimizeVertexFetch( std::vector<unsigned int> &vecIndices, unsigned int numberOfVertices,
+                                                  std::vector<unsigned int> &vecVertexRemap )
+{
+	vecVertexRemap.assign( numberOfVertices, CMeshOptimizer::UNUSEDVERTEX );
+	unsigned int nextVertex = 0;
+	for ( std::vector<unsigned int>::iterator itIndex = vecIndices.begin(); itIndex != vecIndices.end(); itIndex++ )
+	{
+		if ( vecVertexRemap[*itIndex] == CMeshOptimizer::UNUSEDVERTEX )
+		{
+			vecVertexRemap[*itIndex] = nextVertex++;
+		}
+		*itIndex = vecVertexRemap[*itIndex];
+	}
+	unsigned int numberOfUsedVertices = nextVertex;
+	// The unused ones go at the end
+	for ( unsigned int vertex = 0; vertex != numberOfVertices; vertex++ )
+	{
+		if ( vecVertexRemap[vertex] == CMeshOptimizer::UNUSEDVERTEX )
+		{
+			vecVertexRemap[vertex] = nextVertex++;
+		}
+	}
+	return numberOfUsedVertices;
+}
+
+//static
+void CMeshOptimizer::AnalyzeVertexCache( const std::vector<unsigned int> &vecIndices, unsigned int numberOfVertices,
+                                         unsigned int cacheSize, float &ACMR, float &ATVR )
+{
+	ACMR = ATVR = 0.0f;
+	const unsigned int numberOfTriangles = static_cast<unsigned int>( vecIndices.size() / 3 );
+	if ( ( numberOfTriangles == 0 ) || ( numberOfVertices == 0 ) )
+	{
+		return;
+	}
+
+	std::vector<unsigned int> vecCacheTimeStamps( numberOfVertices, 0 );
+	std::vector<bool> vecIsUsed( numberOfVertices, false );
+	unsigned int timeStamp = cacheSize + 1;
+	unsigned int misses = 0;
+	unsigned int numberOfUsedVertices = 0;
+	for ( unsigned int triangle = 0; triangle != numberOfTriangles; triangle++ )
+	{
+		misses += CMeshOptimizer::m_SimulateTriangle( &(vecIndices[triangle * 3]), vecCacheTimeStamps, timeStamp, cacheSize );
+		for ( unsigned int corner = 0; corner != 3; corner++ )
+		{
+			if ( !vecIsUsed[ vecIndices[triangle * 3 + corner] ] )
+			{
+				vecIsUsed[ vecIndices[triangle * 3 + corner] ] = true;
+				numberOfUsedVertices++;
+			}
+		}
+	}
+	ACMR = static_cast<float>( misses ) / static_cast<float>( numberOfTriangles );
+	ATVR = static_cast<float>( misses ) / static_cast<float>( numberOfUsedVertices );
+	return;
+}
+
+//static
+unsigned int CMeshOptimizer::m_SimulateTriangle( const unsigned int* pTriangle, std::vector<unsigned int> &vecCacheTimeStamps,
+                                                 unsigned int &timeStamp, unsigned int cacheSize )
+{
+	// The last cacheSize vertices that went into the cache have time stamps of
+	//	timeStamp - 1 down to timeStamp - cacheSize (FIFO, so a hit doesn't change anything)
+	unsigned int misses = 0;
+	for ( unsigned int corner = 0; corner != 3; corner++ )
+	{
+		unsigned int vertex = pTriangle[corner];
+		if ( ( timeStamp - vecCacheTimeStamps[vertex] ) > cacheSize )
+		{
+			vecCacheTimeStamps[vertex] = timeStamp;
+			timeStamp++;
+			misses++;
+		}
+	}
+	return misses;
+}
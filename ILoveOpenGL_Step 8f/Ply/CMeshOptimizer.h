@@ -0,0 +1,60 @@
+#ifndef _CMeshOptimizer_HG_
+#define _CMeshOptimizer_HG_
+
+// Reorders the triangles (and vertices) of an indexed triangle list so the GPU has less work to do:
+//	1. OptimizeVertexCache(): the "Tipsify" algorithm, from "Fast Triangle Reordering for Vertex
+//	   Locality and Reduced Overdraw" (Sander, Nehab and Barczak, SIGGRAPH 2007). Orders the
+//	   triangles so the vertices are still in the post-transform cache when they are used again.
+//	2. OptimizeOverdraw(): from the same paper. Splits the triangles into clusters, then draws
+//	   the clusters that are most likely to hide the others first (a "view independent" order).
+//	3. OptimizeVertexFetch(): renumbers the vertices in the order they are first used, so
+//	   reading the vertex buffer goes more or less straight through memory.
+// AnalyzeVertexCache() works out how well a particular order does (on a simulated FIFO cache).
+// Everything here works on 3 indices per triangle. The order of the vertices in each
+//	triangle doesn't change (so the winding stays the same).
+
+#include <vector>
+
+class CMeshOptimizer
+{
+public:
+	// Most GPUs have somewhere between 16 and 32 entries (post-transform)
+	static const unsigned int DEFAULTCACHESIZE = 16;
+	// How much worse (ACMR) the overdraw order can be than the vertex cache order (1.05 is 5%)
+	static const float DEFAULTOVERDRAWTHRESHOLD;
+	// In the vertex remap, for vertices that no triangle uses
+	static const unsigned int UNUSEDVERTEX = 0xFFFFFFFF;
+
+	// vecClusters gets the first triangle of each "cluster" (where the algorithm had to
+	//	start over, so the cache was mostly flushed anyway). OptimizeOverdraw() uses them.
+	static void OptimizeVertexCache( std::vector<unsigned int> &vecIndices, unsigned int numberOfVertices,
+	                                 unsigned int cacheSize, std::vector<unsigned int> &vecClusters );
+
+	// vecIndices and vecClusters should be what OptimizeVertexCache() left.
+	// pPositions is x, y, z of the first vertex; each one after that is positionStrideInBytes along.
+	static void OptimizeOverdraw( std::vector<unsigned int> &vecIndices, std::vector<unsigned int> &vecClusters,
+	                              const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+	                              unsigned int cacheSize, float threshold );
+
+	// vecVertexRemap[oldIndex] is where that vertex goes. The vertices that are used are first
+	//	(in the order they're used), then the unused ones (in their original order).
+	// The indices are changed to match. Returns the number of vertices that are used.
+	static unsigned int OptimizeVertexFetch( std::vector<unsigned int> &vecIndices, unsigned int numberOfVertices,
+	                                         std::vector<unsigned int> &vecVertexRemap );
+
+	// ACMR: average cache miss ratio (vertices transformed per triangle). 3.0 is as bad as it gets,
+	//	0.5 is about the best you can do on a big, regular mesh.
+	// ATVR: average transform to vertex ratio (vertices transformed per vertex used). 1.0 is perfect.
+	static void AnalyzeVertexCache( const std::vector<unsigned int> &vecIndices, unsigned int numberOfVertices,
+	                                unsigned int cacheSize, float &ACMR, float &ATVR );
+
+private:
+	// Simulated FIFO cache; returns the number of misses for this triangle
+	static unsigned int m_SimulateTriangle( const unsigned int* pTriangle, std::vector<unsigned int> &vecCacheTimeStamps,
+	                                        unsigned int &timeStamp, unsigned int cacheSize );
+	// Used by OptimizeVertexCache(), when there's nowhere to go from the current vertex
+	static int m_SkipDeadEnd( const std::vector<unsigned int> &vecLiveTriangles, std::vector<unsigned int> &vecDeadEndStack,
+	                          unsigned int &cursor, unsigned int numberOfVertices );
+};
+
+#endif
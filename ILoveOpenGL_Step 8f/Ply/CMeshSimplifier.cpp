@@ -0,0 +1,474 @@
+#include "CMeshSimplifier.h"
+
+#include <math.h>
+#include <string.h>		// for memset()
+#include <algorithm>
+
+//static
+const float CMeshSimplifier::BORDERWEIGHT = 10.0f;
+
+//static
+void CMeshSimplifier::SimplifyQEM( const std::vector<unsigned int> &vecIndices,
+                                   const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+                                   unsigned int targetNumberOfTriangles, float maxError,
+                                   std::vector<unsigned int> &vecIndicesOut, float &resultError )
+{
+	vecIndicesOut = vecIndices;
+	resultError = 0.0f;
+	unsigned int numberOfTriangles = static_cast<unsigned int>( vecIndicesOut.size() / 3 );
+	if ( ( numberOfTriangles <= targetNumberOfTriangles ) || ( numberOfVertices == 0 ) )
+	{
+		return;
+	}
+
+	// Vertices that are in the same place (seams) all point to the first one
+	// vecWedge goes around in a circle through all the vertices in the same place
+	std::vector<unsigned int> vecPositionRemap( numberOfVertices );
+	std::vector<unsigned int> vecWedge( numberOfVertices );
+	{
+		std::vector<unsigned int> vecSorted( numberOfVertices );
+		for ( unsigned int vertex = 0; vertex != numberOfVertices; vertex++ )
+		{
+			vecSorted[vertex] = vertex;
+		}
+		std::sort( vecSorted.begin(), vecSorted.end(),
+			[pPositions, positionStrideInBytes]( unsigned int a, unsigned int b ) -> bool
+			{
+				const float* pA = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, a );
+				const float* pB = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, b );
+				if ( pA[0] != pB[0] )	{ return pA[0] < pB[0]; }
+				if ( pA[1] != pB[1] )	{ return pA[1] < pB[1]; }
+				if ( pA[2] != pB[2] )	{ return pA[2] < pB[2]; }
+				return a < b;
+			} );
+		unsigned int runStart = 0;
+		for ( unsigned int index = 1; index <= numberOfVertices; index++ )
+		{
+			if ( index != numberOfVertices )
+			{
+				const float* pA = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, vecSorted[runStart] );
+				const float* pB = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, vecSorted[index] );
+				if ( ( pA[0] == pB[0] ) && ( pA[1] == pB[1] ) && ( pA[2] == pB[2] ) )
+				{
+					continue;
+				}
+			}
+			// vecSorted[runStart] to vecSorted[index - 1] are all in the same place
+			for ( unsigned int runIndex = runStart; runIndex != index; runIndex++ )
+			{
+				vecPositionRemap[ vecSorted[runIndex] ] = vecSorted[runStart];
+				vecWedge[ vecSorted[runIndex] ] = vecSorted[ ( runIndex + 1 == index ) ? runStart : runIndex + 1 ];
+			}
+			runStart = index;
+		}
+	}
+
+	std::vector<unsigned int> vecAdjacencyStart;
+	std::vector<unsigned int> vecAdjacency;
+	CMeshSimplifier::m_BuildAdjacency( vecIndicesOut, numberOfVertices, vecAdjacencyStart, vecAdjacency );
+
+	// Open edges (no triangle going the other way) and what the vertices are allowed to do
+	std::vector<unsigned int> vecOpenOut( numberOfVertices, 0 );
+	std::vector<unsigned int> vecOpenIn( numberOfVertices, 0 );
+	std::vector<unsigned int> vecOpenNext( numberOfVertices, 0 );
+	std::vector<unsigned int> vecOpenPrev( numberOfVertices, 0 );
+	for ( unsigned int index = 0; index != numberOfTriangles * 3; index++ )
+	{
+		unsigned int from = vecIndicesOut[index];
+		unsigned int to = vecIndicesOut[ ( index % 3 == 2 ) ? index - 2 : index + 1 ];
+		if ( !CMeshSimplifier::m_HasEdge( vecIndicesOut, vecAdjacencyStart, vecAdjacency, to, from ) )
+		{
+			vecOpenOut[from]++;		vecOpenNext[from] = to;
+			vecOpenIn[to]++;		vecOpenPrev[to] = from;
+		}
+	}
+	std::vector<unsigned char> vecKind( numberOfVertices, VERTEX_LOCKED );
+	for ( unsigned int vertex = 0; vertex != numberOfVertices; vertex++ )
+	{
+		unsigned int wedge = vecWedge[vertex];
+		if ( wedge == vertex )
+		{	// Only one vertex here
+			if ( ( vecOpenOut[vertex] == 0 ) && ( vecOpenIn[vertex] == 0 ) )
+			{
+				vecKind[vertex] = VERTEX_MANIFOLD;
+			}
+			else if ( ( vecOpenOut[vertex] == 1 ) && ( vecOpenIn[vertex] == 1 ) )
+			{
+				vecKind[vertex] = VERTEX_BORDER;
+			}
+		}
+		else if ( vecWedge[wedge] == vertex )
+		{	// Two vertices here: it's a seam if the open edges of one side match the other side's (going the other way)
+			if ( ( vecOpenOut[vertex] == 1 ) && ( vecOpenIn[vertex] == 1 ) && ( vecOpenOut[wedge] == 1 ) && ( vecOpenIn[wedge] == 1 ) &&
+				 ( vecPositionRemap[ vecOpenNext[vertex] ] == vecPositionRemap[ vecOpenPrev[wedge] ] ) &&
+				 ( vecPositionRemap[ vecOpenPrev[vertex] ] == vecPositionRemap[ vecOpenNext[wedge] ] ) )
+			{
+				vecKind[vertex] = VERTEX_SEAM;
+			}
+		}
+	}
+
+	// Quadrics (one per position, so both sides of a seam share it)
+	std::vector<sQuadric> vecQuadrics( numberOfVertices );
+	memset( &(vecQuadrics[0]), 0, sizeof(sQuadric) * numberOfVertices );
+	for ( unsigned int triangle = 0; triangle != numberOfTriangles; triangle++ )
+	{
+		const float* p0 = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, vecIndicesOut[triangle * 3 + 0] );
+		const float* p1 = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, vecIndicesOut[triangle * 3 + 1] );
+		const float* p2 = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, vecIndicesOut[triangle * 3 + 2] );
+		double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		double length = sqrt( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+		if ( length <= 0.0 )
+		{
+			continue;
+		}
+		n[0] /= length;		n[1] /= length;		n[2] /= length;
+		double d = -( n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2] );
+		for ( unsigned int corner = 0; corner != 3; corner++ )
+		{
+			CMeshSimplifier::m_AddPlane( vecQuadrics[ vecPositionRemap[ vecIndicesOut[triangle * 3 + corner] ] ],
+			                             n[0], n[1], n[2], d, length * 0.5 );
+		}
+
+		// Borders (and seams) get a plane at right angles to the triangle, through the edge,
+		//	so moving along the edge is cheap, but moving away from it isn't
+		for ( unsigned int corner = 0; corner != 3; corner++ )
+		{
+			unsigned int from = vecIndicesOut[triangle * 3 + corner];
+			unsigned int to = vecIndicesOut[triangle * 3 + ( corner + 1 ) % 3];
+			if ( CMeshSimplifier::m_HasEdge( vecIndicesOut, vecAdjacencyStart, vecAdjacency, to, from ) )
+			{
+				continue;
+			}
+			const float* pFrom = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, from );
+			const float* pTo = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, to );
+			double edge[3] = { pTo[0] - pFrom[0], pTo[1] - pFrom[1], pTo[2] - pFrom[2] };
+			double edgeLengthSquared = edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2];
+			double m[3] = { edge[1] * n[2] - edge[2] * n[1], edge[2] * n[0] - edge[0] * n[2], edge[0] * n[1] - edge[1] * n[0] };
+			double mLength = sqrt( m[0] * m[0] + m[1] * m[1] + m[2] * m[2] );
+			if ( mLength <= 0.0 )
+			{
+				continue;
+			}
+			m[0] /= mLength;	m[1] /= mLength;	m[2] /= mLength;
+			double md = -( m[0] * pFrom[0] + m[1] * pFrom[1] + m[2] * pFrom[2] );
+			double weight = edgeLengthSquared * CMeshSimplifier::BORDERWEIGHT;
+			CMeshSimplifier::m_AddPlane( vecQuadrics[ vecPositionRemap[from] ], m[0], m[1], m[2], md, weight );
+			CMeshSimplifier::m_AddPlane( vecQuadrics[ vecPositionRemap[to] ], m[0], m[1], m[2], md, weight );
+		}
+	}
+
+	// Collapse in passes: find all the possible collapses, then do the cheapest ones that
+	//	don't touch each other (then the triangles are updated, and around again)
+	const double maxErrorSquared = static_cast<double>( maxError ) * maxError;
+	double worstErrorSquared = 0.0;
+	std::vector<sCollapse> vecCandidates;
+	std::vector<unsigned int> vecCollapseTo( numberOfVertices );
+	std::vector<bool> vecIsTouched( numberOfVertices );
+	std::vector<unsigned int> vecNewIndices;
+	bool bAdjacencyIsUpToDate = true;
+
+	while ( numberOfTriangles > targetNumberOfTriangles )
+	{
+		if ( !bAdjacencyIsUpToDate )
+		{
+			CMeshSimplifier::m_BuildAdjacency( vecIndicesOut, numberOfVertices, vecAdjacencyStart, vecAdjacency );
+			bAdjacencyIsUpToDate = true;
+		}
+
+		vecCandidates.clear();
+		for ( unsigned int index = 0; index != numberOfTriangles * 3; index++ )
+		{
+			unsigned int a = vecIndicesOut[index];
+			unsigned int b = vecIndicesOut[ ( index % 3 == 2 ) ? index - 2 : index + 1 ];
+			bool bIsOpen = !CMeshSimplifier::m_HasEdge( vecIndicesOut, vecAdjacencyStart, vecAdjacency, b, a );
+			if ( !bIsOpen && ( a > b ) )
+			{	// (the other triangle will do this edge)
+				continue;
+			}
+			if ( vecPositionRemap[a] == vecPositionRemap[b] )
+			{
+				continue;
+			}
+			// Try it both ways, and keep the cheaper one
+			sCollapse best;
+			best.error = -1.0f;
+			for ( unsigned int direction = 0; direction != 2; direction++ )
+			{
+				unsigned int from = ( direction == 0 ) ? a : b;
+				unsigned int to = ( direction == 0 ) ? b : a;
+				unsigned char fromKind = vecKind[from];
+				unsigned char toKind = vecKind[to];
+				bool bCanCollapse = ( fromKind == VERTEX_MANIFOLD ) ||
+				                    ( bIsOpen && ( fromKind == VERTEX_BORDER ) && ( ( toKind == VERTEX_BORDER ) || ( toKind == VERTEX_LOCKED ) ) ) ||
+				                    ( bIsOpen && ( fromKind == VERTEX_SEAM ) && ( ( toKind == VERTEX_SEAM ) || ( toKind == VERTEX_LOCKED ) ) );
+				if ( !bCanCollapse )
+				{
+					continue;
+				}
+				sQuadric quadric = vecQuadrics[ vecPositionRemap[from] ];
+				CMeshSimplifier::m_AddQuadric( quadric, vecQuadrics[ vecPositionRemap[to] ] );
+				float error = static_cast<float>( CMeshSimplifier::m_EvaluateQuadric( quadric,
+				                                  CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, to ) ) );
+				if ( ( best.error < 0.0f ) || ( error < best.error ) )
+				{
+					best.fromVertex = from;
+					best.toVertex = to;
+					best.error = error;
+				}
+			}
+			if ( ( best.error >= 0.0f ) && ( best.error <= maxErrorSquared ) )
+			{
+				vecCandidates.push_back( best );
+			}
+		}// for ( unsigned int index...
+		if ( vecCandidates.empty() )
+		{
+			break;
+		}
+		std::sort( vecCandidates.begin(), vecCandidates.end(),
+			[]( const sCollapse &a, const sCollapse &b ) -> bool { return a.error < b.error; } );
+
+		// Each collapse takes out about 2 triangles. Don't go (much) past the error of the
+		//	collapse that would get there, so the cheap ones that are blocked this time
+		//	(by their neighbours) get a chance next time around.
+		unsigned int trianglesToRemove = numberOfTriangles - targetNumberOfTriangles;
+		unsigned int errorLimitIndex = std::min<unsigned int>( static_cast<unsigned int>( vecCandidates.size() ) - 1,
+		                                                       ( trianglesToRemove + 1 ) / 2 );
+		float errorLimit = vecCandidates[errorLimitIndex].error;
+
+		for ( unsigned int vertex = 0; vertex != numberOfVertices; vertex++ )
+		{
+			vecCollapseTo[vertex] = vertex;
+		}
+		vecIsTouched.assign( numberOfVertices, false );
+		unsigned int trianglesRemoved = 0;
+		unsigned int numberOfCollapses = 0;
+		for ( std::vector<sCollapse>::iterator itCollapse = vecCandidates.begin(); itCollapse != vecCandidates.end(); itCollapse++ )
+		{
+			if ( ( itCollapse->error > errorLimit ) || ( trianglesRemoved >= trianglesToRemove ) )
+			{
+				break;
+			}
+			unsigned int from = itCollapse->fromVertex;
+			unsigned int to = itCollapse->toVertex;
+			if ( vecIsTouched[ vecPositionRemap[from] ] || vecIsTouched[ vecPositionRemap[to] ] )
+			{
+				continue;
+			}
+
+			// The other side of a seam has to go to the same place (on its own side)
+			unsigned int wedgeFrom = from;
+			unsigned int wedgeTo = to;
+			if ( vecKind[from] == VERTEX_SEAM )
+			{
+				wedgeFrom = vecWedge[from];
+				bool bFoundIt = false;
+				unsigned int candidate = to;
+				do
+				{
+					if ( ( candidate != to ) &&
+						 ( CMeshSimplifier::m_HasEdge( vecIndicesOut, vecAdjacencyStart, vecAdjacency, wedgeFrom, candidate ) ||
+						   CMeshSimplifier::m_HasEdge( vecIndicesOut, vecAdjacencyStart, vecAdjacency, candidate, wedgeFrom ) ) )
+					{
+						wedgeTo = candidate;
+						bFoundIt = true;
+						break;
+					}
+					candidate = vecWedge[candidate];
+				} while ( candidate != to );
+				if ( !bFoundIt )
+				{
+					continue;
+				}
+			}
+
+			unsigned int collapsedTriangles = 0;
+			unsigned int wedgeCollapsedTriangles = 0;
+			if ( CMeshSimplifier::m_bCollapseFlipsTriangle( vecIndicesOut, vecAdjacencyStart, vecAdjacency, vecPositionRemap,
+			                                                pPositions, positionStrideInBytes, from, to, collapsedTriangles ) )
+			{
+				continue;
+			}
+			if ( ( wedgeFrom != from ) &&
+				 CMeshSimplifier::m_bCollapseFlipsTriangle( vecIndicesOut, vecAdjacencyStart, vecAdjacency, vecPositionRemap,
+			                                                pPositions, positionStrideInBytes, wedgeFrom, wedgeTo, wedgeCollapsedTriangles ) )
+			{
+				continue;
+			}
+
+			vecCollapseTo[from] = to;
+			vecCollapseTo[wedgeFrom] = wedgeTo;
+			CMeshSimplifier::m_AddQuadric( vecQuadrics[ vecPositionRemap[to] ], vecQuadrics[ vecPositionRemap[from] ] );
+			vecIsTouched[ vecPositionRemap[from] ] = true;
+			vecIsTouched[ vecPositionRemap[to] ] = true;
+			trianglesRemoved += collapsedTriangles + wedgeCollapsedTriangles;
+			worstErrorSquared = std::max<double>( worstErrorSquared, itCollapse->error );
+			numberOfCollapses++;
+		}// for ( std::vector<sCollapse>::iterator itCollapse...
+		if ( numberOfCollapses == 0 )
+		{
+			break;
+		}
+		// Move the indices, and drop the triangles that don't have any area now
+		vecNewIndices.clear();
+		for ( unsigned int triangle = 0; triangle != numberOfTriangles; triangle++ )
+		{
+			unsigned int i0 = vecCollapseTo[ vecIndicesOut[triangle * 3 + 0] ];
+			unsigned int i1 = vecCollapseTo[ vecIndicesOut[triangle * 3 + 1] ];
+			unsigned int i2 = vecCollapseTo[ vecIndicesOut[triangle * 3 + 2] ];
+			unsigned int p0 = vecPositionRemap[i0];
+			unsigned int p1 = vecPositionRemap[i1];
+			unsigned int p2 = vecPositionRemap[i2];
+			if ( ( p0 == p1 ) || ( p1 == p2 ) || ( p2 == p0 ) )
+			{
+				continue;
+			}
+			vecNewIndices.push_back( i0 );
+			vecNewIndices.push_back( i1 );
+			vecNewIndices.push_back( i2 );
+		}
+		vecIndicesOut.swap( vecNewIndices );
+		bAdjacencyIsUpToDate = false;
+		numberOfTriangles = static_cast<unsigned int>( vecIndicesOut.size() / 3 );
+	}// while ( numberOfTriangles > targetNumberOfTriangles )
+
+	resultError = static_cast<float>( sqrt( worstErrorSquared ) );
+	return;
+}
+
+//static
+const float* CMeshSimplifier::m_GetPosition( const float* pPositions, unsigned int positionStrideInBytes, unsigned int vertex )
+{
+	return reinterpret_cast<const float*>( reinterpret_cast<const char*>( pPositions ) + vertex * positionStrideInBytes );
+}
+
+//static
+void CMeshSimplifier::m_AddPlane( sQuadric &quadric, double nx, double ny, double nz, double d, double weight )
+{
+	quadric.a00 += weight * nx * nx;
+	quadric.a11 += weight * ny * ny;
+	quadric.a22 += weight * nz * nz;
+	quadric.a01 += weight * nx * ny;
+	quadric.a02 += weight * nx * nz;
+	quadric.a12 += weight * ny * nz;
+	quadric.b0 += weight * nx * d;
+	quadric.b1 += weight * ny * d;
+	quadric.b2 += weight * nz * d;
+	quadric.c += weight * d * d;
+	quadric.weight += weight;
+	return;
+}
+
+//static
+void CMeshSimplifier::m_AddQuadric( sQuadric &quadric, const sQuadric &other )
+{
+	quadric.a00 += other.a00;	quadric.a11 += other.a11;	quadric.a22 += other.a22;
+	quadric.a01 += other.a01;	quadric.a02 += other.a02;	quadric.a12 += other.a12;
+	quadric.b0 += other.b0;		quadric.b1 += other.b1;		quadric.b2 += other.b2;
+	quadric.c += other.c;
+	quadric.weight += other.weight;
+	return;
+}
+
+//static
+double CMeshSimplifier::m_EvaluateQuadric( const sQuadric &quadric, const float* pXYZ )
+{
+	if ( quadric.weight <= 0.0 )
+	{
+		return 0.0;
+	}
+	double x = pXYZ[0];
+	double y = pXYZ[1];
+	double z = pXYZ[2];
+	double result = quadric.a00 * x * x + quadric.a11 * y * y + quadric.a22 * z * z
+	              + 2.0 * ( quadric.a01 * x * y + quadric.a02 * x * z + quadric.a12 * y * z )
+	              + 2.0 * ( quadric.b0 * x + quadric.b1 * y + quadric.b2 * z )
+	              + quadric.c;
+	// (it can end up a tiny bit negative, from rounding)
+	return fabs( result ) / quadric.weight;
+}
+
+//static
+void CMeshSimplifier::m_BuildAdjacency( const std::vector<unsigned int> &vecIndices, unsigned int numberOfVertices,
+                                        std::vector<unsigned int> &vecAdjacencyStart, std::vector<unsigned int> &vecAdjacency )
+{
+	vecAdjacencyStart.assign( numberOfVertices + 1, 0 );
+	for ( std::vector<unsigned int>::const_iterator itIndex = vecIndices.begin(); itIndex != vecIndices.end(); itIndex++ )
+	{
+		vecAdjacencyStart[ *itIndex + 1 ]++;
+	}
+	for ( unsigned int vertex = 0; vertex != numberOfVertices; vertex++ )
+	{
+		vecAdjacencyStart[vertex + 1] += vecAdjacencyStart[vertex];
+	}
+	vecAdjacency.resize( vecIndices.size() );
+	std::vector<unsigned int> vecNextAdjacency( vecAdjacencyStart.begin(), vecAdjacencyStart.end() - 1 );
+	for ( unsigned int index = 0; index != static_cast<unsigned int>( vecIndices.size() ); index++ )
+	{
+		vecAdjacency[ vecNextAdjacency[ vecIndices[index] ]++ ] = index / 3;
+	}
+	return;
+}
+
+//static
+bool CMeshSimplifier::m_HasEdge( const std::vector<unsigned int> &vecIndices,
+                                 const std::vector<unsigned int> &vecAdjacencyStart, const std::vector<unsigned int> &vecAdjacency,
+                                 unsigned int fromVertex, unsigned int toVertex )
+{
+	for ( unsigned int adjIndex = vecAdjacencyStart[fromVertex]; adjIndex != vecAdjacencyStart[fromVertex + 1]; adjIndex++ )
+	{
+		const unsigned int* pTriangle = &(vecIndices[ vecAdjacency[adjIndex] * 3 ]);
+		if ( ( ( pTriangle[0] == fromVertex ) && ( pTriangle[1] == toVertex ) ) ||
+			 ( ( pTriangle[1] == fromVertex ) && ( pTriangle[2] == toVertex ) ) ||
+			 ( ( pTriangle[2] == fromVertex ) && ( pTriangle[0] == toVertex ) ) )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//static
+bool CMeshSimplifier::m_bCollapseFlipsTriangle( const std::vector<unsigned int> &vecIndices,
+                                                const std::vector<unsigned int> &vecAdjacencyStart, const std::vector<unsigned int> &vecAdjacency,
+                                                const std::vector<unsigned int> &vecPositionRemap,
+                                                const float* pPositions, unsigned int positionStrideInBytes,
+                                                unsigned int vertex, unsigned int targetVertex, unsigned int &numberOfCollapsedTriangles )
+{
+	numberOfCollapsedTriangles = 0;
+	const float* pNewPosition = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, targetVertex );
+
+	for ( unsigned int adjIndex = vecAdjacencyStart[vertex]; adjIndex != vecAdjacencyStart[vertex + 1]; adjIndex++ )
+	{
+		const unsigned int* pTriangle = &(vecIndices[ vecAdjacency[adjIndex] * 3 ]);
+		if ( ( vecPositionRemap[ pTriangle[0] ] == vecPositionRemap[targetVertex] ) ||
+			 ( vecPositionRemap[ pTriangle[1] ] == vecPositionRemap[targetVertex] ) ||
+			 ( vecPositionRemap[ pTriangle[2] ] == vecPositionRemap[targetVertex] ) )
+		{	// This one goes away
+			numberOfCollapsedTriangles++;
+			continue;
+		}
+		// Rotate it so the vertex that's moving is first
+		unsigned int corner = ( pTriangle[0] == vertex ) ? 0 : ( ( pTriangle[1] == vertex ) ? 1 : 2 );
+		const float* p0 = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, pTriangle[corner] );
+		const float* p1 = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, pTriangle[(corner + 1) % 3] );
+		const float* p2 = CMeshSimplifier::m_GetPosition( pPositions, positionStrideInBytes, pTriangle[(corner + 2) % 3] );
+
+		// Normal now, and after
+		float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		float n0[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		float f1[3] = { p1[0] - pNewPosition[0], p1[1] - pNewPosition[1], p1[2] - pNewPosition[2] };
+		float f2[3] = { p2[0] - pNewPosition[0], p2[1] - pNewPosition[1], p2[2] - pNewPosition[2] };
+		float n1[3] = { f1[1] * f2[2] - f1[2] * f2[1], f1[2] * f2[0] - f1[0] * f2[2], f1[0] * f2[1] - f1[1] * f2[0] };
+
+		if ( ( n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] ) <= 0.0f )
+		{
+			return true;
+		}
+	}
+	return false;
+}
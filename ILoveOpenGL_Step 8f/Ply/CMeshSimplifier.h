@@ -0,0 +1,78 @@
+#ifndef _CMeshSimplifier_HG_
+#define _CMeshSimplifier_HG_
+
+// Makes lower detail versions of an indexed triangle list (for LODs), using the "quadric
+//	error metric" from "Surface Simplification Using Quadric Error Metrics" (Garland and
+//	Heckbert, SIGGRAPH 1997).
+// Each vertex gets a quadric (the sum of the squared distances to the planes of the triangles
+//	around it), then the edges are collapsed, cheapest first, until there are few enough triangles.
+// An edge always collapses onto one of its own vertices (no new vertices are made), so only the
+//	indices change: every level can use the same vertex buffer as the original model.
+// The edges of open models (borders) only collapse along the border, and places where the
+//	same position has two vertices (texture "seams") collapse both sides together, so the
+//	model doesn't crack open. Triangles that would flip over aren't collapsed.
+
+#include <vector>
+
+class CMeshSimplifier
+{
+public:
+	// Borders are "stiffer" than the rest of the model by this much
+	static const float BORDERWEIGHT;
+
+	// vecIndices: 3 per triangle. pPositions is x, y, z of the first vertex; each one after that
+	//	is positionStrideInBytes along.
+	// Stops when there are targetNumberOfTriangles (or fewer), or when the next collapse would
+	//	move the surface more than maxError (in model units), or when there's nothing left it can do.
+	// resultError is (roughly) how far the simplified surface is from the original, in model units.
+	static void SimplifyQEM( const std::vector<unsigned int> &vecIndices,
+	                         const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+	                         unsigned int targetNumberOfTriangles, float maxError,
+	                         std::vector<unsigned int> &vecIndicesOut, float &resultError );
+
+private:
+	// Symmetric 4x4 matrix (stored as the 3x3 part, the vector and the constant), plus the total area
+	struct sQuadric
+	{
+		double a00, a11, a22, a01, a02, a12;
+		double b0, b1, b2;
+		double c;
+		double weight;
+	};
+	// What each vertex is allowed to do
+	enum enumVertexKind
+	{
+		VERTEX_MANIFOLD = 0,	// Inside the model; can collapse onto any neighbour
+		VERTEX_BORDER,			// On an open edge; only along the border
+		VERTEX_SEAM,			// Two vertices, one position; only along the seam (both sides at once)
+		VERTEX_LOCKED			// Anything else (corners, non-manifold bits); never moves
+	};
+	struct sCollapse
+	{
+		unsigned int fromVertex;
+		unsigned int toVertex;
+		float error;
+	};
+
+	static const float* m_GetPosition( const float* pPositions, unsigned int positionStrideInBytes, unsigned int vertex );
+	static void m_AddPlane( sQuadric &quadric, double nx, double ny, double nz, double d, double weight );
+	static void m_AddQuadric( sQuadric &quadric, const sQuadric &other );
+	// Squared distance (weighted average over the planes)
+	static double m_EvaluateQuadric( const sQuadric &quadric, const float* pXYZ );
+	// Which triangles use each vertex (vertex N's are from vecAdjacencyStart[N] to vecAdjacencyStart[N+1])
+	static void m_BuildAdjacency( const std::vector<unsigned int> &vecIndices, unsigned int numberOfVertices,
+	                              std::vector<unsigned int> &vecAdjacencyStart, std::vector<unsigned int> &vecAdjacency );
+	// Is there a triangle with the edge fromVertex -> toVertex (in that winding order)?
+	static bool m_HasEdge( const std::vector<unsigned int> &vecIndices,
+	                       const std::vector<unsigned int> &vecAdjacencyStart, const std::vector<unsigned int> &vecAdjacency,
+	                       unsigned int fromVertex, unsigned int toVertex );
+	// Would moving vertex to newPosition turn any of its triangles over? (ignores the ones that will disappear)
+	// numberOfCollapsedTriangles gets how many of them would disappear
+	static bool m_bCollapseFlipsTriangle( const std::vector<unsigned int> &vecIndices,
+	                                      const std::vector<unsigned int> &vecAdjacencyStart, const std::vector<unsigned int> &vecAdjacency,
+	                                      const std::vector<unsigned int> &vecPositionRemap,
+	                                      const float* pPositions, unsigned int positionStrideInBytes,
+	                                      unsigned int vertex, unsigned int targetVertex, unsigned int &numberOfCollapsedTriangles );
+};
+
+#endif
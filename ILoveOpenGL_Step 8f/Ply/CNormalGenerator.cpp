@@ -0,0 +1,325 @@
+#include "CNormalGenerator.h"
+
+#include <math.h>
+#include <emmintrin.h>	// SSE2
+#include "../CThreadPool.h"
+
+// atan2( y, x ) of 4 at once, for y >= 0 (so the answer is 0 to pi). Good to about 0.00001 radians,
+//	which is plenty for a weight. (0, 0) gives 0.
+static inline __m128 ATan2PositiveY_SSE( __m128 y, __m128 x )
+{
+	const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7FFFFFFF ) );
+	const __m128 zero = _mm_setzero_ps();
+	__m128 absX = _mm_and_ps( x, absMask );
+	__m128 bigger = _mm_max_ps( absX, y );
+	__m128 smaller = _mm_min_ps( absX, y );
+	// a = smaller / bigger is 0 to 1, so the polynomial only has to cover 0 to pi/4
+	__m128 a = _mm_and_ps( _mm_div_ps( smaller, bigger ), _mm_cmpgt_ps( bigger, zero ) );
+	__m128 s = _mm_mul_ps( a, a );
+	__m128 r = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( -0.0464964749f ), s ), _mm_set1_ps( 0.15931422f ) );
+	r = _mm_sub_ps( _mm_mul_ps( r, s ), _mm_set1_ps( 0.327622764f ) );
+	r = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( r, s ), a ), a );
+	// Past 45 degrees?
+	__m128 bYIsBigger = _mm_cmpgt_ps( y, absX );
+	r = _mm_or_ps( _mm_and_ps( bYIsBigger, _mm_sub_ps( _mm_set1_ps( 1.57079637f ), r ) ), _mm_andnot_ps( bYIsBigger, r ) );
+	// Past 90 degrees?
+	__m128 bXIsNegative = _mm_cmplt_ps( x, zero );
+	r = _mm_or_ps( _mm_and_ps( bXIsNegative, _mm_sub_ps( _mm_set1_ps( 3.14159274f ), r ) ), _mm_andnot_ps( bXIsNegative, r ) );
+	return r;
+}
+
+static inline const float* PositionAt( const float* pPositions, unsigned int positionStrideInBytes, unsigned int vertex )
+{
+	return reinterpret_cast<const float*>( reinterpret_cast<const char*>( pPositions ) + static_cast<size_t>( vertex ) * positionStrideInBytes );
+}
+
+static inline float* NormalAt( float* pNormals, unsigned int normalStrideInBytes, unsigned int vertex )
+{
+	return reinterpret_cast<float*>( reinterpret_cast<char*>( pNormals ) + static_cast<size_t>( vertex ) * normalStrideInBytes );
+}
+
+static inline const unsigned int* TriangleAt( const unsigned int* pIndices, unsigned int triangleStrideInBytes, unsigned int triangle )
+{
+	return reinterpret_cast<const unsigned int*>( reinterpret_cast<const char*>( pIndices ) + static_cast<size_t>( triangle ) * triangleStrideInBytes );
+}
+
+//static
+void CNormalGenerator::GenerateNormals( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+                                        const unsigned int* pIndices, unsigned int triangleStrideInBytes, unsigned int numberOfTriangles,
+                                        enumWeighting weighting,
+                                        float* pNormals, unsigned int normalStrideInBytes )
+{
+	if ( numberOfVertices == 0 )
+	{
+		return;
+	}
+	CThreadPool* pThreadPool = CThreadPool::getSharedInstance();
+
+	// 1. Face normals
+	std::vector<float> vecFaceX( numberOfTriangles + 1 );		// (+1 so &vec[0] is OK if there aren't any)
+	std::vector<float> vecFaceY( numberOfTriangles + 1 );
+	std::vector<float> vecFaceZ( numberOfTriangles + 1 );
+	std::vector<float> vecCornerWeights( ( weighting == WEIGHT_BY_ANGLE ) ? numberOfTriangles * 3 + 1 : 1 );
+	const unsigned int numberOfTriangleBlocks = ( numberOfTriangles + CNormalGenerator::PARALLELBLOCKSIZE - 1 ) / CNormalGenerator::PARALLELBLOCKSIZE;
+	auto faceNormalJob = [&]( unsigned int blockIndex )
+	{
+		unsigned int firstTriangle = blockIndex * CNormalGenerator::PARALLELBLOCKSIZE;
+		unsigned int lastTriangle = firstTriangle + CNormalGenerator::PARALLELBLOCKSIZE;
+		if ( lastTriangle > numberOfTriangles )
+		{
+			lastTriangle = numberOfTriangles;
+		}
+		CNormalGenerator::m_CalculateFaceNormals( pPositions, positionStrideInBytes, numberOfVertices, pIndices, triangleStrideInBytes,
+		                                          firstTriangle, lastTriangle, weighting,
+		                                          &(vecFaceX[0]), &(vecFaceY[0]), &(vecFaceZ[0]), &(vecCornerWeights[0]) );
+	};
+	if ( numberOfTriangleBlocks > 1 )
+	{
+		pThreadPool->ParallelFor( numberOfTriangleBlocks, faceNormalJob );
+	}
+	else if ( numberOfTriangleBlocks == 1 )
+	{
+		faceNormalJob( 0 );
+	}
+
+	// 2. Which corners use each vertex (vertex N's are from vecCornerStart[N] to vecCornerStart[N+1])
+	// (Filled in in triangle order, so each vertex adds up its triangles in the same order as the old, serial way)
+	// (corner is triangle * 3 + which one)
+	std::vector<unsigned int> vecCornerStart( numberOfVertices + 1, 0 );
+	for ( unsigned int triangle = 0; triangle != numberOfTriangles; triangle++ )
+	{
+		const unsigned int* pTriangle = TriangleAt( pIndices, triangleStrideInBytes, triangle );
+		for ( unsigned int which = 0; which != 3; which++ )
+		{
+			if ( pTriangle[which] < numberOfVertices )
+			{
+				vecCornerStart[ pTriangle[which] + 1 ]++;
+			}
+		}
+	}
+	for ( unsigned int vertex = 0; vertex != numberOfVertices; vertex++ )
+	{
+		vecCornerStart[vertex + 1] += vecCornerStart[vertex];
+	}
+	std::vector<unsigned int> vecCorners( vecCornerStart[numberOfVertices] + 1 );
+	{
+		std::vector<unsigned int> vecNextCorner( vecCornerStart.begin(), vecCornerStart.end() - 1 );
+		for ( unsigned int triangle = 0; triangle != numberOfTriangles; triangle++ )
+		{
+			const unsigned int* pTriangle = TriangleAt( pIndices, triangleStrideInBytes, triangle );
+			for ( unsigned int which = 0; which != 3; which++ )
+			{
+				if ( pTriangle[which] < numberOfVertices )
+				{
+					vecCorners[ vecNextCorner[ pTriangle[which] ]++ ] = triangle * 3 + which;
+				}
+			}
+		}
+	}
+
+	// 3. Each vertex adds up its own triangles (so no two threads write to the same one)
+	const unsigned int numberOfVertexBlocks = ( numberOfVertices + CNormalGenerator::PARALLELBLOCKSIZE - 1 ) / CNormalGenerator::PARALLELBLOCKSIZE;
+	auto vertexNormalJob = [&]( unsigned int blockIndex )
+	{
+		unsigned int firstVertex = blockIndex * CNormalGenerator::PARALLELBLOCKSIZE;
+		unsigned int lastVertex = firstVertex + CNormalGenerator::PARALLELBLOCKSIZE;
+		if ( lastVertex > numberOfVertices )
+		{
+			lastVertex = numberOfVertices;
+		}
+		for ( unsigned int vertex = firstVertex; vertex != lastVertex; vertex++ )
+		{
+			float nx = 0.0f;
+			float ny = 0.0f;
+			float nz = 0.0f;
+			for ( unsigned int cornerIndex = vecCornerStart[vertex]; cornerIndex != vecCornerStart[vertex + 1]; cornerIndex++ )
+			{
+				unsigned int corner = vecCorners[cornerIndex];
+				unsigned int triangle = corner / 3;
+				if ( weighting == WEIGHT_BY_ANGLE )
+				{
+					float weight = vecCornerWeights[corner];
+					nx += vecFaceX[triangle] * weight;
+					ny += vecFaceY[triangle] * weight;
+					nz += vecFaceZ[triangle] * weight;
+				}
+				else
+				{
+					nx += vecFaceX[triangle];
+					ny += vecFaceY[triangle];
+					nz += vecFaceZ[triangle];
+				}
+			}
+			float length = sqrtf( nx * nx + ny * ny + nz * nz );
+			float oneOverLength = ( length > 0.0f ) ? 1.0f / length : 0.0f;
+			float* pNormal = NormalAt( pNormals, normalStrideInBytes, vertex );
+			pNormal[0] = nx * oneOverLength;
+			pNormal[1] = ny * oneOverLength;
+			pNormal[2] = nz * oneOverLength;
+		}
+	};
+	if ( numberOfVertexBlocks > 1 )
+	{
+		pThreadPool->ParallelFor( numberOfVertexBlocks, vertexNormalJob );
+	}
+	else
+	{
+		vertexNormalJob( 0 );
+	}
+	return;
+}
+
+//static
+void CNormalGenerator::m_CalculateFaceNormals( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+                                               const unsigned int* pIndices, unsigned int triangleStrideInBytes,
+                                               unsigned int firstTriangle, unsigned int lastTriangle, enumWeighting weighting,
+                                               float* pFaceX, float* pFaceY, float* pFaceZ, float* pCornerWeights )
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps( 1.0f );
+
+	unsigned int triangle = firstTriangle;
+	for ( ; ( triangle + 4 ) <= lastTriangle; triangle += 4 )
+	{
+		const unsigned int* pTri[4];
+		bool bAllIndicesOK = true;
+		for ( unsigned int lane = 0; lane != 4; lane++ )
+		{
+			pTri[lane] = TriangleAt( pIndices, triangleStrideInBytes, triangle + lane );
+			if ( ( pTri[lane][0] >= numberOfVertices ) || ( pTri[lane][1] >= numberOfVertices ) || ( pTri[lane][2] >= numberOfVertices ) )
+			{
+				bAllIndicesOK = false;
+			}
+		}
+		if ( !bAllIndicesOK )
+		{	// (very rare, so not worth doing in SSE)
+			for ( unsigned int oneTriangle = triangle; oneTriangle != triangle + 4; oneTriangle++ )
+			{
+				CNormalGenerator::m_CalculateOneFaceNormal( pPositions, positionStrideInBytes, numberOfVertices, pIndices, triangleStrideInBytes,
+				                                            oneTriangle, weighting, pFaceX, pFaceY, pFaceZ, pCornerWeights );
+			}
+			continue;
+		}
+
+		// Corner A, B and C of 4 triangles at once (note: _mm_set_ps() goes from the last one to the first)
+		const float* pA[4];	const float* pB[4];	const float* pC[4];
+		for ( unsigned int lane = 0; lane != 4; lane++ )
+		{
+			pA[lane] = PositionAt( pPositions, positionStrideInBytes, pTri[lane][0] );
+			pB[lane] = PositionAt( pPositions, positionStrideInBytes, pTri[lane][1] );
+			pC[lane] = PositionAt( pPositions, positionStrideInBytes, pTri[lane][2] );
+		}
+		__m128 ax = _mm_set_ps( pA[3][0], pA[2][0], pA[1][0], pA[0][0] );
+		__m128 ay = _mm_set_ps( pA[3][1], pA[2][1], pA[1][1], pA[0][1] );
+		__m128 az = _mm_set_ps( pA[3][2], pA[2][2], pA[1][2], pA[0][2] );
+		__m128 bx = _mm_set_ps( pB[3][0], pB[2][0], pB[1][0], pB[0][0] );
+		__m128 by = _mm_set_ps( pB[3][1], pB[2][1], pB[1][1], pB[0][1] );
+		__m128 bz = _mm_set_ps( pB[3][2], pB[2][2], pB[1][2], pB[0][2] );
+		__m128 cx = _mm_set_ps( pC[3][0], pC[2][0], pC[1][0], pC[0][0] );
+		__m128 cy = _mm_set_ps( pC[3][1], pC[2][1], pC[1][1], pC[0][1] );
+		__m128 cz = _mm_set_ps( pC[3][2], pC[2][2], pC[1][2], pC[0][2] );
+
+		// AB x AC (the same as the old AB x BC)
+		__m128 e1x = _mm_sub_ps( bx, ax );
+		__m128 e1y = _mm_sub_ps( by, ay );
+		__m128 e1z = _mm_sub_ps( bz, az );
+		__m128 e2x = _mm_sub_ps( cx, ax );
+		__m128 e2y = _mm_sub_ps( cy, ay );
+		__m128 e2z = _mm_sub_ps( cz, az );
+		__m128 nx = _mm_sub_ps( _mm_mul_ps( e1y, e2z ), _mm_mul_ps( e1z, e2y ) );
+		__m128 ny = _mm_sub_ps( _mm_mul_ps( e1z, e2x ), _mm_mul_ps( e1x, e2z ) );
+		__m128 nz = _mm_sub_ps( _mm_mul_ps( e1x, e2y ), _mm_mul_ps( e1y, e2x ) );
+		// The length is twice the area
+		__m128 length = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, nx ), _mm_mul_ps( ny, ny ) ), _mm_mul_ps( nz, nz ) ) );
+
+		if ( weighting != WEIGHT_BY_AREA )
+		{	// Normalize (zero length ones stay zero)
+			__m128 oneOverLength = _mm_and_ps( _mm_div_ps( one, length ), _mm_cmpgt_ps( length, zero ) );
+			nx = _mm_mul_ps( nx, oneOverLength );
+			ny = _mm_mul_ps( ny, oneOverLength );
+			nz = _mm_mul_ps( nz, oneOverLength );
+		}
+		_mm_storeu_ps( &(pFaceX[triangle]), nx );
+		_mm_storeu_ps( &(pFaceY[triangle]), ny );
+		_mm_storeu_ps( &(pFaceZ[triangle]), nz );
+
+		if ( weighting == WEIGHT_BY_ANGLE )
+		{	// angle = atan2( |u x v|, u . v ), and |u x v| is the same at every corner (twice the area)
+			// A: AB . AC    B: BC . BA = (AC - AB) . -AB    C: CA . CB = -AC . (AB - AC)
+			__m128 dotA = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e1x, e2x ), _mm_mul_ps( e1y, e2y ) ), _mm_mul_ps( e1z, e2z ) );
+			__m128 e1DotE1 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e1x, e1x ), _mm_mul_ps( e1y, e1y ) ), _mm_mul_ps( e1z, e1z ) );
+			__m128 e2DotE2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e2x, e2x ), _mm_mul_ps( e2y, e2y ) ), _mm_mul_ps( e2z, e2z ) );
+			__m128 dotB = _mm_sub_ps( e1DotE1, dotA );
+			__m128 dotC = _mm_sub_ps( e2DotE2, dotA );
+			float anglesA[4];	float anglesB[4];	float anglesC[4];
+			_mm_storeu_ps( anglesA, ATan2PositiveY_SSE( length, dotA ) );
+			_mm_storeu_ps( anglesB, ATan2PositiveY_SSE( length, dotB ) );
+			_mm_storeu_ps( anglesC, ATan2PositiveY_SSE( length, dotC ) );
+			for ( unsigned int lane = 0; lane != 4; lane++ )
+			{
+				pCornerWeights[ ( triangle + lane ) * 3 + 0 ] = anglesA[lane];
+				pCornerWeights[ ( triangle + lane ) * 3 + 1 ] = anglesB[lane];
+				pCornerWeights[ ( triangle + lane ) * 3 + 2 ] = anglesC[lane];
+			}
+		}
+	}// for ( ; ( triangle + 4 ) <= lastTriangle...
+
+	// The last few
+	for ( ; triangle < lastTriangle; triangle++ )
+	{
+		CNormalGenerator::m_CalculateOneFaceNormal( pPositions, positionStrideInBytes, numberOfVertices, pIndices, triangleStrideInBytes,
+		                                            triangle, weighting, pFaceX, pFaceY, pFaceZ, pCornerWeights );
+	}
+	return;
+}
+
+//static
+void CNormalGenerator::m_CalculateOneFaceNormal( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+                                                 const unsigned int* pIndices, unsigned int triangleStrideInBytes,
+                                                 unsigned int triangle, enumWeighting weighting,
+                                                 float* pFaceX, float* pFaceY, float* pFaceZ, float* pCornerWeights )
+{
+	const unsigned int* pTriangle = TriangleAt( pIndices, triangleStrideInBytes, triangle );
+	unsigned int a = pTriangle[0];
+	unsigned int b = pTriangle[1];
+	unsigned int c = pTriangle[2];
+	if ( ( a >= numberOfVertices ) || ( b >= numberOfVertices ) || ( c >= numberOfVertices ) )
+	{	// Doesn't count
+		pFaceX[triangle] = pFaceY[triangle] = pFaceZ[triangle] = 0.0f;
+		if ( weighting == WEIGHT_BY_ANGLE )
+		{
+			pCornerWeights[triangle * 3 + 0] = pCornerWeights[triangle * 3 + 1] = pCornerWeights[triangle * 3 + 2] = 0.0f;
+		}
+		return;
+	}
+	const float* pA = PositionAt( pPositions, positionStrideInBytes, a );
+	const float* pB = PositionAt( pPositions, positionStrideInBytes, b );
+	const float* pC = PositionAt( pPositions, positionStrideInBytes, c );
+	float e1x = pB[0] - pA[0];	float e1y = pB[1] - pA[1];	float e1z = pB[2] - pA[2];
+	float e2x = pC[0] - pA[0];	float e2y = pC[1] - pA[1];	float e2z = pC[2] - pA[2];
+	float nx = e1y * e2z - e1z * e2y;
+	float ny = e1z * e2x - e1x * e2z;
+	float nz = e1x * e2y - e1y * e2x;
+	float length = sqrtf( nx * nx + ny * ny + nz * nz );
+	if ( weighting != WEIGHT_BY_AREA )
+	{
+		float oneOverLength = ( length > 0.0f ) ? 1.0f / length : 0.0f;
+		nx *= oneOverLength;
+		ny *= oneOverLength;
+		nz *= oneOverLength;
+	}
+	pFaceX[triangle] = nx;
+	pFaceY[triangle] = ny;
+	pFaceZ[triangle] = nz;
+
+	if ( weighting == WEIGHT_BY_ANGLE )
+	{
+		float dotA = e1x * e2x + e1y * e2y + e1z * e2z;
+		float dotB = ( e1x * e1x + e1y * e1y + e1z * e1z ) - dotA;
+		float dotC = ( e2x * e2x + e2y * e2y + e2z * e2z ) - dotA;
+		pCornerWeights[triangle * 3 + 0] = atan2f( length, dotA );
+		pCornerWeights[triangle * 3 + 1] = atan2f( length, dotB );
+		pCornerWeights[triangle * 3 + 2] = atan2f( length, dotC );
+	}
+	return;
+}
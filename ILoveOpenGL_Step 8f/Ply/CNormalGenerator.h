@@ -0,0 +1,54 @@
+#ifndef _CNormalGenerator_HG_
+#define _CNormalGenerator_HG_
+
+// Works out the vertex normals of an indexed triangle list (for models that don't have any).
+// Like CPositionKernels, everything is a pointer to the first one and a stride in bytes, so it works
+//	right on the model's own streams, a vector of PlyVertex, or a vertex buffer (without copying):
+//	- the positions are x, y, z; the normals are written as nx, ny, nz (nothing else is changed)
+//	- each triangle is 3 indices in a row; the next triangle is triangleStrideInBytes along
+// The face normals are done 4 triangles at a time with SSE.
+// It's done in two steps, both split up on the shared CThreadPool:
+//	1. The face normals (and the corner angles, for WEIGHT_BY_ANGLE), one per triangle.
+//	2. Each vertex adds up the normals of the triangles around it (found with a "compressed row"
+//	   list of the corners that use each vertex). Each vertex is only written by one thread,
+//	   so there's no locking, and it's always added up in the same order (same answer every time).
+
+#include <vector>
+
+class CNormalGenerator
+{
+public:
+	enum enumWeighting
+	{
+		WEIGHT_EQUAL = 0,		// Each triangle counts the same (what normalizeTheModelBaby() always did)
+		WEIGHT_BY_AREA,			// Big triangles count more. Cheapest.
+		WEIGHT_BY_ANGLE			// By the angle of the triangle at that vertex. Doesn't care how the
+								//	surface is cut up into triangles, so it's the best for scans.
+	};
+
+	// Each job does this many triangles (or vertices). Smaller models don't bother with the threads.
+	static const unsigned int PARALLELBLOCKSIZE = 16384;
+
+	// Triangles with an index past the last vertex are ignored (so signed indices can be passed
+	//	as they are: the negative ones look like big ones).
+	// The normals come out normalized. Vertices that no triangle uses get (0, 0, 0).
+	static void GenerateNormals( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+	                             const unsigned int* pIndices, unsigned int triangleStrideInBytes, unsigned int numberOfTriangles,
+	                             enumWeighting weighting,
+	                             float* pNormals, unsigned int normalStrideInBytes );
+
+private:
+	// Face normals for triangles firstTriangle to lastTriangle - 1 (SSE, then the last few one at a time)
+	// The length of the normal is twice the area for WEIGHT_BY_AREA, 1.0 for the others.
+	// pCornerWeights (3 per triangle) is only filled in for WEIGHT_BY_ANGLE.
+	static void m_CalculateFaceNormals( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+	                                    const unsigned int* pIndices, unsigned int triangleStrideInBytes,
+	                                    unsigned int firstTriangle, unsigned int lastTriangle, enumWeighting weighting,
+	                                    float* pFaceX, float* pFaceY, float* pFaceZ, float* pCornerWeights );
+	static void m_CalculateOneFaceNormal( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+	                                      const unsigned int* pIndices, unsigned int triangleStrideInBytes,
+	                                      unsigned int triangle, enumWeighting weighting,
+	                                      float* pFaceX, float* pFaceY, float* pFaceZ, float* pCornerWeights );
+};
+
+#endif
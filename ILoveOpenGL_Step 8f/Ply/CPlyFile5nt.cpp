@@ -5,6 +5,8 @@
 // Use this code at your own risk. It is indented only as a learning aid.
 //
 #include "CPlyFile5nt.h"
+#include "CMeshOptimizer.h"
+#include "CPositionKernels.h"
 
 #include "../CHRTimer.h"
 
@@ -21,6 +23,8 @@
 #include <sstream>
 #include <math.h>
 #include <algorithm>
+#include <string.h>		// for memcpy()
+#include <stdexcept>		// for std::out_of_range
 
 // Written by Michael Feeney, Fanshawe College, 2009
 // mfeeney@fanshawec.ca
@@ -47,6 +51,7 @@ CPlyFile5nt::CPlyFile5nt()
 	this->m_b_ScaleRGBA_OneByteValuesToFloatZeroToOne = true;
 	float m_minRoundToZero = CDataReader::DEFAULTROUNDSMALLFLOATTOZEROVALUE;
 	this->m_bNewRoundToZeroFlag = true; 
+	this->m_bParallelASCIIParsing = false;
 
 	//
 	//this->m_numberOfVertices = 0;
@@ -85,7 +90,7 @@ CPlyFile5nt::~CPlyFile5nt()
 
 CPlyFile5nt::CPlyFile5nt( const CPlyFile5nt &rhs )	// Copy constructor
 {
-	this->m_verticies = rhs.m_verticies;
+	this->m_vertexStreams = rhs.m_vertexStreams;
 	this->m_elements = rhs.m_elements;
 
 	this->m_minX = rhs.m_minX;
@@ -108,6 +113,7 @@ CPlyFile5nt::CPlyFile5nt( const CPlyFile5nt &rhs )	// Copy constructor
 
 	// Added: November 2, 2014
 	this->m_PlyHeaderInfo = rhs.m_PlyHeaderInfo;
+	this->m_bParallelASCIIParsing = rhs.m_bParallelASCIIParsing;
 
 
 	//this->m_totalProperties = rhs.m_totalProperties;
@@ -136,7 +142,7 @@ CPlyFile5nt& CPlyFile5nt::operator=( const CPlyFile5nt &rhs )
 	// Check for self-assignment *IMPORTANT*
 	if ( this == &rhs )	return *this;
 	// Else...copy values
-	this->m_verticies = rhs.m_verticies;
+	this->m_vertexStreams = rhs.m_vertexStreams;
 	this->m_elements = rhs.m_elements;
 
 	this->m_minX = rhs.m_minX;
@@ -162,6 +168,8 @@ CPlyFile5nt& CPlyFile5nt::operator=( const CPlyFile5nt &rhs )
 	// Added: June 8, 2015
 	this->m_maxExtent = rhs.m_maxExtent;
 
+	this->m_bParallelASCIIParsing = rhs.m_bParallelASCIIParsing;
+
 
 	//this->m_totalProperties = rhs.m_totalProperties;
 	//this->m_x_propertyIndex = rhs.m_x_propertyIndex;
@@ -388,6 +396,8 @@ bool CPlyFile5nt::OpenPLYFile(std::wstring fileName, std::wstring &error)
 		//... a bunch of vertices...
 		//-0.0312216 0.126304 0.00514924 0.850855 0.5 
 
+		this->m_AddVertexStreamsFromHeader();
+		this->m_vertexStreams.reserve( this->m_vertexStreams.size() + this->m_PlyHeaderInfo.numberOfVertices );
 		for (int vertexCount = 0; vertexCount != this->m_PlyHeaderInfo.numberOfVertices; vertexCount++)
 		{
 			PlyVertex tempVertex;
@@ -430,7 +440,7 @@ bool CPlyFile5nt::OpenPLYFile(std::wstring fileName, std::wstring &error)
 			//if ( this->m_deltaY > this->m_maxExtent )	this->m_maxExtent = this->m_deltaY;
 			//if ( this->m_deltaZ > this->m_maxExtent )	this->m_maxExtent = this->m_deltaZ;
 
-			this->m_verticies.push_back(tempVertex);
+			this->m_vertexStreams.push_back(tempVertex);
 		}
 
 		timer.UpdateLongDuration();
@@ -499,28 +509,46 @@ bool CPlyFile5nt::GetScaleRGBA_OneByteValuesToFloatZeroToOne(void)
 	return this->m_b_ScaleRGBA_OneByteValuesToFloatZeroToOne;
 }
 
+void CPlyFile5nt::SetParallelASCIIParsing(bool bEnabled)
+{
+	this->m_bParallelASCIIParsing = bEnabled;
+	return;
+}
+
+bool CPlyFile5nt::GetParallelASCIIParsing(void)
+{
+	return this->m_bParallelASCIIParsing;
+}
+
 void CPlyFile5nt::scaleVertices( float scaleFactor )
 {
-	std::vector<PlyVertex>::iterator itVertex = this->m_verticies.begin();
-	for ( ; itVertex != this->m_verticies.end(); itVertex++ )
-	{
-		itVertex->xyz.x *= scaleFactor;
-		itVertex->xyz.y *= scaleFactor;
-		itVertex->xyz.z *= scaleFactor;
-	}
-	this->calcualteExtents();
+	this->Scale( scaleFactor );
 	return;
 }
 
 void CPlyFile5nt::calcualteExtents(void)
 {
-	this->m_minX = this->m_verticies.begin()->xyz.x;
-	this->m_maxX = this->m_verticies.begin()->xyz.x;		// Fixed
-	this->m_minY = this->m_verticies.begin()->xyz.y;
-	this->m_maxY = this->m_verticies.begin()->xyz.y;
-	this->m_minZ = this->m_verticies.begin()->xyz.z;
-	this->m_maxZ = this->m_verticies.begin()->xyz.z;
+	if ( this->m_vertexStreams.empty() )
+	{
+		this->m_minX = this->m_maxX = this->m_minY = this->m_maxY = this->m_minZ = this->m_maxZ = 0.0f;
+		this->m_updateDeltasAndCentre();
+		return;
+	}
+	// Updated: One pass with CPositionKernels (SSE), then the deltas, etc. once at the end
+	float minXYZ[3];
+	float maxXYZ[3];
+	CPositionKernels::CalculateMinMax( this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_POSITION ), 3 * sizeof(float), this->m_vertexStreams.size(),
+	                                   minXYZ, maxXYZ );
+	this->m_minX = minXYZ[0];	this->m_maxX = maxXYZ[0];
+	this->m_minY = minXYZ[1];	this->m_maxY = maxXYZ[1];
+	this->m_minZ = minXYZ[2];	this->m_maxZ = maxXYZ[2];
+	this->m_updateDeltasAndCentre();
+	return;
+}
 
+// Added
+void CPlyFile5nt::m_updateDeltasAndCentre(void)
+{
 	this->m_deltaX = this->m_maxX - this->m_minX;
 	this->m_deltaY = this->m_maxY - this->m_minY;
 	this->m_deltaZ = this->m_maxZ - this->m_minZ;
@@ -529,27 +557,53 @@ void CPlyFile5nt::calcualteExtents(void)
 	if ( this->m_deltaY > this->m_maxExtent )	this->m_maxExtent = this->m_deltaY;
 	if ( this->m_deltaZ > this->m_maxExtent )	this->m_maxExtent = this->m_deltaZ;
 
-	std::vector<PlyVertex>::iterator itVertex = this->m_verticies.begin();
-	for ( ; itVertex != this->m_verticies.end(); itVertex++ )
+	// Centre of the bounding box
+	this->m_centreX = ( this->m_minX + this->m_maxX ) * 0.5f;
+	this->m_centreY = ( this->m_minY + this->m_maxY ) * 0.5f;
+	this->m_centreZ = ( this->m_minZ + this->m_maxZ ) * 0.5f;
+	return;
+}
+
+// Added
+void CPlyFile5nt::m_scaleAndTranslate( float scaleX, float scaleY, float scaleZ, CVector3f trans )
+{
+	if ( this->m_vertexStreams.empty() )
 	{
-		// Check bounding box limits...
-		if ( itVertex->xyz.x < this->m_minX )	this->m_minX = itVertex->xyz.x;
-		if ( itVertex->xyz.x > this->m_maxX )	this->m_maxX = itVertex->xyz.x;
-		if ( itVertex->xyz.y < this->m_minY )	this->m_minY = itVertex->xyz.y;
-		if ( itVertex->xyz.y > this->m_maxY )	this->m_maxY = itVertex->xyz.y;
-		if ( itVertex->xyz.z < this->m_minZ )	this->m_minZ = itVertex->xyz.z;
-		if ( itVertex->xyz.z > this->m_maxZ )	this->m_maxZ = itVertex->xyz.z;
-		this->m_deltaX = this->m_maxX - this->m_minX;
-		this->m_deltaY = this->m_maxY - this->m_minY;
-		this->m_deltaZ = this->m_maxZ - this->m_minZ;
-		// 
-		if ( this->m_deltaX > this->m_maxExtent )	this->m_maxExtent = this->m_deltaX;
-		if ( this->m_deltaY > this->m_maxExtent )	this->m_maxExtent = this->m_deltaY;
-		if ( this->m_deltaZ > this->m_maxExtent )	this->m_maxExtent = this->m_deltaZ;
+		return;
+	}
+	const float scaleXYZ[3] = { scaleX, scaleY, scaleZ };
+	const float translateXYZ[3] = { trans.x, trans.y, trans.z };
+	CPositionKernels::ScaleAndTranslate( this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_POSITION ), 3 * sizeof(float), this->m_vertexStreams.size(),
+	                                     scaleXYZ, translateXYZ );
+	// The extents move the same way (exactly, since rounding doesn't change which one is smallest), 
+	//	so there's no need to go through all the vertices again.
+	float* pMin[3] = { &(this->m_minX), &(this->m_minY), &(this->m_minZ) };
+	float* pMax[3] = { &(this->m_maxX), &(this->m_maxY), &(this->m_maxZ) };
+	for ( int axis = 0; axis != 3; axis++ )
+	{
+		float newMin = *(pMin[axis]) * scaleXYZ[axis] + translateXYZ[axis];
+		float newMax = *(pMax[axis]) * scaleXYZ[axis] + translateXYZ[axis];
+		*(pMin[axis]) = ( newMin < newMax ) ? newMin : newMax;
+		*(pMax[axis]) = ( newMin < newMax ) ? newMax : newMin;
 	}
+	this->m_updateDeltasAndCentre();
 	return;
 }
 
+// Added
+bool CPlyFile5nt::CalculateBoundingSphere( CVector3f &centre, float &radius )
+{
+	if ( this->m_vertexStreams.empty() )
+	{
+		return false;
+	}
+	float centreXYZ[3];
+	CPositionKernels::CalculateBoundingSphere( this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_POSITION ), 3 * sizeof(float), this->m_vertexStreams.size(),
+	                                           centreXYZ, radius );
+	centre = CVector3f( centreXYZ[0], centreXYZ[1], centreXYZ[2] );
+	return true;
+}
+
 
 void NormalizeVector(float &x, float &y, float &z)
 {
@@ -605,77 +659,36 @@ void CrossProduct(float &x0, float &y0, float &z0,
 //                                                                                       |__/ 
 void CPlyFile5nt::normalizeTheModelBaby(void)
 {
-	// The first part of this is the same as the 'rock-n-roll' versions,
-	//	but instead of just overwriting the vertices at each face, the
-	//	normalized normal is ADDED to the existing normal at that face.
-	// Once we are all done, we go through each vertex an normalize them.
-	// What this effectively does is get the AVERAGE of all the normals 
-	//	of the faces around each vertes.
+	// The normal at each vertex is the AVERAGE of all the normals 
+	//	of the faces around it (each face counts the same).
 	// It's only slightly more complicated, and is more 'proper.'
-	// LONG WAY version
-	std::vector<PlyElement>::iterator itVecFace;
-	for ( itVecFace = this->m_elements.begin(); itVecFace != this->m_elements.end(); itVecFace++)
-	{	// A simple, local struct to help...
-		//struct SexyVector
-		//{
-		//	SexyVector() : x(0.0f), y(0.0f), z(0.0f) {};
-		//	float x, y, z;
-		//};
-		// Get the three corners (verticies) of the triangle
-		//SexyVector vectorA, vectorB, vectorC;
-		CVector3f vectorA, vectorB, vectorC;
-		vectorA.x = this->m_verticies.at( itVecFace->vertex_index_1 ).xyz.x;
-		vectorA.y = this->m_verticies.at( itVecFace->vertex_index_1 ).xyz.y;
-		vectorA.z = this->m_verticies.at( itVecFace->vertex_index_1 ).xyz.z;
-		vectorB.x = this->m_verticies.at( itVecFace->vertex_index_2 ).xyz.x;
-		vectorB.y = this->m_verticies.at( itVecFace->vertex_index_2 ).xyz.y;
-		vectorB.z = this->m_verticies.at( itVecFace->vertex_index_2 ).xyz.z;
-		vectorC.x = this->m_verticies.at( itVecFace->vertex_index_3 ).xyz.x;
-		vectorC.y = this->m_verticies.at( itVecFace->vertex_index_3 ).xyz.y;
-		vectorC.z = this->m_verticies.at( itVecFace->vertex_index_3 ).xyz.z;
-		// calculate the vectors for the cross...
-		//SexyVector vecAB;// = vecB - vecA
-		CVector3f vecAB;
-		//::VectorSubtract( vectorB.x, vectorB.y, vectorB.z,
-		//	              vectorA.x, vectorA.y, vectorA.z,
-		//				  vecAB.x, vecAB.y, vecAB.z );		
-		vecAB = vectorB - vectorA;
-		
-		//SexyVector vecBC;// = vecC - vecB
-		CVector3f vecBC;
-		//::VectorSubtract( vectorC.x, vectorC.y, vectorC.z,
-		//	              vectorB.x, vectorB.y, vectorB.z,
-		//				  vecBC.x, vecBC.y, vecBC.z );
-		vecBC = vectorC - vectorB;
-
-		//SexyVector normal;
-		CVector3f normal;
-		//::CrossProduct( vecAB.x, vecAB.y, vecAB.z, 
-		//	            vecBC.x, vecBC.y, vecBC.z, 
-		//				normal.x, normal.y, normal.z );
-		normal.CrossProduct( vecAB, vecBC, normal );
-
-		//::NormalizeVector( normal.x, normal.y, normal.z );
-		normal.Normalize();
+	// Added: This used to go through the faces one at a time, adding each face normal to its 
+	//	three vertices. Now it's done by CNormalGenerator (see GenerateNormals()), which gives
+	//	the same answer (unless the file already had normals: those used to be added to).
+	this->GenerateNormals( CNormalGenerator::WEIGHT_EQUAL );
+	return;
+}
 
-		// Load the normals onto the verticies
-		// NOTE: We are ADDING instead of OVERWRITING...
-		this->m_verticies.at( itVecFace->vertex_index_1 ).nx += normal.x;  //****
-		this->m_verticies.at( itVecFace->vertex_index_1 ).ny += normal.y;  //****
-		this->m_verticies.at( itVecFace->vertex_index_1 ).nz += normal.z;  //****
-		this->m_verticies.at( itVecFace->vertex_index_2 ).nx += normal.x;  //****
-		this->m_verticies.at( itVecFace->vertex_index_2 ).ny += normal.y;  //****
-		this->m_verticies.at( itVecFace->vertex_index_2 ).nz += normal.z;  //****
-		this->m_verticies.at( itVecFace->vertex_index_3 ).nx += normal.x;  //****
-		this->m_verticies.at( itVecFace->vertex_index_3 ).ny += normal.y;  //****
-		this->m_verticies.at( itVecFace->vertex_index_3 ).nz += normal.z;  //****
-	}
-	// Now go through all the vertices and normalize (average) them...
-	std::vector<PlyVertex>::iterator itVert;
-	for ( itVert = this->m_verticies.begin(); itVert != this->m_verticies.end(); itVert++)
-	{	
-		::NormalizeVector( itVert->nx, itVert->ny, itVert->nz );
+bool CPlyFile5nt::GenerateNormals( CNormalGenerator::enumWeighting weighting )
+{
+	if ( this->m_vertexStreams.empty() )
+	{
+		return false;
 	}
+	const unsigned int numberOfVertices = this->m_vertexStreams.size();
+	const unsigned int numberOfTriangles = static_cast<unsigned int>( this->m_elements.size() );
+
+	// Straight from the position stream and the elements, and straight into the normal stream
+	// (the element indices are signed, but the negative ones just look like big ones, which CNormalGenerator ignores)
+	static_assert( sizeof(PlyElement) == 3 * sizeof(int), "The three vertex indices of a PlyElement are expected to be next to each other" );
+	this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_NORMAL );
+	const float* pPositions = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_POSITION );
+	float* pNormals = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_NORMAL );
+	const unsigned int* pIndices = ( numberOfTriangles == 0 ) ? 0 : reinterpret_cast<const unsigned int*>( &(this->m_elements[0].vertex_index_1) );
+	CNormalGenerator::GenerateNormals( pPositions, 3 * sizeof(float), numberOfVertices,
+	                                   pIndices, sizeof(PlyElement), numberOfTriangles, weighting,
+	                                   pNormals, 3 * sizeof(float) );
+	return true;
 }
 
 ////                         _ _        _____ _        __  __        _     _ ___      _         ___  _            _  __  ____   __            _          
@@ -748,6 +761,9 @@ void CPlyFile5nt::normalizeTheModelBaby_Rock_n_Roll(void)
 	// Go through all the faces, calculate the normal and 
 	//	save (overwrite) the normals at that faces vertices.
 	// LONG WAY version
+	this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_NORMAL );
+	const float* pPositions = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_POSITION );
+	float* pNormals = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_NORMAL );
 	std::vector<PlyElement>::iterator itVecFace;
 	for ( itVecFace = this->m_elements.begin(); itVecFace != this->m_elements.end(); itVecFace++)
 	{	// A simple, local struct to help...
@@ -759,15 +775,15 @@ void CPlyFile5nt::normalizeTheModelBaby_Rock_n_Roll(void)
 		// Get the three corners (verticies) of the triangle
 		//SexyVector vectorA, vectorB, vectorC;
 		CVector3f vectorA, vectorB, vectorC;
-		vectorA.x = this->m_verticies.at( itVecFace->vertex_index_1 ).xyz.x;
-		vectorA.y = this->m_verticies.at( itVecFace->vertex_index_1 ).xyz.y;
-		vectorA.z = this->m_verticies.at( itVecFace->vertex_index_1 ).xyz.z;
-		vectorB.x = this->m_verticies.at( itVecFace->vertex_index_2 ).xyz.x;
-		vectorB.y = this->m_verticies.at( itVecFace->vertex_index_2 ).xyz.y;
-		vectorB.z = this->m_verticies.at( itVecFace->vertex_index_2 ).xyz.z;
-		vectorC.x = this->m_verticies.at( itVecFace->vertex_index_3 ).xyz.x;
-		vectorC.y = this->m_verticies.at( itVecFace->vertex_index_3 ).xyz.y;
-		vectorC.z = this->m_verticies.at( itVecFace->vertex_index_3 ).xyz.z;
+		vectorA.x = pPositions[ itVecFace->vertex_index_1 * 3 + 0 ];
+		vectorA.y = pPositions[ itVecFace->vertex_index_1 * 3 + 1 ];
+		vectorA.z = pPositions[ itVecFace->vertex_index_1 * 3 + 2 ];
+		vectorB.x = pPositions[ itVecFace->vertex_index_2 * 3 + 0 ];
+		vectorB.y = pPositions[ itVecFace->vertex_index_2 * 3 + 1 ];
+		vectorB.z = pPositions[ itVecFace->vertex_index_2 * 3 + 2 ];
+		vectorC.x = pPositions[ itVecFace->vertex_index_3 * 3 + 0 ];
+		vectorC.y = pPositions[ itVecFace->vertex_index_3 * 3 + 1 ];
+		vectorC.z = pPositions[ itVecFace->vertex_index_3 * 3 + 2 ];
 		// calculate the vectors for the cross...
 		//SexyVector vecAB;// = vecB - vecA
 		CVector3f vecAB;
@@ -794,15 +810,15 @@ void CPlyFile5nt::normalizeTheModelBaby_Rock_n_Roll(void)
 		normal.Normalize();
 
 		// Load the normals onto the verticies
-		this->m_verticies.at( itVecFace->vertex_index_1 ).nx = normal.x;
-		this->m_verticies.at( itVecFace->vertex_index_1 ).ny = normal.y;
-		this->m_verticies.at( itVecFace->vertex_index_1 ).nz = normal.z;
-		this->m_verticies.at( itVecFace->vertex_index_2 ).nx = normal.x;
-		this->m_verticies.at( itVecFace->vertex_index_2 ).ny = normal.y;
-		this->m_verticies.at( itVecFace->vertex_index_2 ).nz = normal.z;
-		this->m_verticies.at( itVecFace->vertex_index_3 ).nx = normal.x;
-		this->m_verticies.at( itVecFace->vertex_index_3 ).ny = normal.y;
-		this->m_verticies.at( itVecFace->vertex_index_3 ).nz = normal.z;
+		pNormals[ itVecFace->vertex_index_1 * 3 + 0 ] = normal.x;
+		pNormals[ itVecFace->vertex_index_1 * 3 + 1 ] = normal.y;
+		pNormals[ itVecFace->vertex_index_1 * 3 + 2 ] = normal.z;
+		pNormals[ itVecFace->vertex_index_2 * 3 + 0 ] = normal.x;
+		pNormals[ itVecFace->vertex_index_2 * 3 + 1 ] = normal.y;
+		pNormals[ itVecFace->vertex_index_2 * 3 + 2 ] = normal.z;
+		pNormals[ itVecFace->vertex_index_3 * 3 + 0 ] = normal.x;
+		pNormals[ itVecFace->vertex_index_3 * 3 + 1 ] = normal.y;
+		pNormals[ itVecFace->vertex_index_3 * 3 + 2 ] = normal.z;
 	}
 } 
 
@@ -831,55 +847,58 @@ void CPlyFile5nt::GenTextureCoordsSpherical( enumTEXCOORDBIAS uBias, enumTEXCOOR
 	if ( uBias == POSITIVE_Y || vBias == POSITIVE_Y )	yUsed = true;
 	if ( uBias == POSITIVE_Z || vBias == POSITIVE_Z )	yUsed = true;
 	
-	std::vector<PlyVertex>::iterator itVert;
-	for ( itVert = this->m_verticies.begin(); itVert != this->m_verticies.end(); itVert++ )
+	this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_TEX0 );
+	this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_TEX1 );
+	for ( unsigned int index = 0; index != this->m_vertexStreams.size(); index++ )
 	{
+		PlyVertex curVertex = this->m_vertexStreams.GetVertex( index );
 		CVector3f xyz;
 		if ( basedOnNormals )
 		{
-			if ( uBias == POSITIVE_X )		xyz.x = itVert->nx;
-			else if ( uBias == POSITIVE_Y )	xyz.x = itVert->ny;
-			else if ( uBias == POSITIVE_Z )	xyz.x = itVert->nz;
+			if ( uBias == POSITIVE_X )		xyz.x = curVertex.nx;
+			else if ( uBias == POSITIVE_Y )	xyz.x = curVertex.ny;
+			else if ( uBias == POSITIVE_Z )	xyz.x = curVertex.nz;
 
-			if ( vBias == POSITIVE_X )		xyz.y = itVert->nx;
-			else if ( vBias == POSITIVE_Y )	xyz.y = itVert->ny;
-			else if ( vBias == POSITIVE_Z )	xyz.y = itVert->nz;
+			if ( vBias == POSITIVE_X )		xyz.y = curVertex.nx;
+			else if ( vBias == POSITIVE_Y )	xyz.y = curVertex.ny;
+			else if ( vBias == POSITIVE_Z )	xyz.y = curVertex.nz;
 
 			// Fill in the remaining coordinate...
-			if ( !xUsed )	xyz.z = itVert->nx;
-			if ( !yUsed )	xyz.z = itVert->ny;
-			if ( !zUsed )	xyz.z = itVert->nz;
+			if ( !xUsed )	xyz.z = curVertex.nx;
+			if ( !yUsed )	xyz.z = curVertex.ny;
+			if ( !zUsed )	xyz.z = curVertex.nz;
 		}
 		else
 		{
-			if ( uBias == POSITIVE_X )		xyz.x = itVert->xyz.x;
-			else if ( uBias == POSITIVE_Y )	xyz.x = itVert->xyz.y;
-			else if ( uBias == POSITIVE_Z )	xyz.x = itVert->xyz.z;
+			if ( uBias == POSITIVE_X )		xyz.x = curVertex.xyz.x;
+			else if ( uBias == POSITIVE_Y )	xyz.x = curVertex.xyz.y;
+			else if ( uBias == POSITIVE_Z )	xyz.x = curVertex.xyz.z;
 
-			if ( vBias == POSITIVE_X )		xyz.y = itVert->xyz.x;
-			else if ( vBias == POSITIVE_Y )	xyz.y = itVert->xyz.y;
-			else if ( vBias == POSITIVE_Z )	xyz.y = itVert->xyz.z;
+			if ( vBias == POSITIVE_X )		xyz.y = curVertex.xyz.x;
+			else if ( vBias == POSITIVE_Y )	xyz.y = curVertex.xyz.y;
+			else if ( vBias == POSITIVE_Z )	xyz.y = curVertex.xyz.z;
 
 			// Fill in the remaining coordinate...
-			if ( !xUsed )	xyz.z = itVert->xyz.x;
-			if ( !yUsed )	xyz.z = itVert->xyz.y;
-			if ( !zUsed )	xyz.z = itVert->xyz.z;
+			if ( !xUsed )	xyz.z = curVertex.xyz.x;
+			if ( !yUsed )	xyz.z = curVertex.xyz.y;
+			if ( !zUsed )	xyz.z = curVertex.xyz.z;
 		}
 
 		xyz.Normalize();
 
 		if ( fast )
 		{
-			itVert->tex0u = ( ( xyz.x / 2.0f) + 0.5f ) * scale;
-			itVert->tex0v = ( ( xyz.y / 2.0f) + 0.5f ) * scale;
+			curVertex.tex0u = ( ( xyz.x / 2.0f) + 0.5f ) * scale;
+			curVertex.tex0v = ( ( xyz.y / 2.0f) + 0.5f ) * scale;
 		}
 		else
 		{
-			itVert->tex0u = ( ( asin(xyz.x) / PI ) + 0.5f ) * scale;
-			itVert->tex0v = ( ( asin(xyz.y) / PI ) + 0.5f ) * scale;
+			curVertex.tex0u = ( ( asin(xyz.x) / PI ) + 0.5f ) * scale;
+			curVertex.tex0v = ( ( asin(xyz.y) / PI ) + 0.5f ) * scale;
 		}
-		itVert->tex1u = itVert->tex0u;
-		itVert->tex1v = itVert->tex0v;
+		curVertex.tex1u = curVertex.tex0u;
+		curVertex.tex1v = curVertex.tex0v;
+		this->m_vertexStreams.SetVertex( index, curVertex );
 	}
 }
 
@@ -927,16 +946,99 @@ void CPlyFile5nt::GenTextureCoordsSpherical( enumTEXCOORDBIAS uBias, enumTEXCOOR
 
 PlyVertex CPlyFile5nt::getVertex_at(std::vector<PlyVertex>::size_type index)
 {
-	PlyVertex x = this->m_verticies.at( index );
+	if ( index >= this->m_vertexStreams.size() )
+	{	// (Same as the vector's at() used to do)
+		throw std::out_of_range( "CPlyFile5nt::getVertex_at(): index is past the last vertex" );
+	}
+	PlyVertex x = this->m_vertexStreams.GetVertex( static_cast<unsigned int>( index ) );
 	return x;
 }
 
+const CPlyVertexStreams& CPlyFile5nt::GetVertexStreams(void) const
+{
+	return this->m_vertexStreams;
+}
+
+// Added
+void CPlyFile5nt::m_AddVertexStreamsFromHeader(void)
+{
+	const CPlyHeaderDescription &header = this->m_PlyHeaderInfo;
+	// (The indices of the properties that aren't in the file are INT_MAX)
+	const int lastIndex = header.totalProperties;
+	if ( ( header.normx_propertyIndex < lastIndex ) || ( header.normy_propertyIndex < lastIndex ) || ( header.normz_propertyIndex < lastIndex ) )
+	{
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_NORMAL );
+	}
+	if ( ( header.tex0u_propertyIndex < lastIndex ) || ( header.tex0v_propertyIndex < lastIndex ) )
+	{
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_TEX0 );
+	}
+	if ( ( header.tex1u_propertyIndex < lastIndex ) || ( header.tex1v_propertyIndex < lastIndex ) )
+	{
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_TEX1 );
+	}
+	if ( ( header.red_propertyIndex < lastIndex ) || ( header.green_propertyIndex < lastIndex ) || 
+		 ( header.blue_propertyIndex < lastIndex ) || ( header.alpha_propertyIndex < lastIndex ) )
+	{
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_COLOUR );
+	}
+	if ( ( header.tangentX_propertyIndex < lastIndex ) || ( header.tangentY_propertyIndex < lastIndex ) || ( header.tangentZ_propertyIndex < lastIndex ) )
+	{
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_TANGENT );
+	}
+	if ( ( header.binormalX_propertyIndex < lastIndex ) || ( header.binormalY_propertyIndex < lastIndex ) || ( header.binormalZ_propertyIndex < lastIndex ) )
+	{
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_BINORMAL );
+	}
+	return;
+}
+
 PlyElement CPlyFile5nt::getElement_at(std::vector<PlyElement>::size_type index)
 {
 	PlyElement x = this->m_elements.at( index );
 	return x;
 }
 
+void CPlyFile5nt::ExportVertices( const CPlyVertexLayout &layout, void* pDestination ) const
+{
+	this->m_vertexStreams.ExportInterleaved( layout, pDestination );
+	return;
+}
+
+bool CPlyFile5nt::ExportIndices( void* pDestination, unsigned int indexSizeInBytes ) const
+{
+	const unsigned int numberOfElements = static_cast<unsigned int>( this->m_elements.size() );
+	if ( indexSizeInBytes == 2 )
+	{
+		if ( this->m_vertexStreams.size() > 65536 )
+		{	// (the vertex indices won't fit)
+			return false;
+		}
+		unsigned short* pIndices = static_cast<unsigned short*>( pDestination );
+		for ( unsigned int index = 0; index != numberOfElements; index++ )
+		{
+			const PlyElement &element = this->m_elements[index];
+			pIndices[index * 3 + 0] = static_cast<unsigned short>( element.vertex_index_1 );
+			pIndices[index * 3 + 1] = static_cast<unsigned short>( element.vertex_index_2 );
+			pIndices[index * 3 + 2] = static_cast<unsigned short>( element.vertex_index_3 );
+		}
+		return true;
+	}
+	if ( indexSizeInBytes == 4 )
+	{
+		unsigned int* pIndices = static_cast<unsigned int*>( pDestination );
+		for ( unsigned int index = 0; index != numberOfElements; index++ )
+		{
+			const PlyElement &element = this->m_elements[index];
+			pIndices[index * 3 + 0] = static_cast<unsigned int>( element.vertex_index_1 );
+			pIndices[index * 3 + 1] = static_cast<unsigned int>( element.vertex_index_2 );
+			pIndices[index * 3 + 2] = static_cast<unsigned int>( element.vertex_index_3 );
+		}
+		return true;
+	}
+	return false;
+}
+
 
 void CPlyFile5nt::m_setIndexBasedOnPropertyName(int curIndex, std::wstring propName)
 {
@@ -1121,14 +1223,19 @@ bool CPlyFile5nt::bHasNormalsInFile(void)
 void CPlyFile5nt::normlizeExistingNomrals(void)
 {
 	// Now go through all the vertices and normalize (average) them...
-	std::vector<PlyVertex>::iterator itVert;
-	for ( itVert = this->m_verticies.begin(); itVert != this->m_verticies.end(); itVert++)
+	// (Updated: If there aren't any normals, there's nothing to do)
+	float* pNormals = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_NORMAL );
+	if ( pNormals == 0 )
+	{
+		return;
+	}
+	for ( unsigned int index = 0; index != this->m_vertexStreams.size(); index++ )
 	{	
-		CVector3f normal( itVert->nx, itVert->ny, itVert->nz );
+		CVector3f normal( pNormals[index * 3 + 0], pNormals[index * 3 + 1], pNormals[index * 3 + 2] );
 		normal.Normalize();
-		itVert->nx = normal.x;
-		itVert->ny = normal.y;
-		itVert->nz = normal.z;
+		pNormals[index * 3 + 0] = normal.x;
+		pNormals[index * 3 + 1] = normal.y;
+		pNormals[index * 3 + 2] = normal.z;
 	}
 }
 // End of Added
@@ -1204,14 +1311,19 @@ float CPlyFile5nt::getMaxExtent(bool bRecalculateExtents)
 }
 
 // These were added (again, maybe - I thought I already did this) on June 9, 2015
+// Updated: These all go through m_scaleAndTranslate() (CPositionKernels), which keeps the extents up to date
 void CPlyFile5nt::Scale( float scale )
 {
-	for ( std::vector<PlyVertex>::iterator itVert = this->m_verticies.begin(); itVert != this->m_verticies.end(); itVert++ )
-	{
-		itVert->xyz.x *= scale;
-		itVert->xyz.y *= scale;
-		itVert->xyz.z *= scale;
-	}
+	this->m_scaleAndTranslate( scale, scale, scale, CVector3f( 0.0f, 0.0f, 0.0f ) );
+	return;
+}
+
+void CPlyFile5nt::Scale( float scale, CVector3f origin )
+{
+	// ( xyz - origin ) * scale + origin
+	this->m_scaleAndTranslate( scale, scale, scale, CVector3f( origin.x * ( 1.0f - scale ), 
+	                                                           origin.y * ( 1.0f - scale ), 
+	                                                           origin.z * ( 1.0f - scale ) ) );
 	return;
 }
 
@@ -1221,10 +1333,8 @@ void CPlyFile5nt::ScaleToFit( float boundingBoxSize )
 	this->calcualteExtents();
 	// What's the best scale for this?
 	float neededScale = boundingBoxSize / this->getMaxExtent();
-	// Scale it, baby
+	// Scale it, baby (this updates the extents, too)
 	this->Scale( neededScale );
-	// Recalculate the extents as they've likely changed
-	this->calcualteExtents();
 
 	return;
 }
@@ -1247,38 +1357,36 @@ bool CPlyFile5nt::bHasBinormalsInFile(void)
 
 void CPlyFile5nt::Translate( CVector3f trans )
 {
-	for ( std::vector<PlyVertex>::iterator itVec = this->m_verticies.begin(); itVec != this->m_verticies.end(); itVec++ )
-	{
-		itVec->xyz += trans;
-	}// for ( std::vector<PlyVertex>::iterator itVec ...
+	this->m_scaleAndTranslate( 1.0f, 1.0f, 1.0f, trans );
 	return;
 }
 
+// Updated: These used to always move the model to the 0.0 plane (ignoring the plane passed in)
 void CPlyFile5nt::AlignMinXToPlane( float xMinAxisPlane )
 {
 	// Shift along x to the minium x
-	this->Translate( CVector3f( -this->m_minX, 0.0f, 0.0f ) );
+	this->Translate( CVector3f( xMinAxisPlane - this->m_minX, 0.0f, 0.0f ) );
 	return;
 }
 
 void CPlyFile5nt::AlignMinYToPlane( float yMinAxisPlane )
 {
 	// Shift along y to the minium y
-	this->Translate( CVector3f( 0.0f, -this->m_minY, 0.0f ) );
+	this->Translate( CVector3f( 0.0f, yMinAxisPlane - this->m_minY, 0.0f ) );
 	return;
 }
 
 void CPlyFile5nt::AlignMinZToPlane( float zMinAxisPlane )
 {
 	// Shift along z to the minium z
-	this->Translate( CVector3f( 0.0f, 0.0f, -this->m_minZ ) );
+	this->Translate( CVector3f( 0.0f, 0.0f, zMinAxisPlane - this->m_minZ ) );
 	return;
 }
 
 void CPlyFile5nt::AlignMaxXToPlane( float xMaxAxisPlane )
 {
 	// Shift along x to the maximum x
-	this->Translate( CVector3f( -this->m_maxX, 0.0f, 0.0f ) );
+	this->Translate( CVector3f( xMaxAxisPlane - this->m_maxX, 0.0f, 0.0f ) );
 	return;
 
 }
@@ -1286,21 +1394,270 @@ void CPlyFile5nt::AlignMaxXToPlane( float xMaxAxisPlane )
 void CPlyFile5nt::AlignMaxYToPlane( float yMaxAxisPlane )
 {
 	// Shift along y to the maximum y
-	this->Translate( CVector3f( 0.0f, -this->m_maxY, 0.0f ) );
+	this->Translate( CVector3f( 0.0f, yMaxAxisPlane - this->m_maxY, 0.0f ) );
 	return;
 }
 
 void CPlyFile5nt::AlignMaxZToPlane( float zMaxAxisPlane )
 {
 	// Shift along z to the maximum z
-	this->Translate( CVector3f( 0.0f, 0.0f, -this->m_maxZ ) );
+	this->Translate( CVector3f( 0.0f, 0.0f, zMaxAxisPlane - this->m_maxZ ) );
 	return;
 }
 
 
 void CPlyFile5nt::ShiftToCentreOfVertices(void)
 {
+	// (The centre of the bounding box, worked out in calcualteExtents())
 	this->Translate( CVector3f( -this->m_centreX, -this->m_centreY, -this->m_centreZ ) );
 	return;
 }
 
+
+// Added
+bool CPlyFile5nt::bElementIndicesAreValid(void) const
+{
+	const int numberOfVertices = static_cast<int>( this->m_vertexStreams.size() );
+	for ( std::vector<PlyElement>::const_iterator itElement = this->m_elements.begin(); itElement != this->m_elements.end(); itElement++ )
+	{
+		if ( ( itElement->vertex_index_1 < 0 ) || ( itElement->vertex_index_1 >= numberOfVertices ) ||
+		     ( itElement->vertex_index_2 < 0 ) || ( itElement->vertex_index_2 >= numberOfVertices ) ||
+		     ( itElement->vertex_index_3 < 0 ) || ( itElement->vertex_index_3 >= numberOfVertices ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Added
+bool CPlyFile5nt::WeldVertices( float epsilon, PlyWeldInfo &weldInfo )
+{
+	weldInfo = PlyWeldInfo();
+	if ( this->m_vertexStreams.empty() || this->m_elements.empty() )
+	{
+		return false;
+	}
+	// (the indices are used to look up vecWeldedTo, so one that's out of range would go off the end)
+	if ( !this->bElementIndicesAreValid() )
+	{
+		return false;
+	}
+	if ( epsilon < 0.0f )	{ epsilon = 0.0f; }
+
+	const int numberOfVertices = static_cast<int>( this->m_vertexStreams.size() );
+	weldInfo.verticesBefore = numberOfVertices;
+	weldInfo.trianglesBefore = static_cast<int>( this->m_elements.size() );
+
+	// The grid cells are 4 x epsilon big, and we only look in the cells that are within 2 x epsilon 
+	//	(the extra is so rounding can't make us miss one), which is usually 1 or 2 cells on each axis. 
+	// If epsilon is zero, the "cell" is the exact float value, so there's only the one cell to look in.
+	const bool bExactOnly = ( epsilon == 0.0f );
+	const double oneOverCellSize = bExactOnly ? 0.0 : 1.0 / ( 4.0 * static_cast<double>( epsilon ) );
+	const double searchDistance = 2.0 * static_cast<double>( epsilon );
+
+	// The grid is an open addressing hash table (at least twice as big as the number of vertices, 
+	//	so it's never full). Each cell is a linked list of the "unique" vertices in it 
+	//	(vecCellFirstVertex, then vecNextInCell). -1 is the end of the list (or an empty slot).
+	unsigned int tableSize = 16;
+	while ( tableSize < static_cast<unsigned int>( numberOfVertices ) * 2 )	{ tableSize *= 2; }
+	const unsigned int tableMask = tableSize - 1;
+	std::vector<unsigned long long> vecCellKeys( tableSize, 0 );
+	std::vector<int> vecCellFirstVertex( tableSize, -1 );
+	std::vector<int> vecNextInCell( numberOfVertices, -1 );
+	// Which vertex each one gets welded to (itself, if it's unique)
+	std::vector<int> vecWeldedTo( numberOfVertices, -1 );
+	const float* pPositions = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_POSITION );
+
+	for ( int index = 0; index != numberOfVertices; index++ )
+	{
+		const float* position = &(pPositions[index * 3]);
+		long long cell[3] = { 0 };
+		long long firstCell[3] = { 0 };
+		long long lastCell[3] = { 0 };
+		for ( int axis = 0; axis != 3; axis++ )
+		{
+			if ( bExactOnly )
+			{	// (adding 0.0f turns -0.0f into 0.0f, so they end up in the same cell)
+				float value = position[axis] + 0.0f;
+				unsigned int bits = 0;
+				memcpy( &bits, &value, sizeof(float) );
+				cell[axis] = firstCell[axis] = lastCell[axis] = bits;
+			}
+			else
+			{
+				cell[axis] = CPlyFile5nt::m_WeldGridCell( position[axis], 0.0, oneOverCellSize );
+				firstCell[axis] = CPlyFile5nt::m_WeldGridCell( position[axis], -searchDistance, oneOverCellSize );
+				lastCell[axis] = CPlyFile5nt::m_WeldGridCell( position[axis], searchDistance, oneOverCellSize );
+			}
+		}
+
+		// Is there one already, close enough?
+		int weldTo = -1;
+		for ( long long x = firstCell[0]; ( x <= lastCell[0] ) && ( weldTo == -1 ); x++ )
+		{
+			for ( long long y = firstCell[1]; ( y <= lastCell[1] ) && ( weldTo == -1 ); y++ )
+			{
+				for ( long long z = firstCell[2]; ( z <= lastCell[2] ) && ( weldTo == -1 ); z++ )
+				{
+					unsigned int slot = CPlyFile5nt::m_FindWeldGridSlot( vecCellKeys, vecCellFirstVertex, tableMask, 
+					                                                      CPlyFile5nt::m_WeldGridCellKey( x, y, z ) );
+					for ( int candidate = vecCellFirstVertex[slot]; candidate != -1; candidate = vecNextInCell[candidate] )
+					{
+						if ( this->m_vertexStreams.bVerticesAreTheSame( index, candidate, epsilon ) )
+						{
+							weldTo = candidate;
+							break;
+						}
+					}
+				}// for ( long long z
+			}// for ( long long y
+		}// for ( long long x
+
+		if ( weldTo != -1 )
+		{
+			vecWeldedTo[index] = weldTo;
+			weldInfo.weldedVertices++;
+			continue;
+		}
+		// It's a new one, so add it to the front of its cell's list
+		vecWeldedTo[index] = index;
+		unsigned long long cellKey = CPlyFile5nt::m_WeldGridCellKey( cell[0], cell[1], cell[2] );
+		unsigned int slot = CPlyFile5nt::m_FindWeldGridSlot( vecCellKeys, vecCellFirstVertex, tableMask, cellKey );
+		vecCellKeys[slot] = cellKey;
+		vecNextInCell[index] = vecCellFirstVertex[slot];
+		vecCellFirstVertex[slot] = index;
+	}// for ( int index = 0
+
+	// Point the triangles at the welded vertices, and get rid of the degenerate ones
+	std::vector<bool> vecIsUsed( numberOfVertices, false );
+	std::vector<PlyElement> vecNewElements;
+	vecNewElements.reserve( this->m_elements.size() );
+	for ( std::vector<PlyElement>::iterator itElement = this->m_elements.begin(); itElement != this->m_elements.end(); itElement++ )
+	{
+		PlyElement newElement;
+		newElement.vertex_index_1 = vecWeldedTo[itElement->vertex_index_1];
+		newElement.vertex_index_2 = vecWeldedTo[itElement->vertex_index_2];
+		newElement.vertex_index_3 = vecWeldedTo[itElement->vertex_index_3];
+		if ( ( newElement.vertex_index_1 == newElement.vertex_index_2 ) || 
+			 ( newElement.vertex_index_2 == newElement.vertex_index_3 ) || 
+			 ( newElement.vertex_index_3 == newElement.vertex_index_1 ) )
+		{
+			weldInfo.degenerateTriangles++;
+			continue;
+		}
+		vecIsUsed[newElement.vertex_index_1] = true;
+		vecIsUsed[newElement.vertex_index_2] = true;
+		vecIsUsed[newElement.vertex_index_3] = true;
+		vecNewElements.push_back( newElement );
+	}
+
+	// Keep the vertices that are used (in the same order), and work out where they end up
+	std::vector<int> vecNewIndex( numberOfVertices, -1 );
+	std::vector<unsigned int> vecKeptVertices;
+	vecKeptVertices.reserve( numberOfVertices - weldInfo.weldedVertices );
+	for ( int index = 0; index != numberOfVertices; index++ )
+	{
+		if ( vecWeldedTo[index] != index )
+		{	// Welded to another one
+			continue;
+		}
+		if ( !vecIsUsed[index] )
+		{
+			weldInfo.unreferencedVertices++;
+			continue;
+		}
+		vecNewIndex[index] = static_cast<int>( vecKeptVertices.size() );
+		vecKeptVertices.push_back( static_cast<unsigned int>( index ) );
+	}
+	for ( std::vector<PlyElement>::iterator itElement = vecNewElements.begin(); itElement != vecNewElements.end(); itElement++ )
+	{
+		itElement->vertex_index_1 = vecNewIndex[itElement->vertex_index_1];
+		itElement->vertex_index_2 = vecNewIndex[itElement->vertex_index_2];
+		itElement->vertex_index_3 = vecNewIndex[itElement->vertex_index_3];
+	}
+
+	this->m_vertexStreams.Gather( vecKeptVertices );
+	this->m_elements.swap( vecNewElements );
+	this->m_PlyHeaderInfo.numberOfVertices = static_cast<int>( this->m_vertexStreams.size() );
+	this->m_PlyHeaderInfo.numberOfElements = static_cast<int>( this->m_elements.size() );
+
+	weldInfo.verticesAfter = this->m_PlyHeaderInfo.numberOfVertices;
+	weldInfo.trianglesAfter = this->m_PlyHeaderInfo.numberOfElements;
+
+	if ( !this->m_vertexStreams.empty() )
+	{
+		this->calcualteExtents();
+	}
+	return true;
+}
+
+bool CPlyFile5nt::OptimizeTriangleOrder( unsigned int cacheSize, float overdrawThreshold )
+{
+	if ( this->m_vertexStreams.empty() || this->m_elements.empty() )
+	{
+		return false;
+	}
+	const unsigned int numberOfVertices = this->m_vertexStreams.size();
+
+	std::vector<unsigned int> vecIndices( this->m_elements.size() * 3 );
+	for ( std::vector<PlyElement>::size_type index = 0; index != this->m_elements.size(); index++ )
+	{
+		vecIndices[index * 3 + 0] = static_cast<unsigned int>( this->m_elements[index].vertex_index_1 );
+		vecIndices[index * 3 + 1] = static_cast<unsigned int>( this->m_elements[index].vertex_index_2 );
+		vecIndices[index * 3 + 2] = static_cast<unsigned int>( this->m_elements[index].vertex_index_3 );
+	}
+
+	std::vector<unsigned int> vecClusters;
+	CMeshOptimizer::OptimizeVertexCache( vecIndices, numberOfVertices, cacheSize, vecClusters );
+	CMeshOptimizer::OptimizeOverdraw( vecIndices, vecClusters, this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_POSITION ), 3 * sizeof(float), 
+	                                  numberOfVertices, cacheSize, overdrawThreshold );
+	std::vector<unsigned int> vecVertexRemap;
+	CMeshOptimizer::OptimizeVertexFetch( vecIndices, numberOfVertices, vecVertexRemap );
+
+	this->m_vertexStreams.Reorder( vecVertexRemap );
+
+	for ( std::vector<PlyElement>::size_type index = 0; index != this->m_elements.size(); index++ )
+	{
+		this->m_elements[index].vertex_index_1 = static_cast<int>( vecIndices[index * 3 + 0] );
+		this->m_elements[index].vertex_index_2 = static_cast<int>( vecIndices[index * 3 + 1] );
+		this->m_elements[index].vertex_index_3 = static_cast<int>( vecIndices[index * 3 + 2] );
+	}
+	return true;
+}
+
+//static
+long long CPlyFile5nt::m_WeldGridCell( float value, double offset, double oneOverCellSize )
+{
+	const double MAXCELL = 1099511627776.0;	// 2^40 (so it fits into a long long, even if epsilon is tiny)
+	double cellIndex = floor( ( static_cast<double>( value ) + offset ) * oneOverCellSize );
+	if ( !( cellIndex > -MAXCELL ) )	{ cellIndex = -MAXCELL; }	// (NaN ends up here, too)
+	if ( cellIndex > MAXCELL )			{ cellIndex = MAXCELL; }
+	return static_cast<long long>( cellIndex );
+}
+
+//static
+unsigned int CPlyFile5nt::m_FindWeldGridSlot( const std::vector<unsigned long long> &vecCellKeys, const std::vector<int> &vecCellFirstVertex, 
+                                              unsigned int tableMask, unsigned long long cellKey )
+{
+	// Linear probing: either the slot with this key, or the empty one where it would go
+	unsigned int slot = static_cast<unsigned int>( cellKey >> 32 ) & tableMask;
+	while ( ( vecCellFirstVertex[slot] != -1 ) && ( vecCellKeys[slot] != cellKey ) )
+	{
+		slot = ( slot + 1 ) & tableMask;
+	}
+	return slot;
+}
+
+//static
+unsigned long long CPlyFile5nt::m_WeldGridCellKey( long long cellX, long long cellY, long long cellZ )
+{
+	// Different cells can end up with the same key; that's OK, since the vertices are 
+	//	still compared (it just means looking at a few more of them)
+	unsigned long long key = static_cast<unsigned long long>( cellX ) * 0x9E3779B97F4A7C15ULL;
+	key ^= static_cast<unsigned long long>( cellY ) * 0xC2B2AE3D27D4EB4FULL;
+	key ^= static_cast<unsigned long long>( cellZ ) * 0x165667B19E3779F9ULL;
+	key ^= ( key >> 29 );
+	return key;
+}
+// End of Added
@@ -21,6 +21,9 @@
 #include <vector>
 #include "CVector3f.h"
 #include "CPlyInfo.h"
+#include "CNormalGenerator.h"
+#include "CPlyVertexStreams.h"
+#include "CPlyVertexLayout.h"
 #include <sstream>
 
 // This structure holds the vertex information 
@@ -51,6 +54,20 @@ struct PlyElement
 	int vertex_index_3;
 };
 
+// Added: What CPlyFile5nt::WeldVertices() did (the "before" and "after" counts)
+struct PlyWeldInfo
+{
+	PlyWeldInfo(): verticesBefore(0), verticesAfter(0), trianglesBefore(0), trianglesAfter(0),
+				   weldedVertices(0), unreferencedVertices(0), degenerateTriangles(0) {}
+	int verticesBefore;
+	int verticesAfter;
+	int trianglesBefore;
+	int trianglesAfter;
+	int weldedVertices;			// Merged into another vertex
+	int unreferencedVertices;	// Weren't used by any triangle (not counting the welded ones)
+	int degenerateTriangles;	// Had the same vertex more than once (after welding)
+};
+
 struct CFileInfo
 {
 public:
@@ -82,6 +99,7 @@ public:
 	// Added November 1, 2014
 	bool OpenPLYFile2(std::wstring fileName, std::wstring &error);
 	bool SavePlyFileASCII(std::wstring fileName, bool bOverwrite, bool bIncludeNormals, bool bIncludeVertTex0, bool bIncludeVertTex1 );
+	// Added: These are version 1 GDP files. The "cooked" version 2 (GPU ready) ones are in CGDP2File
 	bool SaveGDPFile(std::wstring fileName, bool bOverwrite, std::wstring &error);
 	bool OpenGDPFile(std::wstring fileName, std::wstring &error);	// GDP model format (basically a binary PLY version)
 	// reads only the header information (number of vertices, etc.)
@@ -96,13 +114,28 @@ public:
 	bool GetRoundTinyFloatsToZeroOnLoadFlag(void);
 	void SetScaleRGBA_OneByteValuesToFloatZeroToOne(bool bEnabled);
 	bool GetScaleRGBA_OneByteValuesToFloatZeroToOne(void);
+	// Added: Parses the vertices and faces of large ASCII files on the shared CThreadPool.
+	// Gives exactly the same result as the regular (serial) way. Off by default.
+	void SetParallelASCIIParsing(bool bEnabled);
+	bool GetParallelASCIIParsing(void);
 
 	std::wstring GetFilenameWithoutExtension(std::wstring fileNameWithExtension, bool bOnlyLookForKnowExtensions = true);
 	
 	int GetNumberOfVerticies(void);
 	int GetNumberOfElements(void);
+	// (Updated: The vertices are kept in a CPlyVertexStreams now, so this puts together a copy)
 	PlyVertex getVertex_at(std::vector<PlyVertex>::size_type index);
+	// Added: The vertices themselves (one array for each thing the vertices have), so they can 
+	//	be used without copying them one at a time.
+	const CPlyVertexStreams& GetVertexStreams(void) const;
 	PlyElement getElement_at(std::vector<PlyElement>::size_type index);
+	// Added: Write the vertices (or the indices, 3 per triangle) right into pDestination, which
+	//	can be a mapped GL buffer, so there's no copy of the model in between.
+	// pDestination needs GetNumberOfVerticies() * layout.GetVertexSizeInBytes() bytes
+	void ExportVertices( const CPlyVertexLayout &layout, void* pDestination ) const;
+	// indexSizeInBytes is 2 (unsigned short, only if there are 65536 vertices or fewer) or 4 (unsigned int).
+	// pDestination needs GetNumberOfElements() * 3 * indexSizeInBytes bytes
+	bool ExportIndices( void* pDestination, unsigned int indexSizeInBytes ) const;
 	float getMaxX(void); float getMinX(void); float getDeltaX(void);
 	float getMaxY(void); float getMinY(void); float getDeltaY(void);
 	float getMaxZ(void); float getMinZ(void); float getDeltaZ(void);
@@ -111,8 +144,13 @@ public:
 	// *********************
 	void normalizeTheModelBaby_Rock_n_Roll(void);
 	//void normalizeTheModelBabyDirectXVersion_Rock_n_Roll(void);
+	// (now the same as GenerateNormals( CNormalGenerator::WEIGHT_EQUAL ))
 	void normalizeTheModelBaby(void);
 	void normalizeTheModelBabyDirectXVersion(void);
+	// Added: Replaces the normals with the (weighted) average of the normals of the triangles 
+	//	around each vertex. Uses CNormalGenerator (SSE, on the shared CThreadPool).
+	// Returns false if there's no model.
+	bool GenerateNormals( CNormalGenerator::enumWeighting weighting );
 
 	// Manipulation operations
 	void Scale( float scale );
@@ -130,6 +168,27 @@ public:
 	void AlignMaxYToPlane( float yMaxAxisPlane );
 	void AlignMaxZToPlane( float zMaxAxisPlane );
 	void ShiftToCentreOfVertices(void);
+	// Added: A sphere around all the vertices (for culling, LOD picking, etc.). See CPositionKernels.
+	// Returns false if there's no model.
+	bool CalculateBoundingSphere( CVector3f &centre, float &radius );
+
+	// Added: True if every triangle only uses vertices that are there (0 to number of vertices - 1)
+	bool bElementIndicesAreValid(void) const;
+	// Added: Welds vertices that are "the same" into one vertex. To be the same, everything 
+	//	(position, normal, texture coords, colour, tangent and binormal) has to be within epsilon. 
+	// The triangles are changed to use the welded vertices, then any triangles that end up using the 
+	//	same vertex more than once (degenerate) and any vertices that no triangle uses are removed. 
+	//	The vertices that are left stay in the same order. 
+	// It uses a hash grid on the positions, so it's about linear time. 
+	// epsilon of 0.0f only welds exact copies. Returns false (and doesn't change anything) if there's no model, 
+	//	or if a triangle uses a vertex that isn't there (see bElementIndicesAreValid()).
+	// Do this AFTER working out the normals: welding first would average the normals across hard edges.
+	bool WeldVertices( float epsilon, PlyWeldInfo &weldInfo );
+	// Added: Reorders the triangles for the GPU's vertex cache, then for less overdraw, then 
+	//	reorders the vertices so they are in the order the triangles use them (see CMeshOptimizer).
+	// Doesn't change what the model looks like (same triangles, same winding), just the order.
+	// Returns false if there's no model.
+	bool OptimizeTriangleOrder( unsigned int cacheSize, float overdrawThreshold );
 
 
 	enum enumTEXCOORDBIAS
@@ -167,7 +226,10 @@ public:
 	float getLastLoadOrSaveTime(void);
 
 private:
-	std::vector<PlyVertex> m_verticies;
+	// Updated: Was std::vector<PlyVertex> m_verticies (92 bytes a vertex, no matter what was in the file)
+	CPlyVertexStreams m_vertexStreams;
+	// Added: Adds the vertex streams for the properties in the header (x, y, z is always there)
+	void m_AddVertexStreamsFromHeader(void);
 	std::vector<PlyElement> m_elements;
 	float m_minX, m_maxX, m_deltaX;
 	float m_minY, m_maxY, m_deltaY;
@@ -175,6 +237,10 @@ private:
 	// *********************
 	float m_centreX, m_centreY, m_centreZ;
 	float m_maxExtent;
+	// Added: deltas, max extent and centre from the min and max
+	void m_updateDeltasAndCentre(void);
+	// Added: Every position is position * scale + trans (the extents are updated, too)
+	void m_scaleAndTranslate( float scaleX, float scaleY, float scaleZ, CVector3f trans );
 
 	float m_lastLoadOrSaveTime;
 
@@ -225,6 +291,21 @@ private:
 		bool bIsHeader_XYZ_vertUV(void);
 		bool bIsHeader_XYZ_nXYZ_ucharRGBA_vertUV(void);
 
+		// Returns the size (in bytes) of a ply property type ("uchar", "float", "int32", etc.)
+		// Returns zero if it's not a type we know about.
+		static int GetPlyTypeSizeInBytes( std::string plyTypeName );
+
+		// Added: the property types (used by CVertexDecoder)
+		enum enumPlyPropertyType
+		{
+			PLY_TYPE_CHAR = 0,	PLY_TYPE_UCHAR,
+			PLY_TYPE_SHORT,		PLY_TYPE_USHORT,
+			PLY_TYPE_INT,		PLY_TYPE_UINT,
+			PLY_TYPE_FLOAT,		PLY_TYPE_DOUBLE,
+			PLY_TYPE_UNKNOWN
+		};
+		static enumPlyPropertyType GetPlyType( std::string plyTypeName );
+		static int GetPlyTypeSizeInBytes( enumPlyPropertyType plyType );
 
 		inline bool bIsThisMachineIsBigEndian(void);	// Motorola, PowerPC often big endian - everyone else (Intel) is little
 
@@ -256,6 +337,16 @@ private:
 
 		int numberOfElements;
 		int numberOfVertices;
+
+		// Used for the binary files (OpenPLYFile2)
+		int vertexSizeInBytes;				// Sum of all the vertex property sizes
+		bool bAllVertexPropertiesAreFloat;	// If so, the vertex block can be copied in one go
+		int faceListCountSizeInBytes;		// "property list uchar int vertex_indices" --> uchar (1)
+		int faceListIndexSizeInBytes;		// "property list uchar int vertex_indices" --> int (4)
+
+		// Added: The type of each vertex property, in the order they are in the file 
+		//	(so vecVertexPropertyTypes[x_propertyIndex] is the type of "x")
+		std::vector<enumPlyPropertyType> vecVertexPropertyTypes;
 	};
 
 	CPlyHeaderDescription m_PlyHeaderInfo;
@@ -327,6 +418,8 @@ private:
 		inline std::string ASCIIReadNextString( char* pData, unsigned int &curIndex, const unsigned int &arraySize );
 		inline float ASCIIReadNextFloat( char* pData, unsigned int &curIndex, const unsigned int &arraySize );
 		inline int ASCIIReadNextInt( char* pData, unsigned int &curIndex, const unsigned int &arraySize );
+		// Added: for the properties we don't store (like "confidence" in the bunny)
+		inline void ASCIISkipNextToken( char* pData, unsigned int &curIndex, const unsigned int &arraySize );
 
 		void SetMinFloatRoundToZero(float minRoundToZero );
 		float GetMinFloatRoundToZeroValue(void);
@@ -339,72 +432,75 @@ private:
 	private:
 		float m_roundToZeroValue;
 		bool m_bRoundSmallFloatToZeroFlag;
-	};
-
 
-	class IVertexReader
-	{
-	public:
-		virtual ~IVertexReader() {};
-		virtual bool IsReaderValid( CPlyHeaderDescription::enumPlyHeaderLayout plyFileType ) = 0;
-		virtual bool ProcessNextVertex( PlyVertex &vertex, char* pData, unsigned int &curIndex, const unsigned int &arraySize ) = 0;
-		// Not technically an interface, but yolo: I can't see why on Earth you'd want to overload these
-		// (and adding them to Every. Single. Derrived. Class. seems pretty pointless)
-		virtual void SetScaleRGBA_OneByteValuesToFloatZeroToOne(bool bEnabled){ this->m_b_ScaleRGBA_OneByteValuesToFloatZeroToOne = bEnabled; }
-		virtual bool GetScaleRGBA_OneByteValuesToFloatZeroToOne(void) { return this->m_b_ScaleRGBA_OneByteValuesToFloatZeroToOne; }
-		virtual void ScaleRGBA_OneByteValuesToZeroToOne( PlyVertex &vertex )
-		{
-			vertex.red =	( vertex.red / 255.0f );
-			vertex.green =	( vertex.green / 255.0f );
-			vertex.blue =	( vertex.blue / 255.0f );
-			vertex.alpha =	( vertex.alpha / 255.0f );
-			return;
-		}
-	protected:
-		bool m_b_ScaleRGBA_OneByteValuesToFloatZeroToOne;// = bEnabled;
+		// These are used by ASCIIReadNextFloat() and ASCIIReadNextInt() to parse the numbers 
+		//	right out of the raw data (i.e. no std::string, no atof(), so no heap allocations)
+		inline bool m_bIsWhiteSpace( char theChar );
+		inline unsigned int m_FindEndOfToken( char* pData, unsigned int curIndex, const unsigned int &arraySize );
+		inline void m_SkipWhiteSpace( char* pData, unsigned int &curIndex, const unsigned int &arraySize );
+		// Parses [pFirst, pLast). Gives exactly the same answer as atof() 
+		//	(it falls back to strtod() for anything that isn't "simple")
+		double m_ParseDouble( const char* pFirst, const char* pLast );
 	};
 
 
-	// These are used for OpenPLYFile2()
-	class CVertexReader_ASCII_fXYZ : public IVertexReader
-	{
-	public:
-		virtual bool IsReaderValid( CPlyHeaderDescription::enumPlyHeaderLayout plyFileType );
-		virtual bool ProcessNextVertex( PlyVertex &vertex, char* pData, unsigned int &curIndex, const unsigned int &arraySize );
-		CPlyFile5nt::CDataReader reader;
-	};
-
-	class CVertexReader_ASCII_fXYZ_nXYZ : public IVertexReader
-	{
-	public:
-		virtual bool IsReaderValid( CPlyHeaderDescription::enumPlyHeaderLayout plyFileType );
-		virtual bool ProcessNextVertex( PlyVertex &vertex, char* pData, unsigned int &curIndex, const unsigned int &arraySize );
-		CPlyFile5nt::CDataReader reader;
-	};	
-	
-	// These are used for OpenPLYFile2()
-	class CVertexReader_ASCII_fXYZ_nXYZ_vertUV : public IVertexReader
-	{
-	public:
-		virtual bool IsReaderValid( CPlyHeaderDescription::enumPlyHeaderLayout plyFileType );
-		virtual bool ProcessNextVertex( PlyVertex &vertex, char* pData, unsigned int &curIndex, const unsigned int &arraySize );
-		CPlyFile5nt::CDataReader reader;
-	};
-	// These are used for OpenPLYFile2()
-	class CVertexReader_ASCII_fXYZ_vertUV : public IVertexReader
-	{
-	public:
-		virtual bool IsReaderValid( CPlyHeaderDescription::enumPlyHeaderLayout plyFileType );
-		virtual bool ProcessNextVertex( PlyVertex &vertex, char* pData, unsigned int &curIndex, const unsigned int &arraySize );
-		CPlyFile5nt::CDataReader reader;
-	};
-	// These are used for OpenPLYFile2()	
-	class CVertexReader_ASCII_XYZ_nXYZ_ucharRGBA_vertUV : public IVertexReader	// HEADER_LAYOUT_IS_ASCII_XYZ_nXYZ_ucharRGBA_vertUV
+	// Added: Reads the vertices for OpenPLYFile2() (ASCII and binary). 
+	// This replaces the CVertexReader_ASCII_xxx classes (one per layout) we used to have. 
+	// Compile() looks at the properties in the header and makes a "step" for each one: 
+	//	what type it is, where it is (binary), and where it goes in the PlyVertex (or if it's 
+	//	skipped). So the properties can be any type, in any order, and extra ones are ignored. 
+	// There's no virtual call per vertex: the Decode methods do all the vertices in one go. 
+	//	If all the properties are floats (the common case), they use templated "kernels" 
+	//	that are unrolled for that number of floats. 
+	class CVertexDecoder
 	{
 	public:
-		virtual bool IsReaderValid( CPlyHeaderDescription::enumPlyHeaderLayout plyFileType );
-		virtual bool ProcessNextVertex( PlyVertex &vertex, char* pData, unsigned int &curIndex, const unsigned int &arraySize );
+		CVertexDecoder();
+		// Returns false if there's no x, y, and z (or there's a property type we don't know)
+		bool Compile( const CPlyHeaderDescription &headerInfo );
+		// Set to true if the file endianness isn't the same as this machine (binary only)
+		void SetSwapBytes( bool bSwapBytes );
+		void SetScaleRGBA_OneByteValuesToFloatZeroToOne( bool bEnabled );
+
+		// These read numberOfVertices vertices, one after the other, into pVertices
+		void DecodeASCIIVertices( PlyVertex* pVertices, unsigned int numberOfVertices, 
+		                          char* pData, unsigned int &curIndex, const unsigned int &arraySize );
+		// Returns false if the file is shorter than the header says it should be
+		bool DecodeBinaryVertices( PlyVertex* pVertices, unsigned int numberOfVertices, 
+		                           char* pData, unsigned int &curIndex, const unsigned int &arraySize );
+
+		// Has the "round tiny floats to zero" settings (ASCII and binary)
 		CPlyFile5nt::CDataReader reader;
+	private:
+		// One per property in the file (in the same order)
+		struct sDecodeStep
+		{
+			CPlyHeaderDescription::enumPlyPropertyType type;
+			unsigned int offsetInFileVertex;	// In bytes, from the start of the vertex (binary only)
+			int offsetInPlyVertex;				// In bytes, or DONT_STORE if we skip it
+			bool bIsOneByteColour;				// Gets scaled to 0.0 to 1.0 (if that's enabled)
+		};
+		static const int DONT_STORE = -1;
+		std::vector<sDecodeStep> m_vecSteps;
+		unsigned int m_vertexSizeInBytes;		// In the file (binary only)
+		bool m_bSwapBytes;
+		bool m_bScaleRGBA_OneByteValuesToFloatZeroToOne;
+
+		// If every property is a float that we store, the "fast" kernels are used
+		static const unsigned int MAXFASTFLOATS = 8;
+		unsigned int m_numberOfFastFloats;		// 0 if it's not all floats
+		int m_fastFloatOffsetInPlyVertex[MAXFASTFLOATS];
+
+		template <unsigned int NUMFLOATS>
+		void m_DecodeASCIIFloats( PlyVertex* pVertices, unsigned int numberOfVertices, 
+		                          char* pData, unsigned int &curIndex, const unsigned int &arraySize );
+		template <unsigned int NUMFLOATS, bool bSWAPBYTES>
+		void m_DecodeBinaryFloats( PlyVertex* pVertices, unsigned int numberOfVertices, const char* pFileVertex );
+		void m_DecodeASCIIGeneric( PlyVertex* pVertices, unsigned int numberOfVertices, 
+		                           char* pData, unsigned int &curIndex, const unsigned int &arraySize );
+		void m_DecodeBinaryGeneric( PlyVertex* pVertices, unsigned int numberOfVertices, const char* pFileVertex );
+		inline float m_ReadBinaryValueAsFloat( const char* pValue, CPlyHeaderDescription::enumPlyPropertyType type );
+		inline float m_RoundTinyFloatToZero( float value );
 	};
 
 	class IElementReader
@@ -423,6 +519,46 @@ private:
 		virtual bool ProcessNextElement( PlyElement &element, char* pData, unsigned int &curIndex, const unsigned int &arraySize );
 		CPlyFile5nt::CDataReader reader;
 	};
+
+	// Used for OpenPLYFile2() with binary_little_endian and binary_big_endian files.
+	// Reads all the faces in one go, then byte-swaps them (if needed). 
+	// (The vertices are done by CVertexDecoder)
+	class CBlockReader_BINARY
+	{
+	public:
+		CBlockReader_BINARY();
+		// Set to true if the file endianness isn't the same as this machine
+		void SetSwapBytes( bool bSwapBytes );
+		bool ProcessElementBlock( std::vector<PlyElement> &vecElements, const CPlyHeaderDescription &headerInfo, 
+		                          char* pData, unsigned int &curIndex, const unsigned int &arraySize );
+	private:
+		bool m_bSwapBytes;
+		// Swaps the byte order of an array of 32 bit values (uses SSE2, 4 at a time)
+		void m_SwapBytes32( unsigned int* pWords, unsigned int numberOfWords );
+		inline unsigned int m_ReadBinaryUInt( const char* pData, int sizeInBytes );
+	};
+
+	// Used by OpenPLYFile2() if SetParallelASCIIParsing(true) 
+	// Finds where each line starts, then parses blocks of lines on the thread pool, right 
+	//	into m_vertexStreams and m_elements. Returns false if the result might not be the same as 
+	//	the serial version (like if there's more than one vertex on a line), and leaves 
+	//	the vectors the way they were, so the serial version can have a go.
+	bool m_ParseASCIIBodyInParallel( CVertexDecoder* pVertexDecoder, IElementReader* pElementReader, 
+	                                 char* pRawData, unsigned int curIndex, const unsigned int &fileSize );
+	bool m_bParallelASCIIParsing;
+	// Added: Used by OpenPLYFile2(). Decodes DECODEBLOCKSIZE vertices at a time into a PlyVertex
+	//	array, then copies them into m_vertexStreams (which is already big enough), so there's
+	//	never a PlyVertex for every vertex. Returns false if the file is too short (binary only).
+	bool m_DecodeVerticesInBlocks( CVertexDecoder &vertexDecoder, bool bIsBinary, unsigned int firstVertex, unsigned int numberOfVertices, 
+	                               char* pRawData, unsigned int &curIndex, const unsigned int &fileSize );
+	static const unsigned int DECODEBLOCKSIZE = 4096;
+	// Used by WeldVertices()
+	static long long m_WeldGridCell( float value, double offset, double oneOverCellSize );
+	static unsigned int m_FindWeldGridSlot( const std::vector<unsigned long long> &vecCellKeys, const std::vector<int> &vecCellFirstVertex, 
+	                                        unsigned int tableMask, unsigned long long cellKey );
+	static unsigned long long m_WeldGridCellKey( long long cellX, long long cellY, long long cellZ );
+	// Fewer lines than this per block isn't worth the bother
+	static const unsigned int PARALLELPARSEMINLINESPERBLOCK = 4096;
 };
 
 
@@ -18,6 +18,11 @@
 #include <cctype>
 
 #include "../CHRTimer.h"
+#include <string.h>		// for memcpy()
+#include <emmintrin.h>	// SSE2 (for the byte swapping in the binary reader)
+#include <atomic>
+#include "../CThreadPool.h"
+#include "../CFileView.h"
 
 //static 
 const float CPlyFile5nt::CDataReader::DEFAULTROUNDSMALLFLOATTOZEROVALUE = FLT_MIN;
@@ -81,23 +86,170 @@ std::string CPlyFile5nt::CDataReader::ASCIIReadNextString( char* pData, unsigned
 	return returnString;
 }
 
+bool CPlyFile5nt::CDataReader::m_bIsWhiteSpace( char theChar )
+{
+	// Same as isspace() for the "C" locale (see list at the top), but without the function call
+	return ( ( theChar == ' ' ) || ( ( theChar >= '\t' ) && ( theChar <= '\r' ) ) );
+}
+
+unsigned int CPlyFile5nt::CDataReader::m_FindEndOfToken( char* pData, unsigned int curIndex, const unsigned int &arraySize )
+{
+	while ( ( curIndex < arraySize ) && !this->m_bIsWhiteSpace( pData[curIndex] ) )
+	{
+		curIndex++;
+	}
+	return curIndex;
+}
+
+void CPlyFile5nt::CDataReader::m_SkipWhiteSpace( char* pData, unsigned int &curIndex, const unsigned int &arraySize )
+{
+	while ( ( curIndex < arraySize ) && this->m_bIsWhiteSpace( pData[curIndex] ) )
+	{
+		curIndex++;
+	}
+	return;
+}
+
+void CPlyFile5nt::CDataReader::ASCIISkipNextToken( char* pData, unsigned int &curIndex, const unsigned int &arraySize )
+{
+	curIndex = this->m_FindEndOfToken( pData, curIndex, arraySize );
+	this->m_SkipWhiteSpace( pData, curIndex, arraySize );
+	return;
+}
+
+double CPlyFile5nt::CDataReader::m_ParseDouble( const char* pFirst, const char* pLast )
+{
+	// These can be represented exactly as doubles
+	static const double powersOfTen[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 
+	                                      1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	static const unsigned long long MAXEXACTMANTISSA = 9007199254740992ULL;	// 2^53
+	static const int MAXMANTISSADIGITS = 19;	// So it doesn't overflow 64 bits
+
+	const char* pCur = pFirst;
+	bool bIsNegative = false;
+	if ( ( pCur != pLast ) && ( ( *pCur == '-' ) || ( *pCur == '+' ) ) )
+	{
+		bIsNegative = ( *pCur == '-' );
+		pCur++;
+	}
+
+	unsigned long long mantissa = 0;
+	int mantissaDigits = 0;
+	int exponent = 0;
+	bool bHasDigits = false;
+	bool bDroppedDigits = false;
+
+	// Whole number part (e.g. the "123" in "123.456e-7")
+	for ( ; ( pCur != pLast ) && ( *pCur >= '0' ) && ( *pCur <= '9' ); pCur++ )
+	{
+		bHasDigits = true;
+		if ( mantissaDigits < MAXMANTISSADIGITS )
+		{
+			mantissa = mantissa * 10 + static_cast<unsigned long long>( *pCur - '0' );
+			if ( mantissa != 0 ) { mantissaDigits++; }		// Don't count leading zeros
+		}
+		else
+		{
+			exponent++;
+			if ( *pCur != '0' ) { bDroppedDigits = true; }
+		}
+	}
+	// Fraction part (the "456")
+	if ( ( pCur != pLast ) && ( *pCur == '.' ) )
+	{
+		pCur++;
+		for ( ; ( pCur != pLast ) && ( *pCur >= '0' ) && ( *pCur <= '9' ); pCur++ )
+		{
+			bHasDigits = true;
+			if ( mantissaDigits < MAXMANTISSADIGITS )
+			{
+				mantissa = mantissa * 10 + static_cast<unsigned long long>( *pCur - '0' );
+				if ( mantissa != 0 ) { mantissaDigits++; }
+				exponent--;
+			}
+			else if ( *pCur != '0' )
+			{
+				bDroppedDigits = true;
+			}
+		}
+	}
+	// Exponent part (the "e-7")
+	if ( bHasDigits && ( pCur != pLast ) && ( ( *pCur == 'e' ) || ( *pCur == 'E' ) ) )
+	{
+		pCur++;
+		bool bExponentIsNegative = false;
+		if ( ( pCur != pLast ) && ( ( *pCur == '-' ) || ( *pCur == '+' ) ) )
+		{
+			bExponentIsNegative = ( *pCur == '-' );
+			pCur++;
+		}
+		int fileExponent = 0;
+		bool bHasExponentDigits = false;
+		for ( ; ( pCur != pLast ) && ( *pCur >= '0' ) && ( *pCur <= '9' ); pCur++ )
+		{
+			bHasExponentDigits = true;
+			if ( fileExponent < 10000 ) { fileExponent = fileExponent * 10 + ( *pCur - '0' ); }
+		}
+		if ( !bHasExponentDigits ) { pCur = pFirst; }		// Something like "1e" (let strtod() deal with it)
+		exponent += ( bExponentIsNegative ? -fileExponent : fileExponent );
+	}
+
+	// The "fast path": if the mantissa and the power of ten are both exact doubles, then one 
+	//	multiply (or divide) gives the correctly rounded answer (same as strtod gives).
+	// Almost every number in a ply file takes this path.
+	if ( bHasDigits && ( pCur == pLast ) && !bDroppedDigits && ( mantissa <= MAXEXACTMANTISSA ) && 
+		 ( exponent >= -22 ) && ( exponent <= 22 ) )
+	{
+		double value = static_cast<double>( mantissa );
+		value = ( exponent < 0 ) ? ( value / powersOfTen[-exponent] ) : ( value * powersOfTen[exponent] );
+		return ( bIsNegative ? -value : value );
+	}
+
+	// The "slow path" (hex floats, "inf", "nan", more than 19 digits, etc.)
+	// strtod() needs a zero terminated string, but small tokens can still go on the stack
+	const unsigned int tokenLength = static_cast<unsigned int>( pLast - pFirst );
+	static const unsigned int STACKBUFFERSIZE = 64;
+	if ( tokenLength < STACKBUFFERSIZE )
+	{
+		char tokenBuffer[STACKBUFFERSIZE];
+		memcpy( tokenBuffer, pFirst, tokenLength );
+		tokenBuffer[tokenLength] = '\0';
+		return strtod( tokenBuffer, 0 );
+	}
+	std::string tempString( pFirst, pLast );
+	return strtod( tempString.c_str(), 0 );
+}
+
 int CPlyFile5nt::CDataReader::ASCIIReadNextInt( char* pData, unsigned int &curIndex, const unsigned int &arraySize )
 {
-	std::string tempString = this->ASCIIReadNextString( pData, curIndex, arraySize );
-	int returnInt = atoi( tempString.c_str() );
-	return returnInt;
+	// Same rules as atoi(): optional sign, then digits up to the first thing that isn't one
+	unsigned int endOfToken = this->m_FindEndOfToken( pData, curIndex, arraySize );
+	unsigned int index = curIndex;
+	bool bIsNegative = false;
+	if ( ( index < endOfToken ) && ( ( pData[index] == '-' ) || ( pData[index] == '+' ) ) )
+	{
+		bIsNegative = ( pData[index] == '-' );
+		index++;
+	}
+	unsigned int returnUInt = 0;
+	for ( ; ( index < endOfToken ) && ( pData[index] >= '0' ) && ( pData[index] <= '9' ); index++ )
+	{
+		returnUInt = returnUInt * 10 + static_cast<unsigned int>( pData[index] - '0' );
+	}
+	curIndex = endOfToken;
+	this->m_SkipWhiteSpace( pData, curIndex, arraySize );
+
+	int returnInt = static_cast<int>( returnUInt );
+	return ( bIsNegative ? -returnInt : returnInt );
 }
 
 float CPlyFile5nt::CDataReader::ASCIIReadNextFloat( char* pData, unsigned int &curIndex, const unsigned int &arraySize )
 {
-	std::string tempString = this->ASCIIReadNextString( pData, curIndex, arraySize );
-	// Has an "e" in there?
-	//bool bSexyBreakpoint = false;
-	//if ( tempString.find('e') != std::string::npos )
-	//{
-	//	bSexyBreakpoint = true;
-	//}
-	float returnFloat = static_cast<float>( atof( tempString.c_str() ) );
+	unsigned int endOfToken = this->m_FindEndOfToken( pData, curIndex, arraySize );
+	float returnFloat = static_cast<float>( this->m_ParseDouble( &(pData[curIndex]), &(pData[endOfToken]) ) );
+	curIndex = endOfToken;
+	this->m_SkipWhiteSpace( pData, curIndex, arraySize );
+
 	if ( this->m_bRoundSmallFloatToZeroFlag )
 	{
 		if ( fabs(returnFloat) < this->m_roundToZeroValue )
@@ -113,31 +265,19 @@ float CPlyFile5nt::CDataReader::ASCIIReadNextFloat( char* pData, unsigned int &c
 
 bool CPlyFile5nt::OpenPLYFile2(std::wstring fileName, std::wstring &error)
 {
-	std::ifstream thePlyFile(fileName.c_str(), std::ios::binary );
-	if (!thePlyFile.is_open())
+	// Added: The file is memory mapped and parsed in place (no copy of the whole file)
+	// (It's unmapped when thePlyFile goes out of scope)
+	CFileView thePlyFile;
+	std::wstring openError;
+	if ( !thePlyFile.Open( fileName, openError ) )
 	{
-		error = L"Can't open the file. Sorry it didn't work out.";
+		error = L"Can't open the file. Sorry it didn't work out. (" + openError + L")";
 		return false;
 	}
 
-	thePlyFile.seekg(0, std::ios::end);
-	// reutrns "std::ios::pos_type" type (which seems to be int in VC++)
-	unsigned int fileSize = static_cast<unsigned int>( thePlyFile.tellg() );	
-	// Return to start
-	thePlyFile.seekg(0, std::ios::beg);
-		
-	//std::vector<char> data( static_cast<unsigned int>(fileSize), 0);
-	//this->m_vecRawData.resize( static_cast<unsigned int>(fileSize), 0);
-
-	char* pRawData = new char[ fileSize ];
+	unsigned int fileSize = thePlyFile.GetSize();
+	char* pRawData = thePlyFile.GetData();
 	unsigned int curIndex = 0;				// Location in the array
-	
-	// read the file
-	//std::vector<char> data;
-	//thePlyFile.read( &data[0], fileSize);
-	//thePlyFile.read( &(this->m_vecRawData[0]), fileSize);
-	thePlyFile.read( pRawData, fileSize );
-	thePlyFile.close();
 
 	// *****************************************************************************
 	// Process the header information
@@ -193,6 +333,7 @@ bool CPlyFile5nt::OpenPLYFile2(std::wstring fileName, std::wstring &error)
 
 		// Read the properties and note the index locations of them...
 		int currentIndex = 0;
+		this->m_PlyHeaderInfo.vecVertexPropertyTypes.clear();
 		while ( true )
 		{
 			tempString = reader.ASCIIReadNextString( pRawData, curIndex, fileSize );
@@ -201,8 +342,16 @@ bool CPlyFile5nt::OpenPLYFile2(std::wstring fileName, std::wstring &error)
 			if ( tempString == "property") 
 			{
 				tempString = reader.ASCIIReadNextString( pRawData, curIndex, fileSize );
-				if ( ( tempString == "float") | ( tempString == "uchar") )	
-				{	// Figure out which index to set
+				int propertySizeInBytes = CPlyHeaderDescription::GetPlyTypeSizeInBytes( tempString );
+				if ( propertySizeInBytes != 0 )	
+				{	// Keep track of the size (for binary files)
+					this->m_PlyHeaderInfo.vertexSizeInBytes += propertySizeInBytes;
+					if ( ( tempString != "float" ) && ( tempString != "float32" ) )
+					{
+						this->m_PlyHeaderInfo.bAllVertexPropertiesAreFloat = false;
+					}
+					this->m_PlyHeaderInfo.vecVertexPropertyTypes.push_back( CPlyHeaderDescription::GetPlyType( tempString ) );
+					// Figure out which index to set
 					tempString = reader.ASCIIReadNextString( pRawData, curIndex, fileSize );
 					this->m_setIndexBasedOnPropertyNameASCII( currentIndex, tempString );
 				}
@@ -228,8 +377,31 @@ bool CPlyFile5nt::OpenPLYFile2(std::wstring fileName, std::wstring &error)
 		do
 		{
 			tempString = reader.ASCIIReadNextString( pRawData, curIndex, fileSize );
+			// property list uchar int vertex_indices
+			// (the ASCII readers don't care, but the binary one does)
+			if ( tempString == "list" )
+			{
+				tempString = reader.ASCIIReadNextString( pRawData, curIndex, fileSize );
+				this->m_PlyHeaderInfo.faceListCountSizeInBytes = CPlyHeaderDescription::GetPlyTypeSizeInBytes( tempString );
+				tempString = reader.ASCIIReadNextString( pRawData, curIndex, fileSize );
+				this->m_PlyHeaderInfo.faceListIndexSizeInBytes = CPlyHeaderDescription::GetPlyTypeSizeInBytes( tempString );
+			}
 		} while ( tempString != "end_header" );
 
+		// ASCIIReadNextString() "eats" all the whitespace after "end_header", but with a binary 
+		//	file, the first few bytes of data could very well look like whitespace. 
+		// The header always ends with exactly one newline, so back up and find that instead.
+		if ( this->m_PlyHeaderInfo.plyFormatASCIIorBinary != CPlyHeaderDescription::FORMAT_IS_ASCII )
+		{
+			std::string rawHeader( pRawData, curIndex );
+			curIndex = static_cast<unsigned int>( rawHeader.rfind( "end_header" ) );
+			while ( ( curIndex < fileSize ) && ( pRawData[curIndex] != '\n' ) )
+			{
+				curIndex++;
+			}
+			curIndex++;		// Skip the newline
+		}
+
 
 
 
@@ -241,79 +413,231 @@ bool CPlyFile5nt::OpenPLYFile2(std::wstring fileName, std::wstring &error)
 	catch (...)
 	{
 		// Something is wrong
-		delete [] pRawData;
 		return false;
 	}
 
 	// *****************************************************************************
 
-	// Determine the type of file... so we can find the right Vertex adapter
+	// Determine the type of file... 
 	this->m_PlyHeaderInfo.DeterminePlyFileType();
 
-	// Find an appropriate vertex reader
-	IVertexReader* pVertReader;
-	// 
-	switch ( this->m_PlyHeaderInfo.plyHeaderLayout )
+	// Added: The vertex decoder is "compiled" from the properties in the header, so any 
+	//	layout will load (not just the ones there used to be a reader class for)
+	CVertexDecoder vertexDecoder;
+	if ( !vertexDecoder.Compile( this->m_PlyHeaderInfo ) )
 	{
-	case CPlyHeaderDescription::HEADER_LAYOUT_IS_ASCII_XYZ:
-		pVertReader = new CVertexReader_ASCII_fXYZ();
-		break;
-	case CPlyHeaderDescription::HEADER_LAYOUT_IS_ASCII_XYZ_nXYZ:
-		pVertReader = new CVertexReader_ASCII_fXYZ_nXYZ();
-		break;
-	case CPlyHeaderDescription::HEADER_LAYOUT_IS_ASCII_XYZ_nXYZ_vertUV:
-		pVertReader = new CVertexReader_ASCII_fXYZ_nXYZ_vertUV();
-		break;
-	case CPlyHeaderDescription::HEADER_LAYOUT_IS_ASCII_XYZ_vertUV:
-		pVertReader = new CVertexReader_ASCII_fXYZ_vertUV();
-		break;
-	case CPlyHeaderDescription::HEADER_LAYOUT_IS_ASCII_XYZ_nXYZ_ucharRGBA_vertUV:
-		pVertReader = new CVertexReader_ASCII_XYZ_nXYZ_ucharRGBA_vertUV();
-		break;
-	default:
-		// There is no reader that can handle this format
-		pVertReader = 0;
-		error = L"Error: No vertex reader to handle this format";
+		error = L"Error: No vertex reader to handle this format (it needs x, y, and z)";
 		return false;
-	};
+	}
+	vertexDecoder.SetScaleRGBA_OneByteValuesToFloatZeroToOne( this->m_b_ScaleRGBA_OneByteValuesToFloatZeroToOne );
 
-	// Double-check if we got a valid reader
-	if ( ( pVertReader == 0 ) && !pVertReader->IsReaderValid( this->m_PlyHeaderInfo.plyHeaderLayout ) )
+	const unsigned int numberOfVertices = static_cast<unsigned int>( this->m_PlyHeaderInfo.numberOfVertices );
+	const unsigned int firstVertex = this->m_vertexStreams.size();
+	this->m_AddVertexStreamsFromHeader();
+
+	// Added: Binary files are read as entire blocks
+	if ( ( this->m_PlyHeaderInfo.plyFormatASCIIorBinary == CPlyHeaderDescription::FORMAT_IS_BINARY_BIG_ENDIAN ) || 
+		 ( this->m_PlyHeaderInfo.plyFormatASCIIorBinary == CPlyHeaderDescription::FORMAT_IS_BINARY_LITTLE_ENDIAN ) )
 	{
-		// No good
-		delete [] pRawData;
-		return false;
-	}
+		bool bFileIsBigEndian = ( this->m_PlyHeaderInfo.plyFormatASCIIorBinary == CPlyHeaderDescription::FORMAT_IS_BINARY_BIG_ENDIAN );
+		bool bSwapBytes = ( bFileIsBigEndian != this->m_PlyHeaderInfo.bIsThisMachineIsBigEndian() );
+		vertexDecoder.SetSwapBytes( bSwapBytes );
+
+		this->m_vertexStreams.resize( firstVertex + numberOfVertices );
+		if ( !this->m_DecodeVerticesInBlocks( vertexDecoder, true, firstVertex, numberOfVertices, pRawData, curIndex, fileSize ) )
+		{
+			this->m_vertexStreams.resize( firstVertex );
+			error = L"Error: The vertex data is shorter than the header says it should be.";
+			return false;
+		}
+
+		this->calcualteExtents();
+
+		CBlockReader_BINARY binaryReader;
+		binaryReader.SetSwapBytes( bSwapBytes );
+		if ( !binaryReader.ProcessElementBlock( this->m_elements, this->m_PlyHeaderInfo, pRawData, curIndex, fileSize ) )
+		{
+			error = L"Error: The face data is truncated or isn't all triangles.";
+			return false;
+		}
+		// Added: Everything after this uses the indices to look up vertices
+		if ( !this->bElementIndicesAreValid() )
+		{
+			error = L"Error: A face uses a vertex that isn't in the file.";
+			return false;
+		}
+
+		this->m_fileInformation.fileName = fileName;
+		this->m_fileInformation.fileType = CFileInfo::MODEL_FILE_TYPE_PLY;
+
+		return true;
+	}// if binary
 
-	pVertReader->SetScaleRGBA_OneByteValuesToFloatZeroToOne( this->m_b_ScaleRGBA_OneByteValuesToFloatZeroToOne );
+	CElementReader_3intVert elementReader;
 
-	// We have a valid vertex reader, so read the vertices
-	this->m_verticies.reserve( this->m_PlyHeaderInfo.numberOfVertices );
-	for ( unsigned int vertCount = 0; vertCount != this->m_PlyHeaderInfo.numberOfVertices; vertCount++ )
+	// Added: Big files can be done on more than one thread
+	bool bParsedInParallel = false;
+	if ( this->m_bParallelASCIIParsing )
 	{
-		PlyVertex tempVertex;
-		pVertReader->ProcessNextVertex( tempVertex, pRawData, curIndex, fileSize );
-		this->m_verticies.push_back( tempVertex );
+		bParsedInParallel = this->m_ParseASCIIBodyInParallel( &vertexDecoder, &elementReader, pRawData, curIndex, fileSize );
 	}
 
-	this->calcualteExtents();
-
-	// Now read the elements...
-	IElementReader* pElementReader = new CPlyFile5nt::CElementReader_3intVert();
+	if ( bParsedInParallel )
+	{
+		this->calcualteExtents();
+	}
+	else
+	{
+		// Read all the vertices in one go
+		this->m_vertexStreams.resize( firstVertex + numberOfVertices );
+		this->m_DecodeVerticesInBlocks( vertexDecoder, false, firstVertex, numberOfVertices, pRawData, curIndex, fileSize );
+
+		this->calcualteExtents();
+
+		// Now read the elements...
+		this->m_elements.reserve( this->m_PlyHeaderInfo.numberOfElements );
+		for ( unsigned int elementCount = 0; elementCount != this->m_PlyHeaderInfo.numberOfElements; elementCount++ )
+		{	
+			PlyElement tempElement;
+			elementReader.ProcessNextElement( tempElement, pRawData, curIndex, fileSize );
+			this->m_elements.push_back( tempElement );
+		}
+	}// if ( bParsedInParallel )
 
-	this->m_elements.reserve( this->m_PlyHeaderInfo.numberOfElements );
-	for ( unsigned int elementCount = 0; elementCount != this->m_PlyHeaderInfo.numberOfElements; elementCount++ )
-	{	
-		PlyElement tempElement;
-		pElementReader->ProcessNextElement( tempElement, pRawData, curIndex, fileSize );
-		this->m_elements.push_back( tempElement );
+	// Added: Everything after this uses the indices to look up vertices
+	if ( !this->bElementIndicesAreValid() )
+	{
+		error = L"Error: A face uses a vertex that isn't in the file.";
+		return false;
 	}
 		
 	this->m_fileInformation.fileName = fileName;
 	this->m_fileInformation.fileType = CFileInfo::MODEL_FILE_TYPE_PLY;
 
-	delete [] pRawData;
+	return true;
+}
+
+bool CPlyFile5nt::m_ParseASCIIBodyInParallel( CVertexDecoder* pVertexDecoder, IElementReader* pElementReader, 
+											  char* pRawData, unsigned int curIndex, const unsigned int &fileSize )
+{
+	const unsigned int numberOfVertices = static_cast<unsigned int>( this->m_PlyHeaderInfo.numberOfVertices );
+	const unsigned int numberOfElements = static_cast<unsigned int>( this->m_PlyHeaderInfo.numberOfElements );
+	const unsigned int numberOfLines = numberOfVertices + numberOfElements;
+
+	// Not worth it for small files
+	if ( numberOfLines < ( 2 * CPlyFile5nt::PARALLELPARSEMINLINESPERBLOCK ) )
+	{
+		return false;
+	}
+
+	// Find where each vertex and face line starts. 
+	// Skips any extra whitespace (blank lines, CR + LF, etc.) like the serial reader does
+	std::vector<unsigned int> vecLineStarts;
+	vecLineStarts.reserve( numberOfLines );
+	unsigned int index = curIndex;
+	while ( ( vecLineStarts.size() < numberOfLines ) && ( index < fileSize ) )
+	{
+		vecLineStarts.push_back( index );
+		const char* pNewLine = static_cast<const char*>( memchr( &(pRawData[index]), '\n', fileSize - index ) );
+		if ( pNewLine == 0 )
+		{
+			break;
+		}
+		index = static_cast<unsigned int>( pNewLine - pRawData ) + 1;
+		while ( ( index < fileSize ) && isspace( static_cast<unsigned char>( pRawData[index] ) ) )
+		{
+			index++;
+		}
+	}
+	if ( vecLineStarts.size() != numberOfLines )
+	{	// File is shorter than the header says
+		return false;
+	}
+
+	// Split the lines into blocks (a few per thread, so they even out)
+	CThreadPool* pThreadPool = CThreadPool::getSharedInstance();
+	unsigned int linesPerBlock = numberOfLines / ( pThreadPool->GetNumberOfThreads() * 4 ) + 1;
+	if ( linesPerBlock < CPlyFile5nt::PARALLELPARSEMINLINESPERBLOCK )
+	{
+		linesPerBlock = CPlyFile5nt::PARALLELPARSEMINLINESPERBLOCK;
+	}
+	const unsigned int numberOfBlocks = ( numberOfLines + linesPerBlock - 1 ) / linesPerBlock;
+
+	// The decoder and reader don't change as they read, so all the threads can share them
+	const unsigned int firstVertex = this->m_vertexStreams.size();
+	std::vector<PlyElement>::size_type firstElement = this->m_elements.size();
+	this->m_vertexStreams.resize( firstVertex + numberOfVertices );
+	this->m_elements.resize( firstElement + numberOfElements );
+
+	std::atomic<bool> bEveryLineLinedUp( true );
 
+	pThreadPool->ParallelFor( numberOfBlocks, [&]( unsigned int blockIndex )
+	{
+		unsigned int firstLine = blockIndex * linesPerBlock;
+		unsigned int lastLine = firstLine + linesPerBlock;
+		if ( lastLine > numberOfLines )
+		{
+			lastLine = numberOfLines;
+		}
+		unsigned int blockIndexInFile = vecLineStarts[firstLine];
+		for ( unsigned int lineIndex = firstLine; lineIndex != lastLine; lineIndex++ )
+		{
+			if ( lineIndex < numberOfVertices )
+			{	// (Each thread only writes its own vertices, so they can share the streams)
+				PlyVertex tempVertex;
+				pVertexDecoder->DecodeASCIIVertices( &tempVertex, 1, pRawData, blockIndexInFile, fileSize );
+				this->m_vertexStreams.SetVertex( firstVertex + lineIndex, tempVertex );
+			}
+			else
+			{
+				pElementReader->ProcessNextElement( this->m_elements[firstElement + lineIndex - numberOfVertices], pRawData, blockIndexInFile, fileSize );
+			}
+			// Each vertex or face has to use up exactly one line. If not, the serial version 
+			//	would come up with a different answer, so give up. 
+			if ( ( ( lineIndex + 1 ) < numberOfLines ) && ( blockIndexInFile != vecLineStarts[lineIndex + 1] ) )
+			{
+				bEveryLineLinedUp = false;
+				return;
+			}
+		}
+	} );
+
+	if ( !bEveryLineLinedUp )
+	{	// Put things back the way they were
+		this->m_vertexStreams.resize( firstVertex );
+		this->m_elements.resize( firstElement );
+		return false;
+	}
+	return true;
+}
+
+bool CPlyFile5nt::m_DecodeVerticesInBlocks( CVertexDecoder &vertexDecoder, bool bIsBinary, unsigned int firstVertex, unsigned int numberOfVertices, 
+											char* pRawData, unsigned int &curIndex, const unsigned int &fileSize )
+{
+	std::vector<PlyVertex> vecBlock( ( numberOfVertices < CPlyFile5nt::DECODEBLOCKSIZE ) ? numberOfVertices : CPlyFile5nt::DECODEBLOCKSIZE );
+	for ( unsigned int blockStart = 0; blockStart < numberOfVertices; blockStart += CPlyFile5nt::DECODEBLOCKSIZE )
+	{
+		unsigned int blockSize = numberOfVertices - blockStart;
+		if ( blockSize > CPlyFile5nt::DECODEBLOCKSIZE )
+		{
+			blockSize = CPlyFile5nt::DECODEBLOCKSIZE;
+		}
+		if ( bIsBinary )
+		{
+			if ( !vertexDecoder.DecodeBinaryVertices( &(vecBlock[0]), blockSize, pRawData, curIndex, fileSize ) )
+			{
+				return false;
+			}
+		}
+		else
+		{
+			vertexDecoder.DecodeASCIIVertices( &(vecBlock[0]), blockSize, pRawData, curIndex, fileSize );
+		}
+		for ( unsigned int index = 0; index != blockSize; index++ )
+		{
+			this->m_vertexStreams.SetVertex( firstVertex + blockStart + index, vecBlock[index] );
+		}
+	}
 	return true;
 }
 
@@ -335,6 +659,12 @@ CPlyFile5nt::CPlyHeaderDescription::CPlyHeaderDescription()
 	this->numberOfVertices = 0;
 	this->plyFormatASCIIorBinary = CPlyHeaderDescription::FORMAT_UNKNOWN;
 
+	// Used for binary files
+	this->vertexSizeInBytes = 0;
+	this->bAllVertexPropertiesAreFloat = true;
+	this->faceListCountSizeInBytes = 0;
+	this->faceListIndexSizeInBytes = 0;
+
 	// Mainly used for the GDP file format
 	this->bHasTangentsInFile = false;
 	this->bHasBiNormalsInFile = false;
@@ -359,6 +689,52 @@ bool CPlyFile5nt::bIsThisMachineIsBigEndian(void)
 	return this->m_PlyHeaderInfo.bIsThisMachineIsBigEndian();
 }
 
+//static 
+int CPlyFile5nt::CPlyHeaderDescription::GetPlyTypeSizeInBytes( std::string plyTypeName )
+{
+	// The original names, then the "new" ones (some exporters use those)
+	if ( ( plyTypeName == "char" )   || ( plyTypeName == "int8" ) )		{ return 1; }
+	if ( ( plyTypeName == "uchar" )  || ( plyTypeName == "uint8" ) )	{ return 1; }
+	if ( ( plyTypeName == "short" )  || ( plyTypeName == "int16" ) )	{ return 2; }
+	if ( ( plyTypeName == "ushort" ) || ( plyTypeName == "uint16" ) )	{ return 2; }
+	if ( ( plyTypeName == "int" )    || ( plyTypeName == "int32" ) )	{ return 4; }
+	if ( ( plyTypeName == "uint" )   || ( plyTypeName == "uint32" ) )	{ return 4; }
+	if ( ( plyTypeName == "float" )  || ( plyTypeName == "float32" ) )	{ return 4; }
+	if ( ( plyTypeName == "double" ) || ( plyTypeName == "float64" ) )	{ return 8; }
+	// Don't know what this is
+	return 0;
+}
+
+//static 
+CPlyFile5nt::CPlyHeaderDescription::enumPlyPropertyType CPlyFile5nt::CPlyHeaderDescription::GetPlyType( std::string plyTypeName )
+{
+	if ( ( plyTypeName == "char" )   || ( plyTypeName == "int8" ) )		{ return PLY_TYPE_CHAR; }
+	if ( ( plyTypeName == "uchar" )  || ( plyTypeName == "uint8" ) )	{ return PLY_TYPE_UCHAR; }
+	if ( ( plyTypeName == "short" )  || ( plyTypeName == "int16" ) )	{ return PLY_TYPE_SHORT; }
+	if ( ( plyTypeName == "ushort" ) || ( plyTypeName == "uint16" ) )	{ return PLY_TYPE_USHORT; }
+	if ( ( plyTypeName == "int" )    || ( plyTypeName == "int32" ) )	{ return PLY_TYPE_INT; }
+	if ( ( plyTypeName == "uint" )   || ( plyTypeName == "uint32" ) )	{ return PLY_TYPE_UINT; }
+	if ( ( plyTypeName == "float" )  || ( plyTypeName == "float32" ) )	{ return PLY_TYPE_FLOAT; }
+	if ( ( plyTypeName == "double" ) || ( plyTypeName == "float64" ) )	{ return PLY_TYPE_DOUBLE; }
+	return PLY_TYPE_UNKNOWN;
+}
+
+//static 
+int CPlyFile5nt::CPlyHeaderDescription::GetPlyTypeSizeInBytes( enumPlyPropertyType plyType )
+{
+	switch ( plyType )
+	{
+	case PLY_TYPE_CHAR:		case PLY_TYPE_UCHAR:	return 1;
+	case PLY_TYPE_SHORT:	case PLY_TYPE_USHORT:	return 2;
+	case PLY_TYPE_INT:		case PLY_TYPE_UINT:		return 4;
+	case PLY_TYPE_FLOAT:							return 4;
+	case PLY_TYPE_DOUBLE:							return 8;
+	default:
+		break;
+	}
+	return 0;
+}
+
 bool CPlyFile5nt::CPlyHeaderDescription::bIsHeader_XYZ(void)
 {
 	// ASCII_XYZ: 
@@ -550,6 +926,26 @@ void CPlyFile5nt::CPlyHeaderDescription::DeterminePlyFileType(void)
 		this->plyHeaderLayout = CPlyHeaderDescription::HEADER_LAYOUT_IS_ASCII_XYZ_nXYZ_ucharRGBA_vertUV;
 	}
 	// else, we dunno what the heck the layout is (well, we can't process it, anyway)
+
+	// Added: binary files (all floats). 
+	// NOTE: OpenPLYFile2() doesn't need these any more (CVertexDecoder can read any layout)
+	if ( ( ( this->plyFormatASCIIorBinary == CPlyHeaderDescription::FORMAT_IS_BINARY_BIG_ENDIAN ) || 
+		   ( this->plyFormatASCIIorBinary == CPlyHeaderDescription::FORMAT_IS_BINARY_LITTLE_ENDIAN ) ) && 
+		 this->bAllVertexPropertiesAreFloat )
+	{
+		if ( this->bIsHeader_XYZ() )
+		{
+			this->plyHeaderLayout = CPlyHeaderDescription::HEADER_LAYOUT_IS_BINARY_XYZ;
+		}
+		else if ( this->bIsHeader_XYZ_nXYZ() )
+		{
+			this->plyHeaderLayout = CPlyHeaderDescription::HEADER_LAYOUT_IS_BINARY_XYZ_nXYZ;
+		}
+		else if ( this->bIsHeader_XYZ_nXYZ_vertUV() )
+		{
+			this->plyHeaderLayout = CPlyHeaderDescription::HEADER_LAYOUT_IS_BINARY_XYZ_nXYZ_vertUV;
+		}
+	}
 	
 	return;
 }
@@ -571,177 +967,338 @@ void CPlyFile5nt::CPlyHeaderDescription::DeterminePlyFileType(void)
 
 
 
- //   _    ___   ___  ___  ___      __ __  ____   __ ____
- //  /_\  / __| / __||_ _||_ _|    / _|\ \/ /\ \ / /|_  /
- // / _ \ \__ \| (__  | |  | |    |  _| >  <  \ V /  / / 
- ///_/ \_\|___/ \___||___||___|___|_|  /_/\_\  |_|  /___|
- //                           |___|                      
-bool CPlyFile5nt::CVertexReader_ASCII_fXYZ::IsReaderValid( CPlyHeaderDescription::enumPlyHeaderLayout plyFileType )
+ //   ___ __   __          _             ___                   _           
+ //  / __|\ \ / /___  _ _ | |_  ___ __ _|   \  ___  __  ___  __| | ___  _ _ 
+ // | (__  \ V // -_)| '_||  _|/ -_)\ \ /| |) |/ -_)/ _|/ _ \/ _` |/ -_)| '_|
+ //  \___|  \_/ \___||_|   \__|\___|/_\_\|___/ \___|\__|\___/\__,_|\___||_|  
+ //                                                                         
+CPlyFile5nt::CVertexDecoder::CVertexDecoder()
 {
-	if ( plyFileType == CPlyFile5nt::CPlyHeaderDescription::HEADER_LAYOUT_IS_ASCII_XYZ )
-	{
-		return true;
-	}	
-	return false;
+	this->m_vertexSizeInBytes = 0;
+	this->m_bSwapBytes = false;
+	this->m_bScaleRGBA_OneByteValuesToFloatZeroToOne = true;
+	this->m_numberOfFastFloats = 0;
+	return;
+}
+
+void CPlyFile5nt::CVertexDecoder::SetSwapBytes( bool bSwapBytes )
+{
+	this->m_bSwapBytes = bSwapBytes;
+	return;
+}
+
+void CPlyFile5nt::CVertexDecoder::SetScaleRGBA_OneByteValuesToFloatZeroToOne( bool bEnabled )
+{
+	this->m_bScaleRGBA_OneByteValuesToFloatZeroToOne = bEnabled;
+	return;
 }
 
-bool CPlyFile5nt::CVertexReader_ASCII_fXYZ::ProcessNextVertex( PlyVertex &vertex, char* pData, 
-															   unsigned int &curIndex, const unsigned int &arraySize )
+bool CPlyFile5nt::CVertexDecoder::Compile( const CPlyHeaderDescription &headerInfo )
 {
-	//property float x
-	//property float y
-	//property float z
-	vertex.xyz.x = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.xyz.y = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.xyz.z = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
+	this->m_vecSteps.clear();
+	this->m_vertexSizeInBytes = 0;
+	this->m_numberOfFastFloats = 0;
+
+	const int numberOfProperties = static_cast<int>( headerInfo.vecVertexPropertyTypes.size() );
+
+	if ( ( headerInfo.x_propertyIndex >= numberOfProperties ) || 
+		 ( headerInfo.y_propertyIndex >= numberOfProperties ) || 
+		 ( headerInfo.z_propertyIndex >= numberOfProperties ) )
+	{
+		return false;
+	}
+
+	// Figure out where each property we know about goes in the PlyVertex (as an offset, in bytes)
+	const int dontStore = CVertexDecoder::DONT_STORE;	// (so the vector doesn't take a reference to the static const)
+	std::vector<int> vecOffsetInPlyVertex( numberOfProperties, dontStore );
+	PlyVertex sampleVertex;
+	const char* pSampleVertex = reinterpret_cast<const char*>( &sampleVertex );
+	struct sPropertyDestination
+	{
+		int propertyIndex;
+		const float* pField;
+	};
+	const sPropertyDestination destinations[] = 
+	{
+		{ headerInfo.x_propertyIndex, &(sampleVertex.xyz.x) },
+		{ headerInfo.y_propertyIndex, &(sampleVertex.xyz.y) },
+		{ headerInfo.z_propertyIndex, &(sampleVertex.xyz.z) },
+		{ headerInfo.normx_propertyIndex, &(sampleVertex.nx) },
+		{ headerInfo.normy_propertyIndex, &(sampleVertex.ny) },
+		{ headerInfo.normz_propertyIndex, &(sampleVertex.nz) },
+		{ headerInfo.red_propertyIndex, &(sampleVertex.red) },
+		{ headerInfo.green_propertyIndex, &(sampleVertex.green) },
+		{ headerInfo.blue_propertyIndex, &(sampleVertex.blue) },
+		{ headerInfo.alpha_propertyIndex, &(sampleVertex.alpha) },
+		{ headerInfo.tex0u_propertyIndex, &(sampleVertex.tex0u) },
+		{ headerInfo.tex0v_propertyIndex, &(sampleVertex.tex0v) },
+		{ headerInfo.tex1u_propertyIndex, &(sampleVertex.tex1u) },
+		{ headerInfo.tex1v_propertyIndex, &(sampleVertex.tex1v) },
+		{ headerInfo.tangentX_propertyIndex, &(sampleVertex.tangent.x) },
+		{ headerInfo.tangentY_propertyIndex, &(sampleVertex.tangent.y) },
+		{ headerInfo.tangentZ_propertyIndex, &(sampleVertex.tangent.z) },
+		{ headerInfo.binormalX_propertyIndex, &(sampleVertex.binormal.x) },
+		{ headerInfo.binormalY_propertyIndex, &(sampleVertex.binormal.y) },
+		{ headerInfo.binormalZ_propertyIndex, &(sampleVertex.binormal.z) }
+	};
+	const unsigned int numberOfDestinations = sizeof(destinations) / sizeof(destinations[0]);
+	for ( unsigned int destIndex = 0; destIndex != numberOfDestinations; destIndex++ )
+	{
+		int propertyIndex = destinations[destIndex].propertyIndex;
+		if ( ( propertyIndex >= 0 ) && ( propertyIndex < numberOfProperties ) )
+		{
+			vecOffsetInPlyVertex[propertyIndex] = static_cast<int>( reinterpret_cast<const char*>( destinations[destIndex].pField ) - pSampleVertex );
+		}
+	}
+
+	// Make the steps
+	bool bAllFloatsAndAllStored = true;
+	for ( int propertyIndex = 0; propertyIndex != numberOfProperties; propertyIndex++ )
+	{
+		sDecodeStep curStep;
+		curStep.type = headerInfo.vecVertexPropertyTypes[propertyIndex];
+		if ( curStep.type == CPlyHeaderDescription::PLY_TYPE_UNKNOWN )
+		{
+			return false;
+		}
+		curStep.offsetInFileVertex = this->m_vertexSizeInBytes;
+		curStep.offsetInPlyVertex = vecOffsetInPlyVertex[propertyIndex];
+		curStep.bIsOneByteColour = ( ( curStep.type == CPlyHeaderDescription::PLY_TYPE_CHAR ) || 
+		                             ( curStep.type == CPlyHeaderDescription::PLY_TYPE_UCHAR ) ) && 
+		                           ( ( propertyIndex == headerInfo.red_propertyIndex ) || 
+		                             ( propertyIndex == headerInfo.green_propertyIndex ) || 
+		                             ( propertyIndex == headerInfo.blue_propertyIndex ) || 
+		                             ( propertyIndex == headerInfo.alpha_propertyIndex ) );
+		this->m_vecSteps.push_back( curStep );
+
+		this->m_vertexSizeInBytes += CPlyHeaderDescription::GetPlyTypeSizeInBytes( curStep.type );
+
+		if ( ( curStep.type != CPlyHeaderDescription::PLY_TYPE_FLOAT ) || ( curStep.offsetInPlyVertex == CVertexDecoder::DONT_STORE ) )
+		{
+			bAllFloatsAndAllStored = false;
+		}
+	}
+
+	// Can we use one of the "fast" kernels? 
+	if ( bAllFloatsAndAllStored && ( this->m_vecSteps.size() <= CVertexDecoder::MAXFASTFLOATS ) )
+	{
+		this->m_numberOfFastFloats = static_cast<unsigned int>( this->m_vecSteps.size() );
+		for ( unsigned int floatIndex = 0; floatIndex != this->m_numberOfFastFloats; floatIndex++ )
+		{
+			this->m_fastFloatOffsetInPlyVertex[floatIndex] = this->m_vecSteps[floatIndex].offsetInPlyVertex;
+		}
+	}
 	return true;
 }
 
- //  __ __  ____   __ ____         __  ____   __ ____                  _    _   _ __   __
- // / _|\ \/ /\ \ / /|_  /    _ _  \ \/ /\ \ / /|_  /  __ __ ___  _ _ | |_ | | | |\ \ / /
- //|  _| >  <  \ V /  / /    | ' \  >  <  \ V /  / /   \ V // -_)| '_||  _|| |_| | \ V / 
- //|_|  /_/\_\  |_|  /___|___|_||_|/_/\_\  |_|  /___|___\_/ \___||_|   \__| \___/   \_/  
- //                      |___|                      |___|                                
-bool CPlyFile5nt::CVertexReader_ASCII_fXYZ_nXYZ_vertUV::IsReaderValid( CPlyHeaderDescription::enumPlyHeaderLayout plyFileType )
+void CPlyFile5nt::CVertexDecoder::DecodeASCIIVertices( PlyVertex* pVertices, unsigned int numberOfVertices, 
+													   char* pData, unsigned int &curIndex, const unsigned int &arraySize )
 {
-	if ( plyFileType == CPlyFile5nt::CPlyHeaderDescription::HEADER_LAYOUT_IS_ASCII_XYZ_nXYZ_vertUV )
+	// Pick the kernel once (not once per vertex)
+	switch ( this->m_numberOfFastFloats )
 	{
-		return true;
+	case 3:		// x y z
+		this->m_DecodeASCIIFloats<3>( pVertices, numberOfVertices, pData, curIndex, arraySize );
+		break;
+	case 5:		// x y z u v
+		this->m_DecodeASCIIFloats<5>( pVertices, numberOfVertices, pData, curIndex, arraySize );
+		break;
+	case 6:		// x y z nx ny nz
+		this->m_DecodeASCIIFloats<6>( pVertices, numberOfVertices, pData, curIndex, arraySize );
+		break;
+	case 8:		// x y z nx ny nz u v
+		this->m_DecodeASCIIFloats<8>( pVertices, numberOfVertices, pData, curIndex, arraySize );
+		break;
+	default:
+		this->m_DecodeASCIIGeneric( pVertices, numberOfVertices, pData, curIndex, arraySize );
+		break;
 	}
-	return false;
+	return;
 }
 
-bool CPlyFile5nt::CVertexReader_ASCII_fXYZ_nXYZ_vertUV::ProcessNextVertex( PlyVertex &vertex, char* pData, 
-															   unsigned int &curIndex, const unsigned int &arraySize )
+bool CPlyFile5nt::CVertexDecoder::DecodeBinaryVertices( PlyVertex* pVertices, unsigned int numberOfVertices, 
+														char* pData, unsigned int &curIndex, const unsigned int &arraySize )
 {
-	//property float x
-	//property float y
-	//property float z
-	//property float nx
-	//property float ny
-	//property float nz
-	//property float texture_u
-	//property float texture_v
-	vertex.xyz.x = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.xyz.y = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.xyz.z = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.nx = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.ny = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.nz = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.tex0u = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.tex0v = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
+	unsigned long long blockSizeInBytes = static_cast<unsigned long long>( numberOfVertices ) * this->m_vertexSizeInBytes;
+	if ( ( curIndex + blockSizeInBytes ) > arraySize )
+	{
+		return false;
+	}
+	const char* pFileVertex = &(pData[curIndex]);
+
+	// (big endian files, on Intel, use the byte swapping kernels)
+	switch ( this->m_numberOfFastFloats )
+	{
+	case 3:
+		if ( this->m_bSwapBytes )	{ this->m_DecodeBinaryFloats<3, true>( pVertices, numberOfVertices, pFileVertex ); }
+		else						{ this->m_DecodeBinaryFloats<3, false>( pVertices, numberOfVertices, pFileVertex ); }
+		break;
+	case 5:
+		if ( this->m_bSwapBytes )	{ this->m_DecodeBinaryFloats<5, true>( pVertices, numberOfVertices, pFileVertex ); }
+		else						{ this->m_DecodeBinaryFloats<5, false>( pVertices, numberOfVertices, pFileVertex ); }
+		break;
+	case 6:
+		if ( this->m_bSwapBytes )	{ this->m_DecodeBinaryFloats<6, true>( pVertices, numberOfVertices, pFileVertex ); }
+		else						{ this->m_DecodeBinaryFloats<6, false>( pVertices, numberOfVertices, pFileVertex ); }
+		break;
+	case 8:
+		if ( this->m_bSwapBytes )	{ this->m_DecodeBinaryFloats<8, true>( pVertices, numberOfVertices, pFileVertex ); }
+		else						{ this->m_DecodeBinaryFloats<8, false>( pVertices, numberOfVertices, pFileVertex ); }
+		break;
+	default:
+		// Anything that isn't all floats
+		this->m_DecodeBinaryGeneric( pVertices, numberOfVertices, pFileVertex );
+		break;
+	}
+	curIndex += static_cast<unsigned int>( blockSizeInBytes );
 	return true;
 }
 
- //  __ __  ____   __ ____                  _    _   _ __   __
- // / _|\ \/ /\ \ / /|_  /  __ __ ___  _ _ | |_ | | | |\ \ / /
- //|  _| >  <  \ V /  / /   \ V // -_)| '_||  _|| |_| | \ V / 
- //|_|  /_/\_\  |_|  /___|___\_/ \___||_|   \__| \___/   \_/  
- //                      |___|                                
-bool CPlyFile5nt::CVertexReader_ASCII_fXYZ_vertUV::IsReaderValid( CPlyHeaderDescription::enumPlyHeaderLayout plyFileType )
+template <unsigned int NUMFLOATS>
+void CPlyFile5nt::CVertexDecoder::m_DecodeASCIIFloats( PlyVertex* pVertices, unsigned int numberOfVertices, 
+													   char* pData, unsigned int &curIndex, const unsigned int &arraySize )
 {
-	if ( plyFileType == CPlyFile5nt::CPlyHeaderDescription::HEADER_LAYOUT_IS_ASCII_XYZ_vertUV )
+	for ( unsigned int vertCount = 0; vertCount != numberOfVertices; vertCount++ )
 	{
-		return true;
+		char* pPlyVertex = reinterpret_cast<char*>( &(pVertices[vertCount]) );
+		// NUMFLOATS is known at compile time, so this gets unrolled
+		for ( unsigned int floatIndex = 0; floatIndex != NUMFLOATS; floatIndex++ )
+		{
+			*reinterpret_cast<float*>( pPlyVertex + this->m_fastFloatOffsetInPlyVertex[floatIndex] ) = 
+				this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
+		}
 	}
-	return false;
+	return;
 }
 
-bool CPlyFile5nt::CVertexReader_ASCII_fXYZ_vertUV::ProcessNextVertex( PlyVertex &vertex, char* pData, 
-															   unsigned int &curIndex, const unsigned int &arraySize )
+template <unsigned int NUMFLOATS, bool bSWAPBYTES>
+void CPlyFile5nt::CVertexDecoder::m_DecodeBinaryFloats( PlyVertex* pVertices, unsigned int numberOfVertices, const char* pFileVertex )
 {
-	//property float x
-	//property float y
-	//property float z
-	//property float texture_u
-	//property float texture_v
-	vertex.xyz.x = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.xyz.y = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.xyz.z = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.tex0u = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.tex0v = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	return true;
+	for ( unsigned int vertCount = 0; vertCount != numberOfVertices; vertCount++ )
+	{
+		char* pPlyVertex = reinterpret_cast<char*>( &(pVertices[vertCount]) );
+		for ( unsigned int floatIndex = 0; floatIndex != NUMFLOATS; floatIndex++ )
+		{
+			unsigned int floatBits = 0;
+			memcpy( &floatBits, pFileVertex + floatIndex * sizeof(float), sizeof(float) );
+			if ( bSWAPBYTES )
+			{
+				floatBits = ( floatBits >> 24 ) | ( ( floatBits >> 8 ) & 0x0000FF00 ) | ( ( floatBits << 8 ) & 0x00FF0000 ) | ( floatBits << 24 );
+			}
+			float value = 0.0f;
+			memcpy( &value, &floatBits, sizeof(float) );
+			*reinterpret_cast<float*>( pPlyVertex + this->m_fastFloatOffsetInPlyVertex[floatIndex] ) = this->m_RoundTinyFloatToZero( value );
+		}
+		pFileVertex += NUMFLOATS * sizeof(float);
+	}
+	return;
 }
 
- //  __ __  ____   __ ____         __  ____   __ ____
- // / _|\ \/ /\ \ / /|_  /    _ _  \ \/ /\ \ / /|_  /
- //|  _| >  <  \ V /  / /    | ' \  >  <  \ V /  / / 
- //|_|  /_/\_\  |_|  /___|___|_||_|/_/\_\  |_|  /___|
- //                      |___|                       
-bool CPlyFile5nt::CVertexReader_ASCII_fXYZ_nXYZ::IsReaderValid( CPlyHeaderDescription::enumPlyHeaderLayout plyFileType )
+void CPlyFile5nt::CVertexDecoder::m_DecodeASCIIGeneric( PlyVertex* pVertices, unsigned int numberOfVertices, 
+														char* pData, unsigned int &curIndex, const unsigned int &arraySize )
 {
-	if ( plyFileType == CPlyFile5nt::CPlyHeaderDescription::HEADER_LAYOUT_IS_ASCII_XYZ_nXYZ )
+	const sDecodeStep* pFirstStep = &(this->m_vecSteps[0]);
+	const sDecodeStep* pLastStep = pFirstStep + this->m_vecSteps.size();
+	for ( unsigned int vertCount = 0; vertCount != numberOfVertices; vertCount++ )
 	{
-		return true;
+		char* pPlyVertex = reinterpret_cast<char*>( &(pVertices[vertCount]) );
+		for ( const sDecodeStep* pStep = pFirstStep; pStep != pLastStep; pStep++ )
+		{
+			if ( pStep->offsetInPlyVertex == CVertexDecoder::DONT_STORE )
+			{
+				this->reader.ASCIISkipNextToken( pData, curIndex, arraySize );
+				continue;
+			}
+			float value = 0.0f;
+			if ( ( pStep->type == CPlyHeaderDescription::PLY_TYPE_FLOAT ) || ( pStep->type == CPlyHeaderDescription::PLY_TYPE_DOUBLE ) )
+			{
+				value = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
+			}
+			else
+			{
+				value = static_cast<float>( this->reader.ASCIIReadNextInt( pData, curIndex, arraySize ) );
+				if ( pStep->bIsOneByteColour && this->m_bScaleRGBA_OneByteValuesToFloatZeroToOne )
+				{
+					value = value / 255.0f;
+				}
+			}
+			*reinterpret_cast<float*>( pPlyVertex + pStep->offsetInPlyVertex ) = value;
+		}
 	}
-	return false;
+	return;
 }
 
-bool CPlyFile5nt::CVertexReader_ASCII_fXYZ_nXYZ::ProcessNextVertex( PlyVertex &vertex, char* pData, 
-															   unsigned int &curIndex, const unsigned int &arraySize )
+void CPlyFile5nt::CVertexDecoder::m_DecodeBinaryGeneric( PlyVertex* pVertices, unsigned int numberOfVertices, const char* pFileVertex )
 {
-	//property float x
-	//property float y
-	//property float z
-	//property float nx
-	//property float ny
-	//property float nz
-	vertex.xyz.x = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.xyz.y = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.xyz.z = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.nx = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.ny = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.nz = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	return true;
+	const sDecodeStep* pFirstStep = &(this->m_vecSteps[0]);
+	const sDecodeStep* pLastStep = pFirstStep + this->m_vecSteps.size();
+	for ( unsigned int vertCount = 0; vertCount != numberOfVertices; vertCount++ )
+	{
+		char* pPlyVertex = reinterpret_cast<char*>( &(pVertices[vertCount]) );
+		for ( const sDecodeStep* pStep = pFirstStep; pStep != pLastStep; pStep++ )
+		{
+			if ( pStep->offsetInPlyVertex == CVertexDecoder::DONT_STORE )
+			{
+				continue;
+			}
+			float value = this->m_ReadBinaryValueAsFloat( pFileVertex + pStep->offsetInFileVertex, pStep->type );
+			if ( ( pStep->type == CPlyHeaderDescription::PLY_TYPE_FLOAT ) || ( pStep->type == CPlyHeaderDescription::PLY_TYPE_DOUBLE ) )
+			{
+				value = this->m_RoundTinyFloatToZero( value );
+			}
+			else if ( pStep->bIsOneByteColour && this->m_bScaleRGBA_OneByteValuesToFloatZeroToOne )
+			{
+				value = value / 255.0f;
+			}
+			*reinterpret_cast<float*>( pPlyVertex + pStep->offsetInPlyVertex ) = value;
+		}
+		pFileVertex += this->m_vertexSizeInBytes;
+	}
+	return;
 }
 
-
-//    ____  ____   ______      __  ____   ______         _             ___  ___ ___   _                _   _   ___   __
-//   / _\ \/ /\ \ / /_  /  _ _ \ \/ /\ \ / /_  / _  _ __| |_  __ _ _ _| _ \/ __| _ ) /_\  __ _____ _ _| |_| | | \ \ / /
-//  |  _|>  <  \ V / / /  | ' \ >  <  \ V / / / | || / _| ' \/ _` | '_|   / (_ | _ \/ _ \ \ V / -_) '_|  _| |_| |\ V / 
-//  |_| /_/\_\  |_| /___|_|_||_/_/\_\  |_| /___|_\_,_\__|_||_\__,_|_| |_|_\\___|___/_/ \_\_\_/\___|_|  \__|\___/  \_/  
-//                     |___|                  |___|                                     |___|                          
-bool CPlyFile5nt::CVertexReader_ASCII_XYZ_nXYZ_ucharRGBA_vertUV::IsReaderValid( CPlyHeaderDescription::enumPlyHeaderLayout plyFileType )
+float CPlyFile5nt::CVertexDecoder::m_ReadBinaryValueAsFloat( const char* pValue, CPlyHeaderDescription::enumPlyPropertyType type )
 {
-	if ( plyFileType == CPlyFile5nt::CPlyHeaderDescription::HEADER_LAYOUT_IS_ASCII_XYZ_nXYZ_ucharRGBA_vertUV )
+	// Get the bytes in this machine's order
+	unsigned char bytes[8] = { 0 };
+	const int sizeInBytes = CPlyHeaderDescription::GetPlyTypeSizeInBytes( type );
+	for ( int byteIndex = 0; byteIndex != sizeInBytes; byteIndex++ )
 	{
-		return true;
+		bytes[byteIndex] = static_cast<unsigned char>( pValue[ this->m_bSwapBytes ? ( sizeInBytes - 1 - byteIndex ) : byteIndex ] );
 	}
-	return false;
+
+	switch ( type )
+	{
+	case CPlyHeaderDescription::PLY_TYPE_CHAR:
+		{ signed char value;		memcpy( &value, bytes, sizeof(value) );	return static_cast<float>( value ); }
+	case CPlyHeaderDescription::PLY_TYPE_UCHAR:
+		{ unsigned char value;		memcpy( &value, bytes, sizeof(value) );	return static_cast<float>( value ); }
+	case CPlyHeaderDescription::PLY_TYPE_SHORT:
+		{ short value;				memcpy( &value, bytes, sizeof(value) );	return static_cast<float>( value ); }
+	case CPlyHeaderDescription::PLY_TYPE_USHORT:
+		{ unsigned short value;		memcpy( &value, bytes, sizeof(value) );	return static_cast<float>( value ); }
+	case CPlyHeaderDescription::PLY_TYPE_INT:
+		{ int value;				memcpy( &value, bytes, sizeof(value) );	return static_cast<float>( value ); }
+	case CPlyHeaderDescription::PLY_TYPE_UINT:
+		{ unsigned int value;		memcpy( &value, bytes, sizeof(value) );	return static_cast<float>( value ); }
+	case CPlyHeaderDescription::PLY_TYPE_FLOAT:
+		{ float value;				memcpy( &value, bytes, sizeof(value) );	return value; }
+	case CPlyHeaderDescription::PLY_TYPE_DOUBLE:
+		{ double value;				memcpy( &value, bytes, sizeof(value) );	return static_cast<float>( value ); }
+	default:
+		break;
+	}
+	return 0.0f;
 }
 
-bool CPlyFile5nt::CVertexReader_ASCII_XYZ_nXYZ_ucharRGBA_vertUV::ProcessNextVertex( PlyVertex &vertex, char* pData, 
-															                        unsigned int &curIndex, const unsigned int &arraySize )
+float CPlyFile5nt::CVertexDecoder::m_RoundTinyFloatToZero( float value )
 {
-	//property float x
-	//property float y
-	//property float z
-	//property float nx
-	//property float ny
-	//property float nz
-	//property uchar red
-	//property uchar green
-	//property uchar blue
-	//property uchar alpha
-	//property float texture_u
-	//property float texture_v
-	vertex.xyz.x = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.xyz.y = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.xyz.z = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.nx = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.ny = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.nz = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.red = static_cast<float>( this->reader.ASCIIReadNextInt( pData, curIndex, arraySize ) );
-	vertex.green = static_cast<float>( this->reader.ASCIIReadNextInt( pData, curIndex, arraySize ) );
-	vertex.blue = static_cast<float>( this->reader.ASCIIReadNextInt( pData, curIndex, arraySize ) );
-	vertex.alpha = static_cast<float>( this->reader.ASCIIReadNextInt( pData, curIndex, arraySize ) );
-	if ( this->m_b_ScaleRGBA_OneByteValuesToFloatZeroToOne )
-	{
-		this->ScaleRGBA_OneByteValuesToZeroToOne( vertex );
-	}
-	vertex.tex0u = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	vertex.tex0v = this->reader.ASCIIReadNextFloat( pData, curIndex, arraySize );
-	return true;
+	// Same as the ASCII reader does
+	if ( this->reader.GetRoundTinyFloatsToZeroOnLoadFlag() && ( fabs(value) < this->reader.GetMinFloatRoundToZeroValue() ) )
+	{
+		return 0.0f;
+	}
+	return value;
 }
 
 
@@ -761,6 +1318,115 @@ bool CPlyFile5nt::CElementReader_3intVert::ProcessNextElement( PlyElement &eleme
 	return true;
 }
 
+
+ //  ___  _            _    ___                _                ___  ___  _  _    _    ___ __   __
+ // | _ )| | ___  __ | |__| _ \ ___  __ _  __| | ___  _ _     | _ )|_ _|| \| |  /_\  | _ \\ \ / /
+ // | _ \| |/ _ \/ _|| / /|   // -_)/ _` |/ _` |/ -_)| '_|    | _ \ | | | .` | / _ \ |   / \ V / 
+ // |___/|_|\___/\__||_\_\|_|_\\___|\__,_|\__,_|\___||_| ___ |___/|___||_|\_|/_/ \_\|_|_\  |_|  
+ //                                                     |___|                                  
+CPlyFile5nt::CBlockReader_BINARY::CBlockReader_BINARY()
+{
+	this->m_bSwapBytes = false;
+	return;
+}
+
+void CPlyFile5nt::CBlockReader_BINARY::SetSwapBytes( bool bSwapBytes )
+{
+	this->m_bSwapBytes = bSwapBytes;
+	return;
+}
+
+void CPlyFile5nt::CBlockReader_BINARY::m_SwapBytes32( unsigned int* pWords, unsigned int numberOfWords )
+{
+	unsigned int index = 0;
+	// Do 4 at a time: swap the bytes in each 16 bit half, then swap the halves
+	for ( ; ( index + 4 ) <= numberOfWords; index += 4 )
+	{
+		__m128i fourWords = _mm_loadu_si128( reinterpret_cast<__m128i*>( &(pWords[index]) ) );
+		fourWords = _mm_or_si128( _mm_slli_epi16( fourWords, 8 ), _mm_srli_epi16( fourWords, 8 ) );
+		fourWords = _mm_shufflelo_epi16( fourWords, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+		fourWords = _mm_shufflehi_epi16( fourWords, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( &(pWords[index]) ), fourWords );
+	}
+	// Any left over
+	for ( ; index < numberOfWords; index++ )
+	{
+		unsigned int word = pWords[index];
+		pWords[index] = ( word >> 24 ) | ( ( word >> 8 ) & 0x0000FF00 ) | ( ( word << 8 ) & 0x00FF0000 ) | ( word << 24 );
+	}
+	return;
+}
+
+unsigned int CPlyFile5nt::CBlockReader_BINARY::m_ReadBinaryUInt( const char* pData, int sizeInBytes )
+{
+	// The file is big endian if the machine is little endian and we're swapping (or vice versa)
+	const int i = 1;
+	const bool bMachineIsBigEndian = ( (*(char*)&i) == 0 );
+	const bool bFileIsBigEndian = ( bMachineIsBigEndian != this->m_bSwapBytes );
+
+	const unsigned char* pBytes = reinterpret_cast<const unsigned char*>( pData );
+	unsigned int theUInt = 0;
+	for ( int byteIndex = 0; byteIndex != sizeInBytes; byteIndex++ )
+	{
+		int shiftIndex = ( bFileIsBigEndian ? ( sizeInBytes - 1 - byteIndex ) : byteIndex );
+		theUInt |= ( static_cast<unsigned int>( pBytes[byteIndex] ) << ( 8 * shiftIndex ) );
+	}
+	return theUInt;
+}
+
+bool CPlyFile5nt::CBlockReader_BINARY::ProcessElementBlock( std::vector<PlyElement> &vecElements, const CPlyHeaderDescription &headerInfo, 
+															char* pData, unsigned int &curIndex, const unsigned int &arraySize )
+{
+	const unsigned int numberOfElements = static_cast<unsigned int>( headerInfo.numberOfElements );
+	const int countSize = headerInfo.faceListCountSizeInBytes;
+	const int indexSize = headerInfo.faceListIndexSizeInBytes;
+	// Didn't find a "property list ..." line?
+	if ( ( countSize == 0 ) || ( indexSize == 0 ) || ( indexSize > 4 ) )
+	{
+		return false;
+	}
+	const unsigned int faceSizeInBytes = static_cast<unsigned int>( countSize + 3 * indexSize );
+	if ( ( curIndex + numberOfElements * faceSizeInBytes ) > arraySize )
+	{
+		return false;
+	}
+
+	std::vector<PlyElement>::size_type firstElement = vecElements.size();
+	vecElements.resize( firstElement + numberOfElements );
+	for ( unsigned int elementCount = 0; elementCount != numberOfElements; elementCount++ )
+	{
+		// Only triangles, please
+		if ( this->m_ReadBinaryUInt( &(pData[curIndex]), countSize ) != 3 )
+		{
+			return false;
+		}
+		curIndex += countSize;
+
+		PlyElement &curElement = vecElements[firstElement + elementCount];
+		if ( indexSize == 4 )
+		{	// Most common "uchar int" case: copy now, swap the whole lot later
+			memcpy( &(curElement.vertex_index_1), &(pData[curIndex]), sizeof(int) );
+			memcpy( &(curElement.vertex_index_2), &(pData[curIndex + 4]), sizeof(int) );
+			memcpy( &(curElement.vertex_index_3), &(pData[curIndex + 8]), sizeof(int) );
+		}
+		else
+		{
+			curElement.vertex_index_1 = static_cast<int>( this->m_ReadBinaryUInt( &(pData[curIndex]), indexSize ) );
+			curElement.vertex_index_2 = static_cast<int>( this->m_ReadBinaryUInt( &(pData[curIndex + indexSize]), indexSize ) );
+			curElement.vertex_index_3 = static_cast<int>( this->m_ReadBinaryUInt( &(pData[curIndex + 2 * indexSize]), indexSize ) );
+		}
+		curIndex += 3 * indexSize;
+	}
+
+	// PlyElement is just three ints, so it can be swapped as one big array
+	if ( ( indexSize == 4 ) && this->m_bSwapBytes && ( numberOfElements != 0 ) )
+	{
+		static_assert( sizeof(PlyElement) == ( 3 * sizeof(int) ), "PlyElement is expected to be three packed ints" );
+		this->m_SwapBytes32( reinterpret_cast<unsigned int*>( &(vecElements[firstElement]) ), numberOfElements * 3 );
+	}
+	return true;
+}
+
 void CPlyFile5nt::m_gdp_StoreBoolToCharArray( char* pCharArrLoc, bool bValue )
 {
 	(*pCharArrLoc) = ( bValue ? CPlyHeaderDescription::GDP_TRUE : CPlyHeaderDescription::GDP_FALSE );
@@ -906,13 +1572,12 @@ bool CPlyFile5nt::SaveGDPFile(std::wstring fileName, bool bOverwrite, std::wstri
 	//unsigned int sizeOfVertArray = this->GetNumberOfVerticies() * 3 * sizeof(float);
 	//char* tempVertArray = new char(sizeOfVertArray);
 
+	// Updated: The vertex streams are packed the same way as the file (all the x, y, z, then all
+	//	the normals, etc.), so each one is a single write
+	const std::streamsize numberOfVertices = static_cast<std::streamsize>( this->m_vertexStreams.size() );
+
 	// ALWAYS has XYZ...
-	for ( int index = 0; index != this->GetNumberOfVerticies(); index++ )
-	{
-		thePlyFile.write( (const char*) &(this->m_verticies[index].xyz.x), sizeof(float) );
-		thePlyFile.write( (const char*) &(this->m_verticies[index].xyz.y), sizeof(float) );
-		thePlyFile.write( (const char*) &(this->m_verticies[index].xyz.z), sizeof(float) );
-	}
+	thePlyFile.write( (const char*) this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_POSITION ), numberOfVertices * 3 * sizeof(float) );
 	timer.UpdateLongDuration();
 
 	// ALWAYS has elements
@@ -929,60 +1594,41 @@ bool CPlyFile5nt::SaveGDPFile(std::wstring fileName, bool bOverwrite, std::wstri
 	// Vertex Normals in the file?
 	if ( this->bHasNormalsInFile() )
 	{
-		for ( int index = 0; index != this->GetNumberOfVerticies(); index++ )
-		{
-			thePlyFile.write( (const char*) &(this->m_verticies[index].nx), sizeof(float) );
-			thePlyFile.write( (const char*) &(this->m_verticies[index].ny), sizeof(float) );
-			thePlyFile.write( (const char*) &(this->m_verticies[index].nz), sizeof(float) );
-		}
+		// (adds an all zero stream if it isn't there, which is what the PlyVertex used to have)
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_NORMAL );
+		thePlyFile.write( (const char*) this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_NORMAL ), numberOfVertices * 3 * sizeof(float) );
 	}//if ( this->bHadNormalsInFile() )
 	timer.UpdateLongDuration();
 
 	// Vertex UVs in the file?
 	if ( this->bHasTextureCoordinatesInFile() )
 	{
-		for ( int index = 0; index != this->GetNumberOfVerticies(); index++ )
-		{
-			thePlyFile.write( (const char*) &(this->m_verticies[index].tex0u), sizeof(float) );
-			thePlyFile.write( (const char*) &(this->m_verticies[index].tex0v), sizeof(float) );
-		}
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_TEX0 );
+		thePlyFile.write( (const char*) this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_TEX0 ), numberOfVertices * 2 * sizeof(float) );
 	}//if ( this->bHadTextureCoordinatesInFile() )
 	timer.UpdateLongDuration();
 
 	// Vertex Colours in the file?
 	if ( this->m_PlyHeaderInfo.bHasColourRGBAInFile )
 	{
-		for ( int index = 0; index != this->GetNumberOfVerticies(); index++ )
-		{
-			thePlyFile.write( (const char*) &(this->m_verticies[index].red), sizeof(float) );
-			thePlyFile.write( (const char*) &(this->m_verticies[index].green), sizeof(float) );
-			thePlyFile.write( (const char*) &(this->m_verticies[index].blue), sizeof(float) );
-			thePlyFile.write( (const char*) &(this->m_verticies[index].alpha), sizeof(float) );
-		}
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_COLOUR );
+		thePlyFile.write( (const char*) this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_COLOUR ), numberOfVertices * 4 * sizeof(float) );
 	}// if ( this->m_PlyHeaderInfo.bHasColourRGBInFile )
 	timer.UpdateLongDuration();
 
 	// Vertex tangents in the file?
 	if ( this->m_PlyHeaderInfo.bHasTangentsInFile )
 	{
-		for ( int index = 0; index != this->GetNumberOfVerticies(); index++ )
-		{
-			thePlyFile.write( (const char*) &(this->m_verticies[index].tangent.x), sizeof(float) );
-			thePlyFile.write( (const char*) &(this->m_verticies[index].tangent.y), sizeof(float) );
-			thePlyFile.write( (const char*) &(this->m_verticies[index].tangent.z), sizeof(float) );
-		}
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_TANGENT );
+		thePlyFile.write( (const char*) this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_TANGENT ), numberOfVertices * 3 * sizeof(float) );
 	}//if ( this->m_PlyHeaderInfo.bHasTangentsInFile )
 	timer.UpdateLongDuration();
 
 	// Vertex binormals in the file?
 	if ( this->m_PlyHeaderInfo.bHasBiNormalsInFile )
 	{
-		for ( int index = 0; index != this->GetNumberOfVerticies(); index++ )
-		{
-			thePlyFile.write( (const char*) &(this->m_verticies[index].binormal.x), sizeof(float) );
-			thePlyFile.write( (const char*) &(this->m_verticies[index].binormal.y), sizeof(float) );
-			thePlyFile.write( (const char*) &(this->m_verticies[index].binormal.z), sizeof(float) );
-		}
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_BINORMAL );
+		thePlyFile.write( (const char*) this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_BINORMAL ), numberOfVertices * 3 * sizeof(float) );
 	}//if ( this->m_PlyHeaderInfo.bHasBiNormalsInFile )
 	timer.UpdateLongDuration();
 
@@ -1000,35 +1646,27 @@ bool CPlyFile5nt::OpenGDPFile(std::wstring fileName, std::wstring &error)	// GDP
 	timer.Reset();
 	timer.Start();
 
-	std::ifstream thePlyFile(fileName.c_str(), std::ios::binary );
-	if (!thePlyFile.is_open())
+	// Added: Memory mapped, like OpenPLYFile2()
+	CFileView theGDPFile;
+	std::wstring openError;
+	if ( !theGDPFile.Open( fileName, openError ) )
 	{
-		error = L"Can't open the file. Sorry it didn't work out.";
+		error = L"Can't open the file. Sorry it didn't work out. (" + openError + L")";
 		return false;
 	}
 
 	timer.UpdateLongDuration();
 
-	thePlyFile.seekg(0, std::ios::end);
-	// reutrns "std::ios::pos_type" type (which seems to be int in VC++)
-	unsigned int fileSize = static_cast<unsigned int>( thePlyFile.tellg() );	
-	// Return to start
-	thePlyFile.seekg(0, std::ios::beg);
-		
-	timer.UpdateLongDuration();
-
-	//std::vector<char> data( static_cast<unsigned int>(fileSize), 0);
-	//this->m_vecRawData.resize( static_cast<unsigned int>(fileSize), 0);
-
-	char* pRawData = new char[ fileSize ];
+	unsigned int fileSize = theGDPFile.GetSize();
+	char* pRawData = theGDPFile.GetData();
 	unsigned int curIndex = 0;				// Location in the array
-	
-	// read the file
-	//std::vector<char> data;
-	//thePlyFile.read( &data[0], fileSize);
-	//thePlyFile.read( &(this->m_vecRawData[0]), fileSize);
-	thePlyFile.read( pRawData, fileSize );
-	thePlyFile.close();
+
+	// Header is a fixed size
+	if ( fileSize < CPlyFile5nt::GDPHEADERSIZE )
+	{
+		error = L"ERROR: Isn't a valid GDP file.";
+		return false;
+	}
 
 	timer.UpdateLongDuration();
 
@@ -1047,6 +1685,11 @@ bool CPlyFile5nt::OpenGDPFile(std::wstring fileName, std::wstring &error)	// GDP
 
 	// char 3: version - this one loads only version 1
 	char gdpVersion = pRawData[3];
+	if ( gdpVersion != 1 )
+	{	// Added: version 2 (and up) is the "cooked" (GPU ready) format, which is loaded with CGDP2File
+		error = L"ERROR: Only version 1 GDP files can be loaded (version 2 and up are loaded with CGDP2File).";
+		return false;
+	}
 
 	// char 4: is little endian (Do we even need this...?)
 	this->m_PlyHeaderInfo.plyFormatASCIIorBinary = CPlyHeaderDescription::FORMAT_UNKNOWN;
@@ -1073,17 +1716,60 @@ bool CPlyFile5nt::OpenGDPFile(std::wstring fileName, std::wstring &error)	// GDP
 	this->m_PlyHeaderInfo.numberOfVertices = this->m_gdp_ReadInt32FromCharArray( &(pRawData[32]) );
 	this->m_PlyHeaderInfo.numberOfElements = this->m_gdp_ReadInt32FromCharArray( &(pRawData[38]) );
 	
+	// Added: Make sure the file is as big as the header says (it's read in place, so 
+	//	reading past the end isn't just garbage any more, it's a crash)
+	unsigned long long bytesPerVertex = 3 * sizeof(float);
+	if ( this->m_PlyHeaderInfo.bHasNormalsInFile )				{ bytesPerVertex += 3 * sizeof(float); }
+	if ( this->m_PlyHeaderInfo.bHasTextureCoordinatesInFile )	{ bytesPerVertex += 2 * sizeof(float); }
+	if ( this->m_PlyHeaderInfo.bHasColourRGBAInFile )			{ bytesPerVertex += 4 * sizeof(float); }
+	if ( this->m_PlyHeaderInfo.bHasTangentsInFile )				{ bytesPerVertex += 3 * sizeof(float); }
+	if ( this->m_PlyHeaderInfo.bHasBiNormalsInFile )			{ bytesPerVertex += 3 * sizeof(float); }
+	unsigned long long expectedFileSize = CPlyFile5nt::GDPHEADERSIZE 
+		+ static_cast<unsigned long long>( this->m_PlyHeaderInfo.numberOfVertices ) * bytesPerVertex
+		+ static_cast<unsigned long long>( this->m_PlyHeaderInfo.numberOfElements ) * ( 3 * sizeof(int) );
+	if ( ( this->m_PlyHeaderInfo.numberOfVertices < 0 ) || ( this->m_PlyHeaderInfo.numberOfElements < 0 ) || 
+		 ( expectedFileSize > fileSize ) )
+	{
+		error = L"ERROR: The GDP file is shorter than the header says it should be.";
+		return false;
+	}
+
 	// Read 
 	// Vertices XYZ and ELEMENTs (ALWAYS has these), then 
 	// Vertex: nxyz, UVs, colours, tangents, binormals (because they are optional)
 	
 	// Allocate the number of vertices and elements and load empty values
-	this->m_verticies.clear();
-	this->m_verticies.reserve( this->m_PlyHeaderInfo.numberOfVertices );
-	for ( int index = 0; index != this->GetNumberOfVerticies(); index++ )
+	// Updated: Only the vertex streams that are in the file
+	this->m_vertexStreams.clear();
+	if ( this->bHasNormalsInFile() )
+	{
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_NORMAL );
+	}
+	if ( this->bHasTextureCoordinatesInFile() )
+	{
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_TEX0 );
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_TEX1 );
+	}
+	if ( this->m_PlyHeaderInfo.bHasColourRGBAInFile )
+	{
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_COLOUR );
+	}
+	if ( this->m_PlyHeaderInfo.bHasTangentsInFile )
+	{
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_TANGENT );
+	}
+	if ( this->m_PlyHeaderInfo.bHasBiNormalsInFile )
 	{
-		this->m_verticies.push_back( PlyVertex() );
+		this->m_vertexStreams.AddStream( CPlyVertexStreams::STREAM_BINORMAL );
 	}
+	this->m_vertexStreams.resize( this->m_PlyHeaderInfo.numberOfVertices );
+	float* pPositions = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_POSITION );
+	float* pNormals = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_NORMAL );
+	float* pTex0 = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_TEX0 );
+	float* pTex1 = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_TEX1 );
+	float* pColours = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_COLOUR );
+	float* pTangents = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_TANGENT );
+	float* pBinormals = this->m_vertexStreams.GetStream( CPlyVertexStreams::STREAM_BINORMAL );
 	this->m_elements.clear();
 	this->m_elements.reserve( this->m_PlyHeaderInfo.numberOfElements );
 	for ( int index = 0; index != this->GetNumberOfElements(); index++ )
@@ -1109,9 +1795,9 @@ bool CPlyFile5nt::OpenGDPFile(std::wstring fileName, std::wstring &error)	// GDP
 //		tempVert.xyz.x = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
 //		tempVert.xyz.y = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
 //		tempVert.xyz.z = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 2 * sizeof(float)] ) );
-		this->m_verticies[index].xyz.x = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
-		this->m_verticies[index].xyz.y = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
-		this->m_verticies[index].xyz.z = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 2 * sizeof(float)] ) );
+		pPositions[index * 3 + 0] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
+		pPositions[index * 3 + 1] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
+		pPositions[index * 3 + 2] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 2 * sizeof(float)] ) );
 
 //		this->m_verticies[index] = tempVert;
 
@@ -1144,9 +1830,9 @@ bool CPlyFile5nt::OpenGDPFile(std::wstring fileName, std::wstring &error)	// GDP
 	{
 		for ( int index = 0; index != this->GetNumberOfVerticies(); index++ )
 		{
-			this->m_verticies[index].nx = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
-			this->m_verticies[index].ny = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
-			this->m_verticies[index].nz = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 2 * sizeof(float)] ) );
+			pNormals[index * 3 + 0] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
+			pNormals[index * 3 + 1] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
+			pNormals[index * 3 + 2] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 2 * sizeof(float)] ) );
 			// Move pointer to next vertex (3 floats away)
 			arrayCurrentIndex += ( 3 * sizeof(float) );
 		}//for ( int index = 0;....
@@ -1158,11 +1844,11 @@ bool CPlyFile5nt::OpenGDPFile(std::wstring fileName, std::wstring &error)	// GDP
 	{
 		for ( int index = 0; index != this->GetNumberOfVerticies(); index++ )
 		{
-			this->m_verticies[index].tex0u = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
-			this->m_verticies[index].tex0v = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
+			pTex0[index * 2 + 0] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
+			pTex0[index * 2 + 1] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
 			// I don't really remember why there are two sets of texture coords...
-			this->m_verticies[index].tex1u = this->m_verticies[index].tex0u;
-			this->m_verticies[index].tex1v = this->m_verticies[index].tex0v;
+			pTex1[index * 2 + 0] = pTex0[index * 2 + 0];
+			pTex1[index * 2 + 1] = pTex0[index * 2 + 1];
 			// Move pointer to next vertex (3 floats away)
 			arrayCurrentIndex += ( 2 * sizeof(float) );
 		}//for ( int index = 0;....
@@ -1174,10 +1860,10 @@ bool CPlyFile5nt::OpenGDPFile(std::wstring fileName, std::wstring &error)	// GDP
 	{
 		for ( int index = 0; index != this->GetNumberOfVerticies(); index++ )
 		{
-			this->m_verticies[index].red = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
-			this->m_verticies[index].green = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
-			this->m_verticies[index].blue = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 2 * sizeof(float)] ) );
-			this->m_verticies[index].alpha = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 3 * sizeof(float)] ) );
+			pColours[index * 4 + 0] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
+			pColours[index * 4 + 1] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
+			pColours[index * 4 + 2] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 2 * sizeof(float)] ) );
+			pColours[index * 4 + 3] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 3 * sizeof(float)] ) );
 			// Move pointer to next vertex (4 floats away)
 			arrayCurrentIndex += ( 4 * sizeof(float) );
 		}//for ( int index = 0;....
@@ -1190,9 +1876,9 @@ bool CPlyFile5nt::OpenGDPFile(std::wstring fileName, std::wstring &error)	// GDP
 	{
 		for ( int index = 0; index != this->GetNumberOfVerticies(); index++ )
 		{
-			this->m_verticies[index].tangent.x = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
-			this->m_verticies[index].tangent.y = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
-			this->m_verticies[index].tangent.z = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 2 * sizeof(float)] ) );
+			pTangents[index * 3 + 0] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
+			pTangents[index * 3 + 1] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
+			pTangents[index * 3 + 2] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 2 * sizeof(float)] ) );
 			// Move pointer to next vertex (3 floats away)
 			arrayCurrentIndex += ( 3 * sizeof(float) );
 		}//for ( int index = 0;....
@@ -1204,9 +1890,9 @@ bool CPlyFile5nt::OpenGDPFile(std::wstring fileName, std::wstring &error)	// GDP
 	{
 		for ( int index = 0; index != this->GetNumberOfVerticies(); index++ )
 		{
-			this->m_verticies[index].binormal.x = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
-			this->m_verticies[index].binormal.y = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
-			this->m_verticies[index].binormal.z = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 2 * sizeof(float)] ) );
+			pBinormals[index * 3 + 0] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 0 * sizeof(float)] ) );
+			pBinormals[index * 3 + 1] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 1 * sizeof(float)] ) );
+			pBinormals[index * 3 + 2] = this->m_gdp_ReadFloat32FromCharArray( &(pRawData[arrayCurrentIndex + 2 * sizeof(float)] ) );
 			// Move pointer to next vertex (3 floats away)
 			arrayCurrentIndex += ( 3 * sizeof(float) );
 		}//for ( int index = 0;....
@@ -1215,8 +1901,6 @@ bool CPlyFile5nt::OpenGDPFile(std::wstring fileName, std::wstring &error)	// GDP
 
 	//PlyVertex debugVerted = this->m_verticies[this->GetNumberOfVerticies() -1];
 
-	delete [] pRawData;
-
 	timer.UpdateLongDuration();
 	timer.Stop();
 
@@ -0,0 +1,91 @@
+#include "CPlyLoadBenchmark.h"
+#include "CPlyFile5nt.h"
+#include "CStringHelper.h"
+#include "../CHRTimer.h"
+#include "../CFileView.h"
+
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cfloat>		// DBL_MAX
+
+//static 
+bool CPlyLoadBenchmark::RunOnFolder( std::string modelFolder, unsigned int numberOfRuns, std::ostream &output, 
+                                     bool bParallelASCIIParsing /*=false*/ )
+{
+	// Find all the ply files in the folder
+	std::vector<std::string> vecFileNames;
+	if ( !CFileView::FindFiles( modelFolder, "*.ply", vecFileNames ) )
+	{
+		output << "Didn't find any ply files in " << modelFolder << std::endl;
+		return false;
+	}
+
+	if ( numberOfRuns == 0 )
+	{
+		numberOfRuns = 1;
+	}
+
+	output << std::left << std::setw(40) << "Model" 
+		   << std::right << std::setw(10) << "MB" 
+		   << std::setw(12) << "best (ms)" 
+		   << std::setw(12) << "MB/s" << std::endl;
+
+	double totalMB = 0.0;
+	double totalSeconds = 0.0;
+
+	for ( std::vector<std::string>::iterator itFile = vecFileNames.begin(); itFile != vecFileNames.end(); itFile++ )
+	{
+		std::string fullFileName = modelFolder + "/" + *itFile;
+
+		std::ifstream theFile( fullFileName.c_str(), std::ios::binary | std::ios::ate );
+		double fileSizeMB = static_cast<double>( theFile.tellg() ) / ( 1024.0 * 1024.0 );
+		theFile.close();
+
+		// Take the best of the runs (the first one is likely paying for the disk, too)
+		double bestSeconds = DBL_MAX;
+		bool bLoadedOK = true;
+		std::wstring error;
+		for ( unsigned int runCount = 0; runCount != numberOfRuns; runCount++ )
+		{
+			CPlyFile5nt plyFile;
+			plyFile.SetParallelASCIIParsing( bParallelASCIIParsing );
+			CHRTimer timer;
+			timer.Reset();
+			timer.Start();
+			if ( !plyFile.OpenPLYFile2( CStringHelper::ASCIIToUnicodeQnD( fullFileName ), error ) )
+			{
+				bLoadedOK = false;
+				break;
+			}
+			double seconds = static_cast<double>( timer.GetElapsedSeconds() );
+			if ( seconds < bestSeconds )
+			{
+				bestSeconds = seconds;
+			}
+		}
+
+		output << std::left << std::setw(40) << *itFile << std::right << std::fixed;
+		if ( !bLoadedOK )
+		{
+			output << "  Didn't load: " << CStringHelper::UnicodeToASCII_QnD( error ) << std::endl;
+			continue;
+		}
+		output << std::setprecision(2) << std::setw(10) << fileSizeMB 
+			   << std::setprecision(3) << std::setw(12) << ( bestSeconds * 1000.0 ) 
+			   << std::setprecision(1) << std::setw(12) << ( bestSeconds > 0.0 ? ( fileSizeMB / bestSeconds ) : 0.0 ) 
+			   << std::endl;
+
+		totalMB += fileSizeMB;
+		totalSeconds += bestSeconds;
+	}// for ( std::vector<std::string>::iterator itFile
+
+	output << std::left << std::setw(40) << "Total" << std::right 
+		   << std::setprecision(2) << std::setw(10) << totalMB 
+		   << std::setprecision(3) << std::setw(12) << ( totalSeconds * 1000.0 ) 
+		   << std::setprecision(1) << std::setw(12) << ( totalSeconds > 0.0 ? ( totalMB / totalSeconds ) : 0.0 ) 
+		   << std::endl;
+
+	return true;
+}
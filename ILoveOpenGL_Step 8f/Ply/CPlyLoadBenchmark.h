@@ -0,0 +1,22 @@
+#ifndef _CPlyLoadBenchmark_HG_
+#define _CPlyLoadBenchmark_HG_
+
+// Microbenchmark for the ply loader (CPlyFile5nt::OpenPLYFile2)
+// Loads every .ply file in a folder a few times, then prints the best time 
+//	and the throughput (in MB/s) for each one. 
+// Run the program with "-benchply" (and optionally the number of runs) to use it.
+
+#include <string>
+#include <iostream>
+
+class CPlyLoadBenchmark
+{
+public:
+	static const unsigned int DEFAULTNUMBEROFRUNS = 5;
+	// Returns false if it couldn't find any ply files
+	// bParallelASCIIParsing is passed to CPlyFile5nt::SetParallelASCIIParsing()
+	static bool RunOnFolder( std::string modelFolder, unsigned int numberOfRuns, std::ostream &output, 
+	                         bool bParallelASCIIParsing = false );
+};
+
+#endif
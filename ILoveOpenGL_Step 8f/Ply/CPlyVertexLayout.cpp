@@ -0,0 +1,223 @@
+#include "CPlyVertexLayout.h"
+
+#include <math.h>
+#include <string.h>		// for memcpy()
+
+CPlyVertexLayout::CPlyVertexLayout()
+{
+	this->m_vertexSizeInBytes = 0;
+	return;
+}
+
+//static
+unsigned int CPlyVertexLayout::GetComponentSizeInBytes( enumComponentType type )
+{
+	switch ( type )
+	{
+	case CPlyVertexLayout::TYPE_FLOAT32:	return 4;
+	case CPlyVertexLayout::TYPE_FLOAT16:	return 2;
+	case CPlyVertexLayout::TYPE_UNORM16:	return 2;
+	case CPlyVertexLayout::TYPE_SNORM16:	return 2;
+	case CPlyVertexLayout::TYPE_UNORM8:		return 1;
+	}
+	return 0;
+}
+
+void CPlyVertexLayout::AddAttribute( CPlyVertexStreams::enumStream stream, unsigned int offsetInBytes, unsigned int numberOfComponents,
+                                     float fillX /*=0.0f*/, float fillY /*=0.0f*/, float fillZ /*=0.0f*/, float fillW /*=0.0f*/ )
+{
+	this->AddAttribute( stream, offsetInBytes, numberOfComponents, CPlyVertexLayout::TYPE_FLOAT32, CPlyVertexLayout::ENCODING_NONE,
+	                    fillX, fillY, fillZ, fillW );
+	return;
+}
+
+void CPlyVertexLayout::AddAttribute( CPlyVertexStreams::enumStream stream, unsigned int offsetInBytes, unsigned int numberOfComponents,
+                                     enumComponentType type, enumEncoding encoding,
+                                     float fillX /*=0.0f*/, float fillY /*=0.0f*/, float fillZ /*=0.0f*/, float fillW /*=0.0f*/ )
+{
+	sAttribute attribute;
+	attribute.stream = stream;
+	attribute.offsetInBytes = offsetInBytes;
+	attribute.numberOfComponents = ( numberOfComponents > 4 ) ? 4 : numberOfComponents;
+	attribute.type = type;
+	attribute.encoding = encoding;
+	attribute.fillValues[0] = fillX;
+	attribute.fillValues[1] = fillY;
+	attribute.fillValues[2] = fillZ;
+	attribute.fillValues[3] = fillW;
+	for ( unsigned int component = 0; component != 4; component++ )
+	{
+		attribute.valueOffset[component] = 0.0f;
+		attribute.valueScale[component] = 1.0f;
+	}
+	this->m_vecAttributes.push_back( attribute );
+
+	unsigned int endOfAttribute = offsetInBytes + attribute.numberOfComponents * CPlyVertexLayout::GetComponentSizeInBytes( type );
+	if ( endOfAttribute > this->m_vertexSizeInBytes )
+	{
+		this->m_vertexSizeInBytes = endOfAttribute;
+	}
+	return;
+}
+
+void CPlyVertexLayout::SetLastAttributeOffsetAndScale( const float valueOffset[4], const float valueScale[4] )
+{
+	if ( this->m_vecAttributes.empty() )
+	{
+		return;
+	}
+	sAttribute &attribute = this->m_vecAttributes.back();
+	for ( unsigned int component = 0; component != 4; component++ )
+	{
+		attribute.valueOffset[component] = valueOffset[component];
+		attribute.valueScale[component] = valueScale[component];
+	}
+	return;
+}
+
+void CPlyVertexLayout::SetVertexSizeInBytes( unsigned int vertexSizeInBytes )
+{
+	this->m_vertexSizeInBytes = vertexSizeInBytes;
+	return;
+}
+
+unsigned int CPlyVertexLayout::GetVertexSizeInBytes(void) const
+{
+	return this->m_vertexSizeInBytes;
+}
+
+unsigned int CPlyVertexLayout::GetNumberOfAttributes(void) const
+{
+	return static_cast<unsigned int>( this->m_vecAttributes.size() );
+}
+
+const CPlyVertexLayout::sAttribute& CPlyVertexLayout::GetAttribute( unsigned int index ) const
+{
+	return this->m_vecAttributes[index];
+}
+
+bool CPlyVertexLayout::bHasSameFormat( const CPlyVertexLayout &other ) const
+{
+	if ( ( this->m_vertexSizeInBytes != other.m_vertexSizeInBytes ) || 
+		 ( this->m_vecAttributes.size() != other.m_vecAttributes.size() ) )
+	{
+		return false;
+	}
+	for ( unsigned int index = 0; index != static_cast<unsigned int>( this->m_vecAttributes.size() ); index++ )
+	{
+		const sAttribute &a = this->m_vecAttributes[index];
+		const sAttribute &b = other.m_vecAttributes[index];
+		if ( ( a.stream != b.stream ) || ( a.offsetInBytes != b.offsetInBytes ) || 
+			 ( a.numberOfComponents != b.numberOfComponents ) || ( a.type != b.type ) || ( a.encoding != b.encoding ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//static
+unsigned short CPlyVertexLayout::FloatToHalf( float value )
+{
+	// From Fabian Giesen's "float_to_half_fast3_rtne" (public domain): the rounding is done by
+	//	adding to the float's bits, and the tiny numbers by letting the FPU do the shifting
+	unsigned int bits = 0;
+	memcpy( &bits, &value, sizeof(float) );
+	const unsigned int sign = bits & 0x80000000u;
+	bits ^= sign;
+
+	unsigned int half = 0;
+	if ( bits >= ( ( 127 + 16 ) << 23 ) )
+	{	// Too big (infinity), or NaN
+		half = ( bits > ( 255u << 23 ) ) ? 0x7E00 : 0x7C00;
+	}
+	else if ( bits < ( 113u << 23 ) )
+	{	// Too small for a regular half (so it's a denormal, or zero)
+		const unsigned int denormMagicBits = ( ( 127 - 15 ) + ( 23 - 10 ) + 1 ) << 23;
+		float denormMagic = 0.0f;
+		memcpy( &denormMagic, &denormMagicBits, sizeof(float) );
+		float shifted = 0.0f;
+		memcpy( &shifted, &bits, sizeof(float) );
+		shifted += denormMagic;
+		memcpy( &half, &shifted, sizeof(float) );
+		half -= denormMagicBits;
+	}
+	else
+	{
+		const unsigned int mantissaIsOdd = ( bits >> 13 ) & 1;
+		bits += ( static_cast<unsigned int>( 15 - 127 ) << 23 ) + 0xFFF;		// New exponent, and round
+		bits += mantissaIsOdd;												// (to even)
+		half = bits >> 13;
+	}
+	return static_cast<unsigned short>( half | ( sign >> 16 ) );
+}
+
+//static
+float CPlyVertexLayout::HalfToFloat( unsigned short half )
+{
+	const unsigned int sign = static_cast<unsigned int>( half & 0x8000 ) << 16;
+	const unsigned int exponent = ( half >> 10 ) & 0x1F;
+	const unsigned int mantissa = half & 0x3FF;
+
+	unsigned int bits = 0;
+	if ( exponent == 0 )
+	{	// Zero, or denormal (mantissa * 2^-24)
+		float value = static_cast<float>( mantissa ) * ( 1.0f / 16777216.0f );
+		memcpy( &bits, &value, sizeof(float) );
+		bits |= sign;
+	}
+	else if ( exponent == 31 )
+	{	// Infinity, or NaN
+		bits = sign | 0x7F800000u | ( mantissa << 13 );
+	}
+	else
+	{
+		bits = sign | ( ( exponent + ( 127 - 15 ) ) << 23 ) | ( mantissa << 13 );
+	}
+	float value = 0.0f;
+	memcpy( &value, &bits, sizeof(float) );
+	return value;
+}
+
+//static
+void CPlyVertexLayout::OctahedralEncode( const float xyz[3], float encoded[2] )
+{
+	const float sumOfAbs = fabs( xyz[0] ) + fabs( xyz[1] ) + fabs( xyz[2] );
+	if ( !( sumOfAbs > 0.0f ) )
+	{	// (no direction at all, so it doesn't matter)
+		encoded[0] = encoded[1] = 0.0f;
+		return;
+	}
+	const float x = xyz[0] / sumOfAbs;
+	const float y = xyz[1] / sumOfAbs;
+	if ( xyz[2] >= 0.0f )
+	{
+		encoded[0] = x;
+		encoded[1] = y;
+	}
+	else
+	{	// Bottom half is folded over the top
+		encoded[0] = ( 1.0f - fabs( y ) ) * ( ( x >= 0.0f ) ? 1.0f : -1.0f );
+		encoded[1] = ( 1.0f - fabs( x ) ) * ( ( y >= 0.0f ) ? 1.0f : -1.0f );
+	}
+	return;
+}
+
+//static
+void CPlyVertexLayout::OctahedralDecode( const float encoded[2], float xyz[3] )
+{
+	// (Same as OctahedralDecode() in MultiLightsTextures.vertex.glsl)
+	float x = encoded[0];
+	float y = encoded[1];
+	const float z = 1.0f - fabs( x ) - fabs( y );
+	if ( z < 0.0f )
+	{
+		x = ( 1.0f - fabs( encoded[1] ) ) * ( ( encoded[0] >= 0.0f ) ? 1.0f : -1.0f );
+		y = ( 1.0f - fabs( encoded[0] ) ) * ( ( encoded[1] >= 0.0f ) ? 1.0f : -1.0f );
+	}
+	const float length = sqrt( x * x + y * y + z * z );
+	xyz[0] = x / length;
+	xyz[1] = y / length;
+	xyz[2] = z / length;
+	return;
+}
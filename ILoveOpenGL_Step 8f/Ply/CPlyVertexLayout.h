@@ -0,0 +1,87 @@
+#ifndef _CPlyVertexLayout_HG_
+#define _CPlyVertexLayout_HG_
+
+// Describes an interleaved (GPU) vertex: which vertex stream goes where, and how many floats
+//	each one gets. CPlyFile5nt::ExportVertices() uses this to write the vertices straight into
+//	a vertex buffer (a mapped GL buffer, the GDP v2 vertex array, etc.).
+// If an attribute has more floats than the stream (like a 4 float position from the 3 float
+//	x, y, z), the rest come from the fill values (so w can be 1.0f).
+// A stream the model doesn't have is zeros (then the fill values), like an unset PlyVertex.
+// Updated: Each attribute can also be stored smaller than a float (a half float, or a 16 or 8 bit
+//	"normalised" integer, which the GPU turns back into 0.0 to 1.0, or -1.0 to 1.0).
+//	The value is (value - valueOffset) * valueScale before it's stored, so (for example) a
+//	position can be stored as 0.0 to 1.0 across the bounding box. The normals can be stored as
+//	just 2 numbers (octahedral, see below).
+
+#include "CPlyVertexStreams.h"
+#include <vector>
+
+class CPlyVertexLayout
+{
+public:
+	CPlyVertexLayout();
+
+	enum enumComponentType
+	{
+		TYPE_FLOAT32 = 0,		// 4 bytes (GL_FLOAT)
+		TYPE_FLOAT16,			// 2 bytes (GL_HALF_FLOAT)
+		TYPE_UNORM16,			// 2 bytes, 0.0 to 1.0 (GL_UNSIGNED_SHORT, normalised)
+		TYPE_SNORM16,			// 2 bytes, -1.0 to 1.0 (GL_SHORT, normalised)
+		TYPE_UNORM8				// 1 byte, 0.0 to 1.0 (GL_UNSIGNED_BYTE, normalised)
+	};
+	static unsigned int GetComponentSizeInBytes( enumComponentType type );
+
+	enum enumEncoding
+	{
+		ENCODING_NONE = 0,
+		// A unit vector (the normals) as 2 numbers from -1.0 to 1.0: it's "folded" onto an
+		//	octahedron, which is then flattened out ("A Survey of Efficient Representations for
+		//	Independent Unit Vectors", Cigolle et al., JCGT 2014). Use 2 components, TYPE_SNORM16.
+		ENCODING_OCTAHEDRAL
+	};
+
+	struct sAttribute
+	{
+		CPlyVertexStreams::enumStream stream;
+		unsigned int offsetInBytes;			// From the start of the vertex
+		unsigned int numberOfComponents;	// 1 to 4
+		enumComponentType type;
+		enumEncoding encoding;
+		float fillValues[4];				// For the components past the end of the stream
+		float valueOffset[4];				// Stored value is ( value - valueOffset ) * valueScale
+		float valueScale[4];				//	(the fill values aren't changed)
+	};
+
+	// The vertex size grows to fit each attribute (use SetVertexSizeInBytes() for any padding at the end)
+	void AddAttribute( CPlyVertexStreams::enumStream stream, unsigned int offsetInBytes, unsigned int numberOfComponents,
+	                   float fillX = 0.0f, float fillY = 0.0f, float fillZ = 0.0f, float fillW = 0.0f );
+	// Added: Same thing, but stored as the type (and encoding)
+	void AddAttribute( CPlyVertexStreams::enumStream stream, unsigned int offsetInBytes, unsigned int numberOfComponents,
+	                   enumComponentType type, enumEncoding encoding,
+	                   float fillX = 0.0f, float fillY = 0.0f, float fillZ = 0.0f, float fillW = 0.0f );
+	// Added: Sets the valueOffset and valueScale of the last attribute added
+	void SetLastAttributeOffsetAndScale( const float valueOffset[4], const float valueScale[4] );
+	void SetVertexSizeInBytes( unsigned int vertexSizeInBytes );
+	unsigned int GetVertexSizeInBytes(void) const;
+
+	unsigned int GetNumberOfAttributes(void) const;
+	const sAttribute& GetAttribute( unsigned int index ) const;
+	// Added: Same vertex size, and the same attributes in the same places (stream, offset, number of 
+	//	components, type and encoding), so the GPU reads them the same way. The fill values and the 
+	//	value offsets and scales can be different.
+	bool bHasSameFormat( const CPlyVertexLayout &other ) const;
+
+	// Added: Converting to (and from) the smaller types
+	// (round to nearest; anything outside of the range is clamped, and too big for a half is infinity)
+	static unsigned short FloatToHalf( float value );
+	static float HalfToFloat( unsigned short half );
+	// x, y, z (doesn't have to be unit length) to 2 numbers from -1.0 to 1.0, and back again
+	static void OctahedralEncode( const float xyz[3], float encoded[2] );
+	static void OctahedralDecode( const float encoded[2], float xyz[3] );
+
+private:
+	unsigned int m_vertexSizeInBytes;
+	std::vector<sAttribute> m_vecAttributes;
+};
+
+#endif
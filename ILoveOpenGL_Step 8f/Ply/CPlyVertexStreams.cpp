@@ -0,0 +1,429 @@
+#include "CPlyVertexStreams.h"
+#include "CPlyFile5nt.h"	// For PlyVertex
+#include "CPlyVertexLayout.h"
+
+#include <math.h>
+#include <utility>		// for std::swap()
+#include <string.h>		// for memcpy()
+
+// Writes one component of a vertex as the type, and returns how many bytes that was
+static inline unsigned int StoreComponent( float value, CPlyVertexLayout::enumComponentType type, unsigned char* pDestination )
+{
+	switch ( type )
+	{
+	case CPlyVertexLayout::TYPE_FLOAT32:
+		memcpy( pDestination, &value, sizeof(float) );
+		return sizeof(float);
+	case CPlyVertexLayout::TYPE_FLOAT16:
+		{
+			unsigned short half = CPlyVertexLayout::FloatToHalf( value );
+			memcpy( pDestination, &half, sizeof(unsigned short) );
+		}
+		return sizeof(unsigned short);
+	case CPlyVertexLayout::TYPE_UNORM16:
+		{	// (the "!( >= )" is so NaN ends up as zero)
+			float clamped = !( value >= 0.0f ) ? 0.0f : ( ( value > 1.0f ) ? 1.0f : value );
+			unsigned short unorm = static_cast<unsigned short>( clamped * 65535.0f + 0.5f );
+			memcpy( pDestination, &unorm, sizeof(unsigned short) );
+		}
+		return sizeof(unsigned short);
+	case CPlyVertexLayout::TYPE_SNORM16:
+		{
+			float clamped = !( value >= -1.0f ) ? -1.0f : ( ( value > 1.0f ) ? 1.0f : value );
+			short snorm = static_cast<short>( floor( clamped * 32767.0f + 0.5f ) );
+			memcpy( pDestination, &snorm, sizeof(short) );
+		}
+		return sizeof(short);
+	case CPlyVertexLayout::TYPE_UNORM8:
+		{
+			float clamped = !( value >= 0.0f ) ? 0.0f : ( ( value > 1.0f ) ? 1.0f : value );
+			*pDestination = static_cast<unsigned char>( clamped * 255.0f + 0.5f );
+		}
+		return 1;
+	}
+	return 0;
+}
+
+CPlyVertexStreams::CPlyVertexStreams()
+{
+	this->m_numberOfVertices = 0;
+	for ( unsigned int stream = 0; stream != CPlyVertexStreams::NUMBEROFSTREAMS; stream++ )
+	{
+		this->m_bHasStream[stream] = false;
+	}
+	this->m_bHasStream[CPlyVertexStreams::STREAM_POSITION] = true;
+	return;
+}
+
+//static
+unsigned int CPlyVertexStreams::GetFloatsPerVertex( enumStream stream )
+{
+	switch ( stream )
+	{
+	case CPlyVertexStreams::STREAM_POSITION:	return 3;
+	case CPlyVertexStreams::STREAM_NORMAL:		return 3;
+	case CPlyVertexStreams::STREAM_TEX0:		return 2;
+	case CPlyVertexStreams::STREAM_TEX1:		return 2;
+	case CPlyVertexStreams::STREAM_COLOUR:		return 4;
+	case CPlyVertexStreams::STREAM_TANGENT:		return 3;
+	case CPlyVertexStreams::STREAM_BINORMAL:	return 3;
+	default:									return 0;
+	}
+}
+
+unsigned int CPlyVertexStreams::size(void) const
+{
+	return this->m_numberOfVertices;
+}
+
+bool CPlyVertexStreams::empty(void) const
+{
+	return ( this->m_numberOfVertices == 0 );
+}
+
+void CPlyVertexStreams::clear(void)
+{
+	CPlyVertexStreams empty;
+	this->swap( empty );
+	return;
+}
+
+void CPlyVertexStreams::resize( unsigned int numberOfVertices )
+{
+	for ( unsigned int stream = 0; stream != CPlyVertexStreams::NUMBEROFSTREAMS; stream++ )
+	{
+		if ( this->m_bHasStream[stream] )
+		{
+			this->m_vecStreams[stream].resize( static_cast<size_t>( numberOfVertices ) *
+			                                   CPlyVertexStreams::GetFloatsPerVertex( static_cast<enumStream>( stream ) ), 0.0f );
+		}
+	}
+	this->m_numberOfVertices = numberOfVertices;
+	return;
+}
+
+void CPlyVertexStreams::reserve( unsigned int numberOfVertices )
+{
+	for ( unsigned int stream = 0; stream != CPlyVertexStreams::NUMBEROFSTREAMS; stream++ )
+	{
+		if ( this->m_bHasStream[stream] )
+		{
+			this->m_vecStreams[stream].reserve( static_cast<size_t>( numberOfVertices ) *
+			                                    CPlyVertexStreams::GetFloatsPerVertex( static_cast<enumStream>( stream ) ) );
+		}
+	}
+	return;
+}
+
+void CPlyVertexStreams::swap( CPlyVertexStreams &other )
+{
+	std::swap( this->m_numberOfVertices, other.m_numberOfVertices );
+	for ( unsigned int stream = 0; stream != CPlyVertexStreams::NUMBEROFSTREAMS; stream++ )
+	{
+		this->m_vecStreams[stream].swap( other.m_vecStreams[stream] );
+		std::swap( this->m_bHasStream[stream], other.m_bHasStream[stream] );
+	}
+	return;
+}
+
+bool CPlyVertexStreams::bHasStream( enumStream stream ) const
+{
+	return this->m_bHasStream[stream];
+}
+
+void CPlyVertexStreams::AddStream( enumStream stream )
+{
+	if ( this->m_bHasStream[stream] )
+	{
+		return;
+	}
+	this->m_bHasStream[stream] = true;
+	this->m_vecStreams[stream].assign( static_cast<size_t>( this->m_numberOfVertices ) * CPlyVertexStreams::GetFloatsPerVertex( stream ), 0.0f );
+	return;
+}
+
+float* CPlyVertexStreams::GetStream( enumStream stream )
+{
+	if ( !this->m_bHasStream[stream] || this->m_vecStreams[stream].empty() )
+	{
+		return 0;
+	}
+	return &(this->m_vecStreams[stream][0]);
+}
+
+const float* CPlyVertexStreams::GetStream( enumStream stream ) const
+{
+	if ( !this->m_bHasStream[stream] || this->m_vecStreams[stream].empty() )
+	{
+		return 0;
+	}
+	return &(this->m_vecStreams[stream][0]);
+}
+
+PlyVertex CPlyVertexStreams::GetVertex( unsigned int index ) const
+{
+	PlyVertex vertex;
+	const float* pPosition = &(this->m_vecStreams[STREAM_POSITION][index * 3]);
+	vertex.xyz.x = pPosition[0];	vertex.xyz.y = pPosition[1];	vertex.xyz.z = pPosition[2];
+	if ( this->m_bHasStream[STREAM_NORMAL] )
+	{
+		const float* pNormal = &(this->m_vecStreams[STREAM_NORMAL][index * 3]);
+		vertex.nx = pNormal[0];		vertex.ny = pNormal[1];		vertex.nz = pNormal[2];
+	}
+	if ( this->m_bHasStream[STREAM_TEX0] )
+	{
+		const float* pTex0 = &(this->m_vecStreams[STREAM_TEX0][index * 2]);
+		vertex.tex0u = pTex0[0];	vertex.tex0v = pTex0[1];
+	}
+	if ( this->m_bHasStream[STREAM_TEX1] )
+	{
+		const float* pTex1 = &(this->m_vecStreams[STREAM_TEX1][index * 2]);
+		vertex.tex1u = pTex1[0];	vertex.tex1v = pTex1[1];
+	}
+	if ( this->m_bHasStream[STREAM_COLOUR] )
+	{
+		const float* pColour = &(this->m_vecStreams[STREAM_COLOUR][index * 4]);
+		vertex.red = pColour[0];	vertex.green = pColour[1];	vertex.blue = pColour[2];	vertex.alpha = pColour[3];
+	}
+	if ( this->m_bHasStream[STREAM_TANGENT] )
+	{
+		const float* pTangent = &(this->m_vecStreams[STREAM_TANGENT][index * 3]);
+		vertex.tangent.x = pTangent[0];		vertex.tangent.y = pTangent[1];		vertex.tangent.z = pTangent[2];
+	}
+	if ( this->m_bHasStream[STREAM_BINORMAL] )
+	{
+		const float* pBinormal = &(this->m_vecStreams[STREAM_BINORMAL][index * 3]);
+		vertex.binormal.x = pBinormal[0];	vertex.binormal.y = pBinormal[1];	vertex.binormal.z = pBinormal[2];
+	}
+	return vertex;
+}
+
+void CPlyVertexStreams::SetVertex( unsigned int index, const PlyVertex &vertex )
+{
+	float* pPosition = &(this->m_vecStreams[STREAM_POSITION][index * 3]);
+	pPosition[0] = vertex.xyz.x;	pPosition[1] = vertex.xyz.y;	pPosition[2] = vertex.xyz.z;
+	if ( this->m_bHasStream[STREAM_NORMAL] )
+	{
+		float* pNormal = &(this->m_vecStreams[STREAM_NORMAL][index * 3]);
+		pNormal[0] = vertex.nx;		pNormal[1] = vertex.ny;		pNormal[2] = vertex.nz;
+	}
+	if ( this->m_bHasStream[STREAM_TEX0] )
+	{
+		float* pTex0 = &(this->m_vecStreams[STREAM_TEX0][index * 2]);
+		pTex0[0] = vertex.tex0u;	pTex0[1] = vertex.tex0v;
+	}
+	if ( this->m_bHasStream[STREAM_TEX1] )
+	{
+		float* pTex1 = &(this->m_vecStreams[STREAM_TEX1][index * 2]);
+		pTex1[0] = vertex.tex1u;	pTex1[1] = vertex.tex1v;
+	}
+	if ( this->m_bHasStream[STREAM_COLOUR] )
+	{
+		float* pColour = &(this->m_vecStreams[STREAM_COLOUR][index * 4]);
+		pColour[0] = vertex.red;	pColour[1] = vertex.green;	pColour[2] = vertex.blue;	pColour[3] = vertex.alpha;
+	}
+	if ( this->m_bHasStream[STREAM_TANGENT] )
+	{
+		float* pTangent = &(this->m_vecStreams[STREAM_TANGENT][index * 3]);
+		pTangent[0] = vertex.tangent.x;		pTangent[1] = vertex.tangent.y;		pTangent[2] = vertex.tangent.z;
+	}
+	if ( this->m_bHasStream[STREAM_BINORMAL] )
+	{
+		float* pBinormal = &(this->m_vecStreams[STREAM_BINORMAL][index * 3]);
+		pBinormal[0] = vertex.binormal.x;	pBinormal[1] = vertex.binormal.y;	pBinormal[2] = vertex.binormal.z;
+	}
+	return;
+}
+
+void CPlyVertexStreams::push_back( const PlyVertex &vertex )
+{
+	this->resize( this->m_numberOfVertices + 1 );
+	this->SetVertex( this->m_numberOfVertices - 1, vertex );
+	return;
+}
+
+void CPlyVertexStreams::Gather( const std::vector<unsigned int> &vecOldIndices )
+{
+	const unsigned int newNumberOfVertices = static_cast<unsigned int>( vecOldIndices.size() );
+	for ( unsigned int stream = 0; stream != CPlyVertexStreams::NUMBEROFSTREAMS; stream++ )
+	{
+		if ( !this->m_bHasStream[stream] )
+		{
+			continue;
+		}
+		const unsigned int floatsPerVertex = CPlyVertexStreams::GetFloatsPerVertex( static_cast<enumStream>( stream ) );
+		std::vector<float> vecNewStream( static_cast<size_t>( newNumberOfVertices ) * floatsPerVertex );
+		for ( unsigned int newIndex = 0; newIndex != newNumberOfVertices; newIndex++ )
+		{
+			const float* pOld = &(this->m_vecStreams[stream][ static_cast<size_t>( vecOldIndices[newIndex] ) * floatsPerVertex ]);
+			float* pNew = &(vecNewStream[ static_cast<size_t>( newIndex ) * floatsPerVertex ]);
+			for ( unsigned int component = 0; component != floatsPerVertex; component++ )
+			{
+				pNew[component] = pOld[component];
+			}
+		}
+		this->m_vecStreams[stream].swap( vecNewStream );
+	}
+	this->m_numberOfVertices = newNumberOfVertices;
+	return;
+}
+
+void CPlyVertexStreams::Reorder( const std::vector<unsigned int> &vecNewIndices )
+{
+	std::vector<unsigned int> vecOldIndices( vecNewIndices.size() );
+	for ( unsigned int oldIndex = 0; oldIndex != static_cast<unsigned int>( vecNewIndices.size() ); oldIndex++ )
+	{
+		vecOldIndices[ vecNewIndices[oldIndex] ] = oldIndex;
+	}
+	this->Gather( vecOldIndices );
+	return;
+}
+
+bool CPlyVertexStreams::bVerticesAreTheSame( unsigned int indexA, unsigned int indexB, float epsilon ) const
+{
+	// (A stream that isn't there is zero for both, so it's the same)
+	for ( unsigned int stream = 0; stream != CPlyVertexStreams::NUMBEROFSTREAMS; stream++ )
+	{
+		if ( !this->m_bHasStream[stream] )
+		{
+			continue;
+		}
+		const unsigned int floatsPerVertex = CPlyVertexStreams::GetFloatsPerVertex( static_cast<enumStream>( stream ) );
+		const float* pA = &(this->m_vecStreams[stream][ static_cast<size_t>( indexA ) * floatsPerVertex ]);
+		const float* pB = &(this->m_vecStreams[stream][ static_cast<size_t>( indexB ) * floatsPerVertex ]);
+		for ( unsigned int component = 0; component != floatsPerVertex; component++ )
+		{
+			if ( !( fabs( pA[component] - pB[component] ) <= epsilon ) )
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void CPlyVertexStreams::ExportInterleaved( const CPlyVertexLayout &layout, void* pDestination ) const
+{
+	const unsigned int vertexSizeInBytes = layout.GetVertexSizeInBytes();
+	const unsigned int numberOfAttributes = layout.GetNumberOfAttributes();
+	if ( ( this->m_numberOfVertices == 0 ) || ( vertexSizeInBytes == 0 ) )
+	{
+		return;
+	}
+
+	// Each vertex is put together here, then copied over in one go, so the destination is 
+	//	written from start to end (mapped GL buffers are often write combined, and slow to "jump around" in)
+	std::vector<unsigned char> vecVertex( vertexSizeInBytes, 0 );
+	unsigned char* pVertex = &(vecVertex[0]);
+	unsigned char* pDestinationVertex = static_cast<unsigned char*>( pDestination );
+
+	// The streams (and how many floats of each go in) don't change from vertex to vertex
+	std::vector<const float*> vecAttributeStreams( numberOfAttributes );
+	std::vector<unsigned int> vecFloatsFromStream( numberOfAttributes );
+	for ( unsigned int attributeIndex = 0; attributeIndex != numberOfAttributes; attributeIndex++ )
+	{
+		const CPlyVertexLayout::sAttribute &attribute = layout.GetAttribute( attributeIndex );
+		vecAttributeStreams[attributeIndex] = this->GetStream( attribute.stream );
+		vecFloatsFromStream[attributeIndex] = CPlyVertexStreams::GetFloatsPerVertex( attribute.stream );
+	}
+
+	for ( unsigned int index = 0; index != this->m_numberOfVertices; index++ )
+	{
+		for ( unsigned int attributeIndex = 0; attributeIndex != numberOfAttributes; attributeIndex++ )
+		{
+			const CPlyVertexLayout::sAttribute &attribute = layout.GetAttribute( attributeIndex );
+			const unsigned int floatsPerVertex = vecFloatsFromStream[attributeIndex];
+			const float* pStream = vecAttributeStreams[attributeIndex];
+
+			float streamValues[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			if ( pStream != 0 )
+			{
+				for ( unsigned int component = 0; component != floatsPerVertex; component++ )
+				{
+					streamValues[component] = pStream[ static_cast<size_t>( index ) * floatsPerVertex + component ];
+				}
+			}
+			unsigned int numberOfValuesFromStream = floatsPerVertex;
+			if ( attribute.encoding == CPlyVertexLayout::ENCODING_OCTAHEDRAL )
+			{	// (x, y, z into 2 numbers)
+				float encoded[2];
+				CPlyVertexLayout::OctahedralEncode( streamValues, encoded );
+				streamValues[0] = encoded[0];
+				streamValues[1] = encoded[1];
+				numberOfValuesFromStream = 2;
+			}
+
+			unsigned char* pComponent = pVertex + attribute.offsetInBytes;
+			for ( unsigned int component = 0; component != attribute.numberOfComponents; component++ )
+			{
+				float value = attribute.fillValues[component];
+				if ( component < numberOfValuesFromStream )
+				{
+					value = ( streamValues[component] - attribute.valueOffset[component] ) * attribute.valueScale[component];
+				}
+				pComponent += StoreComponent( value, attribute.type, pComponent );
+			}
+		}
+		memcpy( pDestinationVertex, pVertex, vertexSizeInBytes );
+		pDestinationVertex += vertexSizeInBytes;
+	}
+	return;
+}
+
+void CPlyVertexStreams::ImportInterleaved( const CPlyVertexLayout &layout, const void* pSource, unsigned int numberOfVertices )
+{
+	this->clear();
+	const unsigned int numberOfAttributes = layout.GetNumberOfAttributes();
+	for ( unsigned int attributeIndex = 0; attributeIndex != numberOfAttributes; attributeIndex++ )
+	{
+		this->AddStream( layout.GetAttribute( attributeIndex ).stream );
+	}
+	this->resize( numberOfVertices );
+
+	const unsigned int vertexSizeInBytes = layout.GetVertexSizeInBytes();
+	for ( unsigned int attributeIndex = 0; attributeIndex != numberOfAttributes; attributeIndex++ )
+	{
+		const CPlyVertexLayout::sAttribute &attribute = layout.GetAttribute( attributeIndex );
+		if ( ( attribute.type != CPlyVertexLayout::TYPE_FLOAT32 ) || ( attribute.encoding != CPlyVertexLayout::ENCODING_NONE ) )
+		{
+			continue;
+		}
+		const unsigned int floatsPerVertex = CPlyVertexStreams::GetFloatsPerVertex( attribute.stream );
+		const unsigned int floatsToCopy = ( attribute.numberOfComponents < floatsPerVertex ) ? attribute.numberOfComponents : floatsPerVertex;
+		float* pStream = this->GetStream( attribute.stream );
+		const unsigned char* pSourceAttribute = static_cast<const unsigned char*>( pSource ) + attribute.offsetInBytes;
+		for ( unsigned int index = 0; index != numberOfVertices; index++ )
+		{
+			memcpy( &(pStream[ static_cast<size_t>( index ) * floatsPerVertex ]), pSourceAttribute, floatsToCopy * sizeof(float) );
+			pSourceAttribute += vertexSizeInBytes;
+		}
+	}
+	return;
+}
+
+bool CPlyVertexStreams::bIsStreamAllZeros( enumStream stream ) const
+{
+	if ( !this->m_bHasStream[stream] )
+	{
+		return true;
+	}
+	const std::vector<float> &vecStream = this->m_vecStreams[stream];
+	for ( std::vector<float>::const_iterator itValue = vecStream.begin(); itValue != vecStream.end(); itValue++ )
+	{
+		if ( *itValue != 0.0f )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+unsigned long long CPlyVertexStreams::GetSizeInBytes(void) const
+{
+	unsigned long long sizeInBytes = 0;
+	for ( unsigned int stream = 0; stream != CPlyVertexStreams::NUMBEROFSTREAMS; stream++ )
+	{
+		sizeInBytes += static_cast<unsigned long long>( this->m_vecStreams[stream].capacity() ) * sizeof(float);
+	}
+	return sizeInBytes;
+}
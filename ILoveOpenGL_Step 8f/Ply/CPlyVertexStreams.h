@@ -0,0 +1,85 @@
+#ifndef _CPlyVertexStreams_HG_
+#define _CPlyVertexStreams_HG_
+
+// The vertices of a CPlyFile5nt, as "structure of arrays": one array ("stream") for each thing
+//	a vertex can have (positions, normals, texture coords, etc.).
+// Only the streams that are actually there get any memory. A PlyVertex is 92 bytes, so a scan
+//	that only has x, y, z (12 bytes) or x, y, z, nx, ny, nz (24 bytes) is a lot smaller this way.
+// A stream that isn't there reads as all zeros (the same as a PlyVertex that was never set).
+// Each stream is packed (e.g. x y z x y z ...), so the positions can go right into
+//	CPositionKernels, CMeshOptimizer, etc. with a stride of 3 floats.
+
+#include <vector>
+
+struct PlyVertex;
+class CPlyVertexLayout;
+
+class CPlyVertexStreams
+{
+public:
+	CPlyVertexStreams();
+
+	enum enumStream
+	{
+		STREAM_POSITION = 0,	// x, y, z (always there)
+		STREAM_NORMAL,			// nx, ny, nz
+		STREAM_TEX0,			// tex0u, tex0v
+		STREAM_TEX1,			// tex1u, tex1v
+		STREAM_COLOUR,			// red, green, blue, alpha
+		STREAM_TANGENT,			// tangent x, y, z
+		STREAM_BINORMAL,		// binormal x, y, z
+		NUMBEROFSTREAMS
+	};
+	// How many floats each vertex has in this stream
+	static unsigned int GetFloatsPerVertex( enumStream stream );
+
+	unsigned int size(void) const;
+	bool empty(void) const;
+	// No vertices, and only the position stream
+	void clear(void);
+	// New vertices are all zeros
+	void resize( unsigned int numberOfVertices );
+	void reserve( unsigned int numberOfVertices );
+	void swap( CPlyVertexStreams &other );
+
+	bool bHasStream( enumStream stream ) const;
+	// Adds the stream (all zeros) if it isn't already there
+	void AddStream( enumStream stream );
+	// The first float of vertex 0, or 0 (NULL) if the stream isn't there (or there are no vertices)
+	float* GetStream( enumStream stream );
+	const float* GetStream( enumStream stream ) const;
+
+	// These copy to and from a PlyVertex (the "old" way of getting at a vertex)
+	// SetVertex() ignores anything in the PlyVertex that this doesn't have a stream for.
+	PlyVertex GetVertex( unsigned int index ) const;
+	void SetVertex( unsigned int index, const PlyVertex &vertex );
+	void push_back( const PlyVertex &vertex );
+
+	// Keeps only the vertices in vecOldIndices, in that order (new vertex N is old vertex vecOldIndices[N])
+	void Gather( const std::vector<unsigned int> &vecOldIndices );
+	// Moves the vertices around (old vertex N becomes new vertex vecNewIndices[N])
+	void Reorder( const std::vector<unsigned int> &vecNewIndices );
+
+	// Is everything (in every stream) within epsilon? (epsilon of 0.0f is the same as ==)
+	bool bVerticesAreTheSame( unsigned int indexA, unsigned int indexB, float epsilon ) const;
+
+	// Writes the vertices one after the other (interleaved), laid out the way the layout says
+	// pDestination needs size() * layout.GetVertexSizeInBytes() bytes (any gaps in the vertex are zeros)
+	// Updated: The values are converted to the layout's types as they're written (see CPlyVertexLayout)
+	void ExportInterleaved( const CPlyVertexLayout &layout, void* pDestination ) const;
+	// Added: The other way (like from a GDP v2 vertex array). Replaces everything, and makes a stream 
+	//	for each attribute in the layout. Only does the TYPE_FLOAT32 (not encoded) attributes.
+	void ImportInterleaved( const CPlyVertexLayout &layout, const void* pSource, unsigned int numberOfVertices );
+	// Added: True if the stream isn't there, too
+	bool bIsStreamAllZeros( enumStream stream ) const;
+
+	// How much memory the streams are using
+	unsigned long long GetSizeInBytes(void) const;
+
+private:
+	unsigned int m_numberOfVertices;
+	std::vector<float> m_vecStreams[NUMBEROFSTREAMS];
+	bool m_bHasStream[NUMBEROFSTREAMS];
+};
+
+#endif
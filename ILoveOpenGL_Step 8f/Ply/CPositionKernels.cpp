@@ -0,0 +1,246 @@
+#include "CPositionKernels.h"
+
+#include <math.h>
+#include <emmintrin.h>	// SSE2
+
+// x, y, z of one vertex into the first 3 floats. The 4th is whatever comes after z (the
+//	next float of the vertex, or the next vertex), except for the last vertex, where it's 0.
+static inline __m128 LoadXYZ_SSE( const float* pXYZ, bool bIsLastVertex )
+{
+	if ( bIsLastVertex )
+	{
+		return _mm_setr_ps( pXYZ[0], pXYZ[1], pXYZ[2], 0.0f );
+	}
+	return _mm_loadu_ps( pXYZ );
+}
+
+static inline const float* PositionAt( const float* pPositions, unsigned int positionStrideInBytes, unsigned int vertex )
+{
+	return reinterpret_cast<const float*>( reinterpret_cast<const char*>( pPositions ) + static_cast<size_t>( vertex ) * positionStrideInBytes );
+}
+
+//static
+void CPositionKernels::CalculateMinMax( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+                                        float minXYZ[3], float maxXYZ[3] )
+{
+	if ( numberOfVertices == 0 )
+	{
+		return;
+	}
+	const unsigned int lastVertex = numberOfVertices - 1;
+	// Two sets, so the min and max of one vertex don't have to wait for the one before
+	__m128 min0 = LoadXYZ_SSE( PositionAt( pPositions, positionStrideInBytes, lastVertex ), true );
+	__m128 max0 = min0;
+	__m128 min1 = min0;
+	__m128 max1 = min0;
+	unsigned int vertex = 0;
+	for ( ; vertex + 1 < lastVertex; vertex += 2 )
+	{
+		__m128 xyz0 = _mm_loadu_ps( PositionAt( pPositions, positionStrideInBytes, vertex ) );
+		__m128 xyz1 = _mm_loadu_ps( PositionAt( pPositions, positionStrideInBytes, vertex + 1 ) );
+		min0 = _mm_min_ps( min0, xyz0 );
+		max0 = _mm_max_ps( max0, xyz0 );
+		min1 = _mm_min_ps( min1, xyz1 );
+		max1 = _mm_max_ps( max1, xyz1 );
+	}
+	for ( ; vertex < lastVertex; vertex++ )
+	{
+		__m128 xyz = _mm_loadu_ps( PositionAt( pPositions, positionStrideInBytes, vertex ) );
+		min0 = _mm_min_ps( min0, xyz );
+		max0 = _mm_max_ps( max0, xyz );
+	}
+	float minOut[4];
+	float maxOut[4];
+	_mm_storeu_ps( minOut, _mm_min_ps( min0, min1 ) );
+	_mm_storeu_ps( maxOut, _mm_max_ps( max0, max1 ) );
+	for ( int axis = 0; axis != 3; axis++ )
+	{
+		minXYZ[axis] = minOut[axis];
+		maxXYZ[axis] = maxOut[axis];
+	}
+	return;
+}
+
+//static
+void CPositionKernels::ScaleAndTranslate( float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+                                          const float scaleXYZ[3], const float translateXYZ[3] )
+{
+	if ( numberOfVertices == 0 )
+	{
+		return;
+	}
+	const unsigned int lastVertex = numberOfVertices - 1;
+	const __m128 scale = _mm_setr_ps( scaleXYZ[0], scaleXYZ[1], scaleXYZ[2], 1.0f );
+	const __m128 translate = _mm_setr_ps( translateXYZ[0], translateXYZ[1], translateXYZ[2], 0.0f );
+	// The 4th float is put back exactly as it was (it's not ours)
+	const __m128 xyzMask = _mm_castsi128_ps( _mm_setr_epi32( -1, -1, -1, 0 ) );
+	for ( unsigned int vertex = 0; vertex != lastVertex; vertex++ )
+	{
+		float* pXYZ = const_cast<float*>( PositionAt( pPositions, positionStrideInBytes, vertex ) );
+		__m128 xyz = _mm_loadu_ps( pXYZ );
+		__m128 result = _mm_add_ps( _mm_mul_ps( xyz, scale ), translate );
+		_mm_storeu_ps( pXYZ, _mm_or_ps( _mm_and_ps( xyzMask, result ), _mm_andnot_ps( xyzMask, xyz ) ) );
+	}
+	float* pLast = const_cast<float*>( PositionAt( pPositions, positionStrideInBytes, lastVertex ) );
+	for ( int axis = 0; axis != 3; axis++ )
+	{
+		pLast[axis] = pLast[axis] * scaleXYZ[axis] + translateXYZ[axis];
+	}
+	return;
+}
+
+//static
+unsigned int CPositionKernels::m_FindFurthestVertex( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+                                                     const float pointXYZ[3], float &distanceSquared )
+{
+	const unsigned int lastVertex = numberOfVertices - 1;
+	// 4 vertices at a time: load them, then turn them into x x x x, y y y y, z z z z
+	// Each of the 4 "lanes" keeps the furthest of its own vertices (the first one, if it's a tie)
+	const __m128 pointX = _mm_set1_ps( pointXYZ[0] );
+	const __m128 pointY = _mm_set1_ps( pointXYZ[1] );
+	const __m128 pointZ = _mm_set1_ps( pointXYZ[2] );
+	__m128 furthestDistance = _mm_set1_ps( -1.0f );
+	__m128i furthestIndex = _mm_setzero_si128();
+	__m128i index = _mm_setr_epi32( 0, 1, 2, 3 );
+	const __m128i four = _mm_set1_epi32( 4 );
+	unsigned int vertex = 0;
+	for ( ; vertex + 4 <= lastVertex; vertex += 4 )
+	{
+		__m128 x = _mm_loadu_ps( PositionAt( pPositions, positionStrideInBytes, vertex ) );
+		__m128 y = _mm_loadu_ps( PositionAt( pPositions, positionStrideInBytes, vertex + 1 ) );
+		__m128 z = _mm_loadu_ps( PositionAt( pPositions, positionStrideInBytes, vertex + 2 ) );
+		__m128 w = _mm_loadu_ps( PositionAt( pPositions, positionStrideInBytes, vertex + 3 ) );
+		_MM_TRANSPOSE4_PS( x, y, z, w );
+		__m128 dx = _mm_sub_ps( x, pointX );
+		__m128 dy = _mm_sub_ps( y, pointY );
+		__m128 dz = _mm_sub_ps( z, pointZ );
+		__m128 d2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) ), _mm_mul_ps( dz, dz ) );
+		__m128 bIsFurther = _mm_cmpgt_ps( d2, furthestDistance );
+		furthestDistance = _mm_or_ps( _mm_and_ps( bIsFurther, d2 ), _mm_andnot_ps( bIsFurther, furthestDistance ) );
+		__m128i bIsFurtherInt = _mm_castps_si128( bIsFurther );
+		furthestIndex = _mm_or_si128( _mm_and_si128( bIsFurtherInt, index ), _mm_andnot_si128( bIsFurtherInt, furthestIndex ) );
+		index = _mm_add_epi32( index, four );
+	}
+	float laneDistance[4];
+	unsigned int laneIndex[4];
+	_mm_storeu_ps( laneDistance, furthestDistance );
+	_mm_storeu_si128( reinterpret_cast<__m128i*>( laneIndex ), furthestIndex );
+	unsigned int bestVertex = 0;
+	float bestDistance = -1.0f;
+	for ( int lane = 0; lane != 4; lane++ )
+	{
+		if ( ( laneDistance[lane] > bestDistance ) ||
+		     ( laneDistance[lane] == bestDistance && laneIndex[lane] < bestVertex ) )
+		{
+			bestDistance = laneDistance[lane];
+			bestVertex = laneIndex[lane];
+		}
+	}
+	// The last few (and the last vertex) one at a time
+	for ( ; vertex != numberOfVertices; vertex++ )
+	{
+		const float* pXYZ = PositionAt( pPositions, positionStrideInBytes, vertex );
+		float dx = pXYZ[0] - pointXYZ[0];
+		float dy = pXYZ[1] - pointXYZ[1];
+		float dz = pXYZ[2] - pointXYZ[2];
+		float d2 = dx * dx + dy * dy + dz * dz;
+		if ( d2 > bestDistance )
+		{
+			bestDistance = d2;
+			bestVertex = vertex;
+		}
+	}
+	distanceSquared = bestDistance;
+	return bestVertex;
+}
+
+//static
+void CPositionKernels::CalculateBoundingSphere( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+                                                float centreXYZ[3], float &radius )
+{
+	if ( numberOfVertices == 0 )
+	{
+		centreXYZ[0] = centreXYZ[1] = centreXYZ[2] = 0.0f;
+		radius = 0.0f;
+		return;
+	}
+	float distanceSquared = 0.0f;
+
+	// 1. A first guess: the sphere between two vertices that are (about) as far apart as any
+	const float* pFirst = PositionAt( pPositions, positionStrideInBytes, 0 );
+	unsigned int vertexA = CPositionKernels::m_FindFurthestVertex( pPositions, positionStrideInBytes, numberOfVertices, pFirst, distanceSquared );
+	const float* pA = PositionAt( pPositions, positionStrideInBytes, vertexA );
+	unsigned int vertexB = CPositionKernels::m_FindFurthestVertex( pPositions, positionStrideInBytes, numberOfVertices, pA, distanceSquared );
+	const float* pB = PositionAt( pPositions, positionStrideInBytes, vertexB );
+	float centre[3] = { ( pA[0] + pB[0] ) * 0.5f, ( pA[1] + pB[1] ) * 0.5f, ( pA[2] + pB[2] ) * 0.5f };
+	float ritterRadius = sqrt( distanceSquared ) * 0.5f;
+
+	// 2. Grow it to take in any vertex that's outside (moving the centre towards it)
+	// The test is done 4 at a time; the (few) that are outside are then done one at a time, in order.
+	auto growToInclude = [&]( unsigned int vertex )
+	{
+		const float* pXYZ = PositionAt( pPositions, positionStrideInBytes, vertex );
+		float dx = pXYZ[0] - centre[0];
+		float dy = pXYZ[1] - centre[1];
+		float dz = pXYZ[2] - centre[2];
+		float d2 = dx * dx + dy * dy + dz * dz;
+		if ( d2 > ritterRadius * ritterRadius )
+		{
+			float distance = sqrt( d2 );
+			float newRadius = ( ritterRadius + distance ) * 0.5f;
+			float moveRatio = ( newRadius - ritterRadius ) / distance;
+			centre[0] += dx * moveRatio;
+			centre[1] += dy * moveRatio;
+			centre[2] += dz * moveRatio;
+			ritterRadius = newRadius;
+		}
+	};
+	const unsigned int lastVertex = numberOfVertices - 1;
+	unsigned int vertex = 0;
+	for ( ; vertex + 4 <= lastVertex; vertex += 4 )
+	{
+		__m128 x = _mm_loadu_ps( PositionAt( pPositions, positionStrideInBytes, vertex ) );
+		__m128 y = _mm_loadu_ps( PositionAt( pPositions, positionStrideInBytes, vertex + 1 ) );
+		__m128 z = _mm_loadu_ps( PositionAt( pPositions, positionStrideInBytes, vertex + 2 ) );
+		__m128 w = _mm_loadu_ps( PositionAt( pPositions, positionStrideInBytes, vertex + 3 ) );
+		_MM_TRANSPOSE4_PS( x, y, z, w );
+		__m128 dx = _mm_sub_ps( x, _mm_set1_ps( centre[0] ) );
+		__m128 dy = _mm_sub_ps( y, _mm_set1_ps( centre[1] ) );
+		__m128 dz = _mm_sub_ps( z, _mm_set1_ps( centre[2] ) );
+		__m128 d2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) ), _mm_mul_ps( dz, dz ) );
+		if ( _mm_movemask_ps( _mm_cmpgt_ps( d2, _mm_set1_ps( ritterRadius * ritterRadius ) ) ) != 0 )
+		{
+			for ( unsigned int lane = 0; lane != 4; lane++ )
+			{
+				growToInclude( vertex + lane );
+			}
+		}
+	}
+	for ( ; vertex != numberOfVertices; vertex++ )
+	{
+		growToInclude( vertex );
+	}
+	// (Rounding can leave a vertex a tiny bit outside, so the radius is the actual furthest one)
+	CPositionKernels::m_FindFurthestVertex( pPositions, positionStrideInBytes, numberOfVertices, centre, distanceSquared );
+	ritterRadius = sqrt( distanceSquared );
+
+	// 3. Is the one around the middle of the bounding box any better?
+	float minXYZ[3];
+	float maxXYZ[3];
+	CPositionKernels::CalculateMinMax( pPositions, positionStrideInBytes, numberOfVertices, minXYZ, maxXYZ );
+	float boxCentre[3] = { ( minXYZ[0] + maxXYZ[0] ) * 0.5f, ( minXYZ[1] + maxXYZ[1] ) * 0.5f, ( minXYZ[2] + maxXYZ[2] ) * 0.5f };
+	CPositionKernels::m_FindFurthestVertex( pPositions, positionStrideInBytes, numberOfVertices, boxCentre, distanceSquared );
+	float boxRadius = sqrt( distanceSquared );
+
+	if ( boxRadius < ritterRadius )
+	{
+		centreXYZ[0] = boxCentre[0]; centreXYZ[1] = boxCentre[1]; centreXYZ[2] = boxCentre[2];
+		radius = boxRadius;
+	}
+	else
+	{
+		centreXYZ[0] = centre[0]; centreXYZ[1] = centre[1]; centreXYZ[2] = centre[2];
+		radius = ritterRadius;
+	}
+	return;
+}
@@ -0,0 +1,37 @@
+#ifndef _CPositionKernels_HG_
+#define _CPositionKernels_HG_
+
+// The "do something to every position" loops (extents, scaling, moving, bounding spheres),
+//	done with SSE.
+// The positions are x, y, z of the first vertex; each one after that is positionStrideInBytes
+//	along (so they work right on a vector of PlyVertex, or a vertex buffer, without copying).
+// Each x, y, z is loaded into one SSE register, so the stride has to be at least 12 bytes.
+// Only the last vertex is done one float at a time (the load would read past the end), and
+//	nothing past the z of any vertex is ever changed.
+
+class CPositionKernels
+{
+public:
+	// The axis aligned bounding box. Does nothing if there aren't any vertices.
+	static void CalculateMinMax( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+	                             float minXYZ[3], float maxXYZ[3] );
+
+	// position = position * scaleXYZ + translateXYZ
+	static void ScaleAndTranslate( float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+	                               const float scaleXYZ[3], const float translateXYZ[3] );
+
+	// A sphere around all the vertices, using "An Efficient Bounding Sphere" (Jack Ritter,
+	//	Graphics Gems, 1990): a first guess from two vertices that are far apart, then grown
+	//	to take in any that are outside it.
+	// If the sphere around the centre of the bounding box happens to be smaller, you get that one.
+	// Not the smallest possible sphere (usually within 5 to 20%), but every vertex is inside it.
+	static void CalculateBoundingSphere( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+	                                     float centreXYZ[3], float &radius );
+
+private:
+	// The vertex furthest from pointXYZ (and its distance squared)
+	static unsigned int m_FindFurthestVertex( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices,
+	                                          const float pointXYZ[3], float &distanceSquared );
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "CVertexCacheReport.h"
+#include "CPlyFile5nt.h"
+#include "CMeshOptimizer.h"
+#include "CStringHelper.h"
+#include "../CHRTimer.h"
+#include "../CFileView.h"
+
+#include <iomanip>
+#include <algorithm>
+
+//static 
+bool CVertexCacheReport::RunOnFolder( std::string modelFolder, unsigned int cacheSize, std::ostream &output )
+{
+	// Find all the ply files in the folder
+	std::vector<std::string> vecFileNames;
+	if ( !CFileView::FindFiles( modelFolder, "*.ply", vecFileNames ) )
+	{
+		output << "Didn't find any ply files in " << modelFolder << std::endl;
+		return false;
+	}
+
+	if ( cacheSize == 0 )
+	{
+		cacheSize = CMeshOptimizer::DEFAULTCACHESIZE;
+	}
+
+	output << "Vertex cache size: " << cacheSize << std::endl;
+	output << std::left << std::setw(40) << "Model" 
+		   << std::right << std::setw(10) << "triangles" 
+		   << std::setw(12) << "ACMR file" 
+		   << std::setw(12) << "ACMR opt" 
+		   << std::setw(12) << "ATVR file" 
+		   << std::setw(12) << "ATVR opt" 
+		   << std::setw(10) << "ms" << std::endl;
+
+	for ( std::vector<std::string>::iterator itFile = vecFileNames.begin(); itFile != vecFileNames.end(); itFile++ )
+	{
+		std::string fullFileName = modelFolder + "/" + *itFile;
+
+		output << std::left << std::setw(40) << *itFile << std::right << std::fixed;
+
+		CPlyFile5nt plyFile;
+		std::wstring error;
+		if ( !plyFile.OpenPLYFile2( CStringHelper::ASCIIToUnicodeQnD( fullFileName ), error ) )
+		{
+			output << "  Didn't load: " << CStringHelper::UnicodeToASCII_QnD( error ) << std::endl;
+			continue;
+		}
+		unsigned int numberOfVertices = static_cast<unsigned int>( plyFile.GetNumberOfVerticies() );
+
+		std::vector<unsigned int> vecIndices;
+		CVertexCacheReport::m_GetIndices( plyFile, vecIndices );
+		float ACMRBefore = 0.0f;
+		float ATVRBefore = 0.0f;
+		CMeshOptimizer::AnalyzeVertexCache( vecIndices, numberOfVertices, cacheSize, ACMRBefore, ATVRBefore );
+
+		CHRTimer timer;
+		timer.Reset();
+		timer.Start();
+		plyFile.OptimizeTriangleOrder( cacheSize, CMeshOptimizer::DEFAULTOVERDRAWTHRESHOLD );
+		double seconds = static_cast<double>( timer.GetElapsedSeconds() );
+
+		CVertexCacheReport::m_GetIndices( plyFile, vecIndices );
+		float ACMRAfter = 0.0f;
+		float ATVRAfter = 0.0f;
+		CMeshOptimizer::AnalyzeVertexCache( vecIndices, numberOfVertices, cacheSize, ACMRAfter, ATVRAfter );
+
+		output << std::setw(10) << plyFile.GetNumberOfElements() 
+			   << std::setprecision(3) << std::setw(12) << ACMRBefore << std::setw(12) << ACMRAfter 
+			   << std::setw(12) << ATVRBefore << std::setw(12) << ATVRAfter 
+			   << std::setprecision(2) << std::setw(10) << ( seconds * 1000.0 ) << std::endl;
+	}// for ( std::vector<std::string>::iterator itFile
+
+	return true;
+}
+
+//static 
+void CVertexCacheReport::m_GetIndices( CPlyFile5nt &plyFile, std::vector<unsigned int> &vecIndices )
+{
+	vecIndices.resize( plyFile.GetNumberOfElements() * 3 );
+	for ( int index = 0; index != plyFile.GetNumberOfElements(); index++ )
+	{
+		PlyElement element = plyFile.getElement_at(index);
+		vecIndices[index * 3 + 0] = static_cast<unsigned int>( element.vertex_index_1 );
+		vecIndices[index * 3 + 1] = static_cast<unsigned int>( element.vertex_index_2 );
+		vecIndices[index * 3 + 2] = static_cast<unsigned int>( element.vertex_index_3 );
+	}
+	return;
+}
@@ -0,0 +1,25 @@
+#ifndef _CVertexCacheReport_HG_
+#define _CVertexCacheReport_HG_
+
+// Vertex cache report for the models (see CMeshOptimizer)
+// Loads every .ply file in a folder, and prints the ACMR and ATVR (on a simulated FIFO 
+//	cache) for the triangles in the order they are in the file, then after 
+//	CPlyFile5nt::OptimizeTriangleOrder(), plus how long the optimizing took.
+// Run the program with "-cachereport" (and optionally the cache size) to use it.
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+class CPlyFile5nt;
+
+class CVertexCacheReport
+{
+public:
+	// Returns false if it couldn't find any ply files
+	static bool RunOnFolder( std::string modelFolder, unsigned int cacheSize, std::ostream &output );
+private:
+	static void m_GetIndices( CPlyFile5nt &plyFile, std::vector<unsigned int> &vecIndices );
+};
+
+#endif
@@ -29,19 +29,45 @@ uniform mat4 ModelMatrixRotOnly;		// 8
 uniform mat4 ViewMatrix;
 uniform mat4 ProjectionMatrix;
 
+// Added: For the compact vertices (see cVBOInfo::enumVertexFormat). 
+// The position is 0.0 to 1.0 across the bounding box, and the normal can be 2 numbers (octahedral).
+// (for regular float vertices, these are scale 1s, offset 0s, and "false")
+uniform vec4 PositionDecodeScale;
+uniform vec4 PositionDecodeOffset;
+uniform bool bNormalIsOctahedral;
+
+// Same as CPlyVertexLayout::OctahedralDecode()
+vec3 OctahedralDecode( vec2 encoded )
+{
+  vec3 normal = vec3( encoded.xy, 1.0f - abs(encoded.x) - abs(encoded.y) );
+  if ( normal.z < 0.0f )
+  {
+    normal.xy = ( 1.0f - abs(encoded.yx) ) * vec2( (encoded.x >= 0.0f) ? 1.0f : -1.0f, 
+                                                   (encoded.y >= 0.0f) ? 1.0f : -1.0f );
+  }
+  return normalize(normal);
+}
+
 void main(void)
 {
+  vec4 position = vec4( PositionDecodeOffset.xyz + in_Position.xyz * PositionDecodeScale.xyz, 1.0f );
+  vec4 normal = in_Normal;
+  if ( bNormalIsOctahedral )
+  {
+    normal = vec4( OctahedralDecode(in_Normal.xy), 1.0f );
+  }
+
   mat4 oneMatrixToRuleThemAll
   	= ProjectionMatrix * ViewMatrix * ModelMatrix;
 
-  gl_Position = oneMatrixToRuleThemAll * in_Position;
+  gl_Position = oneMatrixToRuleThemAll * position;
     
   // Sent 'pass through' variables to the fragment shader
   ex_Position = gl_Position;
   
-  ex_PositionWorld = ModelMatrix * in_Position;
+  ex_PositionWorld = ModelMatrix * position;
   
-  ex_Normal = ModelMatrixRotOnly * normalize(in_Normal);
+  ex_Normal = ModelMatrixRotOnly * normalize(normal);
   ex_RGBA = in_RGBA;
   ex_UV_x2 = in_UV_x2;
 
@@ -2,7 +2,7 @@
 
 cGameObject::cGameObject()
 {
-	this->cached_VBO_ID = -1;	
+	this->cached_VBO_ID = 0;	// cMeshManager::INVALIDMESHHANDLE
 	this->scale = 1.0f;
 
 	this->bUseDebugColour = false;
@@ -25,6 +25,8 @@ cGameObject::cGameObject()
 
 	this->bUseDiscardMask = false;
 
+	this->currentLOD = 0;		// Full detail
+
 	return;
 }
 
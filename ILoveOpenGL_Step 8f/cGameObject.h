@@ -42,8 +42,12 @@ public:
 
 	// Added
 	std::string modelName;		// File name
-	int cached_VBO_ID;// = -1;	// Huh??
+	// Updated: The mesh handle for modelName (see cMeshManager::GetVBOInfo()). It's looked up 
+	//	by name the first time it's drawn (0, or a handle that's out of date, means "look it up")
+	unsigned int cached_VBO_ID;
 	unsigned int numberOfTriangles;
+	// Added: The level of detail it was drawn with last time (see cMeshManager::SelectLOD())
+	unsigned int currentLOD;
 
 	bool bIsADebugObject;
 
@@ -3,18 +3,65 @@
 #include <vector>
 #include <fstream>
 #include <string>
+#include <algorithm>
+#include <math.h>
+#include <string.h>		// for memset()
 
 #include "Ply/CPlyFile5nt.h"
 #include "Ply/CStringHelper.h"
+#include "Ply/CGDP2File.h"
+#include "Ply/CMeshOptimizer.h"
+#include "Ply/CMeshSimplifier.h"
+#include "Ply/CPositionKernels.h"
+#include "Ply/CPlyVertexLayout.h"
+#include "Ply/CPlyVertexStreams.h"
+#include "CThreadPool.h"
+#include "CHRTimer.h"
+
+// (the LODs are copied in and out of the GDP files one by one)
+static_assert( cVBOInfo::MAXLODS == CGDP2File::MAXLODS, "The GDP file has to have room for all the LODs" );
+
+// Added: See m_PrepareMeshFromPly(), etc. The vertices are either in pVertices (Vertex_xyz_n_RGB_UVx2s, 
+//	like from a GDP v2 file), or in *pVertexStreams (written out the way the layout says). Both point 
+//	into this (the ply, the mapped file, etc.), so it can't be copied.
+// Updated: Same with the indices: either pIndices (from a GDP file, already 16 or 32 bits, 
+//	the way m_AddToMeshArena() wants them) or vecIndices
+struct cMeshManager::sPreparedMesh
+{
+	sPreparedMesh() : pVertices(0), pVertexStreams(0), numberOfVertices(0), pIndices(0), numberOfIndices(0), numberOfIndicesWithLODs(0) {};
+	std::string meshName;
+	CPlyFile5nt plyFile;
+	CGDP2File gdpFile;
+	CPlyVertexStreams vertexStreams;		// (for VERTEX_FORMAT_COMPACT from a GDP file without the compact vertices)
+	const void* pVertices;
+	const CPlyVertexStreams* pVertexStreams;
+	unsigned int numberOfVertices;
+	CPlyVertexLayout layout;
+	const void* pIndices;
+	std::vector<unsigned int> vecIndices;	// The full model, then the LODs
+	unsigned int numberOfIndices;			// Just the full model
+	unsigned int numberOfIndicesWithLODs;	// (zero if it didn't load)
+	cVBOInfo VBOInfo;						// The LODs, bounding sphere, decode values, etc.
+};
 
 cMeshManager::cMeshManager()
 {
+	this->m_GPUMemoryBudget = 0;
+	this->m_meshBytesInUse = 0;
+	this->m_currentFrame = 0;
+	this->m_totalEvictions = 0;
+	this->m_totalReloads = 0;
+	this->m_totalLazyLoads = 0;
+	this->m_pUploadRing = 0;
+	this->m_bytesUploadedThisFrame = 0;
 	return;
 }
 
 cMeshManager::~cMeshManager()
 {
 	// A bunch of clean up code to go here... 
+	// Added: The load jobs have a pointer to this
+	this->m_FinishLoadJobs();
 	return;
 }
 
@@ -90,18 +137,377 @@ cMeshManager::~cMeshManager()
 //}
 
 // "Fancier" version that loads more models, WAY faster
-bool cMeshManager::LoadPlyIntoVBO( std::string fileToLoad )
+unsigned int cMeshManager::LoadPlyIntoVBO( std::string fileToLoad, cVBOInfo::enumVertexFormat vertexFormat /*=VERTEX_FORMAT_FLOAT*/ )
 {
-	CPlyFile5nt plyFile;
+	// Updated: Split into the part that doesn't need OpenGL, and the part that does (see LoadPlyIntoVBOAsync())
+	sPreparedMesh preparedMesh;
+	if ( !cMeshManager::m_PrepareMeshFromPly( fileToLoad, vertexFormat, this->m_cookedCache, preparedMesh ) )
+	{
+		return cMeshManager::INVALIDMESHHANDLE;
+	}
+	return this->m_AddToMeshArena( preparedMesh );
+}
+
+unsigned int cMeshManager::LoadGDP2IntoVBO( std::string fileToLoad, std::string meshName, 
+                                            cVBOInfo::enumVertexFormat vertexFormat /*=VERTEX_FORMAT_FLOAT*/ )
+{
+	sPreparedMesh preparedMesh;
+	if ( !cMeshManager::m_PrepareMeshFromGDP2( fileToLoad, meshName, vertexFormat, preparedMesh ) )
+	{
+		return cMeshManager::INVALIDMESHHANDLE;
+	}
+	return this->m_AddToMeshArena( preparedMesh );
+}
+
+//static 
+bool cMeshManager::m_PrepareMeshFromGDP2( std::string fileToLoad, std::string meshName, cVBOInfo::enumVertexFormat vertexFormat, 
+                                          sPreparedMesh &preparedMesh )
+{
+	preparedMesh.meshName = meshName;
+	preparedMesh.VBOInfo.sourceFileName = fileToLoad;
+	preparedMesh.VBOInfo.bSourceIsGDP2 = true;
+	std::wstring error;
+	if ( !preparedMesh.gdpFile.Open( CStringHelper::getInstance( )->ASCIIToUnicodeQnD( fileToLoad ), error ) )
+	{
+		return false;
+	}
+
+	// The vertices (either format) and the indices (and the LODs) go straight from the mapped file to OpenGL
+	cMeshManager::m_PrepareMeshFromGDP2File( preparedMesh, vertexFormat );
+	return true;
+}
+
+//static 
+bool cMeshManager::m_PrepareMeshFromPly( std::string fileToLoad, cVBOInfo::enumVertexFormat vertexFormat, CAssetCache cookedCache, 
+                                         sPreparedMesh &preparedMesh )
+{
+	preparedMesh.meshName = fileToLoad;
+	preparedMesh.VBOInfo.sourceFileName = fileToLoad;
+
+	// Added: Is there an up to date, cooked version? (if so, it's only I/O from here)
+	std::wstring cookedFileToSave;
+	unsigned long long cookKey = 0;
+	if ( cookedCache.IsEnabled() && 
+		 CAssetCache::CalculateCookKey( fileToLoad, cMeshManager::MESHCOOKSETTINGS, cookKey ) )
+	{
+		std::string cookedFile = cookedCache.GetCookedFileName( fileToLoad, ".gdp" );
+		CGDP2File &gdpFile = preparedMesh.gdpFile;
+		std::wstring gdpError;
+		if ( gdpFile.Open( CStringHelper::getInstance( )->ASCIIToUnicodeQnD( cookedFile ), gdpError ) && 
+			 ( gdpFile.GetCookKey() == cookKey ) )
+		{
+			cMeshManager::m_PrepareMeshFromGDP2File( preparedMesh, vertexFormat );
+			return true;
+		}
+		// (it can't be saved over while it's mapped)
+		gdpFile.Close();
+		// Not there (or out of date), so cook it this time around
+		if ( cookedCache.CreateCacheFolder() )
+		{
+			cookedFileToSave = CStringHelper::getInstance( )->ASCIIToUnicodeQnD( cookedFile );
+		}
+	}
+
+	CPlyFile5nt &plyFile = preparedMesh.plyFile;
+	plyFile.SetParallelASCIIParsing(true);
 	std::wstring error;
 	if (!plyFile.OpenPLYFile2( CStringHelper::getInstance( )->ASCIIToUnicodeQnD( fileToLoad ), error ))
 	{
 		return false;
 	}
 
-	if ( ! plyFile.bHasNormalsInFile() )
+	if ( plyFile.GetNumberOfVerticies() == 0 )
+	{
+		return false;
+	}
+
+	PlyWeldInfo weldInfo;
+	cMeshManager::m_PrepareForRendering( plyFile, weldInfo );
+	if ( plyFile.GetNumberOfElements() == 0 )
+	{	// (all the triangles were degenerate)
+		return false;
+	}
+
+	// Updated: The vertices go straight from the ply into the vertex buffer (no copy of them in between)
+	cMeshManager::m_PrepareMeshFromPlyFile( preparedMesh, vertexFormat );
+
+	// Updated: After the LODs are made, so they are saved, too
+	if ( !cookedFileToSave.empty() )
+	{	// (it doesn't matter if this doesn't work; it'll just be cooked again next time)
+		cMeshManager::m_SaveCookedFile( preparedMesh, cookedFileToSave, cookKey, error );
+	}
+	return true;
+}
+
+bool cMeshManager::LoadPlyIntoVBOAsync( std::string fileToLoad, cVBOInfo::enumVertexFormat vertexFormat /*=VERTEX_FORMAT_FLOAT*/ )
+{
+	return this->m_LoadAsync( fileToLoad, fileToLoad, false, vertexFormat );
+}
+
+bool cMeshManager::m_LoadAsync( std::string fileToLoad, std::string meshName, bool bIsGDP2, cVBOInfo::enumVertexFormat vertexFormat )
+{
+	if ( this->LookUpMeshHandle( meshName ) != cMeshManager::INVALIDMESHHANDLE )
 	{
-		plyFile.normalizeTheModelBaby();
+		return false;
+	}
+	{
+		std::lock_guard<std::mutex> lock( this->m_loadQueueMutex );
+		if ( !this->m_setMeshesLoading.insert( meshName ).second )
+		{	// Already on its way
+			return false;
+		}
+	}
+
+	// (so the singleton is made here, not by two of the jobs at once)
+	CStringHelper::getInstance();
+
+	CAssetCache cookedCache = this->m_cookedCache;
+	std::future<void> loadJob = CThreadPool::getSharedInstance()->AddJob( [this, fileToLoad, meshName, bIsGDP2, vertexFormat, cookedCache]()
+	{
+		sPreparedMesh* pPreparedMesh = new sPreparedMesh();
+		const bool bPrepared = bIsGDP2 ? cMeshManager::m_PrepareMeshFromGDP2( fileToLoad, meshName, vertexFormat, *pPreparedMesh )
+		                               : cMeshManager::m_PrepareMeshFromPly( fileToLoad, vertexFormat, cookedCache, *pPreparedMesh );
+		if ( !bPrepared )
+		{	// (it still goes in the queue, with no indices, so ProcessLoadQueue() knows it's done)
+			pPreparedMesh->numberOfIndicesWithLODs = 0;
+		}
+		std::lock_guard<std::mutex> lock( this->m_loadQueueMutex );
+		this->m_queueMeshesToUpload.push_back( pPreparedMesh );
+	} );
+
+	std::lock_guard<std::mutex> lock( this->m_loadQueueMutex );
+	this->m_vecLoadJobs.push_back( std::move( loadJob ) );
+	return true;
+}
+
+unsigned int cMeshManager::ProcessLoadQueue( float budgetInSeconds /*=DEFAULTUPLOADBUDGETSECONDS*/, 
+                                             unsigned int budgetInBytes /*=DEFAULTUPLOADBUDGETBYTES*/ )
+{
+	CHRTimer timer;
+	timer.Reset();
+	timer.Start();
+
+	unsigned int numberUploaded = 0;
+	while ( true )
+	{
+		sPreparedMesh* pPreparedMesh = 0;
+		{
+			std::lock_guard<std::mutex> lock( this->m_loadQueueMutex );
+			if ( this->m_queueMeshesToUpload.empty() )
+			{
+				break;
+			}
+			pPreparedMesh = this->m_queueMeshesToUpload.front();
+			this->m_queueMeshesToUpload.pop_front();
+		}
+
+		if ( pPreparedMesh->numberOfIndicesWithLODs != 0 )
+		{
+			if ( this->m_AddToMeshArena( *pPreparedMesh ) != cMeshManager::INVALIDMESHHANDLE )
+			{
+				numberUploaded++;
+			}
+		}
+		else
+		{	// (if it was evicted, or lazy, and now it won't load, don't keep trying)
+			this->m_mapEvictedMeshes.erase( pPreparedMesh->meshName );
+			this->m_mapLazyMeshes.erase( pPreparedMesh->meshName );
+		}
+		{
+			std::lock_guard<std::mutex> lock( this->m_loadQueueMutex );
+			this->m_setMeshesLoading.erase( pPreparedMesh->meshName );
+		}
+		delete pPreparedMesh;
+
+		if ( timer.GetElapsedSeconds() >= budgetInSeconds )
+		{
+			break;
+		}
+		// Added: (the rest wait for the next frame)
+		if ( ( budgetInBytes != 0 ) && ( this->m_bytesUploadedThisFrame >= budgetInBytes ) )
+		{
+			break;
+		}
+	}
+
+	// Forget about the jobs that are done
+	std::lock_guard<std::mutex> lock( this->m_loadQueueMutex );
+	std::vector< std::future<void> >::iterator itJob = this->m_vecLoadJobs.begin();
+	while ( itJob != this->m_vecLoadJobs.end() )
+	{
+		if ( itJob->wait_for( std::chrono::seconds(0) ) == std::future_status::ready )
+		{
+			itJob = this->m_vecLoadJobs.erase( itJob );
+		}
+		else
+		{
+			itJob++;
+		}
+	}
+	return numberUploaded;
+}
+
+unsigned int cMeshManager::GetNumberOfMeshesLoading(void)
+{
+	std::lock_guard<std::mutex> lock( this->m_loadQueueMutex );
+	return static_cast<unsigned int>( this->m_setMeshesLoading.size() );
+}
+
+void cMeshManager::m_FinishLoadJobs(void)
+{
+	// (not locked while waiting, since the jobs lock it to add to the queue)
+	std::vector< std::future<void> > vecLoadJobs;
+	{
+		std::lock_guard<std::mutex> lock( this->m_loadQueueMutex );
+		vecLoadJobs.swap( this->m_vecLoadJobs );
+	}
+	for ( std::vector< std::future<void> >::iterator itJob = vecLoadJobs.begin(); itJob != vecLoadJobs.end(); itJob++ )
+	{
+		itJob->wait();
+	}
+
+	std::lock_guard<std::mutex> lock( this->m_loadQueueMutex );
+	for ( std::deque< sPreparedMesh* >::iterator itMesh = this->m_queueMeshesToUpload.begin(); 
+		  itMesh != this->m_queueMeshesToUpload.end(); itMesh++ )
+	{
+		delete *itMesh;
+	}
+	this->m_queueMeshesToUpload.clear();
+	this->m_setMeshesLoading.clear();
+	return;
+}
+
+//static 
+const std::string cMeshManager::MESHCOOKSETTINGS = 
+	"gdp v4: normals calculated (angle weighted) if missing, then normalized; spherical texture coords (+X, +Y, from normals) if missing; "
+	"welded (epsilon 0.00001), degenerate triangles and unused vertices removed; "
+	"triangles reordered for a 16 entry vertex cache, then overdraw (1.05), vertices in the order they're used; "
+	"bounding sphere (Ritter's); up to 5 LODs (QEM, 0.5 of the triangles each, at least 64, 10% or more taken out), vertex cache reordered; "
+	"compact vertices (UNORM16 position in the box, octahedral SNORM16 normal, UNORM8 or half colour, half or float UVs under 2.0)";
+
+//static 
+const float cMeshManager::WELDEPSILON = 0.00001f;
+
+//static 
+const float cMeshManager::DEFAULTUPLOADBUDGETSECONDS = 0.004f;
+
+//static 
+const float cMeshManager::LODTRIANGLERATIO = 0.5f;
+//static 
+const float cMeshManager::LODPIXELERROR = 1.0f;
+//static 
+const float cMeshManager::LODHYSTERESIS = 0.25f;
+
+void cMeshManager::SetCookedCacheFolder( std::string cacheFolder )
+{
+	this->m_cookedCache.SetCacheFolder( cacheFolder );
+	return;
+}
+
+//static 
+bool cMeshManager::CookPlyFile( std::string plyFileToLoad, CAssetCache &cache, bool &bWasAlreadyUpToDate, std::wstring &error, 
+                                PlyWeldInfo* pWeldInfo /*=0*/ )
+{
+	bWasAlreadyUpToDate = false;
+
+	unsigned long long cookKey = 0;
+	if ( !CAssetCache::CalculateCookKey( plyFileToLoad, cMeshManager::MESHCOOKSETTINGS, cookKey ) )
+	{
+		error = L"Can't read " + CStringHelper::getInstance( )->ASCIIToUnicodeQnD( plyFileToLoad );
+		return false;
+	}
+	std::string cookedFile = cache.GetCookedFileName( plyFileToLoad, ".gdp" );
+
+	// Already done?
+	CGDP2File existingFile;
+	std::wstring openError;
+	if ( existingFile.Open( CStringHelper::getInstance( )->ASCIIToUnicodeQnD( cookedFile ), openError ) && 
+		 ( existingFile.GetCookKey() == cookKey ) )
+	{
+		bWasAlreadyUpToDate = true;
+		return true;
+	}
+	existingFile.Close();
+
+	if ( !cache.CreateCacheFolder() )
+	{
+		error = L"Can't make the cache folder " + CStringHelper::getInstance( )->ASCIIToUnicodeQnD( cache.GetCacheFolder() );
+		return false;
+	}
+	return cMeshManager::CookPlyToGDP2( plyFileToLoad, cookedFile, cookKey, error, pWeldInfo );
+}
+
+//static 
+bool cMeshManager::CookPlyToGDP2( std::string plyFileToLoad, std::string gdpFileToSave, unsigned long long cookKey, std::wstring &error, 
+                                  PlyWeldInfo* pWeldInfo /*=0*/ )
+{
+	sPreparedMesh preparedMesh;
+	CPlyFile5nt &plyFile = preparedMesh.plyFile;
+	plyFile.SetParallelASCIIParsing(true);
+	if (!plyFile.OpenPLYFile2( CStringHelper::getInstance( )->ASCIIToUnicodeQnD( plyFileToLoad ), error ))
+	{
+		return false;
+	}
+
+	// (same as m_PrepareMeshFromPly(), so an empty model isn't cooked into one that "loads")
+	if ( plyFile.GetNumberOfVerticies() == 0 )
+	{
+		error = L"ERROR: The model doesn't have any vertices.";
+		return false;
+	}
+
+	PlyWeldInfo weldInfo;
+	cMeshManager::m_PrepareForRendering( plyFile, weldInfo );
+	if ( pWeldInfo != 0 )
+	{
+		*pWeldInfo = weldInfo;
+	}
+	if ( plyFile.GetNumberOfElements() == 0 )
+	{
+		error = L"ERROR: All of the model's triangles were degenerate.";
+		return false;
+	}
+
+	// Added: The LODs and the bounding sphere are cooked, too (the same way LoadPlyIntoVBO() makes them)
+	cMeshManager::m_PrepareMeshFromPlyFile( preparedMesh, cVBOInfo::VERTEX_FORMAT_FLOAT );
+	return cMeshManager::m_SaveCookedFile( preparedMesh, CStringHelper::getInstance( )->ASCIIToUnicodeQnD( gdpFileToSave ), cookKey, error );
+}
+
+//static 
+bool cMeshManager::m_SaveCookedFile( sPreparedMesh &preparedMesh, std::wstring fileName, unsigned long long cookKey, std::wstring &error )
+{
+	const cVBOInfo &VBOInfo = preparedMesh.VBOInfo;
+	CGDP2File::sLODChain LODChain;
+	memset( &LODChain, 0, sizeof(CGDP2File::sLODChain) );
+	LODChain.numberOfLODs = VBOInfo.numberOfLODs;
+	for ( unsigned int LOD = 0; LOD != VBOInfo.numberOfLODs; LOD++ )
+	{
+		LODChain.LODs[LOD].firstIndex = VBOInfo.LODs[LOD].firstIndex;
+		LODChain.LODs[LOD].numberOfTriangles = VBOInfo.LODs[LOD].numberOfTriangles;
+		LODChain.LODs[LOD].relativeError = VBOInfo.LODs[LOD].relativeError;
+	}
+	for ( unsigned int axis = 0; axis != 3; axis++ )
+	{
+		LODChain.boundingCentre[axis] = VBOInfo.boundingCentre[axis];
+	}
+	LODChain.boundingRadius = VBOInfo.boundingRadius;
+
+	// Added: The compact vertices are saved, too (whichever format this load was for)
+	CGDP2File::sCompactFormat compactFormat;
+	cMeshManager::m_PickCompactVertexFormat( preparedMesh.plyFile.GetVertexStreams(), compactFormat );
+	CPlyVertexLayout compactLayout;
+	cVBOInfo compactVBOInfo;
+	cMeshManager::m_MakeCompactVertexLayout( compactFormat, compactLayout, compactVBOInfo );
+
+	return CGDP2File::Save( preparedMesh.plyFile, preparedMesh.vecIndices, LODChain, compactLayout, compactFormat, fileName, cookKey, error );
+}
+
+//static 
+void cMeshManager::m_PrepareForRendering( CPlyFile5nt &plyFile, PlyWeldInfo &weldInfo )
+{
+	if ( ! plyFile.bHasNormalsInFile() )
+	{	// Added: Weighted by the angle at each corner (the scans have lots of long, thin triangles)
+		plyFile.GenerateNormals( CNormalGenerator::WEIGHT_BY_ANGLE );
 	}
 	// 
 	plyFile.normlizeExistingNomrals();
@@ -115,151 +521,965 @@ bool cMeshManager::LoadPlyIntoVBO( std::string fileToLoad )
 										   false );	// do it "fast" (kind of pointless, really)
 	}
 
+	// Added: Lots of the plys have the same vertex more than once (and ones nothing uses)
+	// (This is last, so the normals and texture coords are already worked out)
+	if ( cMeshManager::WELDEPSILON >= 0.0f )
+	{
+		plyFile.WeldVertices( cMeshManager::WELDEPSILON, weldInfo );
+	}
+
+	// Added: The order in the file is often pretty bad for the GPU's vertex cache (the scans especially)
+	plyFile.OptimizeTriangleOrder( CMeshOptimizer::DEFAULTCACHESIZE, CMeshOptimizer::DEFAULTOVERDRAWTHRESHOLD );
+	return;
+}
+
+//static 
+void cMeshManager::m_PrepareMeshFromGDP2File( sPreparedMesh &preparedMesh, cVBOInfo::enumVertexFormat vertexFormat )
+{
+	CGDP2File &gdpFile = preparedMesh.gdpFile;
+	const void* pVertices = gdpFile.GetVertices();
+	const unsigned int numberOfVertices = gdpFile.GetNumberOfVertices();
+	preparedMesh.numberOfVertices = numberOfVertices;
+	preparedMesh.numberOfIndices = gdpFile.GetNumberOfIndices();
+
+	// Updated: The LODs were made when it was cooked, and they're already after the full model. 
+	//	The index size is the one m_AddToMeshArena() picks, too (see CGDP2File::Open()).
+	preparedMesh.pIndices = gdpFile.GetIndices();
+	preparedMesh.numberOfIndicesWithLODs = gdpFile.GetNumberOfIndicesWithLODs();
+	const CGDP2File::sLODChain &LODChain = *(gdpFile.GetLODChain());
+	cVBOInfo &VBOInfo = preparedMesh.VBOInfo;
+	VBOInfo.numberOfLODs = LODChain.numberOfLODs;
+	for ( unsigned int LOD = 0; LOD != LODChain.numberOfLODs; LOD++ )
+	{
+		VBOInfo.LODs[LOD].firstIndex = LODChain.LODs[LOD].firstIndex;
+		VBOInfo.LODs[LOD].numberOfTriangles = LODChain.LODs[LOD].numberOfTriangles;
+		VBOInfo.LODs[LOD].relativeError = LODChain.LODs[LOD].relativeError;
+	}
+	for ( unsigned int axis = 0; axis != 3; axis++ )
+	{
+		VBOInfo.boundingCentre[axis] = LODChain.boundingCentre[axis];
+	}
+	VBOInfo.boundingRadius = LODChain.boundingRadius;
+
+	if ( vertexFormat == cVBOInfo::VERTEX_FORMAT_COMPACT )
+	{	// Updated: The compact vertices were written when it was cooked, too
+		cMeshManager::m_MakeCompactVertexLayout( *(gdpFile.GetCompactFormat()), preparedMesh.layout, preparedMesh.VBOInfo );
+		if ( preparedMesh.layout.GetVertexSizeInBytes() == gdpFile.GetCompactVertexSizeInBytes() )
+		{
+			preparedMesh.pVertices = gdpFile.GetCompactVertices();
+			return;
+		}
+		// (they aren't the way this layout wants them, so back into streams and written out again)
+		preparedMesh.vertexStreams.ImportInterleaved( CGDP2File::GetVertexLayout(), pVertices, numberOfVertices );
+		CGDP2File::sCompactFormat compactFormat;
+		cMeshManager::m_PickCompactVertexFormat( preparedMesh.vertexStreams, compactFormat );
+		cMeshManager::m_MakeCompactVertexLayout( compactFormat, preparedMesh.layout, preparedMesh.VBOInfo );
+		preparedMesh.pVertexStreams = &(preparedMesh.vertexStreams);
+		return;
+	}
+
+	preparedMesh.layout = CGDP2File::GetVertexLayout();
+	preparedMesh.pVertices = pVertices;
+	return;
+}
+
+//static 
+void cMeshManager::m_PrepareMeshFromPlyFile( sPreparedMesh &preparedMesh, cVBOInfo::enumVertexFormat vertexFormat )
+{
+	CPlyFile5nt &plyFile = preparedMesh.plyFile;
+	const unsigned int numberOfVertices = static_cast<unsigned int>( plyFile.GetNumberOfVerticies() );
+	const unsigned int numberOfIndices = static_cast<unsigned int>( plyFile.GetNumberOfElements() ) * 3;
+	preparedMesh.numberOfVertices = numberOfVertices;
+	preparedMesh.numberOfIndices = numberOfIndices;
+
+	// The indices go right into the array the LODs get added to
+	std::vector<unsigned int> &vecIndices = preparedMesh.vecIndices;
+	vecIndices.resize( numberOfIndices );
+	if ( numberOfIndices != 0 )
+	{
+		plyFile.ExportIndices( &(vecIndices[0]), sizeof(unsigned int) );
+	}
+	cMeshManager::m_BuildLODChain( plyFile.GetVertexStreams().GetStream( CPlyVertexStreams::STREAM_POSITION ), 3 * sizeof(float), 
+	                               numberOfVertices, vecIndices, preparedMesh.VBOInfo );
+	preparedMesh.numberOfIndicesWithLODs = static_cast<unsigned int>( vecIndices.size() );
+
+	if ( vertexFormat == cVBOInfo::VERTEX_FORMAT_COMPACT )
+	{
+		CGDP2File::sCompactFormat compactFormat;
+		cMeshManager::m_PickCompactVertexFormat( plyFile.GetVertexStreams(), compactFormat );
+		cMeshManager::m_MakeCompactVertexLayout( compactFormat, preparedMesh.layout, preparedMesh.VBOInfo );
+	}
+	else
+	{
+		preparedMesh.layout = CGDP2File::GetVertexLayout();
+	}
+	preparedMesh.pVertexStreams = &(plyFile.GetVertexStreams());
+	return;
+}
+
+//static 
+void cMeshManager::m_ExportVerticesIntoBoundBuffer( const CPlyVertexStreams &vertexStreams, const CPlyVertexLayout &layout, 
+                                                    unsigned int offsetInBytes, unsigned int sizeInBytes )
+{
+	// (invalidate: nothing that's there now is needed, so the driver doesn't have to wait for it or copy it)
+	// Updated: Only this mesh's part of the arena
+	void* pMappedVertices = glMapBufferRange( GL_ARRAY_BUFFER, offsetInBytes, sizeInBytes, 
+	                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT );
+	if ( pMappedVertices != 0 )
+	{
+		vertexStreams.ExportInterleaved( layout, pMappedVertices );
+		if ( glUnmapBuffer( GL_ARRAY_BUFFER ) == GL_TRUE )
+		{
+			return;
+		}
+		// The contents are "undefined" if unmapping didn't work (like if the screen mode changed), 
+		//	so do it again, the regular way
+	}
+	std::vector<char> vecVertices( sizeInBytes );
+	vertexStreams.ExportInterleaved( layout, &(vecVertices[0]) );
+	glBufferSubData( GL_ARRAY_BUFFER, offsetInBytes, sizeInBytes, &(vecVertices[0]) );
+	return;
+}
+
+//static 
+void cMeshManager::m_PickCompactVertexFormat( const CPlyVertexStreams &vertexStreams, CGDP2File::sCompactFormat &format )
+{
+	const unsigned int numberOfVertices = vertexStreams.size();
+
+	// Position: 0 to 65535 across the bounding box, on each axis (the shader scales it back). 
+	//	That's better than a half float, which only has 11 bits once you're away from the origin.
+	float minXYZ[3] = { 0.0f, 0.0f, 0.0f };
+	float maxXYZ[3] = { 0.0f, 0.0f, 0.0f };
+	CPositionKernels::CalculateMinMax( vertexStreams.GetStream( CPlyVertexStreams::STREAM_POSITION ), 3 * sizeof(float), 
+	                                   numberOfVertices, minXYZ, maxXYZ );
+	for ( unsigned int axis = 0; axis != 3; axis++ )
+	{
+		format.positionDecodeOffset[axis] = minXYZ[axis];
+		format.positionDecodeScale[axis] = maxXYZ[axis] - minXYZ[axis];
+	}
+
+	// Colour: only if there is one. Bytes, unless it's outside of 0.0 to 1.0 (which some files do)
+	format.bHasColours = vertexStreams.bIsStreamAllZeros( CPlyVertexStreams::STREAM_COLOUR ) ? 0 : 1;
+	bool bFitsInBytes = true;
+	if ( format.bHasColours )
+	{
+		const float* pColours = vertexStreams.GetStream( CPlyVertexStreams::STREAM_COLOUR );
+		const unsigned int numberOfFloats = numberOfVertices * CPlyVertexStreams::GetFloatsPerVertex( CPlyVertexStreams::STREAM_COLOUR );
+		for ( unsigned int index = 0; ( index != numberOfFloats ) && bFitsInBytes; index++ )
+		{
+			bFitsInBytes = ( pColours[index] >= 0.0f ) && ( pColours[index] <= 1.0f );
+		}
+	}
+	format.colourType = static_cast<unsigned char>( bFitsInBytes ? CPlyVertexLayout::TYPE_UNORM8 : CPlyVertexLayout::TYPE_FLOAT16 );
+
+	// Texture coords: half floats, unless they wrap around so many times that it'd be noticeable
+	//	(a half float has 11 bits, so that's about 1/1000th of the texture out to 2.0)
+	format.bHasTex1 = vertexStreams.bIsStreamAllZeros( CPlyVertexStreams::STREAM_TEX1 ) ? 0 : 1;
+	bool bUVsFitInHalfs = true;
+	for ( unsigned int stream = CPlyVertexStreams::STREAM_TEX0; stream <= CPlyVertexStreams::STREAM_TEX1; stream++ )
+	{
+		const float* pUVs = vertexStreams.GetStream( static_cast<CPlyVertexStreams::enumStream>( stream ) );
+		const unsigned int numberOfFloats = ( pUVs == 0 ) ? 0 : numberOfVertices * 2;
+		for ( unsigned int index = 0; ( index != numberOfFloats ) && bUVsFitInHalfs; index++ )
+		{
+			bUVsFitInHalfs = ( fabs( pUVs[index] ) <= 2.0f );
+		}
+	}
+	format.UVType = static_cast<unsigned char>( bUVsFitInHalfs ? CPlyVertexLayout::TYPE_FLOAT16 : CPlyVertexLayout::TYPE_FLOAT32 );
+	return;
+}
+
+//static 
+void cMeshManager::m_MakeCompactVertexLayout( const CGDP2File::sCompactFormat &format, CPlyVertexLayout &layout, cVBOInfo &VBOInfo )
+{
+	layout = CPlyVertexLayout();
+	unsigned int offsetInBytes = 0;
+
+	float valueOffset[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float valueScale[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	for ( unsigned int axis = 0; axis != 3; axis++ )
+	{
+		const float extent = format.positionDecodeScale[axis];
+		valueOffset[axis] = format.positionDecodeOffset[axis];
+		valueScale[axis] = ( extent > 0.0f ) ? ( 1.0f / extent ) : 0.0f;		// (flat on this axis, so it's all 0)
+		VBOInfo.positionDecodeOffset[axis] = format.positionDecodeOffset[axis];
+		VBOInfo.positionDecodeScale[axis] = extent;
+	}
+	// (4 components, so it's a multiple of 4 bytes, and w is 1.0)
+	layout.AddAttribute( CPlyVertexStreams::STREAM_POSITION, offsetInBytes, 4, 
+	                     CPlyVertexLayout::TYPE_UNORM16, CPlyVertexLayout::ENCODING_NONE, 0.0f, 0.0f, 0.0f, 1.0f );
+	layout.SetLastAttributeOffsetAndScale( valueOffset, valueScale );
+	offsetInBytes += 4 * CPlyVertexLayout::GetComponentSizeInBytes( CPlyVertexLayout::TYPE_UNORM16 );
+
+	// Normal: octahedral, in 2 shorts (a lot closer than 3 bytes would be)
+	layout.AddAttribute( CPlyVertexStreams::STREAM_NORMAL, offsetInBytes, 2, 
+	                     CPlyVertexLayout::TYPE_SNORM16, CPlyVertexLayout::ENCODING_OCTAHEDRAL );
+	offsetInBytes += 2 * CPlyVertexLayout::GetComponentSizeInBytes( CPlyVertexLayout::TYPE_SNORM16 );
+	VBOInfo.bNormalsAreOctahedral = true;
 
-	// Do some magic
-	Vertex_xyz_n_RGB_UVx2* pVerts = new Vertex_xyz_n_RGB_UVx2[ plyFile.GetNumberOfVerticies() ];
-	// Copy the vertices from the nice vector to the 
-	// raw, evil, array
-	PlyVertex tempPlyVert;
-	for (int index = 0; index != plyFile.GetNumberOfVerticies(); index++)
+	VBOInfo.bHasVertexColours = ( format.bHasColours != 0 );
+	if ( VBOInfo.bHasVertexColours )
 	{
-		tempPlyVert = plyFile.getVertex_at(index);
+		const CPlyVertexLayout::enumComponentType colourType = static_cast<CPlyVertexLayout::enumComponentType>( format.colourType );
+		layout.AddAttribute( CPlyVertexStreams::STREAM_COLOUR, offsetInBytes, 4, colourType, CPlyVertexLayout::ENCODING_NONE );
+		offsetInBytes += 4 * CPlyVertexLayout::GetComponentSizeInBytes( colourType );
+	}
+
+	// (both sets right after each other, so they're one vec4 in the shader, like the float format)
+	const CPlyVertexLayout::enumComponentType UVType = static_cast<CPlyVertexLayout::enumComponentType>( format.UVType );
+	layout.AddAttribute( CPlyVertexStreams::STREAM_TEX0, offsetInBytes, 2, UVType, CPlyVertexLayout::ENCODING_NONE );
+	offsetInBytes += 2 * CPlyVertexLayout::GetComponentSizeInBytes( UVType );
+	if ( format.bHasTex1 )
+	{
+		layout.AddAttribute( CPlyVertexStreams::STREAM_TEX1, offsetInBytes, 2, UVType, CPlyVertexLayout::ENCODING_NONE );
+		offsetInBytes += 2 * CPlyVertexLayout::GetComponentSizeInBytes( UVType );
+	}
 
-		pVerts[index].Position[0] = tempPlyVert.xyz.x;
-		pVerts[index].Position[1] = tempPlyVert.xyz.y;
-		pVerts[index].Position[2] = tempPlyVert.xyz.z;
-		pVerts[index].Position[3] = 1.0f;		// w coordinate
+	VBOInfo.vertexFormat = cVBOInfo::VERTEX_FORMAT_COMPACT;
+	VBOInfo.vertexSizeInBytes = layout.GetVertexSizeInBytes();
+	return;
+}
+
+//static 
+void cMeshManager::m_SetVertexAttributePointers( const CPlyVertexLayout &layout )
+{
+	// Which shader input each stream goes to (in_Position, in_Normal, in_RGBA, in_UVx2)
+	static const GLuint streamToLocation[CPlyVertexStreams::NUMBEROFSTREAMS] = { 0, 1, 3, 3, 2, 4, 5 };
+	const GLsizei bytesInOneVertex = static_cast<GLsizei>( layout.GetVertexSizeInBytes() );
+
+	const unsigned int numberOfAttributes = layout.GetNumberOfAttributes();
+	for ( unsigned int index = 0; index != numberOfAttributes; index++ )
+	{
+		const CPlyVertexLayout::sAttribute &attribute = layout.GetAttribute( index );
+		const GLuint location = streamToLocation[attribute.stream];
+		GLint numberOfComponents = static_cast<GLint>( attribute.numberOfComponents );
+		// The 2nd set of texture coords is the zw of the same input as the 1st
+		while ( ( index + 1 != numberOfAttributes ) && 
+		        ( streamToLocation[ layout.GetAttribute( index + 1 ).stream ] == location ) )
+		{
+			index++;
+			numberOfComponents += static_cast<GLint>( layout.GetAttribute( index ).numberOfComponents );
+		}
+
+		GLenum type = GL_FLOAT;
+		GLboolean bNormalised = GL_FALSE;
+		switch ( attribute.type )
+		{
+		case CPlyVertexLayout::TYPE_FLOAT32:	type = GL_FLOAT;			bNormalised = GL_FALSE;	break;
+		case CPlyVertexLayout::TYPE_FLOAT16:	type = GL_HALF_FLOAT;		bNormalised = GL_FALSE;	break;
+		case CPlyVertexLayout::TYPE_UNORM16:	type = GL_UNSIGNED_SHORT;	bNormalised = GL_TRUE;	break;
+		case CPlyVertexLayout::TYPE_SNORM16:	type = GL_SHORT;			bNormalised = GL_TRUE;	break;
+		case CPlyVertexLayout::TYPE_UNORM8:		type = GL_UNSIGNED_BYTE;	bNormalised = GL_TRUE;	break;
+		}
+
+		glEnableVertexAttribArray( location );
+		glVertexAttribPointer( location, numberOfComponents, type, bNormalised, 
+		                       bytesInOneVertex, (GLvoid*)static_cast<size_t>( attribute.offsetInBytes ) );
+	}
+	return;
+}
+
+unsigned int cMeshManager::m_AddToMeshArena( sPreparedMesh &preparedMesh )
+{
+	const std::string &meshName = preparedMesh.meshName;
+	const CPlyVertexLayout &layout = preparedMesh.layout;
+	const void* pVertices = preparedMesh.pVertices;
+	const CPlyVertexStreams* pVertexStreams = preparedMesh.pVertexStreams;
+	const unsigned int numberOfVertices = preparedMesh.numberOfVertices;
+	const std::vector<unsigned int> &vecIndices = preparedMesh.vecIndices;
+	const unsigned int numberOfIndices = preparedMesh.numberOfIndices;
+	const unsigned int numberOfIndicesWithLODs = preparedMesh.numberOfIndicesWithLODs;
+	cVBOInfo &tempVBOInfo = preparedMesh.VBOInfo;
 
-		pVerts[index].Normal[0] = tempPlyVert.nx;
-		pVerts[index].Normal[1] = tempPlyVert.ny;
-		pVerts[index].Normal[2] = tempPlyVert.nz;
-		pVerts[index].Normal[3] = 1.0f;			// (1.0 unless...)
+	// (loading it again replaces it)
+	this->UnloadMesh( meshName );
 
-		pVerts[index].RGBA[0] = tempPlyVert.red;
-		pVerts[index].RGBA[1] = tempPlyVert.green;
-		pVerts[index].RGBA[2] = tempPlyVert.blue;
-		pVerts[index].RGBA[3] = tempPlyVert.alpha;			// (1.0 unless...)
+	// The indices start at 0 for each mesh (see glDrawElementsBaseVertex()), so any mesh with 
+	//	few enough vertices can use 16 bit ones. The LODs only use vertices the full model does.
+	// Updated: Same rule as the GDP files, so theirs can be used as they are
+	const GLenum indexType = ( numberOfVertices <= CGDP2File::MAXVERTICESFOR16BITINDICES ) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	const unsigned int indexSizeInBytes = ( indexType == GL_UNSIGNED_SHORT ) ? sizeof(GLushort) : sizeof(GLuint);
+	std::vector<GLushort> vecIndices16;
+	const void* pAllIndices = preparedMesh.pIndices;
+	if ( ( pAllIndices == 0 ) && !vecIndices.empty() )
+	{
+		pAllIndices = &(vecIndices[0]);
+		if ( indexType == GL_UNSIGNED_SHORT )
+		{
+			vecIndices16.assign( vecIndices.begin(), vecIndices.end() );
+			pAllIndices = &(vecIndices16[0]);
+		}
+	}
+
+	const unsigned int arenaIndex = this->m_FindOrAddArena( layout, indexType );
+
+	// Is there room? If not, make the arena bigger (it's copied on the GPU)
+	unsigned int firstVertex = 0;
+	unsigned int firstIndex = 0;
+	if ( !this->m_vecArenas[arenaIndex].vertexAllocator.Allocate( numberOfVertices, firstVertex ) )
+	{
+		const unsigned int vertexCapacity = this->m_vecArenas[arenaIndex].vertexAllocator.GetCapacity();
+		this->m_MoveArenaIntoNewBuffers( arenaIndex, std::max( vertexCapacity * 2, vertexCapacity + numberOfVertices ), 
+		                                 this->m_vecArenas[arenaIndex].indexAllocator.GetCapacity(), false );
+		if ( !this->m_vecArenas[arenaIndex].vertexAllocator.Allocate( numberOfVertices, firstVertex ) )
+		{	// (still no room, so it would be written over whatever's at the start of the arena)
+			return cMeshManager::INVALIDMESHHANDLE;
+		}
+	}
+	if ( !this->m_vecArenas[arenaIndex].indexAllocator.Allocate( numberOfIndicesWithLODs, firstIndex ) )
+	{
+		const unsigned int indexCapacity = this->m_vecArenas[arenaIndex].indexAllocator.GetCapacity();
+		this->m_MoveArenaIntoNewBuffers( arenaIndex, this->m_vecArenas[arenaIndex].vertexAllocator.GetCapacity(), 
+		                                 std::max( indexCapacity * 2, indexCapacity + numberOfIndicesWithLODs ), false );
+		if ( !this->m_vecArenas[arenaIndex].indexAllocator.Allocate( numberOfIndicesWithLODs, firstIndex ) )
+		{
+			this->m_vecArenas[arenaIndex].vertexAllocator.Free( firstVertex, numberOfVertices );
+			return cMeshManager::INVALIDMESHHANDLE;
+		}
+	}
+	sMeshArena &arena = this->m_vecArenas[arenaIndex];
+
+	// Updated: The vertex size (and where everything is in it) comes from the layout
+	const unsigned int vertexSizeInBytes = layout.GetVertexSizeInBytes();
+	const unsigned int sizeOfVertexArray = vertexSizeInBytes * numberOfVertices;
+
+	this->m_bytesUploadedThisFrame += sizeOfVertexArray + numberOfIndicesWithLODs * indexSizeInBytes;
+	if ( this->m_pUploadRing != 0 )
+	{	// Added: Through the upload ring (copied on the GPU, so no buffer bindings or VAO to worry about)
+		if ( pVertices != 0 )
+		{
+			this->m_pUploadRing->UploadToBuffer( arena.vert_buf_ID, firstVertex * vertexSizeInBytes, sizeOfVertexArray, pVertices );
+		}
+		else if ( pVertexStreams != 0 )
+		{
+			this->m_pUploadRing->UploadToBuffer( arena.vert_buf_ID, firstVertex * vertexSizeInBytes, sizeOfVertexArray,
+				[pVertexStreams, &layout]( void* pDestination )
+				{
+					pVertexStreams->ExportInterleaved( layout, pDestination );
+				} );
+		}
+		this->m_pUploadRing->UploadToBuffer( arena.index_buf_ID, firstIndex * indexSizeInBytes, 
+		                                     numberOfIndicesWithLODs * indexSizeInBytes, pAllIndices );
+		ExitOnGLError("ERROR: Could not copy the mesh into the arena");
+	}
+	else
+	{
+		glBindBuffer( GL_ARRAY_BUFFER, arena.vert_buf_ID );
+		if ( pVertices != 0 )
+		{
+			glBufferSubData( GL_ARRAY_BUFFER, firstVertex * vertexSizeInBytes, sizeOfVertexArray, pVertices );
+		}
+		else if ( ( pVertexStreams != 0 ) && ( sizeOfVertexArray != 0 ) )
+		{	// Added: Straight from the ply
+			cMeshManager::m_ExportVerticesIntoBoundBuffer( *pVertexStreams, layout, firstVertex * vertexSizeInBytes, sizeOfVertexArray );
+		}
+		ExitOnGLError("ERROR: Could not copy the vertices into the arena");
+
+		// (the index buffer is part of the VAO's state)
+		glBindVertexArray( arena.VAO_ID );
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, arena.index_buf_ID );
+		if ( numberOfIndicesWithLODs != 0 )
+		{
+			glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, firstIndex * indexSizeInBytes, numberOfIndicesWithLODs * indexSizeInBytes, pAllIndices );
+		}
+		glBindVertexArray( 0 );
+		ExitOnGLError("ERROR: Could not copy the indices into the arena");
+	}
+
+	tempVBOInfo.VBO_ID = arena.VAO_ID;
+	tempVBOInfo.vert_buf_ID = arena.vert_buf_ID;
+	tempVBOInfo.index_buf_ID = arena.index_buf_ID;
+	tempVBOInfo.arenaIndex = arenaIndex;
+	tempVBOInfo.firstVertex = firstVertex;
+	tempVBOInfo.numberOfVertices = numberOfVertices;
+	tempVBOInfo.firstIndex = firstIndex;
+	tempVBOInfo.numberOfIndices = numberOfIndicesWithLODs;
+
+	tempVBOInfo.meshFileName = meshName;
+	tempVBOInfo.numberOfTriangles = numberOfIndices / 3;
+	tempVBOInfo.indexType = indexType;
+	tempVBOInfo.vertexSizeInBytes = vertexSizeInBytes;
+
+	// Added: For the budget (it counts as used this frame, so it isn't evicted right away)
+	tempVBOInfo.sizeInBytesOnGPU = sizeOfVertexArray + numberOfIndicesWithLODs * indexSizeInBytes;
+	tempVBOInfo.lastFrameUsed = this->m_currentFrame;
+	this->m_meshBytesInUse += tempVBOInfo.sizeInBytesOnGPU;
+	this->m_mapEvictedMeshes.erase( meshName );
+	this->m_mapLazyMeshes.erase( meshName );
+
+	return this->m_AddMesh( tempVBOInfo );
+}
+
+unsigned int cMeshManager::m_AddMesh( const cVBOInfo &VBOInfo )
+{
+	unsigned int slot = 0;
+	if ( !this->m_vecFreeMeshSlots.empty() )
+	{
+		slot = this->m_vecFreeMeshSlots.back();
+		this->m_vecFreeMeshSlots.pop_back();
+	}
+	else
+	{
+		slot = static_cast<unsigned int>( this->m_vecMeshes.size() );
+		this->m_vecMeshes.push_back( cVBOInfo() );
+		this->m_vecMeshSlotGenerations.push_back( 0 );
+	}
+	// (this wraps around after 256 uses of the same spot, which is "good enough")
+	this->m_vecMeshSlotGenerations[slot]++;
 
-		pVerts[index].UVx2[0] = tempPlyVert.tex0u;			// s
-		pVerts[index].UVx2[1] = tempPlyVert.tex0v;			// t
-		pVerts[index].UVx2[2] = tempPlyVert.tex1u;
-		pVerts[index].UVx2[3] = tempPlyVert.tex1v;			// (1.0 unless...)
+	const unsigned int meshHandle = ( static_cast<unsigned int>( this->m_vecMeshSlotGenerations[slot] ) << cMeshManager::MESHHANDLESLOTBITS ) 
+	                                | ( slot + 1 );
+	this->m_vecMeshes[slot] = VBOInfo;
+	this->m_vecMeshes[slot].meshHandle = meshHandle;
+	this->p_mapFileToBVO[VBOInfo.meshFileName] = meshHandle;
+	return meshHandle;
+}
 
+const cVBOInfo* cMeshManager::GetVBOInfo( unsigned int meshHandle ) const
+{
+	const unsigned int slot = ( meshHandle & ( ( 1u << cMeshManager::MESHHANDLESLOTBITS ) - 1 ) ) - 1;
+	// (a handle of 0 is slot 0xFFFFFF, so it's caught here, too)
+	if ( slot >= static_cast<unsigned int>( this->m_vecMeshes.size() ) )
+	{
+		return 0;
 	}
+	const cVBOInfo* pVBOInfo = &(this->m_vecMeshes[slot]);
+	if ( pVBOInfo->meshHandle != meshHandle )
+	{	// Unloaded (or something else is there now)
+		return 0;
+	}
+	return pVBOInfo;
+}
 
-	unsigned int numIndices = plyFile.GetNumberOfElements() * 3;
-	GLuint* pIndices = new GLuint[numIndices];
+unsigned int cMeshManager::LookUpMeshHandle( std::string meshName ) const
+{
+	std::map< std::string /*fileName*/, unsigned int >::const_iterator itMesh = this->p_mapFileToBVO.find( meshName );
+	if ( itMesh == this->p_mapFileToBVO.end() )
+	{
+		return cMeshManager::INVALIDMESHHANDLE;
+	}
+	return itMesh->second;
+}
 
-	int triIndex = 0;
-	PlyElement tempPlyElement;
-	for (; triIndex != plyFile.GetNumberOfElements();
-		triIndex++)
+unsigned int cMeshManager::m_FindOrAddArena( const CPlyVertexLayout &layout, GLenum indexType )
+{
+	for ( unsigned int index = 0; index != static_cast<unsigned int>( this->m_vecArenas.size() ); index++ )
 	{
-		tempPlyElement = plyFile.getElement_at(triIndex);
-		pIndices[triIndex * 3 + 0] = tempPlyElement.vertex_index_1;
-		pIndices[triIndex * 3 + 1] = tempPlyElement.vertex_index_2;
-		pIndices[triIndex * 3 + 2] = tempPlyElement.vertex_index_3;
+		if ( ( this->m_vecArenas[index].indexType == indexType ) && this->m_vecArenas[index].layout.bHasSameFormat( layout ) )
+		{
+			return index;
+		}
 	}
 
-	cVBOInfo tempVBOInfo;
+	this->m_vecArenas.push_back( sMeshArena() );
+	const unsigned int arenaIndex = static_cast<unsigned int>( this->m_vecArenas.size() ) - 1;
+	sMeshArena &arena = this->m_vecArenas[arenaIndex];
+	arena.layout = layout;
+	arena.indexType = indexType;
 
-	//glGenVertexArrays(1, &BufferIds[0]);
-	glGenVertexArrays(1, &(tempVBOInfo.VBO_ID) );
+	glGenVertexArrays( 1, &(arena.VAO_ID) );
 	ExitOnGLError("ERROR: Could not generate the VAO");	// AKA VBO
-	//glBindVertexArray(BufferIds[0]);
-	glBindVertexArray(tempVBOInfo.VBO_ID);
-	ExitOnGLError("ERROR: Could not bind the VAO");
 
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-	glEnableVertexAttribArray(3);
-	ExitOnGLError("ERROR: Could not enable vertex attributes");
+	// (the buffers get made here, and the VAO pointed at them)
+	this->m_MoveArenaIntoNewBuffers( arenaIndex, cMeshManager::ARENAMINVERTICES, cMeshManager::ARENAMININDICES, false );
 
-	// GLuint BufferIds[3];   0,1,2
-	//glGenBuffers(2, & BufferIds[1]);
-	glGenBuffers(1, &(tempVBOInfo.vert_buf_ID));
-	glGenBuffers(1, &(tempVBOInfo.index_buf_ID));
+	return arenaIndex;
+}
 
-	ExitOnGLError("ERROR: Could not generate the buffer objects");
+void cMeshManager::m_MoveArenaIntoNewBuffers( unsigned int arenaIndex, unsigned int vertexCapacity, unsigned int indexCapacity, bool bPack )
+{
+	sMeshArena &arena = this->m_vecArenas[arenaIndex];
+	const unsigned int vertexSizeInBytes = arena.layout.GetVertexSizeInBytes();
+	const unsigned int indexSizeInBytes = ( arena.indexType == GL_UNSIGNED_SHORT ) ? sizeof(GLushort) : sizeof(GLuint);
 
-	//glBindBuffer(GL_ARRAY_BUFFER, BufferIds[1]);
-	glBindBuffer(GL_ARRAY_BUFFER, tempVBOInfo.vert_buf_ID );
-	glBufferData(GL_ARRAY_BUFFER,
-		sizeof(Vertex_xyz_n_RGB_UVx2) * plyFile.GetNumberOfVerticies(),	// sizeof(VERTICES), 
-		pVerts,								// VERTICES,
-		GL_STATIC_DRAW);
-	ExitOnGLError("ERROR: Could not bind the VBO to the VAO");
+	GLuint new_vert_buf_ID = 0;
+	GLuint new_index_buf_ID = 0;
+	glGenBuffers( 1, &new_vert_buf_ID );
+	glGenBuffers( 1, &new_index_buf_ID );
+	ExitOnGLError("ERROR: Could not generate the buffer objects");
 
-//	Vertex tempVert;
-	unsigned int bytesInOneVertex = sizeof(Vertex_xyz_n_RGB_UVx2);
-	unsigned int byteOffsetToPosition = offsetof( Vertex_xyz_n_RGB_UVx2, Position );
-	unsigned int byteOffsetToNormal = offsetof( Vertex_xyz_n_RGB_UVx2, Normal );
-	unsigned int byteOffsetToRGBA = offsetof( Vertex_xyz_n_RGB_UVx2, RGBA );
-	unsigned int byteOffsetToUVCoords = offsetof( Vertex_xyz_n_RGB_UVx2, UVx2 );
+	// (the "copy" targets don't change any VAO)
+	glBindBuffer( GL_COPY_WRITE_BUFFER, new_vert_buf_ID );
+	glBufferData( GL_COPY_WRITE_BUFFER, vertexCapacity * vertexSizeInBytes, 0, GL_STATIC_DRAW );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, new_index_buf_ID );
+	glBufferData( GL_COPY_WRITE_BUFFER, indexCapacity * indexSizeInBytes, 0, GL_STATIC_DRAW );
 
+	if ( arena.vert_buf_ID != 0 )
+	{
+		// The meshes in this arena (in the order they are in the vertex buffer)
+		std::vector< std::pair< unsigned int /*firstVertex*/, cVBOInfo* > > vecMeshes;
+		for ( std::vector< cVBOInfo >::iterator itVBO = this->m_vecMeshes.begin(); 
+			  itVBO != this->m_vecMeshes.end(); itVBO++ )
+		{
+			if ( ( itVBO->meshHandle != cMeshManager::INVALIDMESHHANDLE ) && ( itVBO->arenaIndex == arenaIndex ) )
+			{
+				vecMeshes.push_back( std::pair< unsigned int, cVBOInfo* >( itVBO->firstVertex, &(*itVBO) ) );
+			}
+		}
+		std::sort( vecMeshes.begin(), vecMeshes.end() );
 
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE,
-		bytesInOneVertex,	
-		(GLvoid*)byteOffsetToPosition);	// At start of each vertex
+		const unsigned int numberOfMeshes = static_cast<unsigned int>( vecMeshes.size() );
+		std::vector<unsigned int> vecNewFirstVertex;
+		std::vector<unsigned int> vecNewFirstIndex;
+		if ( bPack )
+		{
+			std::vector<unsigned int> vecFirstVertex( numberOfMeshes ), vecNumberOfVertices( numberOfMeshes );
+			for ( unsigned int mesh = 0; mesh != numberOfMeshes; mesh++ )
+			{
+				vecFirstVertex[mesh] = vecMeshes[mesh].second->firstVertex;
+				vecNumberOfVertices[mesh] = vecMeshes[mesh].second->numberOfVertices;
+			}
+			arena.vertexAllocator.Pack( vecFirstVertex, vecNumberOfVertices, vecNewFirstVertex );
 
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE,
-		bytesInOneVertex,	// sizeof(VERTICES[0]), 
-		(GLvoid*)byteOffsetToNormal);		//sizeof(Vertex_xyz_n_RGB_UVx2::Position));	// (GLvoid*)sizeof(VERTICES[0].Position));
+			// (the indices can be in a different order than the vertices)
+			std::vector< std::pair< unsigned int /*firstIndex*/, unsigned int /*mesh*/ > > vecIndexOrder( numberOfMeshes );
+			for ( unsigned int mesh = 0; mesh != numberOfMeshes; mesh++ )
+			{
+				vecIndexOrder[mesh] = std::pair< unsigned int, unsigned int >( vecMeshes[mesh].second->firstIndex, mesh );
+			}
+			std::sort( vecIndexOrder.begin(), vecIndexOrder.end() );
+			std::vector<unsigned int> vecFirstIndex( numberOfMeshes ), vecNumberOfIndices( numberOfMeshes ), vecPackedFirstIndex;
+			for ( unsigned int order = 0; order != numberOfMeshes; order++ )
+			{
+				vecFirstIndex[order] = vecIndexOrder[order].first;
+				vecNumberOfIndices[order] = vecMeshes[ vecIndexOrder[order].second ].second->numberOfIndices;
+			}
+			arena.indexAllocator.Pack( vecFirstIndex, vecNumberOfIndices, vecPackedFirstIndex );
+			vecNewFirstIndex.resize( numberOfMeshes );
+			for ( unsigned int order = 0; order != numberOfMeshes; order++ )
+			{
+				vecNewFirstIndex[ vecIndexOrder[order].second ] = vecPackedFirstIndex[order];
+			}
+		}
 
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE,
-		bytesInOneVertex,	
-		(GLvoid*)byteOffsetToRGBA);		//sizeof(Vertex_xyz_n_RGB_UVx2::Normal));	
+		// Copy from the old buffers (on the GPU)
+		glBindBuffer( GL_COPY_READ_BUFFER, arena.vert_buf_ID );
+		glBindBuffer( GL_COPY_WRITE_BUFFER, new_vert_buf_ID );
+		for ( unsigned int mesh = 0; mesh != numberOfMeshes; mesh++ )
+		{
+			cVBOInfo &VBOInfo = *(vecMeshes[mesh].second);
+			const unsigned int newFirstVertex = bPack ? vecNewFirstVertex[mesh] : VBOInfo.firstVertex;
+			if ( VBOInfo.numberOfVertices != 0 )
+			{
+				glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, VBOInfo.firstVertex * vertexSizeInBytes, 
+				                     newFirstVertex * vertexSizeInBytes, VBOInfo.numberOfVertices * vertexSizeInBytes );
+			}
+			VBOInfo.firstVertex = newFirstVertex;
+		}
+		glBindBuffer( GL_COPY_READ_BUFFER, arena.index_buf_ID );
+		glBindBuffer( GL_COPY_WRITE_BUFFER, new_index_buf_ID );
+		for ( unsigned int mesh = 0; mesh != numberOfMeshes; mesh++ )
+		{
+			cVBOInfo &VBOInfo = *(vecMeshes[mesh].second);
+			const unsigned int newFirstIndex = bPack ? vecNewFirstIndex[mesh] : VBOInfo.firstIndex;
+			if ( VBOInfo.numberOfIndices != 0 )
+			{
+				glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, VBOInfo.firstIndex * indexSizeInBytes, 
+				                     newFirstIndex * indexSizeInBytes, VBOInfo.numberOfIndices * indexSizeInBytes );
+			}
+			VBOInfo.firstIndex = newFirstIndex;
+			VBOInfo.vert_buf_ID = new_vert_buf_ID;
+			VBOInfo.index_buf_ID = new_index_buf_ID;
+		}
+		ExitOnGLError("ERROR: Could not copy the arena");
 
-	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE,
-		bytesInOneVertex,	
-		(GLvoid*)byteOffsetToUVCoords);		//sizeof(Vertex_xyz_n_RGB_UVx2::RGBA));	
+		glDeleteBuffers( 1, &(arena.vert_buf_ID) );
+		glDeleteBuffers( 1, &(arena.index_buf_ID) );
+	}
+	arena.vert_buf_ID = new_vert_buf_ID;
+	arena.index_buf_ID = new_index_buf_ID;
+	if ( arena.vertexAllocator.GetCapacity() == 0 )
+	{	// (a new arena)
+		arena.vertexAllocator.Reset( vertexCapacity );
+		arena.indexAllocator.Reset( indexCapacity );
+	}
+	else
+	{	// Updated: Or smaller (see CompactMeshArenas())
+		if ( !arena.vertexAllocator.Shrink( vertexCapacity ) )
+		{
+			arena.vertexAllocator.Grow( vertexCapacity );
+		}
+		if ( !arena.indexAllocator.Shrink( indexCapacity ) )
+		{
+			arena.indexAllocator.Grow( indexCapacity );
+		}
+	}
 
+	// Point the VAO at the new buffers
+	glBindVertexArray( arena.VAO_ID );
+	glBindBuffer( GL_ARRAY_BUFFER, arena.vert_buf_ID );
+	cMeshManager::m_SetVertexAttributePointers( arena.layout );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, arena.index_buf_ID );
+	glBindVertexArray( 0 );
 	ExitOnGLError("ERROR: Could not set VAO attributes");
 
-	//glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, BufferIds[2]);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tempVBOInfo.index_buf_ID);
+	return;
+}
 
-	unsigned int sizeOfIndexArray =
-		sizeof(GLuint) * plyFile.GetNumberOfElements() * 3;
+bool cMeshManager::UnloadMesh( std::string meshName )
+{
+	// Added: If it was evicted (or is lazy), it isn't loaded now
+	const bool bWasEvicted = ( this->m_mapEvictedMeshes.erase( meshName ) != 0 ) || 
+	                         ( this->m_mapLazyMeshes.erase( meshName ) != 0 );
 
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-		sizeOfIndexArray,	// sizeof(INDICES),
-		(GLvoid*)pIndices,			// INDICES,
-		GL_STATIC_DRAW);
+	std::map< std::string /*fileName*/, unsigned int >::iterator itMesh = this->p_mapFileToBVO.find( meshName );
+	if ( itMesh == this->p_mapFileToBVO.end() )
+	{
+		return bWasEvicted;
+	}
+	const unsigned int slot = ( itMesh->second & ( ( 1u << cMeshManager::MESHHANDLESLOTBITS ) - 1 ) ) - 1;
+	cVBOInfo &VBOInfo = this->m_vecMeshes[slot];
+	sMeshArena &arena = this->m_vecArenas[VBOInfo.arenaIndex];
+	arena.vertexAllocator.Free( VBOInfo.firstVertex, VBOInfo.numberOfVertices );
+	arena.indexAllocator.Free( VBOInfo.firstIndex, VBOInfo.numberOfIndices );
+	this->m_meshBytesInUse -= VBOInfo.sizeInBytesOnGPU;
 
-	ExitOnGLError("ERROR: Could not bind the IBO to the VAO");
+	// (any handles to it don't find anything now)
+	VBOInfo = cVBOInfo();
+	this->m_vecFreeMeshSlots.push_back( slot );
+	this->p_mapFileToBVO.erase( itMesh );
+	return true;
+}
 
-	glBindVertexArray(0);
+void cMeshManager::CompactMeshArenas(void)
+{
+	for ( unsigned int arenaIndex = 0; arenaIndex != static_cast<unsigned int>( this->m_vecArenas.size() ); arenaIndex++ )
+	{
+		sMeshArena &arena = this->m_vecArenas[arenaIndex];
+		// Added: Half as big, as long as everything still fits (the opposite of what m_AddToMeshArena() does)
+		unsigned int vertexCapacity = arena.vertexAllocator.GetCapacity();
+		while ( ( vertexCapacity / 2 >= cMeshManager::ARENAMINVERTICES ) && 
+		        ( vertexCapacity / 2 >= arena.vertexAllocator.GetSizeInUse() ) )
+		{
+			vertexCapacity /= 2;
+		}
+		unsigned int indexCapacity = arena.indexAllocator.GetCapacity();
+		while ( ( indexCapacity / 2 >= cMeshManager::ARENAMININDICES ) && 
+		        ( indexCapacity / 2 >= arena.indexAllocator.GetSizeInUse() ) )
+		{
+			indexCapacity /= 2;
+		}
+
+		if ( ( arena.vertexAllocator.GetNumberOfFreeBlocks() > 1 ) || ( arena.indexAllocator.GetNumberOfFreeBlocks() > 1 ) || 
+		     ( vertexCapacity != arena.vertexAllocator.GetCapacity() ) || ( indexCapacity != arena.indexAllocator.GetCapacity() ) )
+		{
+			this->m_MoveArenaIntoNewBuffers( arenaIndex, vertexCapacity, indexCapacity, true );
+		}
+	}
+	return;
+}
 
-	// Clean up
-	delete[] pVerts;			// note odd syntax
-	delete[] pIndices;		// note odd syntax
+void cMeshManager::SetGPUMemoryBudget( unsigned long long budgetInBytes )
+{
+	this->m_GPUMemoryBudget = budgetInBytes;
+	return;
+}
 
-	tempVBOInfo.meshFileName = fileToLoad;
-	tempVBOInfo.numberOfTriangles = plyFile.GetNumberOfElements();
-	this->p_mapFileToBVO[tempVBOInfo.meshFileName] = tempVBOInfo;
+void cMeshManager::SetUploadRing( CGPUUploadRing* pUploadRing )
+{
+	this->m_pUploadRing = pUploadRing;
+	return;
+}
 
+void cMeshManager::BeginFrame(void)
+{
+	this->m_currentFrame++;
+	this->m_bytesUploadedThisFrame = 0;
+	this->m_EnforceGPUMemoryBudget();
+	return;
+}
 
+void cMeshManager::MarkMeshAsUsed( unsigned int meshHandle )
+{
+	const cVBOInfo* pVBOInfo = this->GetVBOInfo( meshHandle );
+	if ( pVBOInfo != 0 )
+	{
+		const unsigned int slot = ( meshHandle & ( ( 1u << cMeshManager::MESHHANDLESLOTBITS ) - 1 ) ) - 1;
+		this->m_vecMeshes[slot].lastFrameUsed = this->m_currentFrame;
+	}
+	return;
+}
+
+unsigned int cMeshManager::RequestMesh( std::string meshName )
+{
+	const unsigned int meshHandle = this->LookUpMeshHandle( meshName );
+	if ( meshHandle != cMeshManager::INVALIDMESHHANDLE )
+	{
+		return meshHandle;
+	}
+	std::map< std::string, cVBOInfo >::iterator itEvicted = this->m_mapEvictedMeshes.find( meshName );
+	if ( itEvicted != this->m_mapEvictedMeshes.end() )
+	{	// (false if it's already on its way)
+		if ( this->m_LoadAsync( itEvicted->second.sourceFileName, meshName, itEvicted->second.bSourceIsGDP2, 
+		                        itEvicted->second.vertexFormat ) )
+		{
+			this->m_totalReloads++;
+		}
+		return cMeshManager::INVALIDMESHHANDLE;
+	}
+	// Added: The first time for a lazy one
+	std::map< std::string, cVBOInfo >::iterator itLazy = this->m_mapLazyMeshes.find( meshName );
+	if ( itLazy != this->m_mapLazyMeshes.end() )
+	{
+		if ( this->m_LoadAsync( itLazy->second.sourceFileName, meshName, false, itLazy->second.vertexFormat ) )
+		{
+			this->m_totalLazyLoads++;
+		}
+	}
+	return cMeshManager::INVALIDMESHHANDLE;
+}
+
+void cMeshManager::m_EnforceGPUMemoryBudget(void)
+{
+	if ( ( this->m_GPUMemoryBudget == 0 ) || ( this->m_meshBytesInUse <= this->m_GPUMemoryBudget ) )
+	{
+		return;
+	}
+
+	// The ones that can go, least recently used first
+	std::vector< std::pair< unsigned int /*framesSinceUsed*/, unsigned int /*slot*/ > > vecCandidates;
+	for ( unsigned int slot = 0; slot != static_cast<unsigned int>( this->m_vecMeshes.size() ); slot++ )
+	{
+		const cVBOInfo &VBOInfo = this->m_vecMeshes[slot];
+		const unsigned int framesSinceUsed = this->m_currentFrame - VBOInfo.lastFrameUsed;
+		if ( ( VBOInfo.meshHandle != cMeshManager::INVALIDMESHHANDLE ) && ( framesSinceUsed > 1 ) )
+		{
+			vecCandidates.push_back( std::pair< unsigned int, unsigned int >( framesSinceUsed, slot ) );
+		}
+	}
+	std::sort( vecCandidates.begin(), vecCandidates.end() );
+
+	std::vector< std::pair< unsigned int, unsigned int > >::reverse_iterator itCandidate = vecCandidates.rbegin();
+	for ( ; ( itCandidate != vecCandidates.rend() ) && ( this->m_meshBytesInUse > this->m_GPUMemoryBudget ); itCandidate++ )
+	{
+		// (a copy, since UnloadMesh() clears it)
+		cVBOInfo evictedVBOInfo = this->m_vecMeshes[itCandidate->second];
+		this->UnloadMesh( evictedVBOInfo.meshFileName );
+		this->m_mapEvictedMeshes[evictedVBOInfo.meshFileName] = evictedVBOInfo;
+		this->m_totalEvictions++;
+	}
+
+	// The arenas don't get smaller by themselves
+	cMeshResidencyCounters counters;
+	this->GetResidencyCounters( counters );
+	if ( ( itCandidate != vecCandidates.rbegin() ) && ( counters.bytesAllocated > this->m_GPUMemoryBudget ) )
+	{
+		this->CompactMeshArenas();
+	}
+	return;
+}
+
+void cMeshManager::GetResidencyCounters( cMeshResidencyCounters &counters ) const
+{
+	counters.budgetInBytes = this->m_GPUMemoryBudget;
+	counters.bytesInUse = this->m_meshBytesInUse;
+	counters.bytesAllocated = 0;
+	for ( std::vector<sMeshArena>::const_iterator itArena = this->m_vecArenas.begin(); itArena != this->m_vecArenas.end(); itArena++ )
+	{
+		const unsigned int indexSizeInBytes = ( itArena->indexType == GL_UNSIGNED_SHORT ) ? sizeof(GLushort) : sizeof(GLuint);
+		counters.bytesAllocated += static_cast<unsigned long long>( itArena->vertexAllocator.GetCapacity() ) * itArena->layout.GetVertexSizeInBytes()
+		                         + static_cast<unsigned long long>( itArena->indexAllocator.GetCapacity() ) * indexSizeInBytes;
+	}
+	counters.numberOfResidentMeshes = static_cast<unsigned int>( this->p_mapFileToBVO.size() );
+	counters.numberOfEvictedMeshes = static_cast<unsigned int>( this->m_mapEvictedMeshes.size() );
+	counters.totalEvictions = this->m_totalEvictions;
+	counters.totalReloads = this->m_totalReloads;
+	counters.numberOfLazyMeshes = static_cast<unsigned int>( this->m_mapLazyMeshes.size() );
+	counters.totalLazyLoads = this->m_totalLazyLoads;
+	return;
+}
+
+bool cMeshManager::RegisterPlyLazy( std::string fileToLoad, cVBOInfo::enumVertexFormat vertexFormat /*=VERTEX_FORMAT_FLOAT*/ )
+{
+	if ( ( this->LookUpMeshHandle( fileToLoad ) != cMeshManager::INVALIDMESHHANDLE ) || 
+	     ( this->m_mapLazyMeshes.find( fileToLoad ) != this->m_mapLazyMeshes.end() ) )
+	{
+		return false;
+	}
+
+	// Just the header (not the vertices or triangles)
+	CPlyFile5nt plyFile;
+	std::wstring error;
+	if ( !plyFile.ReadPLYFileHeader( CStringHelper::getInstance( )->ASCIIToUnicodeQnD( fileToLoad ), error ) )
+	{
+		return false;
+	}
+
+	cVBOInfo &lazyVBOInfo = this->m_mapLazyMeshes[fileToLoad];
+	lazyVBOInfo.meshFileName = fileToLoad;
+	lazyVBOInfo.sourceFileName = fileToLoad;
+	lazyVBOInfo.vertexFormat = vertexFormat;
+	lazyVBOInfo.numberOfVertices = static_cast<unsigned int>( plyFile.GetNumberOfVerticies() );
+	lazyVBOInfo.numberOfTriangles = static_cast<unsigned int>( plyFile.GetNumberOfElements() );
+
+	// Added: The ply header doesn't say how big it is, but an up to date cooked version does
+	//	(otherwise boundingRadius stays 0, which means "not known")
+	unsigned long long cookKey = 0;
+	if ( this->m_cookedCache.IsEnabled() && 
+		 CAssetCache::CalculateCookKey( fileToLoad, cMeshManager::MESHCOOKSETTINGS, cookKey ) )
+	{
+		CGDP2File gdpFile;
+		if ( gdpFile.Open( CStringHelper::getInstance( )->ASCIIToUnicodeQnD( this->m_cookedCache.GetCookedFileName( fileToLoad, ".gdp" ) ), error ) && 
+			 ( gdpFile.GetCookKey() == cookKey ) )
+		{
+			const CGDP2File::sLODChain &LODChain = *(gdpFile.GetLODChain());
+			for ( unsigned int axis = 0; axis != 3; axis++ )
+			{
+				lazyVBOInfo.boundingCentre[axis] = LODChain.boundingCentre[axis];
+			}
+			lazyVBOInfo.boundingRadius = LODChain.boundingRadius;
+		}
+	}
+
+	// (so m_vecMeshes doesn't have to move when they're loaded)
+	this->m_vecMeshes.reserve( this->p_mapFileToBVO.size() + this->m_mapLazyMeshes.size() + this->m_mapEvictedMeshes.size() );
+	return true;
+}
+
+bool cMeshManager::GetLazyMeshInfo( std::string meshName, unsigned int &numberOfVertices, unsigned int &numberOfTriangles ) const
+{
+	std::map< std::string, cVBOInfo >::const_iterator itLazy = this->m_mapLazyMeshes.find( meshName );
+	if ( itLazy == this->m_mapLazyMeshes.end() )
+	{
+		return false;
+	}
+	numberOfVertices = itLazy->second.numberOfVertices;
+	numberOfTriangles = itLazy->second.numberOfTriangles;
+	return true;
+}
+
+bool cMeshManager::GetUnloadedMeshBoundingSphere( std::string meshName, float centre[3], float &radius ) const
+{
+	std::map< std::string, cVBOInfo >::const_iterator itMesh = this->m_mapLazyMeshes.find( meshName );
+	if ( itMesh == this->m_mapLazyMeshes.end() )
+	{
+		itMesh = this->m_mapEvictedMeshes.find( meshName );
+		if ( itMesh == this->m_mapEvictedMeshes.end() )
+		{
+			return false;
+		}
+	}
+	if ( itMesh->second.boundingRadius <= 0.0f )
+	{	// (not known)
+		return false;
+	}
+	for ( unsigned int axis = 0; axis != 3; axis++ )
+	{
+		centre[axis] = itMesh->second.boundingCentre[axis];
+	}
+	radius = itMesh->second.boundingRadius;
 	return true;
 }
 
+//static 
+void cMeshManager::m_BuildLODChain( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices, 
+                                    std::vector<unsigned int> &vecIndices, cVBOInfo &VBOInfo )
+{
+	VBOInfo.LODs[0].firstIndex = 0;
+	VBOInfo.LODs[0].numberOfTriangles = static_cast<unsigned int>( vecIndices.size() / 3 );
+	VBOInfo.LODs[0].relativeError = 0.0f;
+	VBOInfo.numberOfLODs = 1;
+	if ( ( numberOfVertices == 0 ) || vecIndices.empty() )
+	{
+		return;
+	}
+
+	// Bounding sphere (Ritter's, or the middle of the box if that's smaller)
+	CPositionKernels::CalculateBoundingSphere( pPositions, positionStrideInBytes, numberOfVertices,
+	                                           VBOInfo.boundingCentre, VBOInfo.boundingRadius );
+	if ( VBOInfo.boundingRadius <= 0.0f )
+	{
+		return;
+	}
+
+	// Each level is made from the one before it (so the errors add up)
+	std::vector<unsigned int> vecLODIndices( vecIndices );
+	std::vector<unsigned int> vecSimplified;
+	std::vector<unsigned int> vecClusters;
+	float totalError = 0.0f;
+	while ( VBOInfo.numberOfLODs != cVBOInfo::MAXLODS )
+	{
+		unsigned int numberOfTriangles = static_cast<unsigned int>( vecLODIndices.size() / 3 );
+		unsigned int targetNumberOfTriangles = static_cast<unsigned int>( numberOfTriangles * cMeshManager::LODTRIANGLERATIO );
+		if ( targetNumberOfTriangles < cMeshManager::MINLODTRIANGLES )
+		{
+			break;
+		}
+		float error = 0.0f;
+		CMeshSimplifier::SimplifyQEM( vecLODIndices, pPositions, positionStrideInBytes, numberOfVertices, 
+		                              targetNumberOfTriangles, VBOInfo.boundingRadius, vecSimplified, error );
+		// Not worth it if it couldn't take out at least 10% (seams, borders, etc. are all locked)
+		if ( ( vecSimplified.size() / 3 ) > ( numberOfTriangles * 9 ) / 10 )
+		{
+			break;
+		}
+		// (it's a new order, so do the vertex cache again; the vertices can't move, since they're shared)
+		CMeshOptimizer::OptimizeVertexCache( vecSimplified, numberOfVertices, CMeshOptimizer::DEFAULTCACHESIZE, vecClusters );
+
+		totalError += error;
+		cLODInfo &LOD = VBOInfo.LODs[VBOInfo.numberOfLODs];
+		LOD.firstIndex = static_cast<unsigned int>( vecIndices.size() );
+		LOD.numberOfTriangles = static_cast<unsigned int>( vecSimplified.size() / 3 );
+		LOD.relativeError = totalError / VBOInfo.boundingRadius;
+		VBOInfo.numberOfLODs++;
+
+		vecIndices.insert( vecIndices.end(), vecSimplified.begin(), vecSimplified.end() );
+		vecLODIndices.swap( vecSimplified );
+	}
+	return;
+}
+
+//static 
+unsigned int cMeshManager::SelectLOD( const cVBOInfo &VBOInfo, float screenRadiusInPixels, unsigned int currentLOD )
+{
+	if ( VBOInfo.numberOfLODs <= 1 )
+	{
+		return 0;
+	}
+	unsigned int LOD = std::min( currentLOD, VBOInfo.numberOfLODs - 1 );
+	// Too rough for how big it is now? 
+	while ( ( LOD > 0 ) && 
+		    ( ( VBOInfo.LODs[LOD].relativeError * screenRadiusInPixels ) > ( cMeshManager::LODPIXELERROR * ( 1.0f + cMeshManager::LODHYSTERESIS ) ) ) )
+	{
+		LOD--;
+	}
+	// Can it get away with less?
+	while ( ( ( LOD + 1 ) < VBOInfo.numberOfLODs ) && 
+		    ( ( VBOInfo.LODs[LOD + 1].relativeError * screenRadiusInPixels ) <= ( cMeshManager::LODPIXELERROR * ( 1.0f - cMeshManager::LODHYSTERESIS ) ) ) )
+	{
+		LOD++;
+	}
+	return LOD;
+}
+
 void cMeshManager::ShutDown(void)
 {
+	// Added: Anything that's still loading is thrown away
+	this->m_FinishLoadJobs();
+
 	// Lines from the original code...
 	//  glDeleteBuffers(2, &BufferIds[1]);
 	//  glDeleteVertexArrays(1, &BufferIds[0]);	
 	
 	// Go through all the VBAs and delete them 
+	// Updated: The meshes share the arenas' buffers and VAOs, so it's those that get deleted
 
-	for ( std::map< std::string /*fileName*/, cVBOInfo >::iterator itVBA = this->p_mapFileToBVO.begin();
-		  itVBA != this->p_mapFileToBVO.end(); itVBA++ )
+	for ( std::vector<sMeshArena>::iterator itArena = this->m_vecArenas.begin();
+		  itArena != this->m_vecArenas.end(); itArena++ )
 	{
-		glDeleteBuffers( 1, &(itVBA->second.index_buf_ID) );
-		glDeleteBuffers( 1, &(itVBA->second.vert_buf_ID) );
+		glDeleteBuffers( 1, &(itArena->index_buf_ID) );
+		glDeleteBuffers( 1, &(itArena->vert_buf_ID) );
 
-		glDeleteVertexArrays( 1, &(itVBA->second.VBO_ID) );
+		glDeleteVertexArrays( 1, &(itArena->VAO_ID) );
 	}
+	this->m_vecArenas.clear();
+	this->p_mapFileToBVO.clear();
+	this->m_vecMeshes.clear();
+	this->m_vecFreeMeshSlots.clear();
+	this->m_vecMeshSlotGenerations.clear();
+	this->m_mapEvictedMeshes.clear();
+	this->m_mapLazyMeshes.clear();
+	this->m_meshBytesInUse = 0;
 
 	return;
 }
@@ -437,15 +1657,15 @@ bool cMeshManager::LookUpVBOInfoFromModelName(
 	  p_mapFileToBVO;
 
 	// Find the model
-	  std::map< std::string /*fileName*/, cVBOInfo >::iterator itVBO
-		                  = this->p_mapFileToBVO.find(modelName);
+	// Updated: The map has the handle now
+	  const cVBOInfo* pVBOInfo = this->GetVBOInfo( this->LookUpMeshHandle( modelName ) );
 	// Found it? 
-	  if ( itVBO == this->p_mapFileToBVO.end() )
+	  if ( pVBOInfo == 0 )
 	  {		// 
 		  return false;
 	  }
 	  // Did find it
-	  VBOInfo = itVBO->second;
+	  VBOInfo = *pVBOInfo;
 
 	return true;
 }
\ No newline at end of file
@@ -7,18 +7,120 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <deque>
+#include <mutex>
+#include <future>
 #include "cVertex.h"
 #include "cTriangle.h"
+#include "CAssetCache.h"
+#include "CArenaAllocator.h"
+#include "CGPUUploadRing.h"
+#include "Ply/CPlyVertexLayout.h"
+#include "Ply/CGDP2File.h"
+
+class CPlyFile5nt;
+struct PlyWeldInfo;
+
+// Added: One level of detail (LOD). All the levels of a model use the same vertex buffer,
+//	and their indices are one after the other in the same index buffer.
+class cLODInfo
+{
+public:
+	cLODInfo() : firstIndex(0), numberOfTriangles(0), relativeError(0.0f) {};
+	unsigned int firstIndex;		// Where this level starts in the index buffer (after cVBOInfo::firstIndex)
+	unsigned int numberOfTriangles;
+	float relativeError;			// How far off the full model it is (as a fraction of the bounding radius)
+};
 
 class cVBOInfo
 {
 public:
+	cVBOInfo() : VBO_ID(0), vert_buf_ID(0), index_buf_ID(0), numberOfTriangles(0), indexType(GL_UNSIGNED_INT), 
+	             arenaIndex(0), firstVertex(0), numberOfVertices(0), firstIndex(0), numberOfIndices(0), meshHandle(0), 
+	             sizeInBytesOnGPU(0), lastFrameUsed(0), bSourceIsGDP2(false), 
+	             numberOfLODs(0), boundingRadius(0.0f), 
+	             vertexFormat(VERTEX_FORMAT_FLOAT), vertexSizeInBytes(sizeof(Vertex_xyz_n_RGB_UVx2)), 
+	             bNormalsAreOctahedral(false), bHasVertexColours(true)
+	{ 
+		boundingCentre[0] = boundingCentre[1] = boundingCentre[2] = 0.0f;
+		positionDecodeScale[0] = positionDecodeScale[1] = positionDecodeScale[2] = 1.0f;
+		positionDecodeOffset[0] = positionDecodeOffset[1] = positionDecodeOffset[2] = 0.0f;
+	};
 	//GLuint  BufferIds[3] = { 0 };
+	// Updated: These are shared by all the meshes in the same arena (see cMeshManager::sMeshArena)
 	GLuint VBO_ID;		 // BufferIds[0] = VAO (or VBO)
 	GLuint vert_buf_ID;	 // BufferIds[1] = vertex buffer ID
 	GLuint index_buf_ID; // BufferIds[2] = index buffer ID
 	std::string meshFileName;
 	unsigned int numberOfTriangles;
+	GLenum indexType;	 // GL_UNSIGNED_INT or GL_UNSIGNED_SHORT (what's passed to glDrawElements)
+
+	// Added: Where this mesh is in the arena's buffers. The indices start at 0 for each mesh, 
+	//	so draw it with glDrawElementsBaseVertex(), with firstVertex as the base vertex.
+	unsigned int arenaIndex;
+	unsigned int firstVertex;
+	unsigned int numberOfVertices;
+	unsigned int firstIndex;
+	unsigned int numberOfIndices;	// All the LODs
+
+	// Added: What the cMeshManager load methods returned for it (see cMeshManager::GetVBOInfo())
+	unsigned int meshHandle;
+
+	// Added: For the GPU memory budget (see cMeshManager::SetGPUMemoryBudget())
+	unsigned int sizeInBytesOnGPU;		// The vertices and the indices (all the LODs)
+	unsigned int lastFrameUsed;			// See cMeshManager::MarkMeshAsUsed()
+	// Where it came from, so it can be loaded again if it's evicted
+	std::string sourceFileName;
+	bool bSourceIsGDP2;
+
+	// Added: LODs[0] is the full model, then each one after that has fewer triangles
+	static const unsigned int MAXLODS = 5;
+	cLODInfo LODs[MAXLODS];
+	unsigned int numberOfLODs;
+	// Added: Bounding sphere (in model space), for picking the LOD
+	float boundingCentre[3];
+	float boundingRadius;
+
+	// Added: How the vertices are stored (picked for each mesh when it's loaded)
+	enum enumVertexFormat
+	{
+		// Vertex_xyz_n_RGB_UVx2: 4 floats each for the position, normal, colour and texture coords (64 bytes)
+		VERTEX_FORMAT_FLOAT = 0,
+		// Position as 16 bit integers across the bounding box (8 bytes), octahedral normal (4 bytes),
+		//	8 bit colour (4 bytes), half float texture coords (4 bytes, or 8 if there are 2 sets).
+		//	Colours (and the 2nd set of texture coords) the model doesn't have aren't stored at all, 
+		//	so it's 16 to 24 bytes a vertex. See cMeshManager::m_PickCompactVertexFormat().
+		VERTEX_FORMAT_COMPACT
+	};
+	enumVertexFormat vertexFormat;
+	unsigned int vertexSizeInBytes;
+	// What the shader needs to turn them back into regular vertices 
+	//	(PositionDecodeScale, PositionDecodeOffset and bNormalIsOctahedral in MultiLightsTextures.vertex.glsl)
+	float positionDecodeScale[3];		// position = positionDecodeOffset + in_Position * positionDecodeScale
+	float positionDecodeOffset[3];
+	bool bNormalsAreOctahedral;
+	// If not, in_RGBA isn't in the VAO (so set it with glVertexAttrib4f() before drawing)
+	bool bHasVertexColours;
+};
+
+// Added: See cMeshManager::GetResidencyCounters()
+class cMeshResidencyCounters
+{
+public:
+	cMeshResidencyCounters() : budgetInBytes(0), bytesInUse(0), bytesAllocated(0), numberOfResidentMeshes(0), 
+	                           numberOfEvictedMeshes(0), totalEvictions(0), totalReloads(0), 
+	                           numberOfLazyMeshes(0), totalLazyLoads(0) {};
+	unsigned long long budgetInBytes;		// 0 if there isn't one
+	unsigned long long bytesInUse;			// By the meshes that are loaded
+	unsigned long long bytesAllocated;		// By the arenas (what the GPU actually has)
+	unsigned int numberOfResidentMeshes;
+	unsigned int numberOfEvictedMeshes;		// (they get loaded again when they're asked for)
+	unsigned int totalEvictions;
+	unsigned int totalReloads;
+	// Added: See cMeshManager::RegisterPlyLazy()
+	unsigned int numberOfLazyMeshes;		// Registered, but not asked for yet
+	unsigned int totalLazyLoads;
 };
 
 class cMeshManager
@@ -38,19 +140,242 @@ public:
 	//	                 unsigned int &VBO);
 
 	// "Fancier" version that loads more models, WAY faster
-	bool LoadPlyIntoVBO( std::string fileToLoad );
+	// Updated: vertexFormat is how the vertices are stored on the GPU (see cVBOInfo::enumVertexFormat)
+	// Updated: Returns the mesh handle (see GetVBOInfo()), or INVALIDMESHHANDLE (0) if it didn't load
+	unsigned int LoadPlyIntoVBO( std::string fileToLoad, cVBOInfo::enumVertexFormat vertexFormat = cVBOInfo::VERTEX_FORMAT_FLOAT );
 
+	// Added: "Cooked" (GDP version 3, see CGDP2File) models. The file already has the vertex and index
+	//	buffers the way the GPU wants them (and the LODs), so there's nothing to do but map it and upload it.
+	// meshName is what LookUpVBOInfoFromModelName() finds it by (often the original ply file name)
+	unsigned int LoadGDP2IntoVBO( std::string fileToLoad, std::string meshName, 
+	                              cVBOInfo::enumVertexFormat vertexFormat = cVBOInfo::VERTEX_FORMAT_FLOAT );
+
+	// Added: Asynchronous loading. Everything LoadPlyIntoVBO() does that doesn't need OpenGL (parsing, 
+	//	normals, the weld, the LODs, the cooked cache, etc.) is done on the thread pool (see CThreadPool). 
+	//	The finished meshes wait in a queue until ProcessLoadQueue() puts them on the GPU.
+	// Until then, LookUpMeshHandle() doesn't find it (so it isn't drawn).
+	// Returns false if it's already loaded, or on its way.
+	bool LoadPlyIntoVBOAsync( std::string fileToLoad, cVBOInfo::enumVertexFormat vertexFormat = cVBOInfo::VERTEX_FORMAT_FLOAT );
+	// Call this on the OpenGL thread (once a frame). Uploads the finished meshes until it's taken 
+	//	budgetInSeconds (it always does at least one, so a big mesh still gets there). 
+	//	Returns how many were uploaded.
+	// Updated: Or until budgetInBytes have been uploaded this frame (0 is no limit)
+	unsigned int ProcessLoadQueue( float budgetInSeconds = cMeshManager::DEFAULTUPLOADBUDGETSECONDS,
+	                               unsigned int budgetInBytes = cMeshManager::DEFAULTUPLOADBUDGETBYTES );
+	// How many are still being loaded (on the thread pool, or waiting for ProcessLoadQueue())
+	unsigned int GetNumberOfMeshesLoading(void);
+	// About a quarter of a 60 Hz frame
+	static const float DEFAULTUPLOADBUDGETSECONDS;
+	// Added: About 240 MB a second, at 60 Hz
+	static const unsigned int DEFAULTUPLOADBUDGETBYTES = 4 * 1024 * 1024;
+
+	// Added: The vertices and indices go through this (see CGPUUploadRing), instead of glBufferSubData().
+	//	0 (the default) is the old way. It isn't owned by the mesh manager.
+	void SetUploadRing( CGPUUploadRing* pUploadRing );
+
+	// Added: Mesh "handles". The loads return one, and it's what things hang on to (like 
+	//	cGameObject::cached_VBO_ID), so a draw is an array look up, not a search by name.
+	// A handle is where the mesh is in the array (plus 1, so 0 is never one) in the low 24 bits, 
+	//	and how many times that spot has been used in the top 8 bits. If the mesh is unloaded 
+	//	(or loaded again), the old handle doesn't find anything, instead of finding whatever's there now.
+	static const unsigned int INVALIDMESHHANDLE = 0;
+	// Returns 0 (NULL) if the handle isn't a mesh (any more)
+	// NOTE: Loading another mesh can move these around, so don't hang on to the pointer
+	const cVBOInfo* GetVBOInfo( unsigned int meshHandle ) const;
+	// Returns INVALIDMESHHANDLE if there isn't one with that name
+	unsigned int LookUpMeshHandle( std::string meshName ) const;
+	// Loads the ply, does the same things to it as LoadPlyIntoVBO() (normals, texture coords, LODs), 
+	//	then saves it as a GDP version 3 file. Doesn't need OpenGL.
+	// (cookKey is stored in the file, see CAssetCache)
+	// If pWeldInfo isn't null, it gets what the weld did (see CPlyFile5nt::WeldVertices())
+	static bool CookPlyToGDP2( std::string plyFileToLoad, std::string gdpFileToSave, unsigned long long cookKey, std::wstring &error, 
+	                           PlyWeldInfo* pWeldInfo = 0 );
+
+	// Added: If this is set, LoadPlyIntoVBO() uses the cooked (GDP version 3) version of the ply 
+	//	if it's up to date, and saves one if it isn't. Empty turns it off.
+	void SetCookedCacheFolder( std::string cacheFolder );
+	// Added: Cooks the ply into the cache (if it's not already there and up to date). Doesn't need OpenGL.
+	static bool CookPlyFile( std::string plyFileToLoad, CAssetCache &cache, bool &bWasAlreadyUpToDate, std::wstring &error, 
+	                         PlyWeldInfo* pWeldInfo = 0 );
+	// How the plys are cooked (part of the cook key)
+	static const std::string MESHCOOKSETTINGS;
+	// Added: Vertices closer than this (in everything: position, normal, texture coords, etc.) 
+	//	are welded into one when the ply is loaded. Negative turns the weld off. 
+	// NOTE: If you change this, change MESHCOOKSETTINGS, too (so the cooked models get redone)
+	static const float WELDEPSILON;
+
+	// (this searches by name, and copies it, so it's for tools, etc.; use GetVBOInfo() when drawing)
 	bool LookUpVBOInfoFromModelName( std::string modelName,
 		                             cVBOInfo &VBOInfo );
 
+	// Added: Level of detail (LOD) chain. When a model is loaded, lower detail versions of it
+	//	are made (see CMeshSimplifier), each with about LODTRIANGLERATIO as many triangles as 
+	//	the one before, stopping at MINLODTRIANGLES (or cVBOInfo::MAXLODS levels).
+	static const float LODTRIANGLERATIO;
+	static const unsigned int MINLODTRIANGLES = 64;
+	// How far off (in pixels) a LOD can be before a more detailed one is used
+	static const float LODPIXELERROR;
+	// So the LOD doesn't flip back and forth at the switching distance: a LOD is kept until it's 
+	//	this much (0.25 is 25%) past LODPIXELERROR, and isn't picked until it's this much under it
+	static const float LODHYSTERESIS;
+	// screenRadiusInPixels: how big the bounding sphere is on the screen
+	// currentLOD: what this object was drawn with last time (for the hysteresis)
+	static unsigned int SelectLOD( const cVBOInfo &VBOInfo, float screenRadiusInPixels, unsigned int currentLOD );
+
+	// Added: Frees the mesh's part of the arena (the space is used by the next meshes that fit)
+	bool UnloadMesh( std::string meshName );
+	// Added: Moves the meshes in each arena together, so all the free space is one block at the end.
+	//	Only does the arenas that have more than one free block. (this copies on the GPU, so it's 
+	//	something to do on a level change, etc., not every frame)
+	// Updated: Arenas that are less than half used are made smaller, too (not below the minimum)
+	void CompactMeshArenas(void);
+
+	// Added: GPU memory budget (residency). Once the meshes use more than this, the ones that 
+	//	haven't been drawn for the longest time are "evicted" (unloaded) at the start of the next 
+	//	frame, and loaded again (on the thread pool, from the cooked cache if there is one) when 
+	//	RequestMesh() asks for them. 0 is no budget (the default).
+	// Anything drawn this frame or last frame isn't evicted, so if that doesn't fit, it's over 
+	//	the budget, instead of loading the same meshes every frame.
+	void SetGPUMemoryBudget( unsigned long long budgetInBytes );
+	// Call this at the start of each frame (before ProcessLoadQueue()). Evicts meshes if it's over the budget.
+	void BeginFrame(void);
+	// Call this when the mesh is drawn
+	void MarkMeshAsUsed( unsigned int meshHandle );
+	// Like LookUpMeshHandle(), but if the mesh was evicted, it starts loading it again
+	//	(so it's INVALIDMESHHANDLE for a few frames)
+	// Updated: Or if it was registered with RegisterPlyLazy(), and this is the first time
+	unsigned int RequestMesh( std::string meshName );
+	void GetResidencyCounters( cMeshResidencyCounters &counters ) const;
+
+	// Added: Lazy loading. Only reads the ply's header (the number of vertices and triangles), 
+	//	so it's about the same time for any size of file. The rest is loaded (like LoadPlyIntoVBOAsync())
+	//	the first time RequestMesh() asks for it.
+	// Updated: If there's an up to date cooked version (see SetCookedCacheFolder()), the bounding 
+	//	sphere is read from it, too (see GetUnloadedMeshBoundingSphere())
+	// Returns false if the header can't be read (or it's already loaded, or registered).
+	bool RegisterPlyLazy( std::string fileToLoad, cVBOInfo::enumVertexFormat vertexFormat = cVBOInfo::VERTEX_FORMAT_FLOAT );
+	// Added: What the header said (before it's loaded). False if it's not registered (or it's been loaded).
+	bool GetLazyMeshInfo( std::string meshName, unsigned int &numberOfVertices, unsigned int &numberOfTriangles ) const;
+	// Added: The bounding sphere (in model space) of a lazy or evicted mesh, so it can be culled 
+	//	before it's loaded. False if it's not one of those, or how big it is isn't known yet.
+	bool GetUnloadedMeshBoundingSphere( std::string meshName, float centre[3], float &radius ) const;
+	// Added: How many vertices and indices the arenas start with (they double when they're full)
+	static const unsigned int ARENAMINVERTICES = 64 * 1024;
+	static const unsigned int ARENAMININDICES = 256 * 1024;
+
 	void ShutDown(void);
 
 private:
 	// Look up file name to VBOinfo
+	// Updated: The name now goes to the mesh handle; the meshes are in m_vecMeshes
 	std::map< std::string /*fileName*/,
-		      cVBOInfo >  p_mapFileToBVO;
+		      unsigned int /*meshHandle*/ >  p_mapFileToBVO;
+	// Added: A free spot has a meshHandle of INVALIDMESHHANDLE (and is in m_vecFreeMeshSlots)
+	std::vector< cVBOInfo > m_vecMeshes;
+	std::vector< unsigned int > m_vecFreeMeshSlots;
+	// (the top 8 bits of each mesh's handle, so it changes each time the spot is used)
+	std::vector< unsigned char > m_vecMeshSlotGenerations;
+	static const unsigned int MESHHANDLESLOTBITS = 24;
+	// Puts it in m_vecMeshes (and the name map), and returns the handle
+	unsigned int m_AddMesh( const cVBOInfo &VBOInfo );
+
+	CAssetCache m_cookedCache;
+
+	// Added: Everything that's needed to put a mesh into an arena, done ahead of time (no OpenGL), 
+	//	so it can be done on another thread. Defined in the cpp file.
+	struct sPreparedMesh;
+	// Added: For LoadPlyIntoVBOAsync(). The worker threads add to the queue; ProcessLoadQueue() takes from it.
+	std::mutex m_loadQueueMutex;
+	std::deque< sPreparedMesh* > m_queueMeshesToUpload;
+	std::set< std::string > m_setMeshesLoading;
+	std::vector< std::future<void> > m_vecLoadJobs;
+	// Waits for any loads that are still running, and throws away what hasn't been uploaded
+	void m_FinishLoadJobs(void);
+	// (LoadPlyIntoVBOAsync(), and RequestMesh() for an evicted one)
+	bool m_LoadAsync( std::string fileToLoad, std::string meshName, bool bIsGDP2, cVBOInfo::enumVertexFormat vertexFormat );
+
+	// Added: For SetGPUMemoryBudget()
+	unsigned long long m_GPUMemoryBudget;
+	unsigned long long m_meshBytesInUse;
+	unsigned int m_currentFrame;
+	unsigned int m_totalEvictions;
+	unsigned int m_totalReloads;
+	// What's needed to load it again (sourceFileName, vertexFormat, etc.)
+	std::map< std::string /*meshName*/, cVBOInfo > m_mapEvictedMeshes;
+	// Added: Same thing for RegisterPlyLazy() (and numberOfVertices and numberOfTriangles from the header)
+	std::map< std::string /*meshName*/, cVBOInfo > m_mapLazyMeshes;
+	unsigned int m_totalLazyLoads;
+	// Added: See SetUploadRing()
+	CGPUUploadRing* m_pUploadRing;
+	// How much ProcessLoadQueue() (or anything else) has uploaded since BeginFrame()
+	unsigned int m_bytesUploadedThisFrame;
+	// Evicts the least recently used meshes until it's under the budget
+	void m_EnforceGPUMemoryBudget(void);
+
+	// Added: All the meshes with the same vertex format (and index type) go into one big vertex 
+	//	buffer and one big index buffer, with one VAO. The meshes are drawn with a "base vertex", 
+	//	so the VAO doesn't have to change from mesh to mesh.
+	// (the layouts of VERTEX_FORMAT_COMPACT meshes differ by which streams they have, so there can 
+	//	be a few of these)
+	struct sMeshArena
+	{
+		sMeshArena() : VAO_ID(0), vert_buf_ID(0), index_buf_ID(0), indexType(GL_UNSIGNED_INT) {};
+		GLuint VAO_ID;
+		GLuint vert_buf_ID;
+		GLuint index_buf_ID;
+		CPlyVertexLayout layout;
+		GLenum indexType;
+		CArenaAllocator vertexAllocator;	// In vertices
+		CArenaAllocator indexAllocator;		// In indices
+	};
+	std::vector<sMeshArena> m_vecArenas;
+	// Returns the arena for this kind of mesh (makes a new, empty one if there isn't one)
+	unsigned int m_FindOrAddArena( const CPlyVertexLayout &layout, GLenum indexType );
+	// Makes new buffers that are this big and copies the meshes into them. If bPack is true, the 
+	//	meshes are moved together (see CompactMeshArenas()); otherwise they stay where they are.
+	void m_MoveArenaIntoNewBuffers( unsigned int arenaIndex, unsigned int vertexCapacity, unsigned int indexCapacity, bool bPack );
 
 	// Cool method coming... 
+
+	// Added: Normals and texture coordinates, if the file doesn't have them, then the weld, 
+	//	then the triangle order (see CMeshOptimizer)
+	static void m_PrepareForRendering( CPlyFile5nt &plyFile, PlyWeldInfo &weldInfo );
+	// Added: The part of LoadPlyIntoVBO() that doesn't need OpenGL (so it can be on any thread)
+	// (cookedCache is a copy, so SetCookedCacheFolder() doesn't change it part way through)
+	static bool m_PrepareMeshFromPly( std::string fileToLoad, cVBOInfo::enumVertexFormat vertexFormat, CAssetCache cookedCache, 
+	                                  sPreparedMesh &preparedMesh );
+	// Added: Same, for LoadGDP2IntoVBO()
+	static bool m_PrepareMeshFromGDP2( std::string fileToLoad, std::string meshName, cVBOInfo::enumVertexFormat vertexFormat, 
+	                                   sPreparedMesh &preparedMesh );
+	// Added: Picks the layout for the (open) preparedMesh.gdpFile; the GDP loaders end up here. The LODs 
+	//	and the bounding sphere are read from the file, and the vertices and indices point into it.
+	// Updated: Was m_PrepareMeshFromBuffers(), which made the LODs every time
+	static void m_PrepareMeshFromGDP2File( sPreparedMesh &preparedMesh, cVBOInfo::enumVertexFormat vertexFormat );
+	// Added: Same thing, but the vertices and indices are written right from the ply (preparedMesh.plyFile)
+	//	(see CPlyFile5nt::ExportVertices()), instead of being copied into arrays first
+	// Updated: Was m_LoadPlyFileIntoVBO()
+	static void m_PrepareMeshFromPlyFile( sPreparedMesh &preparedMesh, cVBOInfo::enumVertexFormat vertexFormat );
+	// Added: Saves the prepared ply (and its LODs) as a cooked GDP file (see CGDP2File::Save())
+	static bool m_SaveCookedFile( sPreparedMesh &preparedMesh, std::wstring fileName, unsigned long long cookKey, std::wstring &error );
+	// Added: Puts the mesh into an arena, and adds it to the map (all of the above end up here)
+	// Updated: Was m_CreateVAO(). The index type is picked here (16 bits if the mesh has few enough vertices)
+	// Updated: Returns the mesh handle (or INVALIDMESHHANDLE)
+	unsigned int m_AddToMeshArena( sPreparedMesh &preparedMesh );
+	// Added: Maps part of the GL_ARRAY_BUFFER and writes the vertices into it (or uses glBufferSubData() 
+	//	if it can't be mapped)
+	static void m_ExportVerticesIntoBoundBuffer( const CPlyVertexStreams &vertexStreams, const CPlyVertexLayout &layout, 
+	                                             unsigned int offsetInBytes, unsigned int sizeInBytes );
+	// Added: What VERTEX_FORMAT_COMPACT stores for these vertices (the bounding box, which streams are there, etc.)
+	// Updated: Was part of m_MakeCompactVertexLayout(), so the cooked files can store it
+	static void m_PickCompactVertexFormat( const CPlyVertexStreams &vertexStreams, CGDP2File::sCompactFormat &format );
+	// Added: The VERTEX_FORMAT_COMPACT layout for that. Sets the decode values (and vertexSizeInBytes) in VBOInfo, too.
+	static void m_MakeCompactVertexLayout( const CGDP2File::sCompactFormat &format, CPlyVertexLayout &layout, cVBOInfo &VBOInfo );
+	// Added: glVertexAttribPointer() for each attribute in the layout (on the bound VAO and GL_ARRAY_BUFFER)
+	static void m_SetVertexAttributePointers( const CPlyVertexLayout &layout );
+	// Added: Adds the lower detail levels to the end of vecIndices, and sets the LODs and the bounding sphere
+	// (pPositions is the x, y, z of the first vertex; see CPositionKernels)
+	static void m_BuildLODChain( const float* pPositions, unsigned int positionStrideInBytes, unsigned int numberOfVertices, 
+	                             std::vector<unsigned int> &vecIndices, cVBOInfo &VBOInfo );
 };
 
 #endif
@@ -27,6 +27,11 @@
 #include "cGameObject.h"
 #include "cMeshManager.h"
 #include "CShaderManager/CGLShaderManager.h"	// Note: it's "C" here
+#include "Ply/CPlyLoadBenchmark.h"
+#include "Ply/CVertexCacheReport.h"
+#include "Ply/CMeshOptimizer.h"
+#include "CAssetCooker.h"
+#include "CGPUUploadRing.h"
 
 #include <sstream>
 
@@ -34,6 +39,8 @@ cMeshManager* g_pTheMeshManager = 0;
 
 IGLShaderManager* g_pTheShaderManager = 0;
 CTextureManager* g_pTheTextureManager = 0;
+// Added: The meshes and textures are uploaded through this (see CGPUUploadRing)
+CGPUUploadRing* g_pTheUploadRing = 0;
 
 cGameObject* g_pDebugBall = 0;
 
@@ -46,6 +53,10 @@ int
   WindowHandle = 0;
 
 unsigned FrameCount = 0;
+// Added: How many triangles the last frame drew (after the LODs are picked)
+unsigned int g_numberOfTrianglesDrawn = 0;
+// Added: The meshes share VAOs (see cMeshManager::sMeshArena), so DrawObject() only binds one if it's different
+GLuint g_currentlyBoundVAO = 0;
 
 GLint  ProjectionMatrixUniformLocation = 0;
 GLint  ViewMatrixUniformLocation = 0;
@@ -75,6 +86,11 @@ GLint UniLoc_bAlphaForEntireObject = 0;
 
 GLint UniLoc_bUseDiscardMask = 0;
 
+// Added: For meshes loaded as cVBOInfo::VERTEX_FORMAT_COMPACT
+GLint UniLoc_PositionDecodeScale = 0;
+GLint UniLoc_PositionDecodeOffset = 0;
+GLint UniLoc_bNormalIsOctahedral = 0;
+
 // This is taken from the shader... (the fact we have 8 samplers)
 // NOTE: we are using an array here, but you CAN'T have sampler arrays
 //	in this way inside the shader. There are things called "texture arrays",
@@ -143,6 +159,11 @@ void myMouseCallback();		// Look into this if you like
 
 //void DrawCube(void);
 void DrawObject(cGameObject* pGO);
+// Added: For the lazy meshes (see cMeshManager::RegisterPlyLazy())
+bool bIsSphereInViewFrustum( const glm::vec3 &centre, float radius );
+void PrefetchMeshesNearCamera(void);
+// Objects closer than this to the camera have their meshes loaded, even if they can't be seen
+const float MESHPREFETCHDISTANCE = 15.0f;
 
 void CreateTheObjects(void);
 void SetUpInitialLightValues(void);
@@ -151,6 +172,35 @@ int g_selectedLightIndex = 0;
 
 int main(int argc, char* argv[])
 {
+  // "-benchply [runs]" only times the ply loader (no window, no OpenGL), then exits
+  if ( ( argc > 1 ) && ( std::string(argv[1]) == "-benchply" ) )
+  {
+	unsigned int numberOfRuns = ( argc > 2 ) ? static_cast<unsigned int>( atoi(argv[2]) ) : CPlyLoadBenchmark::DEFAULTNUMBEROFRUNS;
+	std::cout << "Serial:" << std::endl;
+	CPlyLoadBenchmark::RunOnFolder( "assets/models", numberOfRuns, std::cout, false );
+	std::cout << std::endl << "Parallel ASCII parsing:" << std::endl;
+	CPlyLoadBenchmark::RunOnFolder( "assets/models", numberOfRuns, std::cout, true );
+	exit(EXIT_SUCCESS);
+  }
+
+  // "-cachereport [cache size]" prints the vertex cache stats for the models, before and after
+  //	they're optimized (no window, no OpenGL), then exits
+  if ( ( argc > 1 ) && ( std::string(argv[1]) == "-cachereport" ) )
+  {
+	unsigned int cacheSize = ( argc > 2 ) ? static_cast<unsigned int>( atoi(argv[2]) ) : CMeshOptimizer::DEFAULTCACHESIZE;
+	CVertexCacheReport::RunOnFolder( "assets/models", cacheSize, std::cout );
+	exit(EXIT_SUCCESS);
+  }
+
+  // "-cook" converts the models and textures into their cooked form (no window, no OpenGL), then exits
+  if ( ( argc > 1 ) && ( std::string(argv[1]) == "-cook" ) )
+  {
+	CAssetCache cache;
+	cache.SetCacheFolder( CAssetCache::DEFAULTCACHEFOLDER );
+	bool bAllCooked = CAssetCooker::CookFolders( "assets/models", "assets/textures", cache, std::cout );
+	exit( bAllCooked ? EXIT_SUCCESS : EXIT_FAILURE );
+  }
+
 	std::cout << "Preparing OpenGL..." << std::endl;
   Initialize(argc, argv);
 
@@ -215,9 +265,29 @@ void Initialize(int argc, char* argv[])
 //  TranslateMatrix(&ViewMatrix, 0, 0, -2);
 
 
+  // Added: (if it can't be made, the meshes and textures are uploaded the old way)
+  ::g_pTheUploadRing = new CGPUUploadRing();
+  std::string uploadRingError;
+  if ( !::g_pTheUploadRing->Initialize( CGPUUploadRing::DEFAULTSIZEINBYTES, uploadRingError ) )
+  {
+    fprintf( stderr, "WARNING: %s\n", uploadRingError.c_str() );
+  }
+
   SetupShader();
 
   ::g_pTheMeshManager = new cMeshManager();
+  ::g_pTheMeshManager->SetCookedCacheFolder( CAssetCache::DEFAULTCACHEFOLDER );
+  ::g_pTheMeshManager->SetUploadRing( ::g_pTheUploadRing );
+  // Added: "-meshbudget megabytes" limits how much GPU memory the meshes use (the least recently 
+  //	drawn ones are unloaded, and loaded again when they're needed)
+  for ( int argIndex = 1; argIndex + 1 < argc; argIndex++ )
+  {
+	// (glutInit() takes out its own arguments, so some of these can be NULL now)
+	if ( ( argv[argIndex] != 0 ) && ( argv[argIndex + 1] != 0 ) && ( std::string(argv[argIndex]) == "-meshbudget" ) )
+	{
+	  ::g_pTheMeshManager->SetGPUMemoryBudget( static_cast<unsigned long long>( atoi(argv[argIndex + 1]) ) * 1024 * 1024 );
+	}
+  }
 
 //  CreateCube();
   //unsigned int VBO_ID = 0;
@@ -531,6 +601,12 @@ void RenderFunction(void)
 
 
 	++FrameCount;
+	::g_numberOfTrianglesDrawn = 0;
+
+	// Added: Evict meshes if they're over the GPU memory budget (see "-meshbudget")
+	::g_pTheMeshManager->BeginFrame();
+	// Added: Upload any meshes that have finished loading (a few milliseconds' worth a frame)
+	::g_pTheMeshManager->ProcessLoadQueue();
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -548,6 +624,9 @@ void RenderFunction(void)
 							::g_cam_at,   // "At"
 						glm::vec3(0.0f, 1.0f, 0.0f));  // up
 
+	// Added: Start loading the (lazy) meshes that are close, so they're there before they're seen
+	PrefetchMeshesNearCamera();
+
 	::g_pTheShaderManager->UseShaderProgram("basicShader");
 
 	glUniform3f( UniLoc_eye, ::g_cam_eye.x, ::g_cam_eye.y, ::g_cam_eye.z );
@@ -619,8 +698,14 @@ void RenderFunction(void)
 			= ::g_vecLights[g_selectedLightIndex].calcDistanceAtBrightness(0.25f);
 		DrawObject(::g_pDebugBall);
 	}
+
+	glBindVertexArray(0);
+	::g_currentlyBoundVAO = 0;
   
 	glutSwapBuffers();
+
+	// Added: Fences this frame's uploads (so that part of the ring can be used again)
+	::g_pTheUploadRing->EndFrame();
 }
 
 void HandleIO(void)
@@ -795,7 +880,24 @@ void TimerFunction(int Value)
 		<< "; "
 		<< ::g_vecLights[::g_selectedLightIndex].attenLinear 
 		<< "; "
-		<< ::g_vecLights[::g_selectedLightIndex].attenQuad;
+		<< ::g_vecLights[::g_selectedLightIndex].attenQuad
+		<< "; triangles: " << ::g_numberOfTrianglesDrawn;
+	// Added: How much GPU memory the meshes are using (see SetGPUMemoryBudget())
+	cMeshResidencyCounters meshCounters;
+	::g_pTheMeshManager->GetResidencyCounters( meshCounters );
+	ssTitle << std::setprecision(1) 
+		<< "; meshes: " << meshCounters.bytesInUse / ( 1024.0 * 1024.0 ) 
+		<< " of " << meshCounters.bytesAllocated / ( 1024.0 * 1024.0 ) << " MB";
+	if ( meshCounters.budgetInBytes != 0 )
+	{
+		ssTitle << " (budget " << meshCounters.budgetInBytes / ( 1024.0 * 1024.0 ) << " MB, " 
+			<< meshCounters.numberOfEvictedMeshes << " evicted, " 
+			<< meshCounters.totalReloads << " reloads)";
+	}
+	if ( meshCounters.numberOfLazyMeshes != 0 )
+	{
+		ssTitle << "; " << meshCounters.numberOfLazyMeshes << " not loaded yet";
+	}
 
     glutSetWindowTitle(ssTitle.str().c_str());
 
@@ -886,6 +988,10 @@ void SetUpUniformVariables(void)
 
 	UniLoc_bUseDiscardMask =  glGetUniformLocation(shaderID, "bUseDiscardMask" );
 
+	UniLoc_PositionDecodeScale = glGetUniformLocation(shaderID, "PositionDecodeScale" );
+	UniLoc_PositionDecodeOffset = glGetUniformLocation(shaderID, "PositionDecodeOffset" );
+	UniLoc_bNormalIsOctahedral = glGetUniformLocation(shaderID, "bNormalIsOctahedral" );
+
 	for ( int index = 0; index != NUMBEROFLIGHTS; index++ )
 	{
 		cLightDesc curLight;
@@ -968,77 +1074,48 @@ void SetUpUniformVariables(void)
 bool SetUpTextures(void)
 {
 	::g_pTheTextureManager = new CTextureManager();
+	::g_pTheTextureManager->SetCookedCacheFolder( CAssetCache::DEFAULTCACHEFOLDER );
+	::g_pTheTextureManager->SetUploadRing( ::g_pTheUploadRing );
 
 	bool bItsAllGoodMan = true;
 
 	::g_pTheTextureManager->setBasePath("assets/textures");
 	
-	if ( ! ::g_pTheTextureManager->Create2DTextureFromBMPFile("glass.bmp", true) )
-	{
-		std::cout << "Couldn't load texture." << std::endl;
-		bItsAllGoodMan = false;
-	}
-
-	if ( ! ::g_pTheTextureManager->Create2DTextureFromBMPFile("Free_Texture_Digital_08.preview_square_powOf2.bmp", true) )
-	{
-		std::cout << "Couldn't load texture." << std::endl;
-		bItsAllGoodMan = false;
-	}
-
-
-	if ( ! ::g_pTheTextureManager->Create2DTextureFromBMPFile("BlueWhale.bmp", true) )
-	{
-		std::cout << "Couldn't load texture." << std::endl;
-		bItsAllGoodMan = false;
-	}
-
-	if ( ! ::g_pTheTextureManager->Create2DTextureFromBMPFile("sand.bmp", true) )
-	{
-		std::cout << "Couldn't load texture." << std::endl;
-		bItsAllGoodMan = false;
-	}
-
-	if ( ! ::g_pTheTextureManager->Create2DTextureFromBMPFile("TropicalFish01.bmp", true) )
-	{
-		std::cout << "Couldn't load texture." << std::endl;
-		bItsAllGoodMan = false;
-	}
-	if ( ! ::g_pTheTextureManager->Create2DTextureFromBMPFile("TropicalFish02.bmp", true) )
-	{
-		std::cout << "Couldn't load texture." << std::endl;
-		bItsAllGoodMan = false;
-	}
+	// Updated: These are all read (and decoded) at the same time, on the thread pool, 
+	//	then created in this order (see Create2DTexturesFromBMPFiles())
+	std::vector<std::string> vecTextureFiles;
+	vecTextureFiles.push_back("glass.bmp");
+	vecTextureFiles.push_back("Free_Texture_Digital_08.preview_square_powOf2.bmp");
+	vecTextureFiles.push_back("BlueWhale.bmp");
+	vecTextureFiles.push_back("sand.bmp");
+	vecTextureFiles.push_back("TropicalFish01.bmp");
+	vecTextureFiles.push_back("TropicalFish02.bmp");
 	// For the "fireball" thingy...
-	if ( ! ::g_pTheTextureManager->Create2DTextureFromBMPFile("TropicalFish03.bmp", true) )	// <--- mask image
-	{
-		std::cout << "Couldn't load texture." << std::endl;
-		bItsAllGoodMan = false;
-	}
-	if ( ! ::g_pTheTextureManager->Create2DTextureFromBMPFile("TropicalFish05.bmp", true) )	// <--- "explosion" texture
-	{
-		std::cout << "Couldn't load texture." << std::endl;
-		bItsAllGoodMan = false;
-	}
-	if (!::g_pTheTextureManager->Create2DTextureFromBMPFile("TropicalFish04.bmp", true))	// <--- "explosion" texture
+	vecTextureFiles.push_back("TropicalFish03.bmp");	// <--- mask image
+	vecTextureFiles.push_back("TropicalFish05.bmp");	// <--- "explosion" texture
+	vecTextureFiles.push_back("TropicalFish04.bmp");	// <--- "explosion" texture
+	vecTextureFiles.push_back("explode.bmp");			// <--- "explosion" texture
+	vecTextureFiles.push_back("ttt-03_square_powOf2.bmp");	// <--- "explosion" texture
+	vecTextureFiles.push_back("Fence_Mask.bmp");		// <--- "explosion" texture
+
+	std::vector<CTextureLoadTiming> vecTimings;
+	if ( ! ::g_pTheTextureManager->Create2DTexturesFromBMPFiles( vecTextureFiles, true, vecTimings ) )
 	{
 		std::cout << "Couldn't load texture." << std::endl;
+		std::cout << ::g_pTheTextureManager->getLastError() << std::endl;
 		bItsAllGoodMan = false;
 	}
-	if (!::g_pTheTextureManager->Create2DTextureFromBMPFile("explode.bmp", true))	// <--- "explosion" texture
+	for ( std::vector<CTextureLoadTiming>::iterator itTiming = vecTimings.begin(); itTiming != vecTimings.end(); itTiming++ )
 	{
-		std::cout << "Couldn't load texture." << std::endl;
-		bItsAllGoodMan = false;
-	}
-	if (!::g_pTheTextureManager->Create2DTextureFromBMPFile("ttt-03_square_powOf2.bmp", true))	// <--- "explosion" texture
-	{
-		std::cout << "Couldn't load texture." << std::endl;
-		bItsAllGoodMan = false;
-	}
-	if (!::g_pTheTextureManager->Create2DTextureFromBMPFile("Fence_Mask.bmp", true))	// <--- "explosion" texture
-	{
-		std::cout << "Couldn't load texture." << std::endl;
-		bItsAllGoodMan = false;
+		std::cout << itTiming->textureFileName << ( itTiming->bLoaded ? "" : " (didn't load)" ) 
+			<< ( itTiming->bFromCookedFile ? " (cooked)" : "" )
+			<< ( itTiming->bCompressed ? " (compressed)" : "" )
+			<< ": decode " << itTiming->decodeSeconds * 1000.0f << " ms"
+			<< ", wait " << itTiming->waitSeconds * 1000.0f << " ms"
+			<< ", upload " << itTiming->uploadSeconds * 1000.0f << " ms" << std::endl;
 	}
+	std::cout << "Textures take about " << ::g_pTheTextureManager->GetTotalSizeInGPUMemory() / 1024 << " KB of video memory" << std::endl;
+
 	// Now we set up the sampler uniform locations. 
 	// These are exactly the same as any other uniforms we've used, as they 
 	//  represent a register in the GPU. Note that you CAN'T have sampler 
@@ -1190,6 +1267,8 @@ void ShutErDownPeople(void)
 
 	::g_pTheTextureManager->ShutDown();
 
+	::g_pTheUploadRing->ShutDown();
+
 	// Go through the game object vector, deleting everything
 	for ( std::vector< cGameObject* >::iterator itpGO = ::g_vec_pGOs.begin();
 		itpGO != ::g_vec_pGOs.end(); itpGO++ )
@@ -1207,6 +1286,7 @@ void ShutErDownPeople(void)
 	delete ::g_pTheMeshManager;		
 	delete ::g_pTheShaderManager;
 	delete ::g_pTheTextureManager;
+	delete ::g_pTheUploadRing;
 
 	ExitOnGLError("ERROR: Could not destroy the buffer objects");
 }
@@ -1355,20 +1435,77 @@ void DrawObject( cGameObject* pGO )
 
 	ExitOnGLError("ERROR: Could not set the shader uniforms");
 
-	std::string modelToDraw = pGO->modelName;
+	// Updated: By handle (an array look up), not by name. The name's only used the first time
+	//	(or if the mesh was loaded again)
+	const cVBOInfo* pCurVBO = ::g_pTheMeshManager->GetVBOInfo( pGO->cached_VBO_ID );
+	if ( pCurVBO == 0 )
+	{
+		// Updated: If it was evicted (see SetGPUMemoryBudget()), this starts loading it again
+		// Updated: A lazy mesh (see RegisterPlyLazy()) is only loaded once the object can be seen. 
+		//	If how big it is isn't known (it hasn't been cooked), it's loaded right away.
+		pGO->cached_VBO_ID = ::g_pTheMeshManager->LookUpMeshHandle( pGO->modelName );
+		if ( pGO->cached_VBO_ID == cMeshManager::INVALIDMESHHANDLE )
+		{
+			bool bCanBeSeen = true;
+			float boundingCentre[3] = { 0.0f, 0.0f, 0.0f };
+			float boundingRadius = 0.0f;
+			if ( ::g_pTheMeshManager->GetUnloadedMeshBoundingSphere( pGO->modelName, boundingCentre, boundingRadius ) )
+			{
+				glm::vec4 centre = matWorld * glm::vec4( boundingCentre[0], boundingCentre[1], boundingCentre[2], 1.0f );
+				bCanBeSeen = bIsSphereInViewFrustum( glm::vec3(centre), boundingRadius * pGO->scale );
+			}
+			if ( bCanBeSeen )
+			{
+				pGO->cached_VBO_ID = ::g_pTheMeshManager->RequestMesh( pGO->modelName );
+			}
+		}
+		pCurVBO = ::g_pTheMeshManager->GetVBOInfo( pGO->cached_VBO_ID );
+		if ( pCurVBO == 0 )
+		{ // Didn't find it. (or it's still loading)
+			return;
+		}
+	}
+	const cVBOInfo &curVBO = *pCurVBO;
+	::g_pTheMeshManager->MarkMeshAsUsed( pGO->cached_VBO_ID );
 
-	cVBOInfo curVBO;
-	if (!::g_pTheMeshManager->LookUpVBOInfoFromModelName(modelToDraw, curVBO))
-	{ // Didn't find it.
-		return;
+	// Added: Pick the level of detail from how big it is on the screen
+	unsigned int LOD = 0;
+	if ( curVBO.numberOfLODs > 1 )
+	{
+		glm::vec4 centre = matWorld * glm::vec4( curVBO.boundingCentre[0], curVBO.boundingCentre[1], curVBO.boundingCentre[2], 1.0f );
+		float radius = curVBO.boundingRadius * pGO->scale;
+		float distance = glm::distance( glm::vec3(centre), ::g_cam_eye );
+		if ( distance > radius )
+		{	// (matProjection[1][1] is 1/tan(fov/2), so this is pixels per unit, 1 unit away)
+			float pixelsPerUnit = matProjection[1][1] * CurrentHeight * 0.5f;
+			float screenRadius = radius / sqrt( distance * distance - radius * radius ) * pixelsPerUnit;
+			LOD = cMeshManager::SelectLOD( curVBO, screenRadius, pGO->currentLOD );
+		}
 	}
+	pGO->currentLOD = LOD;
 
 //  glBindVertexArray(BufferIds[0]);
-  glBindVertexArray(curVBO.VBO_ID);
+  if ( curVBO.VBO_ID != ::g_currentlyBoundVAO )
+  {
+	  glBindVertexArray(curVBO.VBO_ID);
+	  ::g_currentlyBoundVAO = curVBO.VBO_ID;
+  }
 
 
   ExitOnGLError("ERROR: Could not bind the VAO for drawing purposes");
 
+	// Added: How to turn the vertices back into floats (these are just 1s and 0s for VERTEX_FORMAT_FLOAT)
+	glUniform4f( UniLoc_PositionDecodeScale, curVBO.positionDecodeScale[0], curVBO.positionDecodeScale[1], 
+	                                         curVBO.positionDecodeScale[2], 1.0f );
+	glUniform4f( UniLoc_PositionDecodeOffset, curVBO.positionDecodeOffset[0], curVBO.positionDecodeOffset[1], 
+	                                          curVBO.positionDecodeOffset[2], 0.0f );
+	glUniform1f( UniLoc_bNormalIsOctahedral, ( curVBO.bNormalsAreOctahedral ? 1.0f /*TRUE*/ : 0.0f /*FALSE*/ ) );
+	if ( !curVBO.bHasVertexColours )
+	{	// The colour isn't in the vertices, so it's the same for all of them (black, like an "empty" colour in the ply)
+		// (this isn't part of the VAO, so it has to be set each time)
+		glVertexAttrib4f( 2, 0.0f, 0.0f, 0.0f, 0.0f );
+	}
+
   // Make everything lines ("wireframe")
   if ( pGO->bIsWireframe )
   {
@@ -1413,14 +1550,18 @@ void DrawObject( cGameObject* pGO )
 
 
 
-  unsigned int numberOfIndicesToDraw = curVBO.numberOfTriangles * 3;
+  unsigned int numberOfIndicesToDraw = curVBO.LODs[LOD].numberOfTriangles * 3;
+  // Updated: The mesh is somewhere in the arena's buffers (its indices start at 0, hence the "base vertex")
+  unsigned int byteOffsetToLOD = ( curVBO.firstIndex + curVBO.LODs[LOD].firstIndex ) * 
+	                             ( ( curVBO.indexType == GL_UNSIGNED_SHORT ) ? sizeof(GLushort) : sizeof(GLuint) );
 
-  glDrawElements(GL_TRIANGLES, numberOfIndicesToDraw,	// 36,
-	             GL_UNSIGNED_INT, 
-	             (GLvoid*)0);
+  glDrawElementsBaseVertex(GL_TRIANGLES, numberOfIndicesToDraw,	// 36,
+	             curVBO.indexType,		// GL_UNSIGNED_SHORT (or GL_UNSIGNED_INT for meshes with more than 65536 vertices)
+	             (GLvoid*)byteOffsetToLOD, 
+	             static_cast<GLint>( curVBO.firstVertex ));
+  ::g_numberOfTrianglesDrawn += curVBO.LODs[LOD].numberOfTriangles;
   ExitOnGLError("ERROR: Could not draw the cube");
 
-  glBindVertexArray(0);
 //  glUseProgram(0);
   ::g_pTheShaderManager->UseShaderProgram(0);
 
@@ -1456,28 +1597,75 @@ void SetUpInitialLightValues(void)
 }
 
 
+// Added: Is any of the sphere (in world space) inside the view frustum? 
+// (the planes are from the rows of projection * view; see Gribb and Hartmann, 
+//	"Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix")
+bool bIsSphereInViewFrustum( const glm::vec3 &centre, float radius )
+{
+	glm::mat4 matViewProjection = matProjection * matView;
+	glm::vec4 row[4];
+	for ( int rowIndex = 0; rowIndex != 4; rowIndex++ )
+	{
+		row[rowIndex] = glm::vec4( matViewProjection[0][rowIndex], matViewProjection[1][rowIndex], 
+		                           matViewProjection[2][rowIndex], matViewProjection[3][rowIndex] );
+	}
+	// Left, right, bottom, top, near, far
+	glm::vec4 planes[6] = { row[3] + row[0], row[3] - row[0], row[3] + row[1], 
+	                        row[3] - row[1], row[3] + row[2], row[3] - row[2] };
+	for ( int planeIndex = 0; planeIndex != 6; planeIndex++ )
+	{
+		float length = glm::length( glm::vec3( planes[planeIndex] ) );
+		float distance = glm::dot( glm::vec3( planes[planeIndex] ), centre ) + planes[planeIndex].w;
+		if ( distance < -radius * length )
+		{	// All of it is on the outside of this plane
+			return false;
+		}
+	}
+	return true;
+}
+
+// Added: Asks for the mesh of anything close to the camera (which loads it, if it's lazy)
+void PrefetchMeshesNearCamera(void)
+{
+	for ( std::vector< cGameObject* >::iterator itGO = ::g_vec_pGOs.begin(); itGO != ::g_vec_pGOs.end(); itGO++ )
+	{
+		cGameObject* pGO = *itGO;
+		if ( ( ::g_pTheMeshManager->GetVBOInfo( pGO->cached_VBO_ID ) == 0 ) && 
+		     ( glm::distance( pGO->position, ::g_cam_eye ) < MESHPREFETCHDISTANCE ) )
+		{
+			pGO->cached_VBO_ID = ::g_pTheMeshManager->RequestMesh( pGO->modelName );
+		}
+	}
+	return;
+}
+
 void CreateTheObjects(void)
 {
 	// Now with more ply...
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/BlueWhale.ply");
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/tankFrame.ply");
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/tankGlass.ply");
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/tankGround.ply");
+	// (the tank and the plants are stored smaller on the GPU; see cVBOInfo::enumVertexFormat)
+	// Updated: Loaded on the thread pool; RenderFunction() uploads them as they're ready, 
+	//	and the objects show up once their mesh is there (see ProcessLoadQueue())
+	// Updated: Only the headers are read here. Each one is loaded (as above) the first time 
+	//	an object that uses it can be seen, or is close to the camera (see RegisterPlyLazy())
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/BlueWhale.ply");
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/tankFrame.ply", cVBOInfo::VERTEX_FORMAT_COMPACT);
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/tankGlass.ply", cVBOInfo::VERTEX_FORMAT_COMPACT);
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/tankGround.ply", cVBOInfo::VERTEX_FORMAT_COMPACT);
 	//plants
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/Plant1.ply");
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/Plant2.ply");
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/Plant1.ply", cVBOInfo::VERTEX_FORMAT_COMPACT);
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/Plant2.ply", cVBOInfo::VERTEX_FORMAT_COMPACT);
 	//rocks
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/asteroid_sc0001.ply");
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/asteroid_sc0001.ply");
 	//fishes
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/TropicalFish01.ply");
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/TropicalFish03.ply");
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/TropicalFish05.ply");
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/TropicalFish01.ply");
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/TropicalFish03.ply");
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/TropicalFish05.ply");
 	//something else
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/castleTower.ply");
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/castleTower.ply");
 
 	//extra
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/TropicalFish02.ply");
-	::g_pTheMeshManager->LoadPlyIntoVBO("assets/models/TropicalFish04.ply");
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/TropicalFish02.ply");
+	::g_pTheMeshManager->RegisterPlyLazy("assets/models/TropicalFish04.ply");
 
 	//g_pDebugBall = new cGameObject();
 	//g_pDebugBall->modelName = "assets/models/Isoshphere.ply";